@@ -12,6 +12,21 @@
 
 
 
+//------------------------------------------------------- -o-
+// Launch with "-SpotTraceEnabled YES" to record trace spans;  they are
+//   written to Documents each time the app enters the background.
+//
+#define SPOT_TRACE_ENABLED_KEY  @"SpotTraceEnabled"
+#define SPOT_TRACE_FILENAME     @"trace.json"
+
+
+// Launch with "-SpotFlickrBaseURL http://127.0.0.1:<port>" to fetch from
+//   a FlickrStandIn (spotcli serve) instead of Flickr.
+//
+#define SPOT_FLICKR_BASEURL_KEY  @"SpotFlickrBaseURL"
+
+
+
 //------------------------------------------------------- -o-
 @interface AppDelegate : UIResponder <UIApplicationDelegate>
 
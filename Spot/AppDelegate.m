@@ -16,6 +16,14 @@
   //[ZedUD udRemoveRootDictionary:PF_DICTIONARY_ROOT_KEY];             // DEBUG
   //DP_ONEDICT([ZedUD udGetRootDictionary:PF_DICTIONARY_ROOT_KEY], @"USER DEFAULTS", nil);
 
+  [Trace setEnabled:[[NSUserDefaults standardUserDefaults] boolForKey:SPOT_TRACE_ENABLED_KEY]];
+
+  NSString  *flickrBaseURL = [[NSUserDefaults standardUserDefaults] stringForKey:SPOT_FLICKR_BASEURL_KEY];
+
+  if (flickrBaseURL) {
+    [FlickrFetcher setBaseURL:[NSURL URLWithString:flickrBaseURL]];
+  }
+
   return YES;
 }
 							
@@ -31,6 +39,16 @@
 {
     // Use this method to release shared resources, save user data, invalidate timers, and store enough application state information to restore your application to its current state in case it is terminated later. 
     // If your application supports background execution, this method is called instead of applicationWillTerminate: when the user quits.
+
+  [ZedUD synchronize];
+
+  if ([Trace isEnabled]) 
+  {
+    NSURL  *documentsURL = 
+      [[[NSFileManager defaultManager] URLsForDirectory:NSDocumentDirectory inDomains:NSUserDomainMask] lastObject];
+
+    [Trace writeChromeTraceToURL:DP_URL_PLUSFILE(documentsURL, SPOT_TRACE_FILENAME)];
+  }
 }
 
 //---------------------- -o-
@@ -49,6 +67,8 @@
 - (void)applicationWillTerminate:(UIApplication *)application
 {
     // Called when the application is about to terminate. Save data if appropriate. See also applicationDidEnterBackground:.
+
+  [ZedUD synchronize];
 }
 
 @end
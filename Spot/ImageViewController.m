@@ -24,6 +24,12 @@
 
 
   - (void) resetImage;
+
+  - (void) displayImageData: (NSData *)imageData
+                  sourceURL: (NSURL *)sourceURL
+                      error: (NSError *)error
+                   showSpan: (DPTraceSpan)showSpan;
+
   - (void) initialZoomSetting;
  
 @end
@@ -205,6 +211,10 @@
 // Add new images to recents list.
 // Zoom image to form factor of UIImage window.
 //
+// NB  Each step runs on the QueueRegistry role for its work:  cache 
+//       lookup and read on disk, download on network (both in 
+//       PhotoFetch), then decode.
+//
 - (void) resetImage
 {
   if (self.scrollView) 
@@ -220,94 +230,115 @@
     if (!self.imageURL)  { return; }
 
 
+    // Trace spans:  image.show covers tap to first frame;  the read or 
+    //   network fetch, decode, main.hop (the wait for the main queue) 
+    //   and display are its children.
     //
+    DPTraceSpan  showSpan = DP_TRACE_BEGIN_ASYNC("image.show");
+
     [self.activityIndicator startAnimating];
 
-    dispatch_async(DP_ASYNC_QUEUE(@"for fetching images"), 
-    ^{
-      NSData   *imageData;
-      NSURL    *cachedPhotoURL;
-      NSError  *error = nil;
+    [PhotoFetch photoDataForEntry: self.photoEntry
+                              url: self.imageURL
+                       parentSpan: showSpan.spanID
+                       completion: ^(NSData *imageData, NSURL *sourceURL, BOOL isCached, NSError *error)
+    {
+      [self displayImageData:imageData sourceURL:sourceURL error:error showSpan:showSpan];
+    }];
 
+  } // endif -- self.scrollView
 
-      cachedPhotoURL = [[PhotoFetch photoCache] cachedFileURL:PF_PHOTOENTRY_FILENAME(self.photoEntry) ];
+} // resetImage
 
-      if (cachedPhotoURL) {
-        imageData = [[NSData alloc] initWithContentsOfURL:cachedPhotoURL options:0 error:&error];
 
-      } else {
-        [Zed networkIndicatorEnable:YES];
-        imageData = [[NSData alloc] initWithContentsOfURL:self.imageURL options:0 error:&error];
-        [Zed networkIndicatorEnable:NO];
-      }
 
+//------------ -o-
+// displayImageData:sourceURL:error:showSpan:
+//
+// Decode imageData, then display it and cache it  -OR-  report error.
+//
+- (void) displayImageData: (NSData *)imageData
+                sourceURL: (NSURL *)sourceURL
+                    error: (NSError *)error
+                 showSpan: (DPTraceSpan)showSpan
+{
+  // NB  Flickr intecepts bad URLs and returns an image containing and err message.
+  //
+  if (error) 
+  {
+    DP_LOG_NSERROR(error);
+    DP_TRACE_END(showSpan);
 
-      // NB  Flickr intecepts bad URLs and returns an image containing and err message.
-      //
-      if (error) 
+    dispatch_async(dispatch_get_main_queue(), 
+    ^{
+      if (!self.isViewDestroyed) 
       {
-        DP_LOG_NSERROR(error);
-
-	dispatch_async(dispatch_get_main_queue(), 
-	^{
-	  if (!self.isViewDestroyed) 
-	  {
-	    NSURL  *imageSourceURL = cachedPhotoURL ? cachedPhotoURL : self.imageURL;
-
-	    UIAlertView  *anAlert = [[UIAlertView alloc] initWithTitle: @"Image Download Failed."
-							       message: DP_STRWFMT(@"Could not resolve URL: %@ .", imageSourceURL)
-							      delegate: nil
-						     cancelButtonTitle: nil
-						     otherButtonTitles: @"OK", nil ];
-	    [anAlert show];
-	  }
-
-	  [self.activityIndicator stopAnimating];
-	});
-
-        return;
+        UIAlertView  *anAlert = [[UIAlertView alloc] initWithTitle: @"Image Download Failed."
+                                                           message: DP_STRWFMT(@"Could not resolve URL: %@ .", sourceURL)
+                                                          delegate: nil
+                                                 cancelButtonTitle: nil
+                                                 otherButtonTitles: @"OK", nil ];
+        [anAlert show];
       }
 
-      UIImage  *image = [[UIImage alloc] initWithData:imageData];
+      [self.activityIndicator stopAnimating];
+    });
+
+    return;
+  }
 
 
+  //
+  [QueueRegistry async:QRRoleDecode block:
+  ^{
+    // NB  UIKit may defer pixel decode until first draw;  that cost
+    //       then lands in image.show, after image.display.
+    //
+    DPTraceSpan  decodeSpan  = DP_TRACE_BEGIN_CHILD("image.decode", showSpan.spanID);
+    UIImage     *image       = [[UIImage alloc] initWithData:imageData];
+
+    DP_TRACE_END(decodeSpan);
+
+
+    //
+    DPTraceSpan  hopSpan = DP_TRACE_BEGIN_ASYNC_CHILD("main.hop", showSpan.spanID);
+
+    dispatch_async(dispatch_get_main_queue(), 
+    ^{
+      DP_TRACE_END(hopSpan);
+
+      DPTraceSpan  displaySpan = DP_TRACE_BEGIN_CHILD("image.display", showSpan.spanID);
+
+      if (! self.isViewDestroyed)
+      {       
+        [PhotoFetch keepPhotoData: imageData
+                         forEntry: self.photoEntry
+                     addToRecents: !self.isPhotoEntryFromRecentsList ];
+
+        if (image) {      
+          self.scrollView.zoomScale   = 1.0;
+          self.scrollView.contentSize = image.size;
+          self.imageView.image        = image;
+          self.imageView.frame        = CGRectMake(0, 0, image.size.width, image.size.height);
+        }
+
+        [self initialZoomSetting];
+
+      } // endif -- ! self.isViewDestroyed
+
+      [self.activityIndicator stopAnimating];
+
+      DP_TRACE_END(displaySpan);
+
+
+      // Next pass of the main queue follows the Core Animation commit.
       //
-      dispatch_async(dispatch_get_main_queue(), 
-      ^{
-        if (! self.isViewDestroyed)
-        {       
-          if (self.photoEntry)
-          {
-            dispatch_async([PhotoFetch photoCacheQueue],
-            ^{
-              if (! self.isPhotoEntryFromRecentsList) {
-                [PhotoFetch addToRecentsList:self.photoEntry];
-              }
-
-              [[PhotoFetch photoCache] saveFile: PF_PHOTOENTRY_FILENAME(self.photoEntry)
-                                       withData: imageData ];
-            });
-          }
-
-          if (image) {      
-            self.scrollView.zoomScale   = 1.0;
-            self.scrollView.contentSize = image.size;
-            self.imageView.image        = image;
-            self.imageView.frame        = CGRectMake(0, 0, image.size.width, image.size.height);
-          }
-
-          [self initialZoomSetting];
-
-        } // endif -- ! self.isViewDestroyed
-
-        [self.activityIndicator stopAnimating];
-
-      }); // main thread queue
-    }); // fetch thread queue
+      dispatch_async(dispatch_get_main_queue(), ^{ DP_TRACE_END(showSpan); });
 
-  } // endif -- self.scrollView
+    }); // main thread queue
+  }];
 
-} // resetImage
+} // displayImageData:sourceURL:error:showSpan:
 
 
 
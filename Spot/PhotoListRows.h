@@ -0,0 +1,58 @@
+//
+// PhotoListRows.h
+//
+// Display strings for each row of a photo list, computed once, plus one
+// bit per row recording whether its photo is in the photo cache.
+//
+// Build off the main thread;  read and update bits on the main thread.
+//
+
+#import <UIKit/UIKit.h>
+
+#import "FlickrFetcher.h"
+#import "PhotoFetch.h"
+
+#import "Danaprajna.h"
+#import "DataFileCache.h"
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoRow : NSObject
+
+  @property  (readonly, strong, nonatomic)  NSString  *fileName;      // PF_PHOTOENTRY_FILENAME
+  @property  (readonly, strong, nonatomic)  NSString  *title;
+  @property  (readonly, strong, nonatomic)  NSString  *subtitle;
+  @property  (readonly, strong, nonatomic)  NSString  *cachedSubtitle;
+
+  + (PhotoRow *) rowWithPhotoEntry: (NSDictionary *)photoEntry;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoListRows : NSObject
+
+  @property  (readonly, strong, nonatomic)  NSArray  *photoArray;
+  @property  (readonly, strong, nonatomic)  NSArray  *rows;     // of PhotoRow
+
+
+  //
+  - (id) initWithPhotoArray: (NSArray *)photoArray
+            cachedFileNames: (NSSet *)cachedFileNames;
+
+  - (NSUInteger) count;
+
+  - (PhotoRow *) rowAtIndex:            (NSUInteger)index;
+  - (BOOL)       isCachedAtIndex:       (NSUInteger)index;
+  - (NSString *) subtitleAtIndex:       (NSUInteger)index;
+
+  - (NSIndexSet *) setCached: (BOOL)isCached
+                 forFileName: (NSString *)fileName;
+
+  - (void) setAllCached: (BOOL)isCached;
+
+@end
+
@@ -0,0 +1,188 @@
+//
+// PhotoListRows.m
+//
+
+#import "PhotoListRows.h"
+
+
+
+//------------------------------------------------------------ -o-
+#define PF_CACHED_INDICATOR   @"[cached]  "
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoRow()
+
+  @property  (readwrite, strong, nonatomic)  NSString  *fileName;
+  @property  (readwrite, strong, nonatomic)  NSString  *title;
+  @property  (readwrite, strong, nonatomic)  NSString  *subtitle;
+  @property  (readwrite, strong, nonatomic)  NSString  *cachedSubtitle;
+
+@end
+
+
+
+//------------------------------------------------------------ -o--
+@implementation PhotoRow
+
+//-------------------------- -o-
++ (PhotoRow *) rowWithPhotoEntry: (NSDictionary *)photoEntry
+{
+  PhotoRow  *row = [[PhotoRow alloc] init];
+
+  row.fileName        = PF_PHOTOENTRY_FILENAME(photoEntry);
+  row.title           = [[photoEntry objectForKey:FLICKR_PHOTO_TITLE] description];
+  row.subtitle        = [[photoEntry valueForKeyPath:FLICKR_PHOTO_DESCRIPTION] description] ?: @"";
+  row.cachedSubtitle  = [NSString stringWithFormat:@"%@%@", PF_CACHED_INDICATOR, row.subtitle];
+
+  return row;
+}
+
+@end // @implementation PhotoRow
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoListRows()
+
+  @property  (readwrite, strong, nonatomic)  NSArray  *photoArray;
+  @property  (readwrite, strong, nonatomic)  NSArray  *rows;
+
+  @property  (nonatomic)  CFMutableBitVectorRef  cachedBits;
+
+  @property  (strong, nonatomic)  NSDictionary  *indexesByFileName;
+      // fileName --> NSIndexSet of rows.  A photo may appear more than once.
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation PhotoListRows
+
+#pragma mark - Constructors.
+
+//-------------------------- -o-
+// initWithPhotoArray:cachedFileNames:
+//
+// cachedFileNames is from [DataFileCache lookupFiles:completion:].
+//
+- (id) initWithPhotoArray: (NSArray *)photoArray
+          cachedFileNames: (NSSet *)cachedFileNames
+{
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+
+  //
+  NSUInteger            count              = [photoArray count];
+  NSMutableArray       *rows               = [[NSMutableArray alloc] initWithCapacity:count];
+  NSMutableDictionary  *indexesByFileName  = [[NSMutableDictionary alloc] initWithCapacity:count];
+
+  self.photoArray  = photoArray;
+  self.cachedBits  = CFBitVectorCreateMutable(kCFAllocatorDefault, count);
+  CFBitVectorSetCount(self.cachedBits, count);
+
+  for (NSUInteger index = 0; index < count; index++)
+  {
+    PhotoRow  *row = [PhotoRow rowWithPhotoEntry:[photoArray objectAtIndex:index]];
+
+    [rows addObject:row];
+
+    NSMutableIndexSet  *indexes = [indexesByFileName objectForKey:row.fileName];
+    if (!indexes) {
+      indexes = [[NSMutableIndexSet alloc] init];
+      [indexesByFileName setObject:indexes forKey:row.fileName];
+    }
+    [indexes addIndex:index];
+
+    if ([cachedFileNames containsObject:row.fileName]) {
+      CFBitVectorSetBitAtIndex(self.cachedBits, index, 1);
+    }
+  }
+
+  self.rows               = rows;
+  self.indexesByFileName  = indexesByFileName;
+
+  return self;
+
+} // initWithPhotoArray:cachedFileNames:
+
+
+//-------------------------- -o-
+- (void) dealloc
+{
+  if (self.cachedBits) {
+    CFRelease(self.cachedBits);
+  }
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//-------------------------- -o-
+- (NSUInteger) count
+{
+  return [self.rows count];
+}
+
+
+//-------------------------- -o-
+- (PhotoRow *) rowAtIndex: (NSUInteger)index
+{
+  return [self.rows objectAtIndex:index];
+}
+
+
+//-------------------------- -o-
+- (BOOL) isCachedAtIndex: (NSUInteger)index
+{
+  return (1 == CFBitVectorGetBitAtIndex(self.cachedBits, index));
+}
+
+
+//-------------------------- -o-
+- (NSString *) subtitleAtIndex: (NSUInteger)index
+{
+  PhotoRow  *row = [self.rows objectAtIndex:index];
+  return [self isCachedAtIndex:index] ? row.cachedSubtitle : row.subtitle;
+}
+
+
+
+//-------------------------- -o-
+// setCached:forFileName:
+//
+// RETURN:  Rows showing fileName  -OR-  nil.
+//
+- (NSIndexSet *) setCached: (BOOL)isCached
+               forFileName: (NSString *)fileName
+{
+  NSIndexSet  *indexes = [self.indexesByFileName objectForKey:fileName];
+
+  [indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+    CFBitVectorSetBitAtIndex(self.cachedBits, index, isCached ? 1 : 0);
+  }];
+
+  return indexes;
+}
+
+
+//-------------------------- -o-
+- (void) setAllCached: (BOOL)isCached
+{
+  CFBitVectorSetAllBits(self.cachedBits, isCached ? 1 : 0);
+}
+
+
+@end // @implementation PhotoListRows
+
@@ -10,8 +10,10 @@
 #import "FlickrFetcher.h"
 #import "PhotoFetch.h"
 #import "ImageViewController.h"
+#import "PhotoListRows.h"
 
 #import "Danaprajna.h"
+#import "TableRowUpdates.h"
 
 
 
@@ -21,7 +23,11 @@
   @property  (strong, nonatomic)  NSString  *photoSearchTag;
 
   @property  (strong, nonatomic)  NSArray   *photoArray;  // of NSDictionary
-      // Photos with photoSearchTag  -OR-  from [PhotoFetch recentPhotos]
+      // Photos with photoSearchTag, filtered by searchQuery  
+      //   -OR-  from [PhotoFetch recentPhotos]
+
+  @property  (strong, nonatomic)  NSString  *searchQuery;
+      // Typed into search bar;  narrows photoArray by title and description.
 
   @property  (nonatomic, getter=isNotRecentsList)  BOOL  notRecentsList;
       // YES in segue for category photos; NO for list most recently viewed photos.
@@ -13,20 +13,42 @@
 
 
 //-------------------------------------------- -o--
-@interface PhotoListTVC() <UISplitViewControllerDelegate> 
+@interface PhotoListTVC() <UISplitViewControllerDelegate, UISearchBarDelegate> 
 
   @property  (weak, nonatomic)  IBOutlet UIBarButtonItem  *cacheStatusButtonLabelOutput;
       // NB  This button repurposed simply to output text, UILabel-like.
 
+  @property  (strong, nonatomic)  PhotoSnapshot  *snapshot;
+      // Source of photoArray, when not recents list.
+
+  @property  (strong, nonatomic)  NSArray  *taggedPhotoArray;
+      // Photos with photoSearchTag sorted by title, before filtering by searchQuery.
+
+  @property  (strong, nonatomic)  PhotoListRows  *rows;
+      // Display strings and cache state for photoArray, once built.
+
+  @property  (strong, nonatomic)  id  changeSubscription;
+      // From [PhotoFetch changeFeed].
+
 
   //
   - (NSString *) titleForRow:    (NSUInteger) row;
   - (NSString *) subtitleForRow: (NSUInteger) row;
 
+  - (void) rebuildRows;
+  - (void) reconfigureVisibleRows: (NSIndexSet *)rowIndexes;
+
   - (void) transferSplitViewBarButtonItemToViewController: (id)nextDetailVC;
 
   - (void) setCacheSizeFreeDisplayOutput;
 
+  - (void) filterPhotoArray;
+
+  - (void) changesPublished:   (NSArray *)events;
+  - (void) photosUpdated:      (NSArray *)snapshots;
+  - (void) recentsUpdated:     (NSSet *)photoIDs;
+  - (void) photoCacheChanged:  (ChangeFeedEvent *)event;
+
 @end
 
 
@@ -50,35 +72,56 @@
   [super viewDidLoad];
 
   if (self.isNotRecentsList) {
-    self.photoArray = [PhotoFetch photoArrayPerTagOccurrence:self.photoSearchTag];
+    self.snapshot          = [PhotoFetch currentSnapshot];
+    self.taggedPhotoArray  = [self.snapshot sortedPhotoArrayForTag:self.photoSearchTag order:PFSortOrderTitle];
+    [self filterPhotoArray];
+
+    UISearchBar  *searchBar = [[UISearchBar alloc] initWithFrame:CGRectMake(0, 0, self.tableView.bounds.size.width, 44)];
+
+    searchBar.delegate                = self;
+    searchBar.placeholder             = @"Title or description";
+    searchBar.autocapitalizationType  = UITextAutocapitalizationTypeNone;
+    searchBar.autocorrectionType      = UITextAutocorrectionTypeNo;
+    searchBar.text                    = self.searchQuery;
 
+    self.tableView.tableHeaderView = searchBar;
   } else {
     self.photoArray = [PhotoFetch recentPhotos];
     [self setCacheSizeFreeDisplayOutput];
   }
 
+
+  //
+  NSArray  *topics = @[ self.isNotRecentsList ? PF_CHANGE_SNAPSHOT_PUBLISHED : PF_CHANGE_RECENTS,
+                        DFC_NOTIFICATION_FILE_ADDED, DFC_NOTIFICATION_FILE_REMOVED, DFC_NOTIFICATION_CLEARED ];
+
+  __weak PhotoListTVC  *weakSelf = self;
+
+  self.changeSubscription = 
+    [[PhotoFetch changeFeed] subscribeTopics: topics
+                                       queue: dispatch_get_main_queue()
+                                       block: ^(NSArray *events) { [weakSelf changesPublished:events]; } ];
+
 } // viewDidLoad
 
 
 
 //----------------------- -o-
-- (void) viewDidLayoutSubviews
+- (void) dealloc
 {
-  [super viewDidLayoutSubviews];
+  [[PhotoFetch changeFeed] unsubscribe:self.changeSubscription];
+}
 
-  static long long  currentFreeBytesPrevious  = -1;
-  long long         currentFreeBytes          = [[PhotoFetch photoCache] currentFreeBytes];
 
-  if ( (! self.isNotRecentsList) 
-          && ([PhotoFetch areRecentPhotosUpdated] || (currentFreeBytesPrevious != currentFreeBytes)) )
-  {
-    self.photoArray = [PhotoFetch recentPhotos];
-    [self setCacheSizeFreeDisplayOutput];
-
-    currentFreeBytesPrevious = currentFreeBytes;
-    [self.tableView reloadData];
-  }
 
+//----------------------- -o-
+// viewDidLayoutSubviews
+//
+// NB  No cache or defaults access here;  changes arrive by changesPublished:.
+//
+- (void) viewDidLayoutSubviews
+{
+  [super viewDidLayoutSubviews];
 
   //
   // NB  Both clauses needed for iPad.  iPhone needs only setToolbarHidden=YES.
@@ -125,26 +168,210 @@
 //-------------------------------------------- -o--
 #pragma mark - Getters/setters.
 
-
 //----------------------- -o-
 - (void) setPhotoArray: (NSArray *)photoArray
 {
-  // Recents list is already sorted by date.
+  _photoArray = photoArray;
+  [self rebuildRows];
+}
+
+
+
+
+//-------------------------------------------- -o--
+#pragma mark - Change feed.
+
+//----------------------- -o-
+// changesPublished:
+//
+// Dispatch one coalesced batch from [PhotoFetch changeFeed], in order.
+//
+- (void) changesPublished: (NSArray *)events
+{
+  NSMutableArray  *snapshots        = [[NSMutableArray alloc] init];
+  NSMutableSet    *recentIDs        = [[NSMutableSet alloc] init];
+  BOOL             recentsChanged   = NO;
+  BOOL             cacheChanged     = NO;
+
+  for (ChangeFeedEvent *event in events)
+  {
+    if ([event.topic isEqualToString:PF_CHANGE_SNAPSHOT_PUBLISHED]) {
+      [snapshots addObject:event.payload];
+
+    } else if ([event.topic isEqualToString:PF_CHANGE_RECENTS]) {
+      [recentIDs addObject:event.payload];
+      recentsChanged = YES;
+
+    } else {
+      [self photoCacheChanged:event];
+      cacheChanged = YES;
+    }
+  }
+
+
+  //
+  if ([snapshots count] > 0)  { [self photosUpdated:snapshots]; }
+  if (recentsChanged)         { [self recentsUpdated:recentIDs]; }
+
+  if (cacheChanged && !self.isNotRecentsList) {
+    [self setCacheSizeFreeDisplayOutput];
+  }
+
+} // changesPublished:
+
+
+
+//----------------------- -o-
+// photosUpdated:
+//
+// Take photos for this tag from the newest snapshot of the same category, 
+// then insert, delete or reload only the rows touched by the diffs since 
+// the current snapshot.  Reload everything when most photos have changed, 
+// or when a version between the two was not seen.
+//
+- (void) photosUpdated: (NSArray *)snapshots
+{
+  PhotoSnapshot  *oldSnapshot   = self.snapshot;
+  PhotoSnapshot  *snapshot      = oldSnapshot;
+  NSMutableSet   *changedIDs    = [[NSMutableSet alloc] init];
+  BOOL            isReloadAll   = NO;
+
+  for (PhotoSnapshot *next in snapshots)
+  {
+    if (next.category != oldSnapshot.category)  { continue; }
+
+    if (    (!next.diff) 
+         || (next.previousVersion != snapshot.version)
+         || [next.diff exceedsChangeRatio:PF_DIFF_REBUILD_RATIO] )
+    {
+      isReloadAll = YES;
+    }
+
+    [changedIDs addObjectsFromArray:next.diff.changedIDs];
+    snapshot = next;
+  }
+
+  if (snapshot == oldSnapshot)  { return; }
+
+
+  //
+  NSArray  *oldKeys = [self.photoArray valueForKey:FLICKR_PHOTO_ID];
+
+  self.snapshot          = snapshot;
+  self.taggedPhotoArray  = [snapshot sortedPhotoArrayForTag:self.photoSearchTag order:PFSortOrderTitle];
+  [self filterPhotoArray];
+
+  if (isReloadAll) {
+    [self.tableView reloadData];
+    return;
+  }
+
+
+  //
+  TableRowUpdates  *updates = [TableRowUpdates updatesFromKeys: oldKeys
+                                                        toKeys: [self.photoArray valueForKey:FLICKR_PHOTO_ID]
+                                                   changedKeys: changedIDs
+                                                     inSection: 0 ];
+  if (!updates) {
+    [self.tableView reloadData];
+    return;
+  }
+
+  [updates applyToTableView:self.tableView withRowAnimation:UITableViewRowAnimationAutomatic];
+
+} // photosUpdated:
+
+
+
+//----------------------- -o-
+// recentsUpdated:
+//
+// Move, insert or delete only the recents rows that changed.  A photo in 
+// photoIDs that keeps its row is reloaded.
+//
+- (void) recentsUpdated: (NSSet *)photoIDs
+{
+  NSArray  *oldKeys  = [self.photoArray valueForKey:FLICKR_PHOTO_ID];
+
+  self.photoArray = [PhotoFetch recentPhotos];
+
+  NSArray  *newKeys  = [self.photoArray valueForKey:FLICKR_PHOTO_ID];
+
+  if (([oldKeys count] > PF_RECENTS_MAX) || ([newKeys count] > PF_RECENTS_MAX)) {
+    [self.tableView reloadData];
+    return;
+  }
+
+
   //
-  if (! self.isNotRecentsList) { 
-    _photoArray = photoArray;
-    return; 
+  TableRowUpdates  *updates = [TableRowUpdates updatesFromKeys: oldKeys
+                                                        toKeys: newKeys
+                                                   changedKeys: photoIDs
+                                                     inSection: 0 ];
+  if (!updates) {
+    [self.tableView reloadData];
+    return;
+  }
+
+  [updates applyToTableView:self.tableView withRowAnimation:UITableViewRowAnimationAutomatic];
+}
+
+
+
+//----------------------- -o-
+// photoCacheChanged:
+//
+// Flip the cache state of rows showing the file, then redisplay those 
+// rows that are visible.
+//
+// NB  Rows are built from one lookupFiles:completion: of the cache, 
+//       which runs between the changes the cache publishes, so an update 
+//       is never lost between building rows and displaying them.
+//
+- (void) photoCacheChanged: (ChangeFeedEvent *)event
+{
+  if ([event.topic isEqualToString:DFC_NOTIFICATION_CLEARED]) {
+    [self.rows setAllCached:NO];
+    [self reconfigureVisibleRows:nil];
+    return;
   }
 
+  if (![event.payload isKindOfClass:[NSString class]])  { return; }
+
 
-  // Sort by title, then by description.
   //
-  NSSortDescriptor  *sd1 = [[NSSortDescriptor alloc]  initWithKey:FLICKR_PHOTO_TITLE        ascending:YES  selector:@selector(caseInsensitiveCompare:)];
-  NSSortDescriptor  *sd2 = [[NSSortDescriptor alloc]  initWithKey:FLICKR_PHOTO_DESCRIPTION  ascending:YES  selector:@selector(caseInsensitiveCompare:)];
+  NSIndexSet  *rowIndexes = [self.rows setCached: [event.topic isEqualToString:DFC_NOTIFICATION_FILE_ADDED]
+                                     forFileName: event.payload ];
+  if (rowIndexes) {
+    [self reconfigureVisibleRows:rowIndexes];
+  }
+}
+
+
+
+
+//-------------------------------------------- -o--
+#pragma mark - UISearchBar delegate.
+
+//----------------------- -o-
+// searchBar:textDidChange:
+//
+// NB  Answered from the snapshot text index;  photo entries are not rescanned.
+//
+- (void)  searchBar: (UISearchBar *)searchBar 
+      textDidChange: (NSString *)searchText
+{
+  self.searchQuery = searchText;
+
+  [self filterPhotoArray];
+  [self.tableView reloadData];
+}
 
-  NSArray *sortDescriptorList = [NSArray arrayWithObjects:sd1, sd2, nil];
 
-  _photoArray = [photoArray sortedArrayUsingDescriptors:sortDescriptorList];
+//----------------------- -o-
+- (void) searchBarSearchButtonClicked: (UISearchBar *)searchBar
+{
+  [searchBar resignFirstResponder];
 }
 
 
@@ -157,10 +384,6 @@
 - (IBAction) clearAllRecents: (UIBarButtonItem *)sender 
 {
   [PhotoFetch clearRecents];
-
-  [self setCacheSizeFreeDisplayOutput];
-
-  [self.tableView reloadData];
 }
 
 
@@ -298,9 +521,23 @@
 #pragma mark - Helper methods.
 
 //----------------------- -o-
+// titleForRow:
+// subtitleForRow:
+//
+// Read from rows once they are built for photoArray;  until then, title
+//   is taken from the photo entry and subtitle is left blank.
+//
+// NB  photoArray changes with every search keystroke, ahead of its rows.
+//       Subtitles wait for rebuildRows rather than touch the description
+//       or the cache per cell on the main queue.
+//
 - (NSString *) titleForRow: (NSUInteger)row
 {
-    return [self.photoArray[row][FLICKR_PHOTO_TITLE] description];
+  if (self.rows.photoArray == self.photoArray) {
+    return [[self.rows rowAtIndex:row] title];
+  }
+
+  return [self.photoArray[row][FLICKR_PHOTO_TITLE] description];
 }
 
 
@@ -308,15 +545,93 @@
 //----------------------- -o-
 - (NSString *) subtitleForRow: (NSUInteger)row
 {
-  NSString  *rowDescription   = [[self.photoArray[row] valueForKeyPath:FLICKR_PHOTO_DESCRIPTION] description];
-  NSString  *cachedIndicator  = @"";
+  if (self.rows.photoArray == self.photoArray) {
+    return [self.rows subtitleAtIndex:row];
+  }
+
+  return @"";
+}
+
+
+
+//----------------------- -o-
+// rebuildRows
+//
+// Look up which photos of photoArray are cached, build rows off the main 
+// queue, then show them on the main queue unless photoArray has since 
+// changed.
+//
+- (void) rebuildRows
+{
+  NSArray         *photoArray  = self.photoArray;
+  NSMutableArray  *fileNames   = [[NSMutableArray alloc] initWithCapacity:[photoArray count]];
+
+  for (NSDictionary *photoEntry in photoArray) {
+    [fileNames addObject:PF_PHOTOENTRY_FILENAME(photoEntry)];
+  }
+
+  [[PhotoFetch photoCache] lookupFiles: fileNames
+                            completion: ^(NSSet *cachedFileNames) 
+    {
+      PhotoListRows  *rows = [[PhotoListRows alloc] initWithPhotoArray:photoArray cachedFileNames:cachedFileNames];
+
+      dispatch_async(dispatch_get_main_queue(), ^{
+        if (self.photoArray != photoArray)  { return; }
+
+        self.rows = rows;
+        [self reconfigureVisibleRows:nil];
+      });
+    }];
+}
+
 
-  if ([[PhotoFetch photoCache] isFileCached:PF_PHOTOENTRY_FILENAME(self.photoArray[row])])
+
+//----------------------- -o-
+// reconfigureVisibleRows:
+//
+// Refresh text of visible cells in rowIndexes  -OR-  of all visible cells 
+// if rowIndexes is nil.  Rows are not reloaded.
+//
+- (void) reconfigureVisibleRows: (NSIndexSet *)rowIndexes
+{
+  for (NSIndexPath *indexPath in [self.tableView indexPathsForVisibleRows])
   {
-    cachedIndicator = @"[cached]  ";
+    if ((NSUInteger)indexPath.row >= [self.photoArray count])          { continue; }
+    if (rowIndexes && ![rowIndexes containsIndex:indexPath.row])        { continue; }
+
+    UITableViewCell  *cell = [self.tableView cellForRowAtIndexPath:indexPath];
+
+    cell.textLabel.text        = [self titleForRow:indexPath.row];
+    cell.detailTextLabel.text  = [self subtitleForRow:indexPath.row];
+  }
+}
+
+
+
+//----------------------- -o-
+// filterPhotoArray
+//
+// Set photoArray to those of taggedPhotoArray matching searchQuery.
+//
+- (void) filterPhotoArray
+{
+  if ([[PhotoTextIndex tokensForString:self.searchQuery] count] < 1) {
+    self.photoArray = self.taggedPhotoArray;
+    return;
+  }
+
+
+  //
+  NSSet           *matchingIDs  = [self.snapshot.textIndex photoIDsMatchingQuery:self.searchQuery];
+  NSMutableArray  *filtered     = [[NSMutableArray alloc] init];
+
+  for (NSDictionary *entry in self.taggedPhotoArray) {
+    if ([matchingIDs containsObject:[entry objectForKey:FLICKR_PHOTO_ID]]) {
+      [filtered addObject:entry];
+    }
   }
 
-  return [NSString stringWithFormat:@"%@%@", cachedIndicator, rowDescription];
+  self.photoArray = filtered;
 }
 
 
@@ -9,6 +9,7 @@
 #import "PhotoFetch.h"
 
 #import "Danaprajna.h"
+#import "TableRowUpdates.h"
 
 
 
@@ -12,15 +12,20 @@
 //-------------------------------------------- -o--
 @interface PhotoTagsTVC()
 
-  @property  (nonatomic, strong)  NSArray     *photoTagsSorted;
-  @property  (nonatomic)          PFCategory   currentFetchCategory;
+  @property  (nonatomic, strong)  NSArray        *photoTagsSorted;
+  @property  (nonatomic)          PFCategory      currentFetchCategory;
+
+  @property  (nonatomic, strong)  PhotoSnapshot  *displayedSnapshot;
+      // Source of photoTagsByOccurrence, if taken from the model.
 
 
   //
   - (NSString *) titleForRow:    (NSUInteger) row;
   - (NSString *) subtitleForRow: (NSUInteger) row;
   
-  - (void) fetchPhotos: (PFCategory)fetchCategory;
+  - (void) showCategory:     (PFCategory)category;
+  - (void) fetchPhotos:      (PFCategory)fetchCategory;
+  - (void) displaySnapshot:  (PhotoSnapshot *)snapshot;
 
 @end
 
@@ -69,11 +74,31 @@
 
 
  
+//----------------------- -o-
+// showCategory:
+//
+// Show tags of a category already in the model at once, otherwise fetch them.
+//
+- (void) showCategory: (PFCategory)category
+{
+  PhotoSnapshot  *snapshot = [PhotoFetch showCategory:category];
+
+  if (!snapshot) {
+    [self fetchPhotos:category];
+    return;
+  }
+
+  self.currentFetchCategory = category;
+  [self displaySnapshot:snapshot];
+}
+
+
+
 //----------------------- -o-
 // fetchPhotos:
 //
-// Initiate fetch of photo meta data, store in model.
-// Retreive tags from model.
+// Initiate paginated fetch of photo meta data, store in model.
+// Display each snapshot as pages arrive, updating only the rows that changed.
 //
 - (void) fetchPhotos: (PFCategory)fetchCategory
 {
@@ -83,33 +108,102 @@
   //
   [self.refreshControl beginRefreshing];
 
-  dispatch_async(DP_ASYNC_QUEUE(@"for fetching tags"), 
+  [QueueRegistry async:QRRoleFetch block:
   ^{
-    [Zed networkIndicatorEnable:YES];
-    [PhotoFetch fetchPhotos:fetchCategory];
-    [Zed networkIndicatorEnable:NO];
-
-    self.photoTagsByOccurrence = [PhotoFetch tagOccurrenceCount];
+    [PhotoFetch fetchPhotos: fetchCategory
+                     paging: PF_PAGING_DEFAULT
+                   progress: ^(PhotoSnapshot *snapshot) {
+                       if (self.currentFetchCategory == fetchCategory) {
+                         [self displaySnapshot:snapshot];
+                       }
+                     }];
 
     dispatch_async(dispatch_get_main_queue(), ^{
-      [self.tableView reloadData]; 
       [self.refreshControl endRefreshing];
     }); 
 
-  }); 
+  }]; 
 
 } // fetchPhotos: 
 
 
 
+//----------------------- -o-
+// displaySnapshot:
+//
+// Batch row updates when snapshot follows directly from the one displayed
+// and few photos changed, otherwise reload the whole table.
+//
+// NB  Main queue only.
+// NB  Tags of a snapshot are already sorted by its tag index;  the ivar
+//       is set directly so that setPhotoTagsByOccurrence: does not sort
+//       them again.
+//
+- (void) displaySnapshot: (PhotoSnapshot *)snapshot
+{
+  PhotoSnapshot  *oldSnapshot    = self.displayedSnapshot;
+  NSDictionary   *oldTagCounts   = self.photoTagsByOccurrence;
+  NSArray        *oldTagsSorted  = self.photoTagsSorted;
+
+  if (snapshot == oldSnapshot)  { return; }
+
+  self.displayedSnapshot  = snapshot;
+  _photoTagsByOccurrence  = snapshot.tagIndex.tagCounts;
+  self.photoTagsSorted    = snapshot.tagIndex.sortedTags;
+
+
+  //
+  PhotoSetDiff  *diff = snapshot.diff;
+
+  if (    (!oldSnapshot) || (!diff) 
+       || (oldSnapshot.category != snapshot.category)
+       || (oldSnapshot.version != snapshot.previousVersion)
+       || [diff exceedsChangeRatio:PF_DIFF_REBUILD_RATIO] )
+  {
+    [self.tableView reloadData];
+    return;
+  }
+
+  if ([diff isEmpty])  { return; }
+
+
+  //
+  NSMutableSet  *changedTags = [[NSMutableSet alloc] init];
+
+  for (NSString *tag in self.photoTagsSorted) {
+    if (! [[oldTagCounts objectForKey:tag] isEqual:[self.photoTagsByOccurrence objectForKey:tag]]) {
+      [changedTags addObject:tag];
+    }
+  }
+
+  TableRowUpdates  *updates = [TableRowUpdates updatesFromKeys: oldTagsSorted
+                                                        toKeys: self.photoTagsSorted
+                                                   changedKeys: changedTags
+                                                     inSection: 0 ];
+  if (!updates) {
+    [self.tableView reloadData];
+    return;
+  }
+
+  [updates applyToTableView:self.tableView withRowAnimation:UITableViewRowAnimationAutomatic];
+
+} // displaySnapshot:
+
+
+
+
 //-------------------------------------------- -o--
 #pragma mark - Getters/setters.
 
 //----------------------- -o-
+// setPhotoTagsByOccurrence:
+//
+// NB  For counts from outside a snapshot;  see displaySnapshot:.
+//
 - (void) setPhotoTagsByOccurrence: (NSDictionary *)photoTagsByOccurrence
 {
-  _photoTagsByOccurrence = photoTagsByOccurrence;
-  self.photoTagsSorted = [[self.photoTagsByOccurrence allKeys] sortedArrayUsingComparator:DP_BLOCK_CMPSTR_LOCINS_LT];
+  _photoTagsByOccurrence  = photoTagsByOccurrence;
+  self.photoTagsSorted    = [[self.photoTagsByOccurrence allKeys] sortedArrayUsingComparator:DP_BLOCK_CMPSTR_LOCINS_LT];
 }
 
 
@@ -193,14 +287,14 @@
 //----------------------- -o-
 - (IBAction) showStanfordTags: (UIBarButtonItem *)sender 
 {
-  [self fetchPhotos:PFCategoryStanford];
+  [self showCategory:PFCategoryStanford];
 }
 
 
 //----------------------- -o-
 - (IBAction) showLatestGeoTags: (UIBarButtonItem *)sender
 {
-  [self fetchPhotos:PFCategoryLatestGeoreferenced];
+  [self showCategory:PFCategoryLatestGeoreferenced];
 }
 
 
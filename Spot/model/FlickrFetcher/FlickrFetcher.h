@@ -21,6 +21,15 @@
 #define FLICKR_PHOTO_PLACE_NAME   @"derived_place"         // doesn't work for Stanford photos XXX
 #define FLICKR_TAGS               @"tags"
 
+// tags in the place dictionaries returned from topPlaces
+//
+#define FLICKR_PLACE_ID           @"place_id"              // For photosInPlace:maxResults:
+
+
+// path of REST requests, relative to api.flickr.com or baseURL
+//
+#define FLICKR_REST_PATH          @"/services/rest/"
+
 
 #define NSLOG_FLICKR    NO 
 //#define NSLOG_FLICKR    YES     // DEBUG
@@ -38,6 +47,17 @@ typedef enum {
 //------------------------------------------------- -o--
 @interface FlickrFetcher : NSObject
 
+  // send requests somewhere other than Flickr, such as FlickrStandIn
+  //   REST requests go to baseURL + FLICKR_REST_PATH, photos to
+  //   baseURL + "/farm<farm>/<server>/<id>_<secret>_<format>.<type>"
+  //   nil (the default) restores api.flickr.com and farm<farm>.static.flickr.com
+  //
+  // NB  Set before fetching;  requests already built keep their URL.
+  //
+  + (void)    setBaseURL: (NSURL *)baseURL;
+  + (NSURL *) baseURL;
+
+
   // get the URL for a Flickr photo given a dictionary of Flickr photo info
   //  (which can be gotten using stanfordPhotos or latestGeoreferencedPhotos)
   //
@@ -51,5 +71,23 @@ typedef enum {
   + (NSArray *) stanfordPhotos;
   + (NSArray *) topPlaces;
 
+
+  // fetch one page of a paginated photo search
+  //   pageCount (optional) receives number of pages available
+  //
+  + (NSArray *) latestGeoreferencedPhotosPage: (NSUInteger)page
+                                      perPage: (NSUInteger)perPage
+                                    pageCount: (NSUInteger *)pageCount;
+
+  + (NSArray *) stanfordPhotosPage: (NSUInteger)page
+                           perPage: (NSUInteger)perPage
+                         pageCount: (NSUInteger *)pageCount;
+
+
+  // fetch photos in one place returned by topPlaces
+  //
+  + (NSArray *) photosInPlace: (NSDictionary *)place 
+                   maxResults: (int)maxResults;
+
 @end
 
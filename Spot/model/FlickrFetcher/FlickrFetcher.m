@@ -9,30 +9,77 @@
 #import "FlickrFetcher.h"
 #import "FlickrAPIKey.h"
 
+#import "Trace.h"
 
 
 
-//------------------------------------------- -o--
-#define FLICKR_PLACE_ID  @"place_id" 	// For photosInPlace:maxResults:
-
-
 
 //------------------------------------------- -o--
 @interface FlickrFetcher()
 
   + (NSDictionary *) executeFlickrFetch: (NSString *)query;
 
+  + (NSArray *) photosFromPagedFetch: (NSString *)query
+                           pageCount: (NSUInteger *)pageCount;
+
   + (NSString *) urlStringForPhoto: (NSDictionary *)photo 
                             format: (FlickrPhotoFormat)format;
 
+  + (NSString *) restURLString;
+
 @end
 
 
 
 
+//------------------------------------------- -o--
+static NSURL  *baseURL = nil;
+
+
+
+
 //------------------------------------------- -o--
 @implementation FlickrFetcher
 
+//---------------- -o-
+// setBaseURL:
+//
+// NB  Trailing slash is dropped.  nil restores Flickr.
+//
++ (void) setBaseURL: (NSURL *)url
+{
+    NSString *urlString = [url absoluteString];
+
+    while ([urlString hasSuffix:@"/"]) {
+      urlString = [urlString substringToIndex:[urlString length] - 1];
+    }
+
+    @synchronized (self) {
+      baseURL = url ? [NSURL URLWithString:urlString] : nil;
+    }
+}
+
+
+//---------------- -o-
++ (NSURL *) baseURL
+{
+    @synchronized (self) {
+      return baseURL;
+    }
+}
+
+
+//---------------- -o-
++ (NSString *) restURLString
+{
+    NSURL *url = [self baseURL];
+
+    return url ? [[url absoluteString] stringByAppendingString:FLICKR_REST_PATH]
+               : @"http://api.flickr.com" FLICKR_REST_PATH;
+}
+
+
+
 //---------------- -o-
 // executeFlickrFetch:
 //
@@ -47,14 +94,25 @@
       NSLog(@"[%@ %@] sent %@", NSStringFromClass([self class]), NSStringFromSelector(_cmd), query);
     }
 
+    DPTraceSpan  requestSpan     = DP_TRACE_BEGIN("flickr.request");
+    uint64_t     requestStarted  = [NetworkActivity beginRequest];
+
     NSData *jsonData = 
       [[NSString stringWithContentsOfURL:[NSURL URLWithString:query] encoding:NSUTF8StringEncoding error:nil] dataUsingEncoding:NSUTF8StringEncoding];
     NSError *error = nil;
 
+    [NetworkActivity endRequest:requestStarted bytes:[jsonData length] success:(nil != jsonData)];
+    DP_TRACE_END(requestSpan);
+
+
+    DPTraceSpan  jsonSpan = DP_TRACE_BEGIN("flickr.json");
+
     NSDictionary *results = 
       jsonData ? [NSJSONSerialization JSONObjectWithData:jsonData options:NSJSONReadingMutableContainers|NSJSONReadingMutableLeaves error:&error] 
                : nil;
 
+    DP_TRACE_END(jsonSpan);
+
     if (error) {
       NSLog(@"[%@ %@] JSON error: %@", NSStringFromClass([self class]), NSStringFromSelector(_cmd), error.localizedDescription);
     }
@@ -71,7 +129,7 @@
 //---------------- -o-
 + (NSArray *) latestGeoreferencedPhotos
 {
-    NSString *request = [NSString stringWithFormat:@"http://api.flickr.com/services/rest/?method=flickr.photos.search&per_page=500&license=1,2,4,7&has_geo=1&extras=original_format,tags,description,geo,date_upload,owner_name,place_url"];
+    NSString *request = [NSString stringWithFormat:@"%@?method=flickr.photos.search&per_page=500&license=1,2,4,7&has_geo=1&extras=original_format,tags,description,geo,date_upload,owner_name,place_url", [self restURLString]];
     return [[self executeFlickrFetch:request] valueForKeyPath:@"photos.photo"];
 }
 
@@ -79,15 +137,55 @@
 //---------------- -o-
 + (NSArray *) stanfordPhotos
 {
-    NSString *request = @"http://api.flickr.com/services/rest/?user_id=48247111@N07&format=json&nojsoncallback=1&extras=original_format,tags,description,geo,date_upload,owner_name&page=1&method=flickr.photos.search";
+    NSString *request = [NSString stringWithFormat:@"%@?user_id=48247111@N07&format=json&nojsoncallback=1&extras=original_format,tags,description,geo,date_upload,owner_name&page=1&method=flickr.photos.search", [self restURLString]];
     return [[self executeFlickrFetch:request] valueForKeyPath:@"photos.photo"];
 }
 
 
+//---------------- -o-
++ (NSArray *) latestGeoreferencedPhotosPage: (NSUInteger)page
+                                    perPage: (NSUInteger)perPage
+                                  pageCount: (NSUInteger *)pageCount
+{
+    NSString *request = [NSString stringWithFormat:@"%@?method=flickr.photos.search&page=%lu&per_page=%lu&license=1,2,4,7&has_geo=1&extras=original_format,tags,description,geo,date_upload,owner_name,place_url", [self restURLString], (unsigned long)page, (unsigned long)perPage];
+    return [self photosFromPagedFetch:request pageCount:pageCount];
+}
+
+
+//---------------- -o-
++ (NSArray *) stanfordPhotosPage: (NSUInteger)page
+                         perPage: (NSUInteger)perPage
+                       pageCount: (NSUInteger *)pageCount
+{
+    NSString *request = [NSString stringWithFormat:@"%@?user_id=48247111@N07&format=json&nojsoncallback=1&extras=original_format,tags,description,geo,date_upload,owner_name&page=%lu&per_page=%lu&method=flickr.photos.search", [self restURLString], (unsigned long)page, (unsigned long)perPage];
+    return [self photosFromPagedFetch:request pageCount:pageCount];
+}
+
+
+//---------------- -o-
+// photosFromPagedFetch:pageCount:
+//
+// NB  Flickr reports "pages" as either number or string.
+//
++ (NSArray *) photosFromPagedFetch: (NSString *)query
+                         pageCount: (NSUInteger *)pageCount
+{
+    NSDictionary *results = [self executeFlickrFetch:query];
+
+    if (pageCount) {
+        NSInteger pages = [[results valueForKeyPath:@"photos.pages"] integerValue];
+        *pageCount = (pages > 0) ? (NSUInteger)pages : 0;
+    }
+
+    return [results valueForKeyPath:@"photos.photo"];
+}
+
+
+
 //---------------- -o-
 + (NSArray *) topPlaces
 {
-    NSString *request = [NSString stringWithFormat:@"http://api.flickr.com/services/rest/?method=flickr.places.getTopPlacesList&place_type_id=7"];
+    NSString *request = [NSString stringWithFormat:@"%@?method=flickr.places.getTopPlacesList&place_type_id=7", [self restURLString]];
     return [[self executeFlickrFetch:request] valueForKeyPath:@"places.place"];
 }
 
@@ -96,8 +194,8 @@
 //---------------- -o-
 // photosInPlace:maxResults:
 //
-// NB  Unused.
 // NB  Most photo dictionary entries already have "place_id" (FLICKR_PLACE_NAME).
+// NB  Called concurrently, once per place, by PlacePhotoIndex.
 //
 + (NSArray *) photosInPlace: (NSDictionary *)place 
                  maxResults: (int)maxResults
@@ -107,12 +205,14 @@
 
     if (placeId) 
     {
-        NSString *request = [NSString stringWithFormat:@"http://api.flickr.com/services/rest/?method=flickr.photos.search&place_id=%@&per_page=%d&extras=original_format,tags,description,geo,date_upload,owner_name,place_url", placeId, maxResults];
+        NSString *request = [NSString stringWithFormat:@"%@?method=flickr.photos.search&place_id=%@&per_page=%d&extras=original_format,tags,description,geo,date_upload,owner_name,place_url", [self restURLString], placeId, maxResults];
         NSString *placeName = [place objectForKey:FLICKR_PLACE_NAME];
 
         photos = [[self executeFlickrFetch:request] valueForKeyPath:@"photos.photo"];
-        for (NSMutableDictionary *photo in photos) {
-            [photo setObject:placeName forKey:FLICKR_PHOTO_PLACE_NAME];
+        if (placeName) {
+            for (NSMutableDictionary *photo in photos) {
+                [photo setObject:placeName forKey:FLICKR_PHOTO_PLACE_NAME];
+            }
         }
     }
 
@@ -156,7 +256,10 @@
     case FlickrPhotoFormatOriginal:     formatString = @"o"; break;
   }
 
-  return [NSString stringWithFormat:@"http://farm%@.static.flickr.com/%@/%@_%@_%@.%@", farm, server, photo_id, secret, formatString, fileType];
+  NSString *base = [self baseURL] ? [[[self baseURL] absoluteString] stringByAppendingFormat:@"/farm%@", farm]
+                                  : [NSString stringWithFormat:@"http://farm%@.static.flickr.com", farm];
+
+  return [NSString stringWithFormat:@"%@/%@/%@_%@_%@.%@", base, server, photo_id, secret, formatString, fileType];
 }
 
 
@@ -0,0 +1,85 @@
+//
+// FlickrStandIn.h
+//
+// Local stand-in for Flickr:  an HTTP server on the loopback interface
+// that replays recorded REST responses and photos from a fixture corpus,
+// with injected latency, bandwidth limit, error rate and photo size.
+// Send FlickrFetcher to it with [FlickrFetcher setBaseURL:standIn.baseURL].
+//
+// Corpus layout, under corpusURL:
+//
+//   rest/<method>[_user_id-<id>][_place_id-<id>][_page-<n>].json
+//   images/<id>_<secret>_<format>.<type>
+//   images/default.jpg
+//
+// A REST request is answered by the most specific file present:  every
+// key, then without page, then method alone.  A photo is answered by its
+// own file, then default.jpg, then a synthetic JPEG.  Anything else is 404.
+//
+// Injected faults are seeded.  Whether a request fails and how much
+// latency jitter it gets depend only on seed, the fixture it maps to and
+// how many times it has been asked for, so a run repeats exactly
+// whatever order concurrent requests arrive in.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FlickrFetcher.h"
+
+#import "Danaprajna.h"
+
+
+
+//------------------------------------------------------------ -o-
+#define FSI_IMAGE_DEFAULT         @"images/default.jpg"
+#define FSI_IMAGEBYTES_DEFAULT    (64 * 1024)     // Synthetic photos, when imageBytes is 0.
+
+
+typedef struct {
+  uint64_t  requests;
+  uint64_t  replayed;         // Answered from the corpus.
+  uint64_t  recorded;         // Fetched from Flickr and saved, with recordMissing.
+  uint64_t  synthesized;      // Photos not in the corpus.
+  uint64_t  notFound;
+  uint64_t  injectedErrors;
+  uint64_t  bytes;            // Response bodies sent in full.
+} FSIStats;
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface FlickrStandIn : NSObject
+
+  @property  (readonly, strong, nonatomic)  NSURL     *corpusURL;
+  @property  (readonly, nonatomic)          uint16_t   port;
+  @property  (readonly, strong, nonatomic)  NSURL     *baseURL;
+      // nil until started.
+
+
+  // Injection.  Set before start:.
+  //
+  @property  (nonatomic)  NSTimeInterval  latency;          // Before the first byte of every response.
+  @property  (nonatomic)  NSTimeInterval  latencyJitter;    // Up to this much more, seeded.
+  @property  (nonatomic)  NSUInteger      bytesPerSecond;   // Per connection.  0 is unlimited.
+  @property  (nonatomic)  double          errorRate;        // Fraction answered with 503.
+  @property  (nonatomic)  NSUInteger      imageBytes;       // Photos padded to at least this size.
+  @property  (nonatomic)  uint32_t        seed;
+
+  @property  (nonatomic)  BOOL  recordMissing;
+      // Fetch requests missing from the corpus from Flickr, save them
+      //   under the names they would be replayed from, then answer them.
+
+
+  //
+  - (id) initWithCorpusURL: (NSURL *)corpusURL;
+
+  - (BOOL) start: (uint16_t)port;       // 0 picks a free port.
+  - (void) stop;
+
+  - (FSIStats) stats;
+
+  + (NSArray *) fixtureNamesForURL: (NSURL *)url;
+
+@end
+
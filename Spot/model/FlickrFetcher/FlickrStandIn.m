@@ -0,0 +1,724 @@
+//
+// FlickrStandIn.m
+//
+// One listening socket, watched by a dispatch source on acceptQueue.
+// Each connection is read, answered and closed on connectionQueue.
+// Latency and bandwidth are injected with dispatch_after, so a slow
+// response holds no thread while it waits.
+//
+// HTTP/1.0, GET only, one request per connection.
+//
+
+#import "FlickrStandIn.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+
+
+//------------------------------------------------------------ -o-
+#define FSI_REQUEST_BYTES_MAX     8192
+#define FSI_READ_TIMEOUT          5         // Seconds.
+#define FSI_LISTEN_BACKLOG        128
+
+#define FSI_SEND_INTERVAL         0.05      // Seconds per chunk, with bytesPerSecond.
+#define FSI_CHUNK_BYTES_MIN       1024
+
+#define FSI_FLICKR_API_HOST       @"http://api.flickr.com"
+#define FSI_FLICKR_PHOTO_HOST     @"http://farm%@.static.flickr.com"
+
+#ifdef MSG_NOSIGNAL
+#  define FSI_SEND_FLAGS  MSG_NOSIGNAL
+#else
+#  define FSI_SEND_FLAGS  0
+#endif
+
+
+// 8x8 grey baseline JPEG.  Synthetic photos are this, padded after
+//   the end of image marker, which decoders ignore.
+//
+static const uint8_t  syntheticJPEG[] = {
+  0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+  0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+  0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+  0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+  0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+  0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xff, 0xc0, 0x00, 0x0b, 0x08, 0x00, 0x08,
+  0x00, 0x08, 0x01, 0x01, 0x11, 0x00, 0xff, 0xc4, 0x00, 0x14, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0xff, 0xc4, 0x00, 0x14,
+  0x10, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0xff, 0xda, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3f, 0x00, 0x48, 0x0f, 0xff, 0xd9,
+};
+
+
+
+
+//------------------------------------------------------------ -o-
+// RETURN:  YES if part may appear in a fixture name:  letters, digits and
+//            ._-@ only, and no "..".  @ appears in Flickr user IDs.
+//
+static BOOL
+fsiIsFixtureNamePart (NSString *part)
+{
+  static NSCharacterSet   *unsafe = nil;
+  static dispatch_once_t   onceToken;
+
+  dispatch_once(&onceToken, ^{
+    unsafe = [[NSCharacterSet characterSetWithCharactersInString:
+                @"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789._-@"] invertedSet];
+  });
+
+  return    ([part length] > 0)
+         && (NSNotFound == [part rangeOfCharacterFromSet:unsafe].location)
+         && (NSNotFound == [part rangeOfString:@".."].location);
+}
+
+
+// FNV-1a over name, mixed with seed and attempt, then finished
+//   as in MurmurHash3.
+//
+static uint32_t
+fsiDraw (uint32_t seed, NSString *name, NSUInteger attempt)
+{
+  const char  *bytes = [name UTF8String];
+  uint32_t     hash  = 2166136261u ^ seed;
+
+  for ( ; bytes && *bytes; bytes++) {
+    hash = (hash ^ (uint8_t) *bytes) * 16777619u;
+  }
+
+  hash ^= (uint32_t) attempt * 0x9e3779b9u;
+
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+
+  return hash;
+}
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface FlickrStandIn()
+
+  @property  (readwrite, strong, nonatomic)  NSURL     *corpusURL;
+  @property  (readwrite, nonatomic)          uint16_t   port;
+  @property  (readwrite, strong, nonatomic)  NSURL     *baseURL;
+
+  @property  (strong, nonatomic)  dispatch_queue_t    acceptQueue;
+  @property  (strong, nonatomic)  dispatch_queue_t    connectionQueue;     // Concurrent.
+  @property  (strong, nonatomic)  dispatch_source_t   acceptSource;
+
+
+  // @synchronized (self).
+  //
+  @property  (strong, nonatomic)  NSMutableDictionary  *attempts;         // Fixture name --> NSNumber.
+  @property  (nonatomic)          FSIStats              counters;
+
+
+  - (void) acceptConnections: (int)listenSocket;
+  - (void) serveConnection:   (int)socket;
+
+  - (NSString *) readRequestTarget: (int)socket
+                            status: (NSInteger *)status;
+
+  - (NSData *) bodyForURL: (NSURL *)url
+                   status: (NSInteger *)status
+              contentType: (NSString **)contentType;
+
+  - (NSData *) recordFixture: (NSString *)name
+                      forURL: (NSURL *)url;
+
+  - (void) sendResponse: (NSData *)response
+             fromOffset: (NSUInteger)offset
+               onSocket: (int)socket
+              bodyBytes: (NSUInteger)bodyBytes;
+
+  - (void) count: (uint64_t *)counter
+              by: (uint64_t)amount;
+
+  + (NSDictionary *) parametersForQuery: (NSString *)query;
+  + (NSURL *)        flickrURLForURL:    (NSURL *)url;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation FlickrStandIn
+
+#pragma mark - Constructors.
+
+//-------------------------- -o-
+- (id) initWithCorpusURL: (NSURL *)corpusURL
+{
+  if (!corpusURL) {
+    DP_LOG_ERROR(@"corpusURL is nil.");
+    return nil;
+  }
+
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+
+  //
+  self.corpusURL        = corpusURL;
+  self.attempts         = [[NSMutableDictionary alloc] init];
+
+  self.acceptQueue      = dispatch_queue_create("FlickrStandIn accept", DISPATCH_QUEUE_SERIAL);
+  self.connectionQueue  = dispatch_queue_create("FlickrStandIn connection", DISPATCH_QUEUE_CONCURRENT);
+
+  return self;
+}
+
+
+//-------------------------- -o-
+- (void) dealloc
+{
+  [self stop];
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//-------------------------- -o-
+// start:
+//
+// Listen on 127.0.0.1.
+//
+// RETURN:  YES if listening  -OR-  NO.
+//
+- (BOOL) start: (uint16_t)port
+{
+  if (self.acceptSource) {
+    DP_LOG_WARNING(@"Already listening on port %u.", self.port);
+    return YES;
+  }
+
+
+  //
+  struct sockaddr_in  address;
+  socklen_t           addressLength  = sizeof(address);
+  int                 on             = 1;
+  int                 listenSocket   = socket(AF_INET, SOCK_STREAM, 0);
+
+  if (listenSocket < 0) {
+    DP_LOG_ERROR(@"socket() failed:  %s", strerror(errno));
+    return NO;
+  }
+
+  memset(&address, 0, sizeof(address));
+  address.sin_family       = AF_INET;
+  address.sin_port         = htons(port);
+  address.sin_addr.s_addr  = htonl(INADDR_LOOPBACK);
+
+  setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+  if (   (bind(listenSocket, (struct sockaddr *) &address, sizeof(address)) < 0)
+      || (listen(listenSocket, FSI_LISTEN_BACKLOG) < 0)
+      || (getsockname(listenSocket, (struct sockaddr *) &address, &addressLength) < 0) )
+  {
+    DP_LOG_ERROR(@"Cannot listen on port %u:  %s", port, strerror(errno));
+    close(listenSocket);
+    return NO;
+  }
+
+  fcntl(listenSocket, F_SETFL, fcntl(listenSocket, F_GETFL) | O_NONBLOCK);
+
+  self.port     = ntohs(address.sin_port);
+  self.baseURL  = [NSURL URLWithString:DP_STRWFMT(@"http://127.0.0.1:%u", self.port)];
+
+
+  //
+  __weak FlickrStandIn  *weakSelf  = self;
+  dispatch_source_t      source    =
+    dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t) listenSocket, 0, self.acceptQueue);
+
+  dispatch_source_set_event_handler(source, ^{ [weakSelf acceptConnections:listenSocket]; });
+  dispatch_source_set_cancel_handler(source, ^{ close(listenSocket); });
+
+  self.acceptSource = source;
+  dispatch_resume(source);
+
+  DP_LOG_INFO(@"Serving %@ at %@", [self.corpusURL path], self.baseURL);
+
+  return YES;
+}
+
+
+//-------------------------- -o-
+// stop
+//
+// NB  Connections already accepted are still answered.
+//
+- (void) stop
+{
+  if (self.acceptSource) {
+    dispatch_source_cancel(self.acceptSource);
+    self.acceptSource = nil;
+  }
+}
+
+
+
+//-------------------------- -o-
+- (FSIStats) stats
+{
+  @synchronized (self) {
+    return self.counters;
+  }
+}
+
+
+
+//-------------------------- -o-
+// fixtureNamesForURL:
+//
+// RETURN:  Corpus-relative names that may answer url, most specific
+//            first  -OR-  empty array.
+//
+// NB  A method, parameter or file name that could reach outside rest/
+//       or images/ of the corpus answers nothing.  Names are also where
+//       missing fixtures are recorded.
+//
++ (NSArray *) fixtureNamesForURL: (NSURL *)url
+{
+  NSString        *path   = [url path];
+  NSMutableArray  *names  = [[NSMutableArray alloc] init];
+
+
+  // REST.  NSURL drops the trailing slash from path.
+  //
+  if ([[path stringByAppendingString:@"/"] isEqualToString:FLICKR_REST_PATH])
+  {
+    NSDictionary  *parameters = [self parametersForQuery:[url query]];
+    NSString      *method     = parameters[@"method"];
+
+    if (!fsiIsFixtureNamePart(method))  { return names; }
+
+    for (NSString *key in @[ @"user_id", @"place_id", @"page" ]) {
+      if (parameters[key] && !fsiIsFixtureNamePart(parameters[key]))  { return names; }
+    }
+
+    NSMutableString  *name = [method mutableCopy];
+
+    for (NSString *key in @[ @"user_id", @"place_id" ]) {
+      if (parameters[key])  { [name appendFormat:@"_%@-%@", key, parameters[key]]; }
+    }
+
+    if (parameters[@"page"]) {
+      [names addObject:DP_STRWFMT(@"rest/%@_page-%@.json", name, parameters[@"page"])];
+    }
+
+    [names addObject:DP_STRWFMT(@"rest/%@.json", name)];
+
+    if (![name isEqualToString:method]) {
+      [names addObject:DP_STRWFMT(@"rest/%@.json", method)];
+    }
+
+    return names;
+  }
+
+
+  // Photos:  /farm<farm>/<server>/<file>
+  //
+  NSArray  *components = [path pathComponents];
+
+  if ((4 == [components count]) && [components[1] hasPrefix:@"farm"] && fsiIsFixtureNamePart(components[3])) {
+    [names addObject:DP_STRWFMT(@"images/%@", components[3])];
+    [names addObject:FSI_IMAGE_DEFAULT];
+  }
+
+  return names;
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Private methods.
+
+//-------------------------- -o-
+- (void) acceptConnections: (int)listenSocket
+{
+  for (;;)
+  {
+    int  connection = accept(listenSocket, NULL, NULL);
+
+    if (connection < 0) {
+      if ((EAGAIN != errno) && (EWOULDBLOCK != errno) && (EINTR != errno)) {
+        DP_LOG_ERROR(@"accept() failed:  %s", strerror(errno));
+      }
+      return;
+    }
+
+
+    //
+    struct timeval  timeout = { FSI_READ_TIMEOUT, 0 };
+
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+#ifdef SO_NOSIGPIPE
+    int  on = 1;
+    setsockopt(connection, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+    dispatch_async(self.connectionQueue, ^{ [self serveConnection:connection]; });
+  }
+}
+
+
+
+//-------------------------- -o-
+// serveConnection:
+//
+// Draw for this request, then answer after the injected latency.
+//
+- (void) serveConnection: (int)socket
+{
+  NSInteger   status       = 200;
+  NSString   *contentType  = @"text/plain";
+  NSData     *body         = nil;
+  NSString   *target       = [self readRequestTarget:socket status:&status];
+
+  [self count:&_counters.requests by:1];
+
+
+  //
+  NSURL       *url      = target ? [NSURL URLWithString:target relativeToURL:self.baseURL] : nil;
+  NSString    *name     = url ? [[FlickrStandIn fixtureNamesForURL:url] firstObject] : nil;
+  NSUInteger   attempt  = 0;
+
+  if (!name)  { name = target; }
+
+  if (name) {
+    @synchronized (self) {
+      attempt = [self.attempts[name] unsignedIntegerValue];
+      self.attempts[name] = @(attempt + 1);
+    }
+  }
+
+  uint32_t        draw     = fsiDraw(self.seed, name, attempt);
+  double          failure  = (draw & 0xffff) / 65536.0;
+  NSTimeInterval  delay    = self.latency + self.latencyJitter * ((draw >> 16) / 65536.0);
+
+  if (200 != status) {
+    // Bad request;  answered as is.
+
+  } else if (failure < self.errorRate) {
+    status = 503;
+    [self count:&_counters.injectedErrors by:1];
+
+  } else {
+    body = [self bodyForURL:url status:&status contentType:&contentType];
+  }
+
+
+  //
+  NSString       *reason    = (200 == status) ? @"OK"
+                            : (404 == status) ? @"Not Found"
+                            : (405 == status) ? @"Method Not Allowed"
+                            : (503 == status) ? @"Service Unavailable"
+                            :                   @"Bad Request";
+  NSString       *header    = DP_STRWFMT(@"HTTP/1.0 %ld %@\r\nContent-Type: %@\r\nContent-Length: %lu\r\nConnection: close\r\n\r\n",
+                                           (long)status, reason, contentType, (unsigned long)[body length]);
+  NSMutableData  *response  = [[header dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+
+  if (body)  { [response appendData:body]; }
+
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), self.connectionQueue, ^{
+    [self sendResponse:response fromOffset:0 onSocket:socket bodyBytes:[body length]];
+  });
+}
+
+
+
+//-------------------------- -o-
+// readRequestTarget:status:
+//
+// RETURN:  Target of the request line, eg "/services/rest/?method=..."
+//            -OR-  nil, with status set.
+//
+- (NSString *) readRequestTarget: (int)socket
+                          status: (NSInteger *)status
+{
+  char     buffer[FSI_REQUEST_BYTES_MAX + 1];
+  size_t   length  = 0;
+
+  while (length < FSI_REQUEST_BYTES_MAX)
+  {
+    ssize_t  received = recv(socket, buffer + length, FSI_REQUEST_BYTES_MAX - length, 0);
+
+    if ((received < 0) && (EINTR == errno))  { continue; }
+    if (received <= 0)                       { break; }
+
+    length         += (size_t) received;
+    buffer[length]  = '\0';
+
+    if (strstr(buffer, "\r\n\r\n"))  { break; }
+  }
+
+  buffer[length] = '\0';
+
+
+  //
+  NSString  *request  = [[NSString alloc] initWithBytes:buffer length:length encoding:NSUTF8StringEncoding];
+  NSArray   *words    = [[[request componentsSeparatedByString:@"\r\n"] firstObject] componentsSeparatedByString:@" "];
+
+  if (([words count] < 3) || ![words[1] hasPrefix:@"/"]) {
+    *status = 400;
+    return nil;
+  }
+
+  if (![words[0] isEqualToString:@"GET"]) {
+    *status = 405;
+    return nil;
+  }
+
+  return words[1];
+}
+
+
+
+//-------------------------- -o-
+// bodyForURL:status:contentType:
+//
+// From the corpus, from Flickr when recordMissing, or synthetic.
+// Photos are padded to imageBytes.
+//
+- (NSData *) bodyForURL: (NSURL *)url
+                 status: (NSInteger *)status
+            contentType: (NSString **)contentType
+{
+  NSArray  *names    = [FlickrStandIn fixtureNamesForURL:url];
+  BOOL      isImage  = [[names lastObject] isEqualToString:FSI_IMAGE_DEFAULT];
+  NSData   *data     = nil;
+
+  if ([names count] <= 0) {
+    *status = 404;
+    [self count:&_counters.notFound by:1];
+    return nil;
+  }
+
+  for (NSString *name in names) {
+    if ((data = [NSData dataWithContentsOfURL:DP_URL_PLUSFILE(self.corpusURL, name)]))  { break; }
+  }
+
+  if (data) {
+    [self count:&_counters.replayed by:1];
+
+  } else if (self.recordMissing && (data = [self recordFixture:[names firstObject] forURL:url])) {
+    [self count:&_counters.recorded by:1];
+
+  } else if (isImage) {
+    data = [NSData dataWithBytes:syntheticJPEG length:sizeof(syntheticJPEG)];
+    [self count:&_counters.synthesized by:1];
+
+  } else {
+    *status = 404;
+    [self count:&_counters.notFound by:1];
+    return nil;
+  }
+
+
+  //
+  if (!isImage) {
+    *contentType = @"application/json";
+    return data;
+  }
+
+  *contentType = @"image/jpeg";
+
+  NSUInteger  imageBytes = self.imageBytes;
+
+  if ((0 == imageBytes) && (sizeof(syntheticJPEG) == [data length]))  { imageBytes = FSI_IMAGEBYTES_DEFAULT; }
+
+  if (imageBytes > [data length]) {
+    NSMutableData  *padded = [data mutableCopy];
+    [padded setLength:imageBytes];
+    data = padded;
+  }
+
+  return data;
+}
+
+
+
+//-------------------------- -o-
+// recordFixture:forURL:
+//
+// NB  Synchronous fetch on connectionQueue.  REST responses are only
+//       kept when Flickr says "ok".
+//
+// RETURN:  Data saved  -OR-  nil.
+//
+- (NSData *) recordFixture: (NSString *)name
+                    forURL: (NSURL *)url
+{
+  NSURL   *flickrURL  = [FlickrStandIn flickrURLForURL:url];
+  NSData  *data       = flickrURL ? [NSData dataWithContentsOfURL:flickrURL] : nil;
+
+  if (!data) {
+    DP_LOG_WARNING(@"Nothing to record from %@", flickrURL);
+    return nil;
+  }
+
+  if ([name hasPrefix:@"rest/"]) {
+    NSDictionary  *results = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+
+    if (![results isKindOfClass:[NSDictionary class]] || ![@"ok" isEqual:results[@"stat"]]) {
+      DP_LOG_WARNING(@"Not recording failed request %@", flickrURL);
+      return nil;
+    }
+  }
+
+
+  //
+  NSURL    *fileURL  = DP_URL_PLUSFILE(self.corpusURL, name);
+  NSError  *error    = nil;
+
+  if (   ![[NSFileManager defaultManager] createDirectoryAtURL: [fileURL URLByDeletingLastPathComponent]
+                                   withIntermediateDirectories: YES
+                                                    attributes: nil
+                                                         error: &error]
+      || ![data writeToURL:fileURL options:NSDataWritingAtomic error:&error] )
+  {
+    DP_LOG_NSERROR(error);
+  }
+
+  return data;
+}
+
+
+
+//-------------------------- -o-
+// sendResponse:fromOffset:onSocket:bodyBytes:
+//
+// All at once, or one chunk per FSI_SEND_INTERVAL under bytesPerSecond.
+// Closes the socket when done or when the client goes away.
+//
+- (void) sendResponse: (NSData *)response
+           fromOffset: (NSUInteger)offset
+             onSocket: (int)socket
+            bodyBytes: (NSUInteger)bodyBytes
+{
+  NSUInteger  bytesPerSecond  = self.bytesPerSecond;
+  NSUInteger  chunk           = [response length] - offset;
+
+  if (bytesPerSecond > 0) {
+    chunk = MIN(chunk, MAX(FSI_CHUNK_BYTES_MIN, (NSUInteger)(bytesPerSecond * FSI_SEND_INTERVAL)));
+  }
+
+
+  //
+  const uint8_t  *bytes  = (const uint8_t *) [response bytes] + offset;
+  NSUInteger      sent   = 0;
+
+  while (sent < chunk)
+  {
+    ssize_t  rval = send(socket, bytes + sent, chunk - sent, FSI_SEND_FLAGS);
+
+    if ((rval < 0) && (EINTR == errno))  { continue; }
+
+    if (rval <= 0) {
+      close(socket);
+      return;
+    }
+
+    sent += (NSUInteger) rval;
+  }
+
+  offset += chunk;
+
+
+  //
+  if (offset >= [response length]) {
+    [self count:&_counters.bytes by:bodyBytes];
+    close(socket);
+    return;
+  }
+
+  NSTimeInterval  wait = (double) chunk / bytesPerSecond;
+
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(wait * NSEC_PER_SEC)), self.connectionQueue, ^{
+    [self sendResponse:response fromOffset:offset onSocket:socket bodyBytes:bodyBytes];
+  });
+}
+
+
+
+//-------------------------- -o-
+- (void) count: (uint64_t *)counter
+            by: (uint64_t)amount
+{
+  @synchronized (self) {
+    *counter += amount;
+  }
+}
+
+
+
+//-------------------------- -o-
+// parametersForQuery:
+//
+// RETURN:  Name --> value, values unescaped.
+//
++ (NSDictionary *) parametersForQuery: (NSString *)query
+{
+  NSMutableDictionary  *parameters = [[NSMutableDictionary alloc] init];
+
+  for (NSString *pair in [query componentsSeparatedByString:@"&"])
+  {
+    NSRange  equals = [pair rangeOfString:@"="];
+
+    if (NSNotFound == equals.location)  { continue; }
+
+    NSString  *name   = [pair substringToIndex:equals.location];
+    NSString  *value  = [[pair substringFromIndex:equals.location + 1] stringByReplacingPercentEscapesUsingEncoding:NSUTF8StringEncoding];
+
+    if (value)  { parameters[name] = value; }
+  }
+
+  return parameters;
+}
+
+
+//-------------------------- -o-
+// flickrURLForURL:
+//
+// RETURN:  Where Flickr serves what url asks the stand-in for  -OR-  nil.
+//
++ (NSURL *) flickrURLForURL: (NSURL *)url
+{
+  NSString  *path = [url path];
+
+  if ([[path stringByAppendingString:@"/"] isEqualToString:FLICKR_REST_PATH]) {
+    return [NSURL URLWithString:DP_STRWFMT(@"%@%@?%@", FSI_FLICKR_API_HOST, FLICKR_REST_PATH, [url query])];
+  }
+
+  NSArray  *components = [path pathComponents];
+
+  if ((4 == [components count]) && [components[1] hasPrefix:@"farm"]) {
+    NSString  *host = DP_STRWFMT(FSI_FLICKR_PHOTO_HOST, [components[1] substringFromIndex:[@"farm" length]]);
+    return [NSURL URLWithString:DP_STRWFMT(@"%@/%@/%@", host, components[2], components[3])];
+  }
+
+  return nil;
+}
+
+
+@end // @implementation FlickrStandIn
+
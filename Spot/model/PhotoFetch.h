@@ -4,37 +4,97 @@
 // Photo and photo tag fetching, management and presentation.
 //
 
-#import <UIKit/UIKit.h>
+#import <Foundation/Foundation.h>
 
 #import "Spot.h"
 #import "FlickrFetcher.h"
+#import "PhotoTagIndex.h"
+#import "PhotoSetDiff.h"
+#import "PhotoSnapshot.h"
+#import "PhotoSnapshotStore.h"
+#import "PlacePhotoIndex.h"
+#import "RecentsStore.h"
 
 #import "Danaprajna.h"
 #import "DataFileCache.h"
+#import "QueueRegistry.h"
 
 
 
 //------------------------------------------------------------ -o-
-// enumerated values derived from FlickrFetcher method names
+// Keys for UserDefaults and photo entries.
+//
+// NB  Recents were kept in UserDefaults before RecentsStore;  they are 
+//       moved to the store once, then removed.
 //
-typedef enum { 
-  PFCategoryLatestGeoreferenced, 
-  PFCategoryStanford,
-  PFCategoryTopPlaces 
-} PFCategory;
+#define PF_DICTIONARY_ROOT_KEY   @"Spot"
+
+#define PF_RECENTS_KEY           @"RecentPhotos"
 
+#define PF_ENTRY_TIMESTAMP_KEY   @"PHOTOFETCH_TIMESTAMP"
 
-#define PF_TAG_EXCEPTION_LIST   @"cs193pspot portrait landscape"
+#define PF_RECENTS_DIR_NAME      @"Recents"
 
 
-// Keys for UserDefaults and photo entries.
+// Topics published to [PhotoFetch changeFeed], in addition to the 
+//   DFC_NOTIFICATION_* topics of [PhotoFetch photoCache].
 //
-#define PF_DICTIONARY_ROOT_KEY   @"Spot"
+//   PF_CHANGE_SNAPSHOT_PUBLISHED  payload:  PhotoSnapshot that changed.
+//   PF_CHANGE_RECENTS             payload:  FLICKR_PHOTO_ID added  -OR-  none when cleared.
+//
+#define PF_CHANGE_SNAPSHOT_PUBLISHED  @"PhotoFetchSnapshotPublished"
+#define PF_CHANGE_RECENTS             @"PhotoFetchRecentsChanged"
 
-#define PF_RECENTS_KEY           @"RecentPhotos"
-#define PF_RECENTS_UPDATED_KEY   @"IsRecentPhotosUpdated"
 
-#define PF_ENTRY_TIMESTAMP_KEY   @"PHOTOFETCH_TIMESTAMP"
+// Number of categories whose snapshots are kept in memory.
+//
+#define PF_SNAPSHOT_CATEGORIES_MAX  2
+
+
+// Paginated fetch.  Defaults for PF_PAGING_DEFAULT.
+//
+#define PF_FETCH_PAGES_MAX       4
+#define PF_FETCH_PERPAGE         250
+#define PF_FETCH_INFLIGHT_MAX    2
+#define PF_FETCH_PHOTOS_MAX      1000
+
+typedef struct {
+  NSUInteger  pagesMax;       // Pages requested, at most.
+  NSUInteger  perPage;
+  NSUInteger  inFlightMax;    // Concurrent page requests, at most.
+  NSUInteger  photosMax;      // Photos kept, at most.
+} PFPaging;
+
+#define PF_PAGING_DEFAULT  \
+  ((PFPaging) { PF_FETCH_PAGES_MAX, PF_FETCH_PERPAGE, PF_FETCH_INFLIGHT_MAX, PF_FETCH_PHOTOS_MAX })
+
+
+// Top places:  photos per place, requests in flight, and seconds before 
+//   cached places and their photos are fetched again.
+//
+#define PF_PLACE_PHOTOS_MAX      50
+#define PF_PLACES_INFLIGHT_MAX   4
+#define PF_PLACES_MAXAGE         (10 * 60)
+
+
+// Called on the main queue each time a paginated fetch publishes a snapshot.
+//
+typedef void (^PFFetchProgressBlock)(PhotoSnapshot *snapshot);
+
+
+// Called on the completionQueue of photoCache with photoData from 
+//   photoCache (isCached), otherwise on QRRoleNetwork.
+//
+typedef void (^PFPhotoDataBlock)(NSData *photoData, NSURL *sourceURL, BOOL isCached, NSError *error);
+
+
+// Keys for lastFetchStatistics.
+//
+#define PF_FETCHSTAT_FIRSTPAGE_SECONDS  @"firstPageSeconds"
+#define PF_FETCHSTAT_TOTAL_SECONDS      @"totalSeconds"
+#define PF_FETCHSTAT_PAGES              @"pages"
+#define PF_FETCHSTAT_PHOTOS             @"photos"
+#define PF_FETCHSTAT_BANDWIDTH          @"bandwidth"     // Bytes per second;  NetworkActivity estimate at completion.
 
 
 //
@@ -42,6 +102,12 @@ typedef enum {
 #define PF_CACHEDIR_MAXSIZE_IPHONE        (PF_CACHEDIR_MAXSIZE_MULTIPLIER * 1024 * 1024)
 #define PF_CACHEDIR_MAXSIZE_IPAD          (PF_CACHEDIR_MAXSIZE_IPHONE * 4)
 
+// Optional DataFileCache snapshot in the main bundle, imported when
+//   photoCache opens empty.  See DataFileCache exportSnapshotToURL:.
+//
+#define PF_CACHE_SNAPSHOT_NAME            @"PhotoCache"
+#define PF_CACHE_SNAPSHOT_EXTENSION       @"dfcsnapshot"
+
 
 
 //
@@ -61,17 +127,50 @@ typedef enum {
 @interface PhotoFetch : NSObject
 
   + (DataFileCache *)   photoCache;
-  + (dispatch_queue_t)  photoCacheQueue;
+  + (ChangeFeed *)      changeFeed;
+
+  + (PhotoSnapshotStore *)  snapshotStore;
+  + (PlacePhotoIndex *)     placePhotoIndex;
+  + (RecentsStore *)        recentsStore;
+  + (PhotoSnapshot *)       currentSnapshot;
+  + (PhotoSnapshot *)       showCategory: (PFCategory) category;
+
+  + (PhotoSetDiff *) fetchPhotos: (PFCategory) fetchCategory;
+
+  + (PhotoSnapshot *) fetchPhotos: (PFCategory) fetchCategory
+                           paging: (PFPaging) paging
+                         progress: (PFFetchProgressBlock) progress;
+
+  + (NSDictionary *) lastFetchStatistics;
 
-  + (NSArray *) fetchPhotos: (PFCategory) fetchCategory;
+  + (PhotoTagIndex *) tagIndex;
 
   + (NSDictionary *)  tagOccurrenceCount;
+  + (NSArray *)       sortedTags;
   + (NSArray *)       photoArrayPerTagOccurrence: (NSString *)tag;
+  + (NSArray *)       photoArrayMatchingQuery:    (NSString *)query;
+
+  + (NSArray *) photoArrayNearestLatitude: (double)latitude
+                                longitude: (double)longitude
+                                    count: (NSUInteger)count;
+
+  + (NSArray *) photoArrayInRegionSouth: (double)south
+                                   west: (double)west
+                                  north: (double)north
+                                   east: (double)east;
 
   + (NSArray *)  recentPhotos;
   + (void)       addToRecentsList: (NSMutableDictionary *)photoEntry;
-  + (BOOL)       areRecentPhotosUpdated;
   + (void)       clearRecents;
 
+  + (void) photoDataForEntry: (NSDictionary *)photoEntry
+                         url: (NSURL *)url
+                  parentSpan: (uint64_t)parentSpanID
+                  completion: (PFPhotoDataBlock)completion;
+
+  + (void) keepPhotoData: (NSData *)photoData
+                forEntry: (NSMutableDictionary *)photoEntry
+            addToRecents: (BOOL)addToRecents;
+
 @end
 
@@ -11,10 +11,27 @@
 //------------------------------------------------------------ -o-
 @interface PhotoFetch()
 
-  + (NSArray *) savePhotoArray: (NSArray *) array;
-  + (NSArray *) getPhotoArray;
+  + (NSArray *) photoArrayFromFlickr: (PFCategory)fetchCategory;
 
-  + (NSArray *) tagsToBeIgnored;
+  + (NSArray *) photoArrayFromFlickr: (PFCategory)fetchCategory
+                                page: (NSUInteger)page
+                             perPage: (NSUInteger)perPage
+                           pageCount: (NSUInteger *)pageCount;
+
+  + (NSArray *) photoArrayFromPages: (NSArray *)pages
+                        photosMax: (NSUInteger)photosMax
+                         previous: (PhotoSnapshot *)previous;
+
+  + (PhotoSnapshot *) publishPhotoArray: (NSArray *)photoArray
+                               category: (PFCategory)category
+                               progress: (PFFetchProgressBlock)progress;
+
+  + (void) setLastFetchStatistics: (NSDictionary *)statistics;
+
+  + (void) recordStatisticsOfSnapshot: (PhotoSnapshot *)snapshot
+                                pages: (NSUInteger)pages
+                     firstPageSeconds: (NSTimeInterval)firstPageElapsed
+                         totalSeconds: (NSTimeInterval)totalElapsed;
 
 @end
 
@@ -27,267 +44,762 @@
 #pragma mark - Singleton data.
 
 //-------------------------- -o-
-+ (NSArray *) savePhotoArray: (NSArray *)array
++ (PhotoSnapshotStore *) snapshotStore
 {
-  static NSArray *photoArray = nil;
+  static PhotoSnapshotStore  *store = nil;
+  static dispatch_once_t      onceToken;
 
-  if (array)  { photoArray = array; }
+  dispatch_once(&onceToken, ^{
+    store = [[PhotoSnapshotStore alloc] initWithCapacity:PF_SNAPSHOT_CATEGORIES_MAX];
+    store.currentCategory = PFCategoryStanford;
+  });
 
-  return photoArray;
+  return store;
 }
 
 
 //-------------------------- -o-
-+ (NSArray *) getPhotoArray
++ (PlacePhotoIndex *) placePhotoIndex
 {
-    return [PhotoFetch savePhotoArray:nil];
-}
+  static PlacePhotoIndex  *index = nil;
+  static dispatch_once_t   onceToken;
+
+  dispatch_once(&onceToken, ^{
+    index = [[PlacePhotoIndex alloc] initWithMaxAge:PF_PLACES_MAXAGE inFlightMax:PF_PLACES_INFLIGHT_MAX];
+  });
 
+  return index;
+}
 
 
 //-------------------------- -o-
-+ (DataFileCache *)  photoCache
+// recentsStore
+//
+// NB  Adopts recents left in UserDefaults by earlier versions.
+//
++ (RecentsStore *) recentsStore
 {
-  static DataFileCache  *dfc = nil;
+  static RecentsStore     *store = nil;
+  static dispatch_once_t   onceToken;
 
-  if (!dfc) {
-    long long  cacheSize = [Zed isIPad] ? PF_CACHEDIR_MAXSIZE_IPAD : PF_CACHEDIR_MAXSIZE_IPHONE;
-    dfc = [[DataFileCache alloc] initCacheDirectoryWithURL:nil sizeInBytes:cacheSize];
-  }
+  dispatch_once(&onceToken, ^{
+    NSURL  *supportDirURL = [[[NSFileManager defaultManager] URLsForDirectory: NSApplicationSupportDirectory
+                                                                    inDomains: NSUserDomainMask] firstObject];
 
-  return dfc;
+    NSURL  *logURL = [[supportDirURL URLByAppendingPathComponent:PF_RECENTS_DIR_NAME isDirectory:YES]
+                                     URLByAppendingPathComponent:RS_LOG_FILENAME_DEFAULT];
+
+    store = [[RecentsStore alloc] initWithLogURL:logURL capacity:PF_RECENTS_MAX];
+
+
+    //
+    NSDictionary  *oldRecents = [ZedUD root:PF_DICTIONARY_ROOT_KEY dictionary:PF_RECENTS_KEY];
+
+    if (store && oldRecents) 
+    {
+      for (NSDictionary *photoEntry in [Zed sortedArrayOfDictionaryValues: oldRecents
+                                                                  withKey: PF_ENTRY_TIMESTAMP_KEY
+                                                                ascending: YES]) 
+      {
+        [store addPhotoEntry:photoEntry];
+      }
+
+      [ZedUD udRemoveRootDictionary:PF_DICTIONARY_ROOT_KEY];
+    }
+  });
+
+  return store;
 }
-        
+
 
 //-------------------------- -o-
-+ (dispatch_queue_t)  photoCacheQueue
++ (PhotoSnapshot *) currentSnapshot
 {
-  static dispatch_queue_t  cacheOperationsQueue = nil;
+  PhotoSnapshotStore  *store = [PhotoFetch snapshotStore];
+  return [store snapshotForCategory:store.currentCategory];
+}
 
-  if (!cacheOperationsQueue) 
-  {
-    DataFileCache  *dfc;
-    if (nil == (dfc = [PhotoFetch photoCache])) {
-      return nil; 
-    }
 
-    cacheOperationsQueue = DP_ASYNC_QUEUE(@"photoCache @ %@", [[dfc cacheDirURL] lastPathComponent]);
-  }
+//-------------------------- -o-
++ (PhotoTagIndex *) tagIndex
+{
+    return [[PhotoFetch currentSnapshot] tagIndex];
+}
+
+
+
+//-------------------------- -o-
++ (ChangeFeed *) changeFeed
+{
+  static ChangeFeed       *feed = nil;
+  static dispatch_once_t   onceToken;
+
+  dispatch_once(&onceToken, ^{
+    feed = [[ChangeFeed alloc] initWithCoalesceInterval:CF_COALESCE_INTERVAL_DEFAULT];
+  });
 
-  return cacheOperationsQueue;
+  return feed;
 }
 
 
 
+//-------------------------- -o-
+// photoCache
+//
+// NB  Called from many threads at once (SessionLoad, photo loading);
+//       opening the cache, with its snapshot import, happens only once.
+//
++ (DataFileCache *)  photoCache
+{
+  static DataFileCache    *dfc = nil;
+  static dispatch_once_t   onceToken;
+
+  dispatch_once(&onceToken, ^{
+    long long   cacheSize    = [Zed isIPad] ? PF_CACHEDIR_MAXSIZE_IPAD : PF_CACHEDIR_MAXSIZE_IPHONE;
+    NSURL      *snapshotURL  = [[NSBundle mainBundle] URLForResource:PF_CACHE_SNAPSHOT_NAME withExtension:PF_CACHE_SNAPSHOT_EXTENSION];
+
+    dfc = [[DataFileCache alloc] initCacheDirectoryWithURL:nil sizeInBytes:cacheSize snapshotURL:snapshotURL];
+    dfc.changeFeed = [PhotoFetch changeFeed];
+  });
+
+  return dfc;
+}
+        
+
 //------------------------------------------------------------ -o--
 #pragma mark - Class methods.
 
 //-------------------------- -o-
-// fetchPhotos:
+// photoArrayFromFlickr:
 //
-// NB  Internal state is created, even if return value may be ignored.
-//
-// ASSUME  Calling environment spawns thread before calling this method. 
+// NB  Top places yields the photos in each place, fetched concurrently
+//       and cached per place by placePhotoIndex.
 //
-+ (NSArray *) fetchPhotos: (PFCategory)fetchCategory
++ (NSArray *) photoArrayFromFlickr: (PFCategory)fetchCategory
 {
   switch(fetchCategory) 
   {
     case PFCategoryLatestGeoreferenced:
-    {
-      [self savePhotoArray:[FlickrFetcher latestGeoreferencedPhotos]];
-      break;
-    }
+      return [FlickrFetcher latestGeoreferencedPhotos];
 
     case PFCategoryTopPlaces:
     {
-      [self savePhotoArray:[FlickrFetcher topPlaces]];
-      break;
+      PlacePhotoIndex  *placeIndex  = [self placePhotoIndex];
+      NSArray          *places      = [placeIndex topPlaces];
+
+      return places ? [placeIndex photoArrayForPlaces:places maxResults:PF_PLACE_PHOTOS_MAX] : nil;
     }
 
     case PFCategoryStanford:
-    {
-      [self savePhotoArray:[FlickrFetcher stanfordPhotos]];
-      break;
-    }
+      return [FlickrFetcher stanfordPhotos];
   }
 
+  return nil;
+}
+
+
+
+//-------------------------- -o-
+// photoArrayFromFlickr:page:perPage:pageCount:
+//
+// RETURN:  One page of photos  -OR-  nil if category is not paginated.
+//
++ (NSArray *) photoArrayFromFlickr: (PFCategory)fetchCategory
+                              page: (NSUInteger)page
+                           perPage: (NSUInteger)perPage
+                         pageCount: (NSUInteger *)pageCount
+{
+  switch(fetchCategory) 
+  {
+    case PFCategoryLatestGeoreferenced:
+      return [FlickrFetcher latestGeoreferencedPhotosPage:page perPage:perPage pageCount:pageCount];
+
+    case PFCategoryStanford:
+      return [FlickrFetcher stanfordPhotosPage:page perPage:perPage pageCount:pageCount];
 
-  return [[self getPhotoArray] copy];
+    case PFCategoryTopPlaces:
+      break;
+  }
 
-} // fetchPhotos: 
+  return nil;
+}
 
 
 
 //-------------------------- -o-
-+ (NSArray *) tagsToBeIgnored
+// fetchPhotos:
+//
+// Fetch photos of fetchCategory, make it the current category and publish 
+// a new snapshot of it.
+//
+// RETURN:  Difference from the previous snapshot of fetchCategory  
+//            -OR-  nil if fetch failed or there was no previous snapshot.
+//
+// NB  Internal state is created, even if return value may be ignored.
+//     Tag index is updated from the diff when only a few photos change;
+//     otherwise it is rebuilt once here, rather than on every tag query.
+// NB  A failed fetch keeps the previous snapshot and the current category.
+// NB  Publishes PF_CHANGE_SNAPSHOT_PUBLISHED if anything changed.
+//
+// ASSUME  Calling environment spawns thread before calling this method. 
+//
++ (PhotoSetDiff *) fetchPhotos: (PFCategory)fetchCategory
 {
-  static NSString  *exceptionList = PF_TAG_EXCEPTION_LIST;
-  return [exceptionList componentsSeparatedByString:@" "];
+  NSArray  *photoArray = [self photoArrayFromFlickr:fetchCategory];
+
+  if (!photoArray)  { return nil; }
+
+  [self snapshotStore].currentCategory = fetchCategory;
+
+  return [[self publishPhotoArray:photoArray category:fetchCategory progress:nil] diff];
 }
 
 
 
 //-------------------------- -o-
-+ (NSDictionary *) tagOccurrenceCount
+// fetchPhotos:paging:progress:
+//
+// Fetch up to paging.pagesMax pages of fetchCategory, at most 
+// paging.inFlightMax at a time, and publish a snapshot as pages arrive.
+// The first page is fetched alone to learn how many pages exist.
+//
+// Pages that arrive while a partial snapshot is waiting to be built are
+// merged into that one snapshot.  No partial snapshot is built once every
+// page has arrived;  the final snapshot follows.
+//
+// While pages are outstanding, photos of the previous snapshot not yet 
+// seen are kept, so a refresh does not empty the tag list.  The final 
+// snapshot holds exactly the photos fetched, trimmed to paging.photosMax.
+//
+// RETURN:  Final snapshot  -OR-  nil if the first page failed.
+//
+// NB  Categories without pagination fetch all photos at once.
+// NB  fetchCategory becomes the current category once photos arrive.
+// NB  Pages that fail are skipped;  the rest are still published.
+// NB  Time to first page and total time are logged and kept in 
+//       lastFetchStatistics.
+//
+// ASSUME  Calling environment spawns thread before calling this method,
+//           on neither QRRoleNetwork nor QRRoleIndex. 
+//
++ (PhotoSnapshot *) fetchPhotos: (PFCategory)fetchCategory
+                         paging: (PFPaging)paging
+                       progress: (PFFetchProgressBlock)progress
 {
-  NSMutableDictionary  *tagCountDict  = [[NSMutableDictionary alloc] init];
-  BOOL                  isException   = NO;
+  PhotoSnapshotStore  *store  = [self snapshotStore];
+  NSTimeInterval       start  = [NSDate timeIntervalSinceReferenceDate];
+  NSUInteger           pagesAvailable  = 0;
+  DPTraceSpan          fetchSpan       = DP_TRACE_BEGIN("fetch.photos");
+
+  paging.perPage      = MAX(paging.perPage, 1);
+  paging.inFlightMax  = MAX(paging.inFlightMax, 1);
+
+
+  //
+  DPTraceSpan  firstPageSpan = DP_TRACE_BEGIN("fetch.page");
+
+  NSArray  *firstPage = [self photoArrayFromFlickr: fetchCategory
+                                              page: 1
+                                           perPage: paging.perPage
+                                         pageCount: &pagesAvailable ];
+
+  DP_TRACE_END(firstPageSpan);
 
+  NSTimeInterval  firstPageElapsed = [NSDate timeIntervalSinceReferenceDate] - start;
 
-  for (NSDictionary *entry in [self getPhotoArray])
+  if (!firstPage)
   {
-    for (NSString *tag in [entry[FLICKR_TAGS] componentsSeparatedByString:@" "])
-    {
-      isException = NO;
+    if (PFCategoryTopPlaces != fetchCategory) { 
+      DP_TRACE_END(fetchSpan);
+      return nil; 
+    }
+
+    NSArray  *photoArray = [self photoArrayFromFlickr:fetchCategory];
+
+    if (!photoArray) {
+      DP_TRACE_END(fetchSpan);
+      return nil;
+    }
 
-      for (NSString *exception in [self tagsToBeIgnored]) {
-        if ([tag isEqualToString:exception]) { 
-          isException = YES;
-          break;
-        }
+    store.currentCategory = fetchCategory;
+
+    PhotoSnapshot  *snapshot = [self publishPhotoArray:photoArray category:fetchCategory progress:nil];
+    if (progress) {
+      dispatch_async(dispatch_get_main_queue(), ^{ progress(snapshot); });
+    }
+
+    NSTimeInterval  totalElapsed = [NSDate timeIntervalSinceReferenceDate] - start;
+
+    [self recordStatisticsOfSnapshot: snapshot
+                               pages: 1
+                    firstPageSeconds: totalElapsed
+                        totalSeconds: totalElapsed ];
+
+    DP_TRACE_END(fetchSpan);
+    return snapshot;
+  }
+
+  store.currentCategory = fetchCategory;
+
+
+  //
+  NSUInteger  pagesWanted = MIN(paging.pagesMax, pagesAvailable);
+
+  pagesWanted = MIN(pagesWanted, (paging.photosMax + paging.perPage - 1) / paging.perPage);
+  pagesWanted = MAX(pagesWanted, 1);
+
+  PhotoSnapshot   *previous  = [store snapshotForCategory:fetchCategory];
+  NSMutableArray  *pages     = [[NSMutableArray alloc] initWithCapacity:pagesWanted];
+
+  [pages addObject:firstPage];
+  for (NSUInteger i = 1; i < pagesWanted; i++) {
+    [pages addObject:[NSNull null]];
+  }
+
+  if (pagesWanted > 1) {
+    [self publishPhotoArray: [self photoArrayFromPages:pages photosMax:paging.photosMax previous:previous]
+                   category: fetchCategory
+                   progress: progress ];
+  }
+
+
+  // Remaining pages.  Merges run on QRRoleIndex, one at a time and in 
+  //   the order pages arrive, which also orders publication of the 
+  //   partial snapshots.  At most one partial snapshot waits at a time.
+  //
+  dispatch_group_t      pageGroup   = dispatch_group_create();
+  dispatch_semaphore_t  inFlight    = dispatch_semaphore_create(paging.inFlightMax);
+
+  __block  NSUInteger  pagesPending    = pagesWanted - 1;      // QRRoleIndex only.
+  __block  BOOL        publishPending  = NO;
+
+  for (NSUInteger page = 2; page <= pagesWanted; page++)
+  {
+    dispatch_semaphore_wait(inFlight, DISPATCH_TIME_FOREVER);
+
+    [QueueRegistry async:QRRoleNetwork group:pageGroup block:
+    ^{
+      DPTraceSpan  pageSpan = DP_TRACE_BEGIN_CHILD("fetch.page", fetchSpan.spanID);
+
+      NSArray  *photoArray = [self photoArrayFromFlickr: fetchCategory
+                                                   page: page
+                                                perPage: paging.perPage
+                                              pageCount: NULL ];
+      dispatch_semaphore_signal(inFlight);
+
+      if (!photoArray) {
+        DP_LOG_WARNING(@"Page %lu of %lu failed.", (unsigned long)page, (unsigned long)pagesWanted);
       }
 
-      if (isException)  { continue; }
+      DP_TRACE_END(pageSpan);
 
+      [QueueRegistry async:QRRoleIndex group:pageGroup block:
+      ^{
+        pagesPending -= 1;
 
-      // NB   Leverages [nil integerValue] equal to zero.
-      //
-      NSInteger occurrenceCount = [[tagCountDict objectForKey:tag] integerValue];
-      occurrenceCount += 1;
-      [tagCountDict setObject:@(occurrenceCount) forKey:tag];
+        if (!photoArray)  { return; }
 
-    }
+        [pages replaceObjectAtIndex:(page - 1) withObject:photoArray];
+
+        if (publishPending || (pagesPending < 1))  { return; }
+        publishPending = YES;
+
+        [QueueRegistry async:QRRoleIndex group:pageGroup block:
+        ^{
+          publishPending = NO;
+          if (pagesPending < 1)  { return; }
+
+          [self publishPhotoArray: [self photoArrayFromPages:pages photosMax:paging.photosMax previous:previous]
+                         category: fetchCategory
+                         progress: progress ];
+        }];
+      }];
+    }];
   }
 
-  return tagCountDict;
-}
+  dispatch_group_wait(pageGroup, DISPATCH_TIME_FOREVER);
+
+
+  // Final snapshot drops photos no longer returned by Flickr.
+  //
+  PhotoSnapshot  *snapshot = 
+    [self publishPhotoArray: [self photoArrayFromPages:pages photosMax:paging.photosMax previous:nil]
+                   category: fetchCategory
+                   progress: progress ];
+
+  [self recordStatisticsOfSnapshot: snapshot
+                             pages: pagesWanted
+                  firstPageSeconds: firstPageElapsed
+                      totalSeconds: [NSDate timeIntervalSinceReferenceDate] - start ];
+
+  DP_TRACE_END(fetchSpan);
+
+  return snapshot;
+
+} // fetchPhotos:paging:progress:
 
 
 
 //-------------------------- -o-
-// photoArrayPerTagOccurrence: 
+// photoArrayFromPages:photosMax:previous:
 //
-// NB  Ignores photo entries without tag key/value pair.
+// Concatenate pages received so far (NSNull marks a page not yet received)
+// in page order, without duplicates, trimmed to photosMax.  Then append 
+// photos of previous not otherwise present.
 //
-+ (NSArray *) photoArrayPerTagOccurrence: (NSString *) tag
+// NB  Results can shift between page requests, so one photo may appear 
+//       on two pages.
+//
++ (NSArray *) photoArrayFromPages: (NSArray *)pages
+                        photosMax: (NSUInteger)photosMax
+                         previous: (PhotoSnapshot *)previous
 {
-  NSMutableArray  *taggedPhotos = [[NSMutableArray alloc] init];
+  NSMutableArray  *photoArray  = [[NSMutableArray alloc] init];
+  NSMutableSet    *photoIDs    = [[NSMutableSet alloc] init];
 
-  for (NSDictionary *entry in [self getPhotoArray])
+  for (id page in pages)
   {
-    NSString  *taglist = [entry objectForKey:FLICKR_TAGS];
-    if (!taglist)  { continue; }
+    if ([page isKindOfClass:[NSNull class]])  { continue; }
 
-    for (NSString *entryTag in [taglist componentsSeparatedByString:@" "])
+    for (NSDictionary *entry in page)
     {
-      if ([tag isEqualToString:entryTag])
+      if ([photoArray count] >= photosMax)  { break; }
+
+      NSString  *photoID = [entry objectForKey:FLICKR_PHOTO_ID];
+      if (!photoID || [photoIDs containsObject:photoID])  { continue; }
+
+      [photoIDs addObject:photoID];
+      [photoArray addObject:entry];
+    }
+  }
+
+
+  //
+  for (NSDictionary *entry in previous.photoArray)
+  {
+    NSString  *photoID = [entry objectForKey:FLICKR_PHOTO_ID];
+
+    if (photoID && ![photoIDs containsObject:photoID]) {
+      [photoIDs addObject:photoID];
+      [photoArray addObject:entry];
+    }
+  }
+
+  return photoArray;
+
+} // photoArrayFromPages:photosMax:previous:
+
+
+
+//-------------------------- -o-
+// publishPhotoArray:category:progress:
+//
+// Publish photoArray as the next snapshot of category.
+//
+// RETURN:  Published snapshot.
+//
+// NB  If anything changed, publishes PF_CHANGE_SNAPSHOT_PUBLISHED and 
+//       calls progress on the main queue.
+//
++ (PhotoSnapshot *) publishPhotoArray: (NSArray *)photoArray
+                             category: (PFCategory)category
+                             progress: (PFFetchProgressBlock)progress
+{
+  DPTraceSpan  publishSpan = DP_TRACE_BEGIN("snapshot.publish");
+
+  PhotoSnapshot  *snapshot =
+    [[self snapshotStore] updateCategory: category
+                               withBlock: ^PhotoSnapshot *(PhotoSnapshot *current, NSUInteger nextVersion) 
       {
-        [taggedPhotos addObject:entry];
-        break;
-      }
+        return [PhotoSnapshot snapshotWithPhotoArray: photoArray
+                                            category: category
+                                             version: nextVersion
+                                            previous: current ];
+      }];
+
+
+  //
+  if ((!snapshot.diff) || (! [snapshot.diff isEmpty]))
+  {
+    [[self changeFeed] publishTopic:PF_CHANGE_SNAPSHOT_PUBLISHED payload:snapshot];
+
+    if (progress) {
+      dispatch_async(dispatch_get_main_queue(), ^{
+        progress(snapshot);
+      });
     }
   }
 
-  return taggedPhotos;
+  DP_TRACE_END(publishSpan);
+
+  return snapshot;
+
+} // publishPhotoArray:category:progress:
+
+
+
+//-------------------------- -o-
+// lastFetchStatistics
+//
+// RETURN:  Timings of the most recent fetchPhotos:paging:progress: (PF_FETCHSTAT_*)
+//            -OR-  nil.
+//
+static NSDictionary  *lastFetchStatistics = nil;
+
++ (NSDictionary *) lastFetchStatistics
+{
+  @synchronized(self) {
+    return lastFetchStatistics;
+  }
+}
+
+
+//-------------------------- -o-
++ (void) setLastFetchStatistics: (NSDictionary *)statistics
+{
+  @synchronized(self) {
+    lastFetchStatistics = statistics;
+  }
 }
 
 
 
 //-------------------------- -o-
-+ (NSArray *) recentPhotos
+// recordStatisticsOfSnapshot:pages:firstPageSeconds:totalSeconds:
+//
+// Log a completed fetch and keep it as lastFetchStatistics.
+//
++ (void) recordStatisticsOfSnapshot: (PhotoSnapshot *)snapshot
+                              pages: (NSUInteger)pages
+                   firstPageSeconds: (NSTimeInterval)firstPageElapsed
+                       totalSeconds: (NSTimeInterval)totalElapsed
 {
-  [ZedUD    root: PF_DICTIONARY_ROOT_KEY
-       setObject: [NSNumber numberWithBool:NO]
-          forKey: PF_RECENTS_UPDATED_KEY];
-   
-  return [Zed sortedArrayOfDictionaryValues: [ZedUD root:PF_DICTIONARY_ROOT_KEY dictionary:PF_RECENTS_KEY]
-                                    withKey: PF_ENTRY_TIMESTAMP_KEY
-                                  ascending: NO];
+  double  bandwidth = [NetworkActivity bandwidthEstimate];
+
+  DP_LOG_INFO(@"Fetched %lu photos in %lu pages:  first page %.3f s,  total %.3f s,  bandwidth %.1f KB/s", 
+                (unsigned long)[snapshot.photoArray count], (unsigned long)pages, 
+                firstPageElapsed, totalElapsed, bandwidth / 1024);
+
+  [self setLastFetchStatistics:
+    @{
+       PF_FETCHSTAT_FIRSTPAGE_SECONDS  : @(firstPageElapsed),
+       PF_FETCHSTAT_TOTAL_SECONDS      : @(totalElapsed),
+       PF_FETCHSTAT_PAGES              : @(pages),
+       PF_FETCHSTAT_PHOTOS             : @([snapshot.photoArray count]),
+       PF_FETCHSTAT_BANDWIDTH          : @(bandwidth),
+     }];
 }
 
 
 
 //-------------------------- -o-
-// addToRecentsList:
+// showCategory:
 //
-// Add new, timestamped, entry to recentsList.
-// Trim length of recentsList, as necessary.
-// Store updated results in UserDefaults.
-// 
-// NB  Must always be called from the same serial queue.
+// RETURN:  Snapshot already fetched for category  -OR-  nil.
 //
-+ (void)  addToRecentsList:(NSMutableDictionary *)newPhotoEntry
+// Makes category current if a snapshot is available.  Never blocks.
+//
++ (PhotoSnapshot *) showCategory: (PFCategory)category
 {
-  NSMutableDictionary  *recentsDict = [ZedUD root:PF_DICTIONARY_ROOT_KEY dictionary:PF_RECENTS_KEY];
+  PhotoSnapshotStore  *store     = [self snapshotStore];
+  PhotoSnapshot       *snapshot  = [store snapshotForCategory:category];
 
-  if (!recentsDict) {
-    recentsDict = [[NSMutableDictionary alloc] init];
+  if (snapshot) {
+    store.currentCategory = category;
   }
 
+  return snapshot;
+}
 
-  //
-  [newPhotoEntry setObject:DP_DATE_NOW forKey:PF_ENTRY_TIMESTAMP_KEY];
-  [recentsDict setObject:newPhotoEntry forKey:[newPhotoEntry objectForKey:FLICKR_PHOTO_ID]];
 
 
-  if ([recentsDict count] > PF_RECENTS_MAX) 
-  {
-    NSMutableArray *sortedDictionaryEntries = [Zed sortedArrayOfDictionaryValues: recentsDict
-                                                                         withKey: PF_ENTRY_TIMESTAMP_KEY
-                                                                       ascending: NO];
-    while ([recentsDict count] > PF_RECENTS_MAX) 
-    {
-      NSString  *oldestEntryId = [[sortedDictionaryEntries lastObject] objectForKey:FLICKR_PHOTO_ID];
+//-------------------------- -o-
++ (NSDictionary *) tagOccurrenceCount
+{
+  return [[self tagIndex] tagCounts];
+}
 
-      [sortedDictionaryEntries removeLastObject];
-      [recentsDict removeObjectForKey:oldestEntryId];
-    }
-  }
 
 
-  //
-  [ZedUD     root: PF_DICTIONARY_ROOT_KEY 
-        setObject: recentsDict 
-           forKey: PF_RECENTS_KEY ];
+//-------------------------- -o-
++ (NSArray *) sortedTags
+{
+  return [[self tagIndex] sortedTags];
+}
 
-  [ZedUD  root: PF_DICTIONARY_ROOT_KEY 
-     setObject: [NSNumber numberWithBool:YES] 
-        forKey: PF_RECENTS_UPDATED_KEY ];
 
-} // addToRecentsList:
+
+//-------------------------- -o-
+// photoArrayPerTagOccurrence: 
+//
+// NB  Ignores photo entries without tag key/value pair.
+//
++ (NSArray *) photoArrayPerTagOccurrence: (NSString *) tag
+{
+  return [[self tagIndex] photoArrayForTag:tag];
+}
 
 
 
 //-------------------------- -o-
-// areRecentPhotosUpdated
+// photoArrayMatchingQuery:
 //
-// NB  Checking the value, clears the value.
+// NB  Each word of query matches any title or description word it prefixes,
+//       ignoring case and diacritics.
 //
-+ (BOOL) areRecentPhotosUpdated
++ (NSArray *) photoArrayMatchingQuery: (NSString *)query
 {
-  BOOL  isUpdated = [ZedUD root: PF_DICTIONARY_ROOT_KEY
-                           bool: PF_RECENTS_UPDATED_KEY];
+  return [[[self currentSnapshot] textIndex] photoArrayMatchingQuery:query];
+}
+
 
-  [ZedUD    root: PF_DICTIONARY_ROOT_KEY
-       setObject: [NSNumber numberWithBool:NO]
-          forKey: PF_RECENTS_UPDATED_KEY];
 
-  return isUpdated;
+//-------------------------- -o-
+// photoArrayNearestLatitude:longitude:count:
+//
+// NB  Current snapshot only;  ignores photo entries without coordinates.
+//
++ (NSArray *) photoArrayNearestLatitude: (double)latitude
+                              longitude: (double)longitude
+                                  count: (NSUInteger)count
+{
+  return [[[self currentSnapshot] geoIndex] photoArrayNearestLatitude: latitude
+                                                            longitude: longitude
+                                                                count: count ];
 }
 
 
 
+//-------------------------- -o-
++ (NSArray *) photoArrayInRegionSouth: (double)south
+                                 west: (double)west
+                                north: (double)north
+                                 east: (double)east
+{
+  return [[[self currentSnapshot] geoIndex] photoArrayInRegionSouth: south
+                                                               west: west
+                                                              north: north
+                                                               east: east ];
+}
+
+
+
+//-------------------------- -o-
+// recentPhotos
+//
+// RETURN:  Recently viewed photo entries, newest first.
+//
++ (NSArray *) recentPhotos
+{
+  return [[PhotoFetch recentsStore] photoArrayMostRecent:PF_RECENTS_MAX];
+}
+
+
+
+//-------------------------- -o-
+// addToRecentsList:
+//
+// Make newPhotoEntry the most recent in recentsStore, which keeps at most
+// PF_RECENTS_MAX, then publish PF_CHANGE_RECENTS.
+// 
++ (void)  addToRecentsList:(NSMutableDictionary *)newPhotoEntry
+{
+  [[PhotoFetch recentsStore] addPhotoEntry:newPhotoEntry];
+
+  [[PhotoFetch changeFeed] publishTopic: PF_CHANGE_RECENTS
+                                payload: [newPhotoEntry objectForKey:FLICKR_PHOTO_ID] ];
+
+} // addToRecentsList:
+
+
+
 //-------------------------- -o-
 + (void) clearRecents
 {
-  [ZedUD  udRemoveRootDictionary:PF_DICTIONARY_ROOT_KEY];
+  [[PhotoFetch recentsStore] removeAllPhotos];
+
+  [[PhotoFetch photoCache] clearCacheWithCompletion:nil];
+
+  [[PhotoFetch changeFeed] publishTopic:PF_CHANGE_RECENTS payload:nil];
+}
+
+
+
+//-------------------------- -o-
+// photoDataForEntry:url:parentSpan:completion:
+//
+// Read photoEntry from photoCache, or else download url on QRRoleNetwork.
+// Trace spans image.read and image.network are children of parentSpanID;
+// image.read includes the wait on the cache's I/O queue.
+//
+// NB  Does not cache what it downloads;  see keepPhotoData:forEntry:addToRecents:.
+//
++ (void) photoDataForEntry: (NSDictionary *)photoEntry
+                       url: (NSURL *)url
+                parentSpan: (uint64_t)parentSpanID
+                completion: (PFPhotoDataBlock)completion
+{
+  dispatch_block_t  download = 
+  ^{
+    [QueueRegistry async:QRRoleNetwork block:
+    ^{
+      NSError      *error        = nil;
+      DPTraceSpan   networkSpan  = DP_TRACE_BEGIN_CHILD("image.network", parentSpanID);
+
+      uint64_t  requestStarted  = [NetworkActivity beginRequest];
+      NSData   *photoData       = [[NSData alloc] initWithContentsOfURL:url options:0 error:&error];
+
+      [NetworkActivity endRequest:requestStarted bytes:[photoData length] success:(nil != photoData)];
+
+      DP_TRACE_END(networkSpan);
+
+      completion(photoData, url, NO, error);
+    }];
+  };
 
-  [[PhotoFetch photoCache] clearCache];
+  if (!photoEntry) {
+    download();
+    return;
+  }
+
+
+  //
+  DPTraceSpan  readSpan = DP_TRACE_BEGIN_ASYNC_CHILD("image.read", parentSpanID);
+
+  [[PhotoFetch photoCache] readFile: PF_PHOTOENTRY_FILENAME(photoEntry)
+                         completion: ^(NSData *photoData, NSURL *cachedPhotoURL, NSError *error) 
+    {
+      DP_TRACE_END(readSpan);
+
+      if (cachedPhotoURL) {
+        completion(photoData, cachedPhotoURL, YES, error);
+      } else {
+        download();
+      }
+    }];
+}
+
+
+
+//-------------------------- -o-
+// keepPhotoData:forEntry:addToRecents:
+//
+// Save photoData to photoCache, and optionally make photoEntry most 
+// recent.  Returns at once;  the save runs on the cache's I/O queue.
+//
++ (void) keepPhotoData: (NSData *)photoData
+              forEntry: (NSMutableDictionary *)photoEntry
+          addToRecents: (BOOL)addToRecents
+{
+  if (!photoData || !photoEntry)  { return; }
+
+  if (addToRecents) {
+    [PhotoFetch addToRecentsList:photoEntry];
+  }
 
-  [ZedUD    root: PF_DICTIONARY_ROOT_KEY
-       setObject: [NSNumber numberWithBool:YES]
-          forKey: PF_RECENTS_UPDATED_KEY];
+  [[PhotoFetch photoCache] saveFile: PF_PHOTOENTRY_FILENAME(photoEntry)
+                           withData: photoData 
+                         completion: nil ];
 }
 
 
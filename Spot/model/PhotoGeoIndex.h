@@ -0,0 +1,67 @@
+//
+// PhotoGeoIndex.h
+//
+// Spatial index over photo entries that have FLICKR_LATITUDE and
+// FLICKR_LONGITUDE.  Points are packed by cell of a latitude/longitude
+// grid into flat C arrays;  queries visit only nearby cells.
+//
+// Latitudes are degrees in [-90, 90];  longitudes are degrees, wrapped
+// into [-180, 180).  Distances are great circle, in radians.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FlickrFetcher.h"
+
+#import "Danaprajna.h"
+
+
+
+//------------------------------------------------------------ -o-
+// Grid cell size.  Rounded so that cells tile the globe exactly.
+//
+#define PF_GEO_CELL_DEGREES   1.0
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoGeoIndex : NSObject
+
+  @property  (readonly, strong, nonatomic)  NSArray  *photoArray;
+
+  @property  (readonly, nonatomic)  NSUInteger  count;
+      // Photos with valid coordinates.
+
+  @property  (readonly, nonatomic)  double  cellLatitudeDegrees;
+  @property  (readonly, nonatomic)  double  cellLongitudeDegrees;
+
+
+  //
+  - (id) initWithPhotoArray: (NSArray *)photoArray;
+
+  - (id) initWithPhotoArray: (NSArray *)photoArray
+                cellDegrees: (double)cellDegrees;
+
+  - (id) initWithGeoIndex: (PhotoGeoIndex *)geoIndex
+               photoArray: (NSArray *)photoArray
+              positionMap: (NSData *)positionMap
+           freshPositions: (NSIndexSet *)freshPositions;
+      // See PhotoSetDiff positionMapFromPhotoArray:toPhotoArray:freshPositions:.
+
+  - (NSArray *) photoArrayNearestLatitude: (double)latitude
+                                longitude: (double)longitude
+                                    count: (NSUInteger)count;
+
+  - (NSArray *) photoArrayInRegionSouth: (double)south
+                                   west: (double)west
+                                  north: (double)north
+                                   east: (double)east;
+
+  + (double) distanceFromLatitude: (double)latitude
+                        longitude: (double)longitude
+                       toLatitude: (double)otherLatitude
+                        longitude: (double)otherLongitude;
+
+@end
+
@@ -0,0 +1,667 @@
+//
+// PhotoGeoIndex.m
+//
+// Points of cell c occupy packed positions [cellStart[c], cellStart[c+1]).
+// Cells are numbered row * columns + column;  row 0 starts at latitude -90,
+// column 0 at longitude -180.
+//
+// Nearest neighbours are found by visiting square rings of cells around
+// the query point, widening until no unvisited cell can hold a point
+// closer than the k-th best found.
+//
+// initWithGeoIndex:photoArray:positionMap:freshPositions: derives a new
+// index from an old one, cell by cell:  surviving points are copied with
+// their new positions, and only added or changed photos are parsed.
+//
+// NB  Never modified after construction;  safe to read from any thread.
+//
+
+#import "PhotoGeoIndex.h"
+
+
+
+//------------------------------------------------------------ -o-
+#define DEGREES_TO_RADIANS(degrees)  ((degrees) * M_PI / 180.0)
+
+
+// Running k best candidates, sorted by ascending distance.
+//
+typedef struct {
+  double     latitude;
+  double     longitude;
+  double     cosLatitude;
+
+  NSUInteger   k;
+  NSUInteger   found;
+  double      *distances;
+  uint32_t    *positions;
+} GeoNearest;
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoGeoIndex()
+{
+  NSInteger   rows;
+  NSInteger   columns;
+
+  uint32_t   *cellStart;         // rows * columns + 1
+  double     *latitudes;         // By packed position.
+  double     *longitudes;
+  double     *cosLatitudes;
+  uint32_t   *photoIndexes;      // Packed position --> index in photoArray.
+}
+
+  @property  (readwrite, strong, nonatomic)  NSArray  *photoArray;
+
+  @property  (readwrite, nonatomic)  NSUInteger  count;
+
+  @property  (readwrite, nonatomic)  double  cellLatitudeDegrees;
+  @property  (readwrite, nonatomic)  double  cellLongitudeDegrees;
+
+  - (NSInteger) rowForLatitude:     (double)latitude;
+  - (NSInteger) columnForLongitude: (double)longitude;
+
+  - (void) visitCell: (NSInteger)cell
+             nearest: (GeoNearest *)nearest;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o-
+static double normalizedLongitude(double longitude)
+{
+  longitude = fmod(longitude + 180.0, 360.0);
+  if (longitude < 0)  { longitude += 360.0; }
+
+  return longitude - 180.0;
+}
+
+
+// RETURN:  YES if entry has both coordinates, in range;  longitude normalized.
+//
+static BOOL coordinatesForEntry(NSDictionary *entry, double *latitude, double *longitude)
+{
+  id  latitudeValue   = [entry objectForKey:FLICKR_LATITUDE];
+  id  longitudeValue  = [entry objectForKey:FLICKR_LONGITUDE];
+
+  if (    (! [latitudeValue  respondsToSelector:@selector(doubleValue)])
+       || (! [longitudeValue respondsToSelector:@selector(doubleValue)]) )
+  {
+    return NO;
+  }
+
+  *latitude   = [latitudeValue doubleValue];
+  *longitude  = [longitudeValue doubleValue];
+
+  if ((*latitude < -90) || (*latitude > 90) || !isfinite(*longitude))  { return NO; }
+
+  *longitude = normalizedLongitude(*longitude);
+
+  return YES;
+}
+
+
+// Haversine.
+//
+static double greatCircleDistance(double latitude, double longitude, double cosLatitude,
+                                  double otherLatitude, double otherLongitude, double otherCosLatitude)
+{
+  double  sinHalfLatitude   = sin(DEGREES_TO_RADIANS(otherLatitude - latitude) / 2);
+  double  sinHalfLongitude  = sin(DEGREES_TO_RADIANS(otherLongitude - longitude) / 2);
+
+  double  a = (sinHalfLatitude * sinHalfLatitude)
+                + (cosLatitude * otherCosLatitude * sinHalfLongitude * sinHalfLongitude);
+
+  return 2 * asin(sqrt(MIN(a, 1.0)));
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation PhotoGeoIndex
+
+#pragma mark - Constructors.
+
+//-------------------------- -o-
+- (id) initWithPhotoArray: (NSArray *)photoArray
+{
+  return [self initWithPhotoArray:photoArray cellDegrees:PF_GEO_CELL_DEGREES];
+}
+
+
+//-------------------------- -o-
+// initWithPhotoArray:cellDegrees:
+//
+// Entries without both coordinates, or with coordinates out of range,
+// are not indexed.
+//
+- (id) initWithPhotoArray: (NSArray *)photoArray
+              cellDegrees: (double)cellDegrees
+{
+  if ((cellDegrees <= 0) || (cellDegrees > 90)) {
+    DP_LOG_ERROR(@"cellDegrees must be in (0, 90].");
+    return nil;
+  }
+
+  if ([photoArray count] > UINT32_MAX) {
+    DP_LOG_ERROR(@"photoArray is too large to index.");
+    return nil;
+  }
+
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+
+  //
+  self.photoArray  = [photoArray copy];
+
+  rows     = MAX(1, (NSInteger)lround(180.0 / cellDegrees));
+  columns  = MAX(1, (NSInteger)lround(360.0 / cellDegrees));
+
+  self.cellLatitudeDegrees   = 180.0 / rows;
+  self.cellLongitudeDegrees  = 360.0 / columns;
+
+
+  // Cell of each photo, or -1.  Then counting sort by cell.
+  //
+  NSUInteger   photoCount  = [self.photoArray count];
+  NSInteger    cellCount   = rows * columns;
+  NSInteger   *photoCells  = malloc(MAX(photoCount, 1) * sizeof(NSInteger));
+  double      *photoLats   = malloc(MAX(photoCount, 1) * sizeof(double));
+  double      *photoLons   = malloc(MAX(photoCount, 1) * sizeof(double));
+
+  cellStart = calloc(cellCount + 1, sizeof(uint32_t));
+
+  NSUInteger  i = 0;
+
+  for (NSDictionary *entry in self.photoArray)
+  {
+    photoCells[i] = -1;
+
+    if (coordinatesForEntry(entry, &photoLats[i], &photoLons[i]))
+    {
+      photoCells[i] = ([self rowForLatitude:photoLats[i]] * columns) + [self columnForLongitude:photoLons[i]];
+
+      cellStart[photoCells[i] + 1] += 1;
+      self.count += 1;
+    }
+
+    i += 1;
+  }
+
+  for (NSInteger cell = 0; cell < cellCount; cell++) {
+    cellStart[cell + 1] += cellStart[cell];
+  }
+
+
+  //
+  NSUInteger  packedCount = MAX(self.count, 1);
+  uint32_t   *nextPosition = malloc(cellCount * sizeof(uint32_t));
+
+  memcpy(nextPosition, cellStart, cellCount * sizeof(uint32_t));
+
+  latitudes     = malloc(packedCount * sizeof(double));
+  longitudes    = malloc(packedCount * sizeof(double));
+  cosLatitudes  = malloc(packedCount * sizeof(double));
+  photoIndexes  = malloc(packedCount * sizeof(uint32_t));
+
+  for (i = 0; i < photoCount; i++)
+  {
+    if (photoCells[i] < 0)  { continue; }
+
+    uint32_t  position = nextPosition[photoCells[i]]++;
+
+    latitudes[position]     = photoLats[i];
+    longitudes[position]    = photoLons[i];
+    cosLatitudes[position]  = cos(DEGREES_TO_RADIANS(photoLats[i]));
+    photoIndexes[position]  = (uint32_t)i;
+  }
+
+  free(nextPosition);
+  free(photoCells);
+  free(photoLats);
+  free(photoLons);
+
+  return self;
+
+} // initWithPhotoArray:cellDegrees:
+
+
+//-------------------------- -o-
+// initWithGeoIndex:photoArray:positionMap:freshPositions:
+//
+// Each cell gets its surviving points, in their old order, then the
+// points of fresh positions.  O(points + cells), plus parsing of fresh
+// entries only.
+//
+- (id) initWithGeoIndex: (PhotoGeoIndex *)geoIndex
+             photoArray: (NSArray *)photoArray
+            positionMap: (NSData *)positionMap
+         freshPositions: (NSIndexSet *)freshPositions
+{
+  if (    (!geoIndex) || (!freshPositions)
+       || ([positionMap length] != [geoIndex.photoArray count] * sizeof(NSUInteger)) )
+  {
+    DP_LOG_ERROR(@"geoIndex, positionMap and freshPositions must describe the previous photo array.");
+    return nil;
+  }
+
+  if ([photoArray count] > UINT32_MAX) {
+    DP_LOG_ERROR(@"photoArray is too large to index.");
+    return nil;
+  }
+
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+
+  //
+  self.photoArray  = [photoArray copy];
+
+  rows     = geoIndex->rows;
+  columns  = geoIndex->columns;
+
+  self.cellLatitudeDegrees   = geoIndex.cellLatitudeDegrees;
+  self.cellLongitudeDegrees  = geoIndex.cellLongitudeDegrees;
+
+
+  // Fresh points, and count per cell of survivors and fresh points.
+  //
+  const NSUInteger  *newPositions  = [positionMap bytes];
+  NSInteger          cellCount     = rows * columns;
+  NSUInteger         freshCount    = [freshPositions count];
+
+  NSInteger  *freshCells  = malloc(MAX(freshCount, 1) * sizeof(NSInteger));
+  double     *freshLats   = malloc(MAX(freshCount, 1) * sizeof(double));
+  double     *freshLons   = malloc(MAX(freshCount, 1) * sizeof(double));
+  uint32_t   *freshIndex  = malloc(MAX(freshCount, 1) * sizeof(uint32_t));
+
+  cellStart = calloc(cellCount + 1, sizeof(uint32_t));
+
+  __block  NSUInteger  f = 0;
+
+  [freshPositions enumerateIndexesUsingBlock:^(NSUInteger position, BOOL *stop) {
+    if (coordinatesForEntry([self.photoArray objectAtIndex:position], &freshLats[f], &freshLons[f]))
+    {
+      freshCells[f]  = ([self rowForLatitude:freshLats[f]] * columns) + [self columnForLongitude:freshLons[f]];
+      freshIndex[f]  = (uint32_t)position;
+
+      cellStart[freshCells[f] + 1] += 1;
+      f += 1;
+    }
+  }];
+
+  for (NSInteger cell = 0; cell < cellCount; cell++)
+  {
+    for (uint32_t position = geoIndex->cellStart[cell]; position < geoIndex->cellStart[cell + 1]; position++) {
+      if (NSNotFound != newPositions[geoIndex->photoIndexes[position]])  { cellStart[cell + 1] += 1; }
+    }
+  }
+
+  for (NSInteger cell = 0; cell < cellCount; cell++) {
+    cellStart[cell + 1] += cellStart[cell];
+  }
+
+  self.count = cellStart[cellCount];
+
+
+  //
+  NSUInteger  packedCount   = MAX(self.count, 1);
+  uint32_t   *nextPosition  = malloc(cellCount * sizeof(uint32_t));
+
+  memcpy(nextPosition, cellStart, cellCount * sizeof(uint32_t));
+
+  latitudes     = malloc(packedCount * sizeof(double));
+  longitudes    = malloc(packedCount * sizeof(double));
+  cosLatitudes  = malloc(packedCount * sizeof(double));
+  photoIndexes  = malloc(packedCount * sizeof(uint32_t));
+
+  for (NSInteger cell = 0; cell < cellCount; cell++)
+  {
+    for (uint32_t old = geoIndex->cellStart[cell]; old < geoIndex->cellStart[cell + 1]; old++)
+    {
+      NSUInteger  photoIndex = newPositions[geoIndex->photoIndexes[old]];
+
+      if (NSNotFound == photoIndex)  { continue; }
+
+      uint32_t  position = nextPosition[cell]++;
+
+      latitudes[position]     = geoIndex->latitudes[old];
+      longitudes[position]    = geoIndex->longitudes[old];
+      cosLatitudes[position]  = geoIndex->cosLatitudes[old];
+      photoIndexes[position]  = (uint32_t)photoIndex;
+    }
+  }
+
+  for (NSUInteger n = 0; n < f; n++)
+  {
+    uint32_t  position = nextPosition[freshCells[n]]++;
+
+    latitudes[position]     = freshLats[n];
+    longitudes[position]    = freshLons[n];
+    cosLatitudes[position]  = cos(DEGREES_TO_RADIANS(freshLats[n]));
+    photoIndexes[position]  = freshIndex[n];
+  }
+
+  free(nextPosition);
+  free(freshCells);
+  free(freshLats);
+  free(freshLons);
+  free(freshIndex);
+
+  return self;
+
+} // initWithGeoIndex:photoArray:positionMap:freshPositions:
+
+
+//-------------------------- -o-
+- (void) dealloc
+{
+  free(cellStart);
+  free(latitudes);
+  free(longitudes);
+  free(cosLatitudes);
+  free(photoIndexes);
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//-------------------------- -o-
+// photoArrayNearestLatitude:longitude:count:
+//
+// RETURN:  Up to count photo entries, nearest first.
+//
+- (NSArray *) photoArrayNearestLatitude: (double)latitude
+                              longitude: (double)longitude
+                                  count: (NSUInteger)count
+{
+  count = MIN(count, self.count);
+
+  if ((count < 1) || (latitude < -90) || (latitude > 90) || !isfinite(longitude)) {
+    return @[];
+  }
+
+
+  //
+  GeoNearest  nearest;
+
+  nearest.latitude     = latitude;
+  nearest.longitude    = normalizedLongitude(longitude);
+  nearest.cosLatitude  = cos(DEGREES_TO_RADIANS(latitude));
+  nearest.k            = count;
+  nearest.found        = 0;
+  nearest.distances    = malloc(count * sizeof(double));
+  nearest.positions    = malloc(count * sizeof(uint32_t));
+
+  NSInteger  row     = [self rowForLatitude:latitude];
+  NSInteger  column  = [self columnForLongitude:nearest.longitude];
+
+
+  //
+  for (NSInteger r = 0; ; r++)
+  {
+    BOOL  allColumns = ((2 * r + 1) >= columns);
+
+    for (NSInteger dr = -r; dr <= r; dr++)
+    {
+      NSInteger  ringRow = row + dr;
+
+      if ((ringRow < 0) || (ringRow >= rows))  { continue; }
+
+      if ((dr == -r) || (dr == r))
+      {
+        if (allColumns) {
+          for (NSInteger c = 0; c < columns; c++) {
+            [self visitCell:(ringRow * columns + c) nearest:&nearest];
+          }
+        } else {
+          for (NSInteger dc = -r; dc <= r; dc++) {
+            [self visitCell:(ringRow * columns + (column + dc + columns) % columns) nearest:&nearest];
+          }
+        }
+
+      } else if (2 * r <= columns) {     // Columns exactly r away, around the wrap.
+        [self visitCell:(ringRow * columns + (column + r) % columns) nearest:&nearest];
+
+        if (2 * r != columns) {
+          [self visitCell:(ringRow * columns + (column - r + columns) % columns) nearest:&nearest];
+        }
+      }
+    }
+
+
+    // Stop when every cell is visited, or when unvisited cells can hold
+    //   nothing nearer than the k-th candidate.
+    //
+    BOOL  allRows = ((row - r) <= 0) && ((row + r) >= (rows - 1));
+
+    if (allRows && allColumns)  { break; }
+
+    if (nearest.found < nearest.k)  { continue; }
+
+    double  latitudeGap = INFINITY;
+
+    if ((row - r) > 0) {
+      latitudeGap = MIN(latitudeGap, latitude - (((row - r) * self.cellLatitudeDegrees) - 90.0));
+    }
+    if ((row + r) < (rows - 1)) {
+      latitudeGap = MIN(latitudeGap, (((row + r + 1) * self.cellLatitudeDegrees) - 90.0) - latitude);
+    }
+
+    double  longitudeBound = INFINITY;
+
+    if (!allColumns) {
+      double  longitudeGap = MIN(nearest.longitude - (((column - r) * self.cellLongitudeDegrees) - 180.0),
+                                 (((column + r + 1) * self.cellLongitudeDegrees) - 180.0) - nearest.longitude);
+
+      // Distance from the query point to the meridian longitudeGap away.
+      //
+      longitudeBound = asin(nearest.cosLatitude * sin(DEGREES_TO_RADIANS(MIN(longitudeGap, 90.0))));
+    }
+
+    if (MIN(DEGREES_TO_RADIANS(latitudeGap), longitudeBound) >= nearest.distances[nearest.k - 1]) {
+      break;
+    }
+  }
+
+
+  //
+  NSMutableArray  *photos = [[NSMutableArray alloc] initWithCapacity:nearest.found];
+
+  for (NSUInteger n = 0; n < nearest.found; n++) {
+    [photos addObject:[self.photoArray objectAtIndex:photoIndexes[nearest.positions[n]]]];
+  }
+
+  free(nearest.distances);
+  free(nearest.positions);
+
+  return photos;
+
+} // photoArrayNearestLatitude:longitude:count:
+
+
+
+//-------------------------- -o-
+// photoArrayInRegionSouth:west:north:east:
+//
+// RETURN:  Photo entries inside the region, boundaries included, in no
+//            particular order.
+//
+// NB  west and east are wrapped into [-180, 180);  west then greater
+//       than east denotes a region across longitude 180, as from 170
+//       to 190.
+//
+- (NSArray *) photoArrayInRegionSouth: (double)south
+                                 west: (double)west
+                                north: (double)north
+                                 east: (double)east
+{
+  NSMutableArray  *photos = [[NSMutableArray alloc] init];
+
+  south = MAX(south, -90.0);
+  north = MIN(north,  90.0);
+
+  if ((south > north) || (self.count < 1))  { return photos; }
+
+
+  //
+  BOOL  allLongitudes = ((east - west) >= 360.0);
+
+  if (!allLongitudes) {
+    west  = normalizedLongitude(west);
+    east  = normalizedLongitude(east);
+  }
+
+  BOOL  acrossAntimeridian = (!allLongitudes) && (west > east);
+
+
+  // Column ranges:  west to east, or west to 180 and -180 to east.
+  //
+  NSInteger  southRow     = [self rowForLatitude:south];
+  NSInteger  northRow     = [self rowForLatitude:north];
+  NSInteger  westColumn   = allLongitudes ? 0             : [self columnForLongitude:west];
+  NSInteger  eastColumn   = allLongitudes ? (columns - 1) : [self columnForLongitude:east];
+  NSInteger  firstColumn[2], lastColumn[2];
+  NSInteger  rangeCount   = 1;
+
+  firstColumn[0]  = westColumn;
+  lastColumn[0]   = eastColumn;
+
+  if (acrossAntimeridian)
+  {
+    if (westColumn <= eastColumn) {       // Ranges would share columns.
+      firstColumn[0]  = 0;
+      lastColumn[0]   = columns - 1;
+
+    } else {
+      lastColumn[0]   = columns - 1;
+      firstColumn[1]  = 0;
+      lastColumn[1]   = eastColumn;
+      rangeCount      = 2;
+    }
+  }
+
+
+  //
+  for (NSInteger row = southRow; row <= northRow; row++)
+  {
+    for (NSInteger r = 0; r < rangeCount; r++)
+    {
+      for (NSInteger column = firstColumn[r]; column <= lastColumn[r]; column++)
+      {
+        NSInteger  cell = (row * columns) + column;
+
+        for (uint32_t position = cellStart[cell]; position < cellStart[cell + 1]; position++)
+        {
+          double  latitude   = latitudes[position];
+          double  longitude  = longitudes[position];
+
+          if ((latitude < south) || (latitude > north))  { continue; }
+
+          if (!allLongitudes) {
+            BOOL  isInside = acrossAntimeridian ? ((longitude >= west) || (longitude <= east))
+                                                : ((longitude >= west) && (longitude <= east));
+            if (!isInside)  { continue; }
+          }
+
+          [photos addObject:[self.photoArray objectAtIndex:photoIndexes[position]]];
+        }
+      }
+    }
+  }
+
+  return photos;
+
+} // photoArrayInRegionSouth:west:north:east:
+
+
+
+//-------------------------- -o-
+// distanceFromLatitude:longitude:toLatitude:longitude:
+//
+// RETURN:  Great circle distance in radians.
+//          Multiply by Earth radius (6371 km) for distance on the ground.
+//
++ (double) distanceFromLatitude: (double)latitude
+                      longitude: (double)longitude
+                     toLatitude: (double)otherLatitude
+                      longitude: (double)otherLongitude
+{
+  return greatCircleDistance(latitude, longitude, cos(DEGREES_TO_RADIANS(latitude)),
+                             otherLatitude, otherLongitude, cos(DEGREES_TO_RADIANS(otherLatitude)));
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Private methods.
+
+//-------------------------- -o-
+- (NSInteger) rowForLatitude: (double)latitude
+{
+  NSInteger  row = (NSInteger)floor((latitude + 90.0) / self.cellLatitudeDegrees);
+  return MAX(0, MIN(row, rows - 1));
+}
+
+
+//-------------------------- -o-
+// ASSUME  longitude is normalized.
+//
+- (NSInteger) columnForLongitude: (double)longitude
+{
+  NSInteger  column = (NSInteger)floor((longitude + 180.0) / self.cellLongitudeDegrees);
+  return MAX(0, MIN(column, columns - 1));
+}
+
+
+
+//-------------------------- -o-
+// visitCell:nearest:
+//
+// Merge points of cell into the k best candidates.
+//
+- (void) visitCell: (NSInteger)cell
+           nearest: (GeoNearest *)nearest
+{
+  for (uint32_t position = cellStart[cell]; position < cellStart[cell + 1]; position++)
+  {
+    double  distance = greatCircleDistance(nearest->latitude, nearest->longitude, nearest->cosLatitude,
+                                           latitudes[position], longitudes[position], cosLatitudes[position]);
+
+    if ((nearest->found == nearest->k) && (distance >= nearest->distances[nearest->k - 1])) {
+      continue;
+    }
+
+
+    // Insertion into sorted candidates;  k is small.
+    //
+    NSUInteger  n = (nearest->found < nearest->k) ? nearest->found++ : (nearest->k - 1);
+
+    while ((n > 0) && (nearest->distances[n - 1] > distance)) {
+      nearest->distances[n]  = nearest->distances[n - 1];
+      nearest->positions[n]  = nearest->positions[n - 1];
+      n -= 1;
+    }
+
+    nearest->distances[n]  = distance;
+    nearest->positions[n]  = position;
+  }
+}
+
+
+@end // @implementation PhotoGeoIndex
+
@@ -0,0 +1,54 @@
+//
+// PhotoSetDiff.h
+//
+// Difference between two fetched photo sets, by FLICKR_PHOTO_ID.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FlickrFetcher.h"
+
+#import "Danaprajna.h"
+
+
+
+//------------------------------------------------------------ -o-
+// Rebuild derived structures, rather than update them, when more than
+//   this fraction of the photo array has changed.
+//
+#define PF_DIFF_REBUILD_RATIO    0.5
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoSetDiff : NSObject
+
+  @property  (readonly, strong, nonatomic)  NSArray  *addedIDs;
+  @property  (readonly, strong, nonatomic)  NSArray  *removedIDs;
+  @property  (readonly, strong, nonatomic)  NSArray  *changedIDs;
+      // Present in both sets, but entry content differs.
+
+  @property  (readonly, strong, nonatomic)  NSDictionary  *photosByID;
+      // FLICKR_PHOTO_ID --> entry, for the new photo set.
+
+  @property  (readonly, nonatomic)  NSUInteger  previousCount;
+
+
+  //
+  + (PhotoSetDiff *) diffFromPhotosByID: (NSDictionary *)previousPhotosByID
+                           toPhotoArray: (NSArray *)photoArray;
+
+  - (NSUInteger)  changeCount;
+  - (BOOL)        isEmpty;
+  - (NSSet *)     touchedIDs;
+
+  - (BOOL) exceedsChangeRatio: (double)ratio;
+      // YES if changes exceed ratio of the larger of previous and new set sizes.
+
+  - (NSData *) positionMapFromPhotoArray: (NSArray *)previousPhotoArray
+                            toPhotoArray: (NSArray *)photoArray
+                          freshPositions: (NSIndexSet **)freshPositions;
+      // See PhotoSetDiff.m.  For indexes kept by position in the photo array.
+
+@end
+
@@ -0,0 +1,190 @@
+//
+// PhotoSetDiff.m
+//
+// O(N) over both photo sets.  Entries without FLICKR_PHOTO_ID are ignored.
+//
+
+#import "PhotoSetDiff.h"
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoSetDiff()
+
+  @property  (readwrite, strong, nonatomic)  NSArray       *addedIDs;
+  @property  (readwrite, strong, nonatomic)  NSArray       *removedIDs;
+  @property  (readwrite, strong, nonatomic)  NSArray       *changedIDs;
+
+  @property  (readwrite, strong, nonatomic)  NSDictionary  *photosByID;
+
+  @property  (readwrite, nonatomic)  NSUInteger  previousCount;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation PhotoSetDiff
+
+#pragma mark - Constructors.
+
+//-------------------------- -o-
+// diffFromPhotosByID:toPhotoArray:
+//
+// previousPhotosByID may be nil, in which case every photo is added.
+//
++ (PhotoSetDiff *) diffFromPhotosByID: (NSDictionary *)previousPhotosByID
+                         toPhotoArray: (NSArray *)photoArray
+{
+  PhotoSetDiff         *diff        = [[PhotoSetDiff alloc] init];
+
+  NSMutableDictionary  *photosByID  = [[NSMutableDictionary alloc] initWithCapacity:[photoArray count]];
+  NSMutableArray       *added       = [[NSMutableArray alloc] init];
+  NSMutableArray       *removed     = [[NSMutableArray alloc] init];
+  NSMutableArray       *changed     = [[NSMutableArray alloc] init];
+
+
+  for (NSDictionary *entry in photoArray)
+  {
+    NSString  *photoID = entry[FLICKR_PHOTO_ID];
+    if (!photoID || [photosByID objectForKey:photoID])  { continue; }
+
+    [photosByID setObject:entry forKey:photoID];
+
+
+    NSDictionary  *previousEntry = [previousPhotosByID objectForKey:photoID];
+
+    if (!previousEntry) {
+      [added addObject:photoID];
+    } else if (! [previousEntry isEqual:entry]) {
+      [changed addObject:photoID];
+    }
+  }
+
+  for (NSString *photoID in previousPhotosByID) {
+    if (! [photosByID objectForKey:photoID]) {
+      [removed addObject:photoID];
+    }
+  }
+
+
+  //
+  diff.photosByID     = photosByID;
+  diff.addedIDs       = added;
+  diff.removedIDs     = removed;
+  diff.changedIDs     = changed;
+  diff.previousCount  = [previousPhotosByID count];
+
+  return diff;
+
+} // diffFromPhotosByID:toPhotoArray:
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//-------------------------- -o-
+- (NSUInteger) changeCount
+{
+  return [self.addedIDs count] + [self.removedIDs count] + [self.changedIDs count];
+}
+
+
+//-------------------------- -o-
+- (BOOL) isEmpty
+{
+  return (0 == [self changeCount]);
+}
+
+
+//-------------------------- -o-
+- (NSSet *) touchedIDs
+{
+  NSMutableSet  *touched = [NSMutableSet setWithArray:self.addedIDs];
+
+  [touched addObjectsFromArray:self.removedIDs];
+  [touched addObjectsFromArray:self.changedIDs];
+
+  return touched;
+}
+
+
+
+//-------------------------- -o-
+- (BOOL) exceedsChangeRatio: (double)ratio
+{
+  NSUInteger  setSize = MAX(self.previousCount, [self.photosByID count]);
+
+  return ([self changeCount] > (ratio * setSize));
+}
+
+
+
+
+//-------------------------- -o-
+// positionMapFromPhotoArray:toPhotoArray:freshPositions:
+//
+// INPUTS--
+//   previousPhotoArray  Photo array of the previous set.
+//   photoArray          Photo array of the new set, as given to the diff.
+//
+// RETURN:  NSData of NSUInteger, one per position of previousPhotoArray:
+//            position in photoArray of the same photo, unchanged  -OR-
+//            NSNotFound if it was removed or changed.
+//            *freshPositions are positions of photoArray that no previous
+//            position maps to:  added and changed photos.
+//          nil if either array has an entry without FLICKR_PHOTO_ID, or
+//            repeats one;  positions cannot be matched by ID.
+//
+// NB  O(N) hash lookups;  no entry is compared or parsed.
+//
+- (NSData *) positionMapFromPhotoArray: (NSArray *)previousPhotoArray
+                          toPhotoArray: (NSArray *)photoArray
+                        freshPositions: (NSIndexSet **)freshPositions
+{
+  if (    ([previousPhotoArray count] != self.previousCount)
+       || ([photoArray count] != [self.photosByID count]) )
+  {
+    return nil;
+  }
+
+
+  //
+  NSMutableDictionary  *positionsByID  = [[NSMutableDictionary alloc] initWithCapacity:[photoArray count]];
+  NSUInteger            position       = 0;
+
+  for (NSDictionary *entry in photoArray) {
+    [positionsByID setObject:@(position++) forKey:entry[FLICKR_PHOTO_ID]];
+  }
+
+  NSSet              *changed    = [NSSet setWithArray:self.changedIDs];
+  NSMutableData      *map        = [[NSMutableData alloc] initWithLength:[previousPhotoArray count] * sizeof(NSUInteger)];
+  NSUInteger         *positions  = [map mutableBytes];
+  NSMutableIndexSet  *fresh      = [[NSMutableIndexSet alloc] initWithIndexesInRange:NSMakeRange(0, [photoArray count])];
+
+  position = 0;
+
+  for (NSDictionary *entry in previousPhotoArray)
+  {
+    NSString  *photoID      = entry[FLICKR_PHOTO_ID];
+    NSNumber  *newPosition  = [changed containsObject:photoID] ? nil : [positionsByID objectForKey:photoID];
+
+    if (!photoID)  { return nil; }
+
+    positions[position++] = newPosition ? [newPosition unsignedIntegerValue] : NSNotFound;
+
+    if (newPosition)  { [fresh removeIndex:[newPosition unsignedIntegerValue]]; }
+  }
+
+  if (freshPositions)  { *freshPositions = fresh; }
+
+  return map;
+
+} // positionMapFromPhotoArray:toPhotoArray:freshPositions:
+
+
+@end // @implementation PhotoSetDiff
+
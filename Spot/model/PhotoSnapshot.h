@@ -0,0 +1,50 @@
+//
+// PhotoSnapshot.h
+//
+// Immutable, versioned photo array of one PFCategory, with derived indexes.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "Spot.h"
+#import "PhotoTagIndex.h"
+#import "PhotoGeoIndex.h"
+#import "PhotoTextIndex.h"
+#import "PhotoSortIndex.h"
+#import "PhotoSetDiff.h"
+
+#import "Danaprajna.h"
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoSnapshot : NSObject
+
+  @property  (readonly, nonatomic)  PFCategory  category;
+
+  @property  (readonly, nonatomic)  NSUInteger  version;
+  @property  (readonly, nonatomic)  NSUInteger  previousVersion;
+      // Version of the snapshot this one was derived from, or zero.
+
+  @property  (readonly, strong, nonatomic)  NSArray        *photoArray;
+  @property  (readonly, strong, nonatomic)  PhotoTagIndex  *tagIndex;
+  @property  (readonly, strong, nonatomic)  PhotoGeoIndex  *geoIndex;
+  @property  (readonly, strong, nonatomic)  PhotoTextIndex *textIndex;
+  @property  (readonly, strong, nonatomic)  PhotoSortIndex *sortIndex;
+
+  @property  (readonly, strong, nonatomic)  PhotoSetDiff   *diff;
+      // Difference from previous snapshot  -OR-  nil if there was none.
+
+
+  //
+  + (PhotoSnapshot *) snapshotWithPhotoArray: (NSArray *)photoArray
+                                    category: (PFCategory)category
+                                     version: (NSUInteger)version
+                                    previous: (PhotoSnapshot *)previous;
+
+  - (NSArray *) sortedPhotoArrayForTag: (NSString *)tag
+                                 order: (PFSortOrder)order;
+
+@end
+
@@ -0,0 +1,180 @@
+//
+// PhotoSnapshot.m
+//
+// NB  Never modified after construction;  safe to read from any thread.
+//     Sorted views are cached on demand, in an NSCache shared by snapshots
+//       derived from one another.  A view is valid while the postings of
+//       its tag are the same object, which PhotoTagIndex keeps for tags
+//       that a diff does not touch.
+//
+
+#import "PhotoSnapshot.h"
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoSnapshot()
+
+  @property  (readwrite, nonatomic)  PFCategory  category;
+
+  @property  (readwrite, nonatomic)  NSUInteger  version;
+  @property  (readwrite, nonatomic)  NSUInteger  previousVersion;
+
+  @property  (readwrite, strong, nonatomic)  NSArray        *photoArray;
+  @property  (readwrite, strong, nonatomic)  PhotoTagIndex  *tagIndex;
+  @property  (readwrite, strong, nonatomic)  PhotoGeoIndex  *geoIndex;
+  @property  (readwrite, strong, nonatomic)  PhotoTextIndex *textIndex;
+  @property  (readwrite, strong, nonatomic)  PhotoSortIndex *sortIndex;
+
+  @property  (strong, nonatomic)  NSCache  *sortedViews;
+      // "order/tag" --> @[ postings of tag, NSArray of entries with tag, sorted ].
+  @property  (readwrite, strong, nonatomic)  PhotoSetDiff   *diff;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o-
+// RETURN:  YES if every photo kept its position.
+//
+static BOOL isIdentityMap(NSData *positionMap)
+{
+  const NSUInteger  *positions  = [positionMap bytes];
+  NSUInteger         count      = [positionMap length] / sizeof(NSUInteger);
+
+  for (NSUInteger position = 0; position < count; position++) {
+    if (positions[position] != position)  { return NO; }
+  }
+
+  return YES;
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation PhotoSnapshot
+
+#pragma mark - Constructors.
+
+//-------------------------- -o-
+// snapshotWithPhotoArray:category:version:previous:
+//
+// Derive indexes from previous snapshot when only a few photos changed;
+// otherwise build them from scratch.
+//
+// NB  Geo, text and sort indexes are derived by position in the photo
+//       array, and are rebuilt if positions cannot be matched by photo ID.
+//
++ (PhotoSnapshot *) snapshotWithPhotoArray: (NSArray *)photoArray
+                                  category: (PFCategory)category
+                                   version: (NSUInteger)version
+                                  previous: (PhotoSnapshot *)previous
+{
+  PhotoSnapshot  *snapshot = [[PhotoSnapshot alloc] init];
+
+  snapshot.category    = category;
+  snapshot.version     = version;
+  snapshot.photoArray  = [photoArray copy];
+
+
+  //
+  NSData      *positionMap     = nil;
+  NSIndexSet  *freshPositions  = nil;
+
+  if (previous)
+  {
+    snapshot.previousVersion  = previous.version;
+    snapshot.diff             = [PhotoSetDiff diffFromPhotosByID: previous.tagIndex.photosByID
+                                                    toPhotoArray: snapshot.photoArray ];
+
+    if (! [snapshot.diff exceedsChangeRatio:PF_DIFF_REBUILD_RATIO])
+    {
+      positionMap = [snapshot.diff positionMapFromPhotoArray: previous.photoArray
+                                                toPhotoArray: snapshot.photoArray
+                                              freshPositions: &freshPositions ];
+    }
+  }
+
+  if (!positionMap)
+  {
+    snapshot.tagIndex     = [[PhotoTagIndex alloc] initWithPhotoArray:snapshot.photoArray];
+    snapshot.geoIndex     = [[PhotoGeoIndex alloc] initWithPhotoArray:snapshot.photoArray];
+    snapshot.textIndex    = [[PhotoTextIndex alloc] initWithPhotoArray:snapshot.photoArray];
+    snapshot.sortIndex    = [[PhotoSortIndex alloc] initWithPhotoArray:snapshot.photoArray];
+    snapshot.sortedViews  = [[NSCache alloc] init];
+    return snapshot;
+  }
+
+  snapshot.sortedViews = previous.sortedViews;
+
+  if ([snapshot.diff isEmpty] && isIdentityMap(positionMap))
+  {
+    snapshot.tagIndex   = previous.tagIndex;
+    snapshot.geoIndex   = previous.geoIndex;
+    snapshot.textIndex  = previous.textIndex;
+    snapshot.sortIndex  = previous.sortIndex;
+    return snapshot;
+  }
+
+
+  //
+  snapshot.tagIndex   = [snapshot.diff isEmpty]
+                          ? previous.tagIndex
+                          : [[PhotoTagIndex alloc] initWithTagIndex:previous.tagIndex applyingDiff:snapshot.diff];
+
+  snapshot.geoIndex   = [[PhotoGeoIndex alloc] initWithGeoIndex: previous.geoIndex
+                                                     photoArray: snapshot.photoArray
+                                                    positionMap: positionMap
+                                                 freshPositions: freshPositions ];
+
+  snapshot.textIndex  = [[PhotoTextIndex alloc] initWithTextIndex: previous.textIndex
+                                                       photoArray: snapshot.photoArray
+                                                      positionMap: positionMap
+                                                   freshPositions: freshPositions ];
+
+  snapshot.sortIndex  = [[PhotoSortIndex alloc] initWithSortIndex: previous.sortIndex
+                                                       photoArray: snapshot.photoArray
+                                                      positionMap: positionMap
+                                                   freshPositions: freshPositions ];
+
+  return snapshot;
+
+} // snapshotWithPhotoArray:category:version:previous:
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//-------------------------- -o-
+// sortedPhotoArrayForTag:order:
+//
+// RETURN:  Photos with tag, in order.
+//
+// NB  O(1) once the view for (tag, order) is cached, by this snapshot or
+//       by one it shares the postings of tag with.
+//
+- (NSArray *) sortedPhotoArrayForTag: (NSString *)tag
+                               order: (PFSortOrder)order
+{
+  NSString  *viewKey   = DP_STRWFMT(@"%d/%@", order, tag);
+  id         postings  = [self.tagIndex photoIDsForTag:tag] ?: [NSNull null];
+  NSArray   *view      = [self.sortedViews objectForKey:viewKey];
+
+  if ([view firstObject] != postings)
+  {
+    NSArray  *sorted = [self.sortIndex sortedPhotoArray:[self.tagIndex photoArrayForTag:tag] order:order];
+
+    view = @[ postings, sorted ];
+    [self.sortedViews setObject:view forKey:viewKey];
+  }
+
+  return [view lastObject];
+}
+
+
+@end // @implementation PhotoSnapshot
+
@@ -0,0 +1,43 @@
+//
+// PhotoSnapshotStore.h
+//
+// One current PhotoSnapshot per PFCategory, bounded by LRU over categories.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "Spot.h"
+#import "PhotoSnapshot.h"
+
+#import "Danaprajna.h"
+
+
+
+//------------------------------------------------------------ -o-
+typedef PhotoSnapshot * (^PhotoSnapshotUpdateBlock)(PhotoSnapshot *current, NSUInteger nextVersion);
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoSnapshotStore : NSObject
+
+  @property  (readonly, nonatomic)  NSUInteger  capacity;
+      // Maximum number of categories held at once.
+
+  @property  (atomic)  PFCategory  currentCategory;
+      // Category presented by the UI.
+
+
+  //
+  - (id) initWithCapacity: (NSUInteger)capacity;
+
+  - (PhotoSnapshot *) snapshotForCategory: (PFCategory)category;
+
+  - (PhotoSnapshot *) updateCategory: (PFCategory)category
+                           withBlock: (PhotoSnapshotUpdateBlock)block;
+
+  - (void) removeAllSnapshots;
+
+@end
+
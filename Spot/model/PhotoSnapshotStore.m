@@ -0,0 +1,192 @@
+//
+// PhotoSnapshotStore.m
+//
+// Readers fetch the current snapshot dictionary through an atomic property
+// and never wait on writers.  Writers build their snapshot outside of
+// writerQueue, then, on writerQueue, build a new dictionary and publish it
+// with a single atomic pointer swap.
+// Snapshots themselves are immutable, so a reader may keep using the one
+// it holds while newer versions are published.
+//
+// Category recency is maintained on writerQueue; readers post their
+// accesses asynchronously.
+//
+
+#import "PhotoSnapshotStore.h"
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoSnapshotStore()
+
+  @property  (readwrite, nonatomic)  NSUInteger  capacity;
+
+  @property  (atomic, strong)  NSDictionary  *snapshots;
+      // NSNumber PFCategory --> PhotoSnapshot.  Replaced, never mutated.
+
+
+  // writerQueue only.
+  //
+  @property  (strong, nonatomic)  dispatch_queue_t   writerQueue;
+  @property  (strong, nonatomic)  NSMutableArray    *recentCategories;   // Most recent first.
+  @property  (nonatomic)          NSUInteger         lastVersion;
+
+  - (void) touchCategory: (NSNumber *)categoryKey;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation PhotoSnapshotStore
+
+#pragma mark - Constructors.
+
+//-------------------------- -o-
+- (id) initWithCapacity: (NSUInteger)capacity
+{
+  if (capacity < 1) {
+    DP_LOG_ERROR(@"capacity must be greater than zero.");
+    return nil;
+  }
+
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+
+  //
+  self.capacity          = capacity;
+  self.snapshots         = @{};
+  self.recentCategories  = [[NSMutableArray alloc] init];
+  self.writerQueue       = dispatch_queue_create("PhotoSnapshotStore writer", DISPATCH_QUEUE_SERIAL);
+
+  return self;
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//-------------------------- -o-
+// snapshotForCategory:
+//
+// RETURN:  Latest published snapshot for category  -OR-  nil.
+//
+- (PhotoSnapshot *) snapshotForCategory: (PFCategory)category
+{
+  NSNumber       *categoryKey  = @(category);
+  PhotoSnapshot  *snapshot     = [self.snapshots objectForKey:categoryKey];
+
+  if (snapshot) {
+    dispatch_async(self.writerQueue, ^{
+      if ([self.snapshots objectForKey:categoryKey]) {    // Not since evicted.
+        [self touchCategory:categoryKey];
+      }
+    });
+  }
+
+  return snapshot;
+}
+
+
+
+//-------------------------- -o-
+// updateCategory:withBlock:
+//
+// block receives the current snapshot of category (possibly nil) and the
+// version to assign to a new snapshot.  If block returns a new snapshot it
+// is published, and the least recently used categories beyond capacity
+// are evicted.
+//
+// block runs on the calling thread, outside of writerQueue.  If another
+// writer publishes a snapshot of category meanwhile, the new snapshot is
+// discarded and block runs again, against the snapshot just published.
+//
+// RETURN:  Snapshot current for category after the update.
+//
+// NB  writerQueue is held only to reserve a version and to swap pointers,
+//       so builds of different categories run concurrently.
+// NB  block may run more than once;  it must not have side effects
+//       beyond building the snapshot it returns.
+//
+- (PhotoSnapshot *) updateCategory: (PFCategory)category
+                         withBlock: (PhotoSnapshotUpdateBlock)block
+{
+  NSNumber               *categoryKey  = @(category);
+  __block PhotoSnapshot  *published    = nil;
+  __block BOOL            isCurrent    = NO;
+
+  while (!isCurrent)
+  {
+    PhotoSnapshot      *current  = [self.snapshots objectForKey:categoryKey];
+    __block NSUInteger  version  = 0;
+
+    dispatch_sync(self.writerQueue, ^{
+      self.lastVersion += 1;
+      version = self.lastVersion;
+    });
+
+    PhotoSnapshot  *built = block(current, version);
+
+    if ((!built) || (built == current)) {
+      return current;
+    }
+
+
+    //
+    dispatch_sync(self.writerQueue,
+    ^{
+      if ([self.snapshots objectForKey:categoryKey] != current)  { return; }
+
+      NSMutableDictionary  *snapshots = [self.snapshots mutableCopy];
+
+      [snapshots setObject:built forKey:categoryKey];
+      [self touchCategory:categoryKey];
+
+      while ([self.recentCategories count] > self.capacity) {
+        [snapshots removeObjectForKey:[self.recentCategories lastObject]];
+        [self.recentCategories removeLastObject];
+      }
+
+      self.snapshots  = [snapshots copy];
+      published       = built;
+      isCurrent       = YES;
+    });
+  }
+
+  return published;
+
+} // updateCategory:withBlock:
+
+
+
+//-------------------------- -o-
+- (void) removeAllSnapshots
+{
+  dispatch_sync(self.writerQueue, ^{
+    [self.recentCategories removeAllObjects];
+    self.snapshots = @{};
+  });
+}
+
+
+
+//-------------------------- -o-
+// touchCategory:
+//
+// NB  writerQueue only.
+//
+- (void) touchCategory: (NSNumber *)categoryKey
+{
+  [self.recentCategories removeObject:categoryKey];
+  [self.recentCategories insertObject:categoryKey atIndex:0];
+}
+
+
+@end // @implementation PhotoSnapshotStore
+
@@ -0,0 +1,49 @@
+//
+// PhotoSortIndex.h
+//
+// Sort keys computed once per photo entry, and the rank of each photo in
+// every sort order, so that any subset of the photos sorts by integer
+// comparison.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FlickrFetcher.h"
+
+#import "Danaprajna.h"
+
+
+
+//------------------------------------------------------------ -o-
+#define PF_PHOTO_DATEUPLOAD_KEY   @"dateupload"       // Seconds since 1970, from extras=date_upload.
+
+
+typedef enum {
+  PFSortOrderTitle,           // Title, then description;  case insensitive.
+  PFSortOrderUploadDate,      // Newest first, then title.
+  PFSortOrderCount
+} PFSortOrder;
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoSortIndex : NSObject
+
+  @property  (readonly, strong, nonatomic)  NSArray  *photoArray;
+
+
+  //
+  - (id) initWithPhotoArray: (NSArray *)photoArray;
+
+  - (id) initWithSortIndex: (PhotoSortIndex *)sortIndex
+                photoArray: (NSArray *)photoArray
+               positionMap: (NSData *)positionMap
+            freshPositions: (NSIndexSet *)freshPositions;
+      // See PhotoSetDiff positionMapFromPhotoArray:toPhotoArray:freshPositions:.
+
+  - (NSArray *) sortedPhotoArray: (NSArray *)photoArray
+                           order: (PFSortOrder)order;
+
+@end
+
@@ -0,0 +1,446 @@
+//
+// PhotoSortIndex.m
+//
+// Title and description keys are folded for case when the index is built.
+// Ranks of a sort order are computed on first use, by a single sort of the
+// whole photo array over the precomputed keys;  later sorts of any subset
+// compare ranks only.
+//
+// initWithSortIndex:photoArray:positionMap:freshPositions: reuses the keys
+// of surviving photos.  For each order already ranked by the previous
+// index, survivors keep their relative order and only fresh photos are
+// sorted, then merged in.
+//
+// NB  Safe to use from any thread.  Rank arrays are created under a lock,
+//       then never modified.
+//
+
+#import "PhotoSortIndex.h"
+
+
+
+//------------------------------------------------------------ -o-
+typedef struct {
+  uint32_t    rank;
+  uint32_t    sequence;       // Position in the array being sorted;  keeps sort stable.
+  void       *entry;
+} RankedEntry;
+
+
+static int compareRankedEntries(const void *a, const void *b)
+{
+  const RankedEntry  *ra = a;
+  const RankedEntry  *rb = b;
+
+  if (ra->rank != rb->rank)  { return (ra->rank < rb->rank) ? -1 : 1; }
+  return (ra->sequence < rb->sequence) ? -1 : ((ra->sequence > rb->sequence) ? 1 : 0);
+}
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoSortIndex()
+{
+  uint32_t  *ranks[PFSortOrderCount];       // By position in photoArray;  NULL until first use.
+}
+
+  @property  (readwrite, strong, nonatomic)  NSArray  *photoArray;
+
+  @property  (strong, nonatomic)  NSDictionary  *positionsByID;      // FLICKR_PHOTO_ID --> NSNumber
+  @property  (strong, nonatomic)  NSArray       *titleKeys;
+  @property  (strong, nonatomic)  NSArray       *descriptionKeys;
+  @property  (strong, nonatomic)  NSArray       *photoIDs;
+  @property  (nonatomic)          double        *uploadDates;
+
+  - (uint32_t *) ranksForOrder: (PFSortOrder)order;
+
+  - (NSComparisonResult) comparePosition: (NSUInteger)a
+                              toPosition: (NSUInteger)b
+                                   order: (PFSortOrder)order;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o-
+static NSString *sortKeyForValue(id value)
+{
+  if (! [value isKindOfClass:[NSString class]])  { return @""; }
+  return [(NSString *)value stringByFoldingWithOptions:NSCaseInsensitiveSearch locale:nil];
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation PhotoSortIndex
+
+#pragma mark - Constructors.
+
+//-------------------------- -o-
+- (id) initWithPhotoArray: (NSArray *)photoArray
+{
+  if ([photoArray count] >= UINT32_MAX) {
+    DP_LOG_ERROR(@"photoArray is too large to index.");
+    return nil;
+  }
+
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+
+  //
+  NSUInteger  photoCount = [photoArray count];
+
+  NSMutableDictionary  *positionsByID    = [[NSMutableDictionary alloc] initWithCapacity:photoCount];
+  NSMutableArray       *titleKeys        = [[NSMutableArray alloc] initWithCapacity:photoCount];
+  NSMutableArray       *descriptionKeys  = [[NSMutableArray alloc] initWithCapacity:photoCount];
+  NSMutableArray       *photoIDs         = [[NSMutableArray alloc] initWithCapacity:photoCount];
+
+  self.photoArray   = [photoArray copy];
+  self.uploadDates  = malloc(MAX(photoCount, 1) * sizeof(double));
+
+  NSUInteger  position = 0;
+
+  for (NSDictionary *entry in self.photoArray)
+  {
+    id  photoID = [entry objectForKey:FLICKR_PHOTO_ID];
+
+    if (photoID) {
+      [positionsByID setObject:@(position) forKey:photoID];
+    }
+
+    [photoIDs         addObject:sortKeyForValue(photoID)];
+    [titleKeys        addObject:sortKeyForValue([entry objectForKey:FLICKR_PHOTO_TITLE])];
+    [descriptionKeys  addObject:sortKeyForValue([entry valueForKeyPath:FLICKR_PHOTO_DESCRIPTION])];
+
+    id  uploadDate = [entry objectForKey:PF_PHOTO_DATEUPLOAD_KEY];
+    self.uploadDates[position] = [uploadDate respondsToSelector:@selector(doubleValue)] ? [uploadDate doubleValue] : 0;
+
+    position += 1;
+  }
+
+  self.positionsByID    = positionsByID;
+  self.titleKeys        = titleKeys;
+  self.descriptionKeys  = descriptionKeys;
+  self.photoIDs         = photoIDs;
+
+  return self;
+
+} // initWithPhotoArray:
+
+
+//-------------------------- -o-
+// initWithSortIndex:photoArray:positionMap:freshPositions:
+//
+// NB  O(n) to merge each order ranked by sortIndex, plus O(f log f) to
+//       sort f fresh photos.
+//
+- (id) initWithSortIndex: (PhotoSortIndex *)sortIndex
+              photoArray: (NSArray *)photoArray
+             positionMap: (NSData *)positionMap
+          freshPositions: (NSIndexSet *)freshPositions
+{
+  if (    (!sortIndex) || (!freshPositions)
+       || ([positionMap length] != [sortIndex.photoArray count] * sizeof(NSUInteger)) )
+  {
+    DP_LOG_ERROR(@"sortIndex, positionMap and freshPositions must describe the previous photo array.");
+    return nil;
+  }
+
+  if ([photoArray count] >= UINT32_MAX) {
+    DP_LOG_ERROR(@"photoArray is too large to index.");
+    return nil;
+  }
+
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+
+  // Old position of each new position, or NSNotFound.
+  //
+  const NSUInteger  *newPositions  = [positionMap bytes];
+  NSUInteger         oldCount      = [sortIndex.photoArray count];
+  NSUInteger         photoCount    = [photoArray count];
+  NSUInteger        *oldPositions  = malloc(MAX(photoCount, 1) * sizeof(NSUInteger));
+
+  for (NSUInteger position = 0; position < photoCount; position++) {
+    oldPositions[position] = NSNotFound;
+  }
+
+  for (NSUInteger old = 0; old < oldCount; old++) {
+    if (NSNotFound != newPositions[old])  { oldPositions[newPositions[old]] = old; }
+  }
+
+
+  //
+  NSMutableDictionary  *positionsByID    = [[NSMutableDictionary alloc] initWithCapacity:photoCount];
+  NSMutableArray       *titleKeys        = [[NSMutableArray alloc] initWithCapacity:photoCount];
+  NSMutableArray       *descriptionKeys  = [[NSMutableArray alloc] initWithCapacity:photoCount];
+  NSMutableArray       *photoIDs         = [[NSMutableArray alloc] initWithCapacity:photoCount];
+
+  self.photoArray   = [photoArray copy];
+  self.uploadDates  = malloc(MAX(photoCount, 1) * sizeof(double));
+
+  NSUInteger  position = 0;
+
+  for (NSDictionary *entry in self.photoArray)
+  {
+    id          photoID  = [entry objectForKey:FLICKR_PHOTO_ID];
+    NSUInteger  old      = oldPositions[position];
+
+    if (photoID) {
+      [positionsByID setObject:@(position) forKey:photoID];
+    }
+
+    if (NSNotFound != old)
+    {
+      [photoIDs         addObject:sortIndex.photoIDs[old]];
+      [titleKeys        addObject:sortIndex.titleKeys[old]];
+      [descriptionKeys  addObject:sortIndex.descriptionKeys[old]];
+
+      self.uploadDates[position] = sortIndex.uploadDates[old];
+
+    } else {
+      [photoIDs         addObject:sortKeyForValue(photoID)];
+      [titleKeys        addObject:sortKeyForValue([entry objectForKey:FLICKR_PHOTO_TITLE])];
+      [descriptionKeys  addObject:sortKeyForValue([entry valueForKeyPath:FLICKR_PHOTO_DESCRIPTION])];
+
+      id  uploadDate = [entry objectForKey:PF_PHOTO_DATEUPLOAD_KEY];
+      self.uploadDates[position] = [uploadDate respondsToSelector:@selector(doubleValue)] ? [uploadDate doubleValue] : 0;
+    }
+
+    position += 1;
+  }
+
+  self.positionsByID    = positionsByID;
+  self.titleKeys        = titleKeys;
+  self.descriptionKeys  = descriptionKeys;
+  self.photoIDs         = photoIDs;
+
+  free(oldPositions);
+
+
+  // Orders not yet ranked by sortIndex stay lazy.
+  //
+  for (int order = 0; order < PFSortOrderCount; order++)
+  {
+    uint32_t  *oldRanks;
+
+    @synchronized(sortIndex) {
+      oldRanks = sortIndex->ranks[order];
+    }
+
+    if (!oldRanks)  { continue; }
+
+
+    // Survivors in old rank order, at their new positions.  Fresh positions sorted.
+    //
+    NSUInteger  *byRank         = malloc(MAX(oldCount, 1) * sizeof(NSUInteger));
+    NSUInteger  *survivors      = malloc(MAX(oldCount, 1) * sizeof(NSUInteger));
+    NSUInteger   survivorCount  = 0;
+
+    for (NSUInteger old = 0; old < oldCount; old++) {
+      byRank[oldRanks[old]] = old;
+    }
+
+    for (NSUInteger rank = 0; rank < oldCount; rank++) {
+      NSUInteger  survivor = newPositions[byRank[rank]];
+      if (NSNotFound != survivor)  { survivors[survivorCount++] = survivor; }
+    }
+
+    NSMutableArray  *fresh = [[NSMutableArray alloc] initWithCapacity:[freshPositions count]];
+
+    [freshPositions enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+      [fresh addObject:@(idx)];
+    }];
+
+    [fresh sortUsingComparator:^NSComparisonResult(NSNumber *na, NSNumber *nb) {
+      return [self comparePosition:[na unsignedIntegerValue] toPosition:[nb unsignedIntegerValue] order:order];
+    }];
+
+
+    //
+    uint32_t    *orderRanks  = malloc(MAX(photoCount, 1) * sizeof(uint32_t));
+    uint32_t     rank        = 0;
+    NSUInteger   s           = 0;
+    NSUInteger   f           = 0;
+
+    while ((s < survivorCount) || (f < [fresh count]))
+    {
+      NSUInteger  next;
+
+      if (    (f >= [fresh count])
+           || (    (s < survivorCount)
+                && (NSOrderedDescending != [self comparePosition: survivors[s]
+                                                      toPosition: [fresh[f] unsignedIntegerValue]
+                                                           order: order]) ) )
+      {
+        next = survivors[s++];
+      } else {
+        next = [fresh[f++] unsignedIntegerValue];
+      }
+
+      orderRanks[next] = rank++;
+    }
+
+    ranks[order] = orderRanks;
+
+    free(byRank);
+    free(survivors);
+  }
+
+  return self;
+
+} // initWithSortIndex:photoArray:positionMap:freshPositions:
+
+
+//-------------------------- -o-
+- (void) dealloc
+{
+  for (int order = 0; order < PFSortOrderCount; order++) {
+    free(ranks[order]);
+  }
+
+  free(self.uploadDates);
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//-------------------------- -o-
+// sortedPhotoArray:order:
+//
+// RETURN:  Entries of photoArray in order.  Entries not in the index keep
+//            their relative order, after all others.
+//
+// NB  O(m log m) integer comparisons for m entries, after the first call
+//       per order.
+//
+- (NSArray *) sortedPhotoArray: (NSArray *)photoArray
+                         order: (PFSortOrder)order
+{
+  NSUInteger  count = [photoArray count];
+
+  if ((NSUInteger)order >= PFSortOrderCount) {
+    DP_LOG_ERROR(@"Unknown sort order %d.", order);
+    return photoArray;
+  }
+
+  if (count < 2)  { return photoArray; }
+
+
+  //
+  uint32_t     *orderRanks  = [self ranksForOrder:order];
+  RankedEntry  *ranked      = malloc(count * sizeof(RankedEntry));
+  uint32_t      sequence    = 0;
+
+  for (NSDictionary *entry in photoArray)
+  {
+    NSNumber  *position = [self.positionsByID objectForKey:[entry objectForKey:FLICKR_PHOTO_ID]];
+
+    ranked[sequence].rank      = position ? orderRanks[[position unsignedIntegerValue]] : UINT32_MAX;
+    ranked[sequence].sequence  = sequence;
+    ranked[sequence].entry     = (__bridge void *)entry;
+
+    sequence += 1;
+  }
+
+  qsort(ranked, count, sizeof(RankedEntry), compareRankedEntries);
+
+
+  //
+  NSMutableArray  *sorted = [[NSMutableArray alloc] initWithCapacity:count];
+
+  for (NSUInteger i = 0; i < count; i++) {
+    [sorted addObject:(__bridge id)ranked[i].entry];
+  }
+
+  free(ranked);
+
+  return sorted;
+
+} // sortedPhotoArray:order:
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Private methods.
+
+//-------------------------- -o-
+// ranksForOrder:
+//
+// RETURN:  Rank in order of each position in photoArray.
+//
+- (uint32_t *) ranksForOrder: (PFSortOrder)order
+{
+  @synchronized(self)
+  {
+    if (ranks[order])  { return ranks[order]; }
+
+
+    //
+    NSUInteger       photoCount  = [self.photoArray count];
+    NSMutableArray  *positions   = [[NSMutableArray alloc] initWithCapacity:photoCount];
+
+    for (NSUInteger position = 0; position < photoCount; position++) {
+      [positions addObject:@(position)];
+    }
+
+    [positions sortUsingComparator:^NSComparisonResult(NSNumber *na, NSNumber *nb) {
+      return [self comparePosition:[na unsignedIntegerValue] toPosition:[nb unsignedIntegerValue] order:order];
+    }];
+
+
+    //
+    uint32_t  *orderRanks = malloc(MAX(photoCount, 1) * sizeof(uint32_t));
+    uint32_t   rank       = 0;
+
+    for (NSNumber *position in positions) {
+      orderRanks[[position unsignedIntegerValue]] = rank++;
+    }
+
+    ranks[order] = orderRanks;
+
+    return orderRanks;
+  }
+
+} // ranksForOrder:
+
+
+
+//-------------------------- -o-
+// comparePosition:toPosition:order:
+//
+// RETURN:  Order of the photos at positions a and b of photoArray.
+//
+- (NSComparisonResult) comparePosition: (NSUInteger)a
+                            toPosition: (NSUInteger)b
+                                 order: (PFSortOrder)order
+{
+  if (PFSortOrderUploadDate == order) {
+    if (self.uploadDates[a] > self.uploadDates[b])  { return NSOrderedAscending; }
+    if (self.uploadDates[a] < self.uploadDates[b])  { return NSOrderedDescending; }
+  }
+
+  NSComparisonResult  result = [self.titleKeys[a] compare:self.titleKeys[b]];
+
+  if (NSOrderedSame == result)  { result = [self.descriptionKeys[a] compare:self.descriptionKeys[b]]; }
+  if (NSOrderedSame == result)  { result = [self.photoIDs[a] compare:self.photoIDs[b] options:NSLiteralSearch]; }
+
+  return result;
+}
+
+
+@end // @implementation PhotoSortIndex
+
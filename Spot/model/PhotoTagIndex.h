@@ -0,0 +1,54 @@
+//
+// PhotoTagIndex.h
+//
+// Inverted index of photo tags:  tag --> photo IDs.
+// Built once per fetch, read many times by tag and photo list views.
+//
+// A tag counts the photos that carry it, once per photo even if an entry
+// repeats the tag.  Empty tags, from repeated separators, are dropped.
+// (Before this index, counts were of tag occurrences, and "" could
+// appear as a tag.)
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FlickrFetcher.h"
+#import "PhotoSetDiff.h"
+
+#import "Danaprajna.h"
+
+
+
+//------------------------------------------------------------ -o-
+#define PF_TAG_EXCEPTION_LIST   @"cs193pspot portrait landscape"
+#define PF_TAG_SEPARATOR        @" "
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoTagIndex : NSObject
+
+  @property  (readonly, strong, nonatomic)  NSDictionary  *photosByID;
+      // FLICKR_PHOTO_ID --> NSDictionary photo entry
+
+  @property  (readonly, strong, nonatomic)  NSDictionary  *tagCounts;
+      // NSString tag --> NSNumber count of distinct photos  (exceptions excluded)
+
+  @property  (readonly, strong, nonatomic)  NSArray       *sortedTags;
+      // Keys of tagCounts in DP_BLOCK_CMPSTR_LOCINS_LT order.
+
+
+  //
+  - (id) initWithPhotoArray: (NSArray *)photoArray;
+
+  - (id) initWithTagIndex: (PhotoTagIndex *)tagIndex
+             applyingDiff: (PhotoSetDiff *)diff;
+
+  - (NSArray *) photoIDsForTag:   (NSString *)tag;
+  - (NSArray *) photoArrayForTag: (NSString *)tag;
+
+  + (NSSet *) tagsToBeIgnored;
+
+@end
+
@@ -0,0 +1,322 @@
+//
+// PhotoTagIndex.m
+//
+// One pass over the photo array produces postings (tag --> photo IDs),
+// per tag counts and the sorted list of tags.  Lookups by tag are
+// then O(postings) rather than O(photos * tags).
+//
+// initWithTagIndex:applyingDiff: derives a new index from an old one,
+// touching only the tags of photos named in the diff.
+//
+// NB  Instances are immutable once initialized.  Postings shared with
+//     a previous index are copied before they are modified.
+//
+
+#import "PhotoTagIndex.h"
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoTagIndex()
+
+  @property  (readwrite, strong, nonatomic)  NSDictionary  *photosByID;
+  @property  (readwrite, strong, nonatomic)  NSDictionary  *tagCounts;
+  @property  (readwrite, strong, nonatomic)  NSArray       *sortedTags;
+
+  @property  (strong, nonatomic)  NSDictionary  *postings;
+      // NSString tag --> NSArray of FLICKR_PHOTO_ID.  In photo array order
+      //   from initWithPhotoArray:;  unordered once a diff is applied.
+
+  + (NSArray *) tagsForEntry: (NSDictionary *)entry;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation PhotoTagIndex
+
+#pragma mark - Constructors.
+
+//-------------------------- -o-
+// initWithPhotoArray:
+//
+// NB  Ignores photo entries without FLICKR_PHOTO_ID, and empty tags.
+// NB  Tags in PF_TAG_EXCEPTION_LIST are posted, but not counted.
+//
+- (id) initWithPhotoArray: (NSArray *)photoArray
+{
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+
+  //
+  NSSet                *exceptions  = [PhotoTagIndex tagsToBeIgnored];
+
+  NSMutableDictionary  *photosByID  = [[NSMutableDictionary alloc] initWithCapacity:[photoArray count]];
+  NSMutableDictionary  *postings    = [[NSMutableDictionary alloc] init];
+  NSMutableDictionary  *tagCounts   = [[NSMutableDictionary alloc] init];
+
+
+  for (NSDictionary *entry in photoArray)
+  {
+    NSString  *photoID = entry[FLICKR_PHOTO_ID];
+    if (!photoID)  { continue; }
+
+    [photosByID setObject:entry forKey:photoID];
+
+
+    for (NSString *tag in [PhotoTagIndex tagsForEntry:entry])
+    {
+      NSMutableArray  *photoIDs = [postings objectForKey:tag];
+
+      if (!photoIDs) {
+        photoIDs = [[NSMutableArray alloc] init];
+        [postings setObject:photoIDs forKey:tag];
+
+      } else if ([[photoIDs lastObject] isEqual:photoID]) {
+        continue;   // Tag repeated within one entry.
+      }
+
+      [photoIDs addObject:photoID];
+    }
+  }
+
+
+  //
+  for (NSString *tag in postings)
+  {
+    if ([exceptions containsObject:tag])  { continue; }
+    [tagCounts setObject:@([[postings objectForKey:tag] count]) forKey:tag];
+  }
+
+
+  //
+  self.photosByID  = photosByID;
+  self.postings    = postings;
+  self.tagCounts   = tagCounts;
+  self.sortedTags  = [[tagCounts allKeys] sortedArrayUsingComparator:DP_BLOCK_CMPSTR_LOCINS_LT];
+
+  return self;
+
+} // initWithPhotoArray:
+
+
+
+//-------------------------- -o-
+// initWithTagIndex:applyingDiff:
+//
+// Retract removed and changed photos, then post added and changed photos.
+// Cost is O(tags + postings touched by the diff), independent of photo count.
+//
+- (id) initWithTagIndex: (PhotoTagIndex *)tagIndex
+           applyingDiff: (PhotoSetDiff *)diff
+{
+  if (!tagIndex) {
+    return [self initWithPhotoArray:[diff.photosByID allValues]];
+  }
+
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+
+  //
+  NSSet                *exceptions   = [PhotoTagIndex tagsToBeIgnored];
+
+  NSMutableDictionary  *postings     = [tagIndex.postings mutableCopy];
+  NSMutableSet         *copiedTags   = [[NSMutableSet alloc] init];
+
+  NSMutableDictionary  *tagCounts    = [tagIndex.tagCounts mutableCopy];
+  NSMutableSet         *touchedTags  = [[NSMutableSet alloc] init];
+
+
+  NSMutableArray *(^postingsForTag)(NSString *, BOOL) = ^NSMutableArray *(NSString *tag, BOOL create)
+  {
+    NSMutableArray  *photoIDs = [postings objectForKey:tag];
+
+    if (!photoIDs) {
+      if (!create)  { return nil; }
+      photoIDs = [[NSMutableArray alloc] init];
+
+    } else if (! [copiedTags containsObject:tag]) {
+      photoIDs = [photoIDs mutableCopy];
+    }
+
+    [postings setObject:photoIDs forKey:tag];
+    [copiedTags addObject:tag];
+    [touchedTags addObject:tag];
+
+    return photoIDs;
+  };
+
+
+  //
+  for (NSArray *photoIDList in @[diff.removedIDs, diff.changedIDs])
+  {
+    for (NSString *photoID in photoIDList)
+    {
+      for (NSString *tag in [PhotoTagIndex tagsForEntry:[tagIndex.photosByID objectForKey:photoID]])
+      {
+        NSMutableArray  *photoIDs = postingsForTag(tag, NO);
+
+        [photoIDs removeObject:photoID];
+        if (photoIDs && ([photoIDs count] <= 0)) {
+          [postings removeObjectForKey:tag];
+        }
+      }
+    }
+  }
+
+  for (NSArray *photoIDList in @[diff.addedIDs, diff.changedIDs])
+  {
+    for (NSString *photoID in photoIDList)
+    {
+      for (NSString *tag in [PhotoTagIndex tagsForEntry:[diff.photosByID objectForKey:photoID]])
+      {
+        NSMutableArray  *photoIDs = postingsForTag(tag, YES);
+
+        if (! [[photoIDs lastObject] isEqual:photoID]) {
+          [photoIDs addObject:photoID];
+        }
+      }
+    }
+  }
+
+
+  // Recount touched tags.  Resort only if the set of tags has changed.
+  //
+  NSMutableArray  *newTags      = [[NSMutableArray alloc] init];
+  NSMutableSet    *droppedTags  = [[NSMutableSet alloc] init];
+
+  for (NSString *tag in touchedTags)
+  {
+    if ([exceptions containsObject:tag])  { continue; }
+
+    NSUInteger  count        = [[postings objectForKey:tag] count];
+    BOOL        wasCounted   = (nil != [tagCounts objectForKey:tag]);
+
+    if (count > 0) {
+      [tagCounts setObject:@(count) forKey:tag];
+      if (!wasCounted)  { [newTags addObject:tag]; }
+
+    } else if (wasCounted) {
+      [tagCounts removeObjectForKey:tag];
+      [droppedTags addObject:tag];
+    }
+  }
+
+
+  NSArray  *sortedTags = tagIndex.sortedTags;
+
+  if (([newTags count] > 0) || ([droppedTags count] > 0))
+  {
+    NSMutableArray  *resorted = [[NSMutableArray alloc] initWithCapacity:[tagCounts count]];
+
+    for (NSString *tag in sortedTags) {
+      if (! [droppedTags containsObject:tag])  { [resorted addObject:tag]; }
+    }
+
+    for (NSString *tag in newTags)
+    {
+      NSUInteger  insertionIndex = [resorted indexOfObject: tag
+                                             inSortedRange: NSMakeRange(0, [resorted count])
+                                                   options: NSBinarySearchingInsertionIndex
+                                           usingComparator: DP_BLOCK_CMPSTR_LOCINS_LT ];
+      [resorted insertObject:tag atIndex:insertionIndex];
+    }
+
+    sortedTags = resorted;
+  }
+
+
+  //
+  self.photosByID  = diff.photosByID;
+  self.postings    = postings;
+  self.tagCounts   = tagCounts;
+  self.sortedTags  = sortedTags;
+
+  return self;
+
+} // initWithTagIndex:applyingDiff:
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//-------------------------- -o-
++ (NSSet *) tagsToBeIgnored
+{
+  static NSSet            *exceptionSet = nil;
+  static dispatch_once_t   onceToken;
+
+  dispatch_once(&onceToken, ^{
+    exceptionSet = [NSSet setWithArray:[PF_TAG_EXCEPTION_LIST componentsSeparatedByString:PF_TAG_SEPARATOR]];
+  });
+
+  return exceptionSet;
+}
+
+
+
+//-------------------------- -o-
+// tagsForEntry:
+//
+// RETURN:  Non-empty tags of entry, possibly repeated;  nil if entry has no tags.
+//
++ (NSArray *) tagsForEntry: (NSDictionary *)entry
+{
+  NSString  *taglist = entry[FLICKR_TAGS];
+  if ([taglist length] <= 0)  { return nil; }
+
+  NSArray  *tags = [taglist componentsSeparatedByString:PF_TAG_SEPARATOR];
+
+  if ([tags containsObject:@""]) {
+    tags = [tags filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"length > 0"]];
+  }
+
+  return tags;
+}
+
+
+
+//-------------------------- -o-
+- (NSArray *) photoIDsForTag: (NSString *)tag
+{
+  if (!tag)  { return nil; }
+  return [self.postings objectForKey:tag];
+}
+
+
+
+//-------------------------- -o-
+// photoArrayForTag:
+//
+// RETURN:  Photo entries containing tag.
+//
+// NB  Order is that of the photo array only for an index built by
+//       initWithPhotoArray:.  After initWithTagIndex:applyingDiff:, changed
+//       and added photos are appended, so order is unspecified.  Callers
+//       that display the result sort it.
+//
+- (NSArray *) photoArrayForTag: (NSString *)tag
+{
+  NSArray         *photoIDs      = [self photoIDsForTag:tag];
+  NSMutableArray  *taggedPhotos  = [[NSMutableArray alloc] initWithCapacity:[photoIDs count]];
+
+  for (NSString *photoID in photoIDs) {
+    [taggedPhotos addObject:[self.photosByID objectForKey:photoID]];
+  }
+
+  return taggedPhotos;
+}
+
+
+@end // @implementation PhotoTagIndex
+
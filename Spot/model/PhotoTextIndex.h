@@ -0,0 +1,43 @@
+//
+// PhotoTextIndex.h
+//
+// Inverted index over words of FLICKR_PHOTO_TITLE and
+// FLICKR_PHOTO_DESCRIPTION, folded for case and diacritics.
+// Every query word matches as a prefix;  all words must match.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FlickrFetcher.h"
+
+#import "Danaprajna.h"
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoTextIndex : NSObject
+
+  @property  (readonly, strong, nonatomic)  NSArray  *photoArray;
+
+  @property  (readonly, strong, nonatomic)  NSArray  *sortedTokens;
+      // Distinct folded words, in literal order.
+
+
+  //
+  - (id) initWithPhotoArray: (NSArray *)photoArray;
+
+  - (id) initWithTextIndex: (PhotoTextIndex *)textIndex
+                photoArray: (NSArray *)photoArray
+               positionMap: (NSData *)positionMap
+            freshPositions: (NSIndexSet *)freshPositions;
+      // See PhotoSetDiff positionMapFromPhotoArray:toPhotoArray:freshPositions:.
+
+  - (NSIndexSet *) photoIndexesMatchingQuery: (NSString *)query;
+  - (NSArray *)    photoArrayMatchingQuery:   (NSString *)query;
+  - (NSSet *)      photoIDsMatchingQuery:     (NSString *)query;
+
+  + (NSArray *) tokensForString: (NSString *)string;
+
+@end
+
@@ -0,0 +1,420 @@
+//
+// PhotoTextIndex.m
+//
+// sortedTokens and postings are parallel arrays.  Tokens sharing a prefix
+// are contiguous in literal order, so a prefix lookup is one binary search
+// followed by a short scan.
+//
+// initWithTextIndex:photoArray:positionMap:freshPositions: tokenizes only
+// added, changed and removed photos.  Postings of tokens they do not touch
+// are shared with the previous index when no surviving photo moved.
+//
+// NB  Never modified after construction;  safe to read from any thread.
+//
+
+#import "PhotoTextIndex.h"
+
+
+
+//------------------------------------------------------------ -o-
+@interface PhotoTextIndex()
+
+  @property  (readwrite, strong, nonatomic)  NSArray  *photoArray;
+  @property  (readwrite, strong, nonatomic)  NSArray  *sortedTokens;
+
+  @property  (strong, nonatomic)  NSArray  *postings;
+      // NSIndexSet of positions in photoArray, per token of sortedTokens.
+
+  - (NSIndexSet *) photoIndexesForPrefix: (NSString *)prefix;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o-
+static NSComparisonResult compareTokens(NSString *a, NSString *b)
+{
+  return [a compare:b options:NSLiteralSearch];
+}
+
+
+// RETURN:  Folded words of title and description of entry.
+//
+static NSArray *tokensForEntry(NSDictionary *entry)
+{
+  id  title        = [entry objectForKey:FLICKR_PHOTO_TITLE];
+  id  description  = [entry valueForKeyPath:FLICKR_PHOTO_DESCRIPTION];
+
+  NSString  *text = DP_STRWFMT(@"%@ %@",
+                      [title isKindOfClass:[NSString class]]        ? title        : @"",
+                      [description isKindOfClass:[NSString class]]  ? description  : @"" );
+
+  return [PhotoTextIndex tokensForString:text];
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation PhotoTextIndex
+
+#pragma mark - Constructors.
+
+//-------------------------- -o-
+- (id) initWithPhotoArray: (NSArray *)photoArray
+{
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+
+  //
+  NSMutableDictionary  *postingsByToken  = [[NSMutableDictionary alloc] init];
+  NSUInteger            position         = 0;
+
+  self.photoArray = [photoArray copy];
+
+  for (NSDictionary *entry in self.photoArray)
+  {
+    for (NSString *token in tokensForEntry(entry))
+    {
+      NSMutableIndexSet  *positions = [postingsByToken objectForKey:token];
+
+      if (!positions) {
+        positions = [[NSMutableIndexSet alloc] init];
+        [postingsByToken setObject:positions forKey:token];
+      }
+
+      [positions addIndex:position];
+    }
+
+    position += 1;
+  }
+
+
+  //
+  self.sortedTokens = [[postingsByToken allKeys] sortedArrayUsingComparator:
+                         ^NSComparisonResult(NSString *a, NSString *b) {
+                           return compareTokens(a, b);
+                         }];
+
+  NSMutableArray  *postings = [[NSMutableArray alloc] initWithCapacity:[self.sortedTokens count]];
+
+  for (NSString *token in self.sortedTokens) {
+    [postings addObject:[[postingsByToken objectForKey:token] copy]];
+  }
+
+  self.postings = postings;
+
+  return self;
+
+} // initWithPhotoArray:
+
+
+
+//-------------------------- -o-
+// initWithTextIndex:photoArray:positionMap:freshPositions:
+//
+// Stale positions, whose photos were removed or changed, are dropped from
+// the tokens of their old entries.  If any surviving photo moved, every
+// posting is remapped instead.  Tokens of fresh positions are then merged
+// in, and tokens left without photos are dropped.
+//
+- (id) initWithTextIndex: (PhotoTextIndex *)textIndex
+              photoArray: (NSArray *)photoArray
+             positionMap: (NSData *)positionMap
+          freshPositions: (NSIndexSet *)freshPositions
+{
+  if (    (!textIndex) || (!freshPositions)
+       || ([positionMap length] != [textIndex.photoArray count] * sizeof(NSUInteger)) )
+  {
+    DP_LOG_ERROR(@"textIndex, positionMap and freshPositions must describe the previous photo array.");
+    return nil;
+  }
+
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+
+  //
+  const NSUInteger   *newPositions  = [positionMap bytes];
+  NSUInteger          oldCount      = [textIndex.photoArray count];
+  NSMutableIndexSet  *stale         = [[NSMutableIndexSet alloc] init];
+  BOOL                survivorMoved = NO;
+
+  self.photoArray = [photoArray copy];
+
+  for (NSUInteger position = 0; position < oldCount; position++)
+  {
+    if (NSNotFound == newPositions[position]) {
+      [stale addIndex:position];
+    } else if (newPositions[position] != position) {
+      survivorMoved = YES;
+    }
+  }
+
+
+  // Old postings, with stale positions removed and survivors remapped.
+  //
+  NSMutableArray  *postings = [textIndex.postings mutableCopy];
+
+  if (survivorMoved)
+  {
+    for (NSUInteger t = 0; t < [postings count]; t++)
+    {
+      NSMutableIndexSet  *remapped = [[NSMutableIndexSet alloc] init];
+
+      [[postings objectAtIndex:t] enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+        if (NSNotFound != newPositions[idx])  { [remapped addIndex:newPositions[idx]]; }
+      }];
+
+      [postings replaceObjectAtIndex:t withObject:remapped];
+    }
+
+  } else if ([stale count] > 0) {
+    NSMutableSet  *staleTokens = [[NSMutableSet alloc] init];
+
+    [stale enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+      [staleTokens addObjectsFromArray:tokensForEntry([textIndex.photoArray objectAtIndex:idx])];
+    }];
+
+    for (NSString *token in staleTokens)
+    {
+      NSUInteger  t = [textIndex.sortedTokens indexOfObject: token
+                                              inSortedRange: NSMakeRange(0, [textIndex.sortedTokens count])
+                                                    options: NSBinarySearchingFirstEqual
+                                            usingComparator: ^NSComparisonResult(NSString *a, NSString *b) {
+                                                               return compareTokens(a, b);
+                                                             }];
+      if (NSNotFound == t)  { continue; }
+
+      NSMutableIndexSet  *positions = [[postings objectAtIndex:t] mutableCopy];
+
+      [positions removeIndexes:stale];
+      [postings replaceObjectAtIndex:t withObject:positions];
+    }
+  }
+
+
+  // Tokens of fresh positions.
+  //
+  NSMutableDictionary  *freshByToken = [[NSMutableDictionary alloc] init];
+
+  [freshPositions enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+    for (NSString *token in tokensForEntry([self.photoArray objectAtIndex:idx]))
+    {
+      NSMutableIndexSet  *positions = [freshByToken objectForKey:token];
+
+      if (!positions) {
+        positions = [[NSMutableIndexSet alloc] init];
+        [freshByToken setObject:positions forKey:token];
+      }
+
+      [positions addIndex:idx];
+    }
+  }];
+
+  NSArray  *freshTokens = [[freshByToken allKeys] sortedArrayUsingComparator:
+                            ^NSComparisonResult(NSString *a, NSString *b) {
+                              return compareTokens(a, b);
+                            }];
+
+
+  // Merge old and fresh tokens, both in literal order.
+  //
+  NSUInteger       capacity        = [textIndex.sortedTokens count] + [freshTokens count];
+  NSMutableArray  *sortedTokens    = [[NSMutableArray alloc] initWithCapacity:capacity];
+  NSMutableArray  *mergedPostings  = [[NSMutableArray alloc] initWithCapacity:capacity];
+  NSUInteger       t               = 0;
+  NSUInteger       f               = 0;
+
+  while ((t < [textIndex.sortedTokens count]) || (f < [freshTokens count]))
+  {
+    NSString           *oldToken    = (t < [textIndex.sortedTokens count]) ? [textIndex.sortedTokens objectAtIndex:t] : nil;
+    NSString           *freshToken  = (f < [freshTokens count])            ? [freshTokens objectAtIndex:f]            : nil;
+    NSComparisonResult  order       = (!oldToken)   ? NSOrderedDescending
+                                    : (!freshToken) ? NSOrderedAscending
+                                    :                 compareTokens(oldToken, freshToken);
+    NSString           *token;
+    NSIndexSet         *positions;
+
+    if (NSOrderedAscending == order)
+    {
+      token      = oldToken;
+      positions  = [postings objectAtIndex:t++];
+
+    } else if (NSOrderedDescending == order) {
+      token      = freshToken;
+      positions  = [freshByToken objectForKey:freshToken];
+
+    } else {
+      NSMutableIndexSet  *merged = [[postings objectAtIndex:t++] mutableCopy];
+
+      [merged addIndexes:[freshByToken objectForKey:freshToken]];
+
+      token      = oldToken;
+      positions  = merged;
+    }
+
+    if (NSOrderedAscending != order)  { f += 1; }
+
+    if ([positions count] < 1)  { continue; }
+
+    [sortedTokens addObject:token];
+    [mergedPostings addObject:[positions copy]];
+  }
+
+  self.sortedTokens  = sortedTokens;
+  self.postings      = mergedPostings;
+
+  return self;
+
+} // initWithTextIndex:photoArray:positionMap:freshPositions:
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//-------------------------- -o-
+// photoIndexesMatchingQuery:
+//
+// RETURN:  Positions in photoArray of photos matching every query word
+//            as a prefix  -OR-  all positions if query has no words.
+//
+- (NSIndexSet *) photoIndexesMatchingQuery: (NSString *)query
+{
+  NSArray  *queryTokens = [PhotoTextIndex tokensForString:query];
+
+  if ([queryTokens count] < 1) {
+    return [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [self.photoArray count])];
+  }
+
+
+  // Narrowest word first keeps intersections small.
+  //
+  NSMutableArray  *matches = [[NSMutableArray alloc] initWithCapacity:[queryTokens count]];
+
+  for (NSString *token in queryTokens)
+  {
+    NSIndexSet  *positions = [self photoIndexesForPrefix:token];
+
+    if ([positions count] < 1)  { return [NSIndexSet indexSet]; }
+    [matches addObject:positions];
+  }
+
+  [matches sortUsingComparator:^NSComparisonResult(NSIndexSet *a, NSIndexSet *b) {
+    return ([a count] < [b count]) ? NSOrderedAscending : (([a count] > [b count]) ? NSOrderedDescending : NSOrderedSame);
+  }];
+
+
+  //
+  NSMutableIndexSet  *result = [[matches objectAtIndex:0] mutableCopy];
+
+  for (NSUInteger m = 1; (m < [matches count]) && ([result count] > 0); m++)
+  {
+    NSIndexSet  *positions = [matches objectAtIndex:m];
+
+    [result removeIndexes:[result indexesPassingTest:^BOOL(NSUInteger idx, BOOL *stop) {
+      return ![positions containsIndex:idx];
+    }]];
+  }
+
+  return result;
+
+} // photoIndexesMatchingQuery:
+
+
+
+//-------------------------- -o-
+- (NSArray *) photoArrayMatchingQuery: (NSString *)query
+{
+  return [self.photoArray objectsAtIndexes:[self photoIndexesMatchingQuery:query]];
+}
+
+
+
+//-------------------------- -o-
+- (NSSet *) photoIDsMatchingQuery: (NSString *)query
+{
+  NSMutableSet  *photoIDs = [[NSMutableSet alloc] init];
+
+  [[self photoIndexesMatchingQuery:query] enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+    id  photoID = [[self.photoArray objectAtIndex:idx] objectForKey:FLICKR_PHOTO_ID];
+    if (photoID)  { [photoIDs addObject:photoID]; }
+  }];
+
+  return photoIDs;
+}
+
+
+
+//-------------------------- -o-
+// tokensForString:
+//
+// RETURN:  Words of string, folded for case and diacritics, in order.
+//
+// NB  Words are maximal runs of letters and digits.
+//
++ (NSArray *) tokensForString: (NSString *)string
+{
+  static NSCharacterSet   *separators = nil;
+  static dispatch_once_t   onceToken;
+
+  dispatch_once(&onceToken, ^{
+    separators = [[NSCharacterSet alphanumericCharacterSet] invertedSet];
+  });
+
+
+  //
+  NSString        *folded  = [string stringByFoldingWithOptions: NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch
+                                                          locale: nil ];
+  NSMutableArray  *tokens  = [[NSMutableArray alloc] init];
+
+  for (NSString *word in [folded componentsSeparatedByCharactersInSet:separators]) {
+    if ([word length] > 0)  { [tokens addObject:word]; }
+  }
+
+  return tokens;
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Private methods.
+
+//-------------------------- -o-
+// photoIndexesForPrefix:
+//
+// ASSUME  prefix is folded.
+//
+- (NSIndexSet *) photoIndexesForPrefix: (NSString *)prefix
+{
+  NSUInteger  first =
+    [self.sortedTokens indexOfObject: prefix
+                       inSortedRange: NSMakeRange(0, [self.sortedTokens count])
+                             options: NSBinarySearchingInsertionIndex | NSBinarySearchingFirstEqual
+                     usingComparator: ^NSComparisonResult(NSString *a, NSString *b) {
+                                        return compareTokens(a, b);
+                                      }];
+
+  NSMutableIndexSet  *positions = [[NSMutableIndexSet alloc] init];
+
+  for (NSUInteger t = first; t < [self.sortedTokens count]; t++)
+  {
+    if (! [[self.sortedTokens objectAtIndex:t] hasPrefix:prefix])  { break; }
+    [positions addIndexes:[self.postings objectAtIndex:t]];
+  }
+
+  return positions;
+}
+
+
+@end // @implementation PhotoTextIndex
+
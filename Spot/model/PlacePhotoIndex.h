@@ -0,0 +1,55 @@
+//
+// PlacePhotoIndex.h
+//
+// Top places and the photos in each, by FLICKR_PLACE_ID.
+// Per place photos are fetched concurrently, with a bound on requests in
+// flight, and cached until older than maxAge.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FlickrFetcher.h"
+
+#import "Danaprajna.h"
+#import "QueueRegistry.h"
+
+
+
+//------------------------------------------------------------ -o-
+// Called on the main queue as photos of each place arrive.
+//
+typedef void (^PlacePhotosBlock)(NSDictionary *place, NSArray *photoArray);
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface PlacePhotoIndex : NSObject
+
+  @property  (readonly, nonatomic)  NSTimeInterval  maxAge;
+      // Seconds before cached places or photos must be fetched again.
+
+  @property  (readonly, nonatomic)  NSUInteger  inFlightMax;
+      // Concurrent Flickr requests, at most.
+
+
+  //
+  - (id) initWithMaxAge: (NSTimeInterval)maxAge
+            inFlightMax: (NSUInteger)inFlightMax;
+
+  - (NSArray *) topPlaces;
+
+  - (NSArray *) photosForPlace: (NSDictionary *)place;
+  - (BOOL)      isFreshPlace:   (NSDictionary *)place;
+
+  - (NSUInteger) fetchPhotosForPlaces: (NSArray *)places
+                           maxResults: (NSUInteger)maxResults
+                             progress: (PlacePhotosBlock)progress;
+
+  - (NSArray *) photoArrayForPlaces: (NSArray *)places
+                         maxResults: (NSUInteger)maxResults;
+
+  - (void) removeAllPlaces;
+
+@end
+
@@ -0,0 +1,328 @@
+//
+// PlacePhotoIndex.m
+//
+// All index state is read and written on indexQueue.  Flickr requests
+// run on QRRoleNetwork, outside indexQueue, and only their results are
+// merged under it.
+//
+// Each place being fetched has a dispatch group in pendingGroupByPlaceID,
+// entered by the caller that fetches it and left when its request ends.
+// Callers that need the same place wait on that group instead of
+// fetching it again.
+//
+
+#import "PlacePhotoIndex.h"
+
+
+
+//------------------------------------------------------------ -o-
+@interface PlacePhotoIndex()
+
+  @property  (readwrite, nonatomic)  NSTimeInterval  maxAge;
+  @property  (readwrite, nonatomic)  NSUInteger      inFlightMax;
+
+
+  // indexQueue only.
+  //
+  @property  (strong, nonatomic)  dispatch_queue_t      indexQueue;
+
+  @property  (strong, nonatomic)  NSArray              *places;
+  @property  (strong, nonatomic)  NSDate               *placesFetchDate;
+
+  @property  (strong, nonatomic)  NSMutableDictionary  *photosByPlaceID;       // FLICKR_PLACE_ID --> NSArray
+  @property  (strong, nonatomic)  NSMutableDictionary  *fetchDateByPlaceID;    // FLICKR_PLACE_ID --> NSDate
+  @property  (strong, nonatomic)  NSMutableDictionary  *pendingGroupByPlaceID; // FLICKR_PLACE_ID --> dispatch_group_t, while in flight.
+
+  - (BOOL) isFreshDate: (NSDate *)date;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation PlacePhotoIndex
+
+#pragma mark - Constructors.
+
+//-------------------------- -o-
+- (id) initWithMaxAge: (NSTimeInterval)maxAge
+          inFlightMax: (NSUInteger)inFlightMax
+{
+  if (inFlightMax < 1) {
+    DP_LOG_ERROR(@"inFlightMax must be greater than zero.");
+    return nil;
+  }
+
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+
+  //
+  self.maxAge       = maxAge;
+  self.inFlightMax  = inFlightMax;
+
+  self.indexQueue             = dispatch_queue_create("PlacePhotoIndex", DISPATCH_QUEUE_SERIAL);
+  self.photosByPlaceID        = [[NSMutableDictionary alloc] init];
+  self.fetchDateByPlaceID     = [[NSMutableDictionary alloc] init];
+  self.pendingGroupByPlaceID  = [[NSMutableDictionary alloc] init];
+
+  return self;
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//-------------------------- -o-
+// topPlaces
+//
+// RETURN:  Cached places if fresh, otherwise places fetched from Flickr.
+//          Stale places if the fetch fails.  -OR-  nil.
+//
+// ASSUME  Calling environment spawns thread before calling this method.
+//
+- (NSArray *) topPlaces
+{
+  __block NSArray  *places  = nil;
+  __block BOOL      isFresh = NO;
+
+  dispatch_sync(self.indexQueue, ^{
+    places   = self.places;
+    isFresh  = [self isFreshDate:self.placesFetchDate];
+  });
+
+  if (isFresh)  { return places; }
+
+
+  //
+  NSArray  *fetchedPlaces = [FlickrFetcher topPlaces];
+
+  if (!fetchedPlaces) {
+    DP_LOG_WARNING(@"Top places fetch failed;  keeping %lu cached places.", (unsigned long)[places count]);
+    return places;
+  }
+
+  dispatch_sync(self.indexQueue, ^{
+    self.places           = [fetchedPlaces copy];
+    self.placesFetchDate  = DP_DATE_NOW;
+  });
+
+  return fetchedPlaces;
+
+} // topPlaces
+
+
+
+//-------------------------- -o-
+// photosForPlace:
+//
+// RETURN:  Cached photos of place, fresh or not  -OR-  nil.
+//
+- (NSArray *) photosForPlace: (NSDictionary *)place
+{
+  NSString        *placeID  = [place objectForKey:FLICKR_PLACE_ID];
+  __block NSArray *photos   = nil;
+
+  if (!placeID)  { return nil; }
+
+  dispatch_sync(self.indexQueue, ^{
+    photos = [self.photosByPlaceID objectForKey:placeID];
+  });
+
+  return photos;
+}
+
+
+
+//-------------------------- -o-
+- (BOOL) isFreshPlace: (NSDictionary *)place
+{
+  NSString      *placeID  = [place objectForKey:FLICKR_PLACE_ID];
+  __block BOOL   isFresh  = NO;
+
+  if (!placeID)  { return NO; }
+
+  dispatch_sync(self.indexQueue, ^{
+    isFresh = [self isFreshDate:[self.fetchDateByPlaceID objectForKey:placeID]];
+  });
+
+  return isFresh;
+}
+
+
+
+//-------------------------- -o-
+// fetchPhotosForPlaces:maxResults:progress:
+//
+// Fetch photos of each place not fresh in the cache, at most inFlightMax
+// at a time.  Returns once every request has completed, including those
+// of other callers for the same places.
+//
+// RETURN:  Number of places whose photos were fetched by this call.
+//
+// NB  Places already being fetched by another caller are not requested
+//       again;  this call waits for them.
+// NB  A failed request keeps the photos previously cached for that place.
+// NB  maxResults applies to new requests only;  cached photos are reused
+//       whatever maxResults they were fetched with.
+//
+// ASSUME  Calling environment spawns thread before calling this method,
+//           not on QRRoleNetwork.
+//
+- (NSUInteger) fetchPhotosForPlaces: (NSArray *)places
+                         maxResults: (NSUInteger)maxResults
+                           progress: (PlacePhotosBlock)progress
+{
+  NSMutableArray  *stalePlaces    = [[NSMutableArray alloc] init];
+  NSMutableArray  *pendingGroups  = [[NSMutableArray alloc] init];       // Of other callers.
+
+  dispatch_sync(self.indexQueue,
+  ^{
+    for (NSDictionary *place in places)
+    {
+      NSString          *placeID       = [place objectForKey:FLICKR_PLACE_ID];
+      dispatch_group_t   pendingGroup  = placeID ? [self.pendingGroupByPlaceID objectForKey:placeID] : nil;
+
+      if (pendingGroup) {
+        [pendingGroups addObject:pendingGroup];
+        continue;
+      }
+
+      if ((!placeID) || [self isFreshDate:[self.fetchDateByPlaceID objectForKey:placeID]])  { continue; }
+
+      pendingGroup = dispatch_group_create();
+      dispatch_group_enter(pendingGroup);
+
+      [self.pendingGroupByPlaceID setObject:pendingGroup forKey:placeID];
+      [stalePlaces addObject:place];
+    }
+  });
+
+
+  //
+  dispatch_group_t      fetchGroup   = dispatch_group_create();
+  dispatch_semaphore_t  inFlight     = dispatch_semaphore_create(self.inFlightMax);
+  __block NSUInteger    fetchCount   = 0;
+  NSTimeInterval        start        = [NSDate timeIntervalSinceReferenceDate];
+
+  for (NSDictionary *place in stalePlaces)
+  {
+    dispatch_semaphore_wait(inFlight, DISPATCH_TIME_FOREVER);
+
+    [QueueRegistry async:QRRoleNetwork group:fetchGroup block:
+    ^{
+      NSString  *placeID  = [place objectForKey:FLICKR_PLACE_ID];
+      NSArray   *photos   = [FlickrFetcher photosInPlace:place maxResults:(int)maxResults];
+
+      dispatch_semaphore_signal(inFlight);
+
+      dispatch_sync(self.indexQueue, ^{
+        if (photos) {
+          [self.photosByPlaceID     setObject:[photos copy] forKey:placeID];
+          [self.fetchDateByPlaceID  setObject:DP_DATE_NOW   forKey:placeID];
+          fetchCount += 1;
+        }
+
+        dispatch_group_leave([self.pendingGroupByPlaceID objectForKey:placeID]);
+        [self.pendingGroupByPlaceID removeObjectForKey:placeID];
+      });
+
+      if (!photos) {
+        DP_LOG_WARNING(@"Photos fetch failed for place %@.", placeID);
+        return;
+      }
+
+      if (progress) {
+        dispatch_async(dispatch_get_main_queue(), ^{ progress(place, photos); });
+      }
+    }];
+  }
+
+  dispatch_group_wait(fetchGroup, DISPATCH_TIME_FOREVER);
+
+  for (dispatch_group_t pendingGroup in pendingGroups) {
+    dispatch_group_wait(pendingGroup, DISPATCH_TIME_FOREVER);
+  }
+
+  if ([stalePlaces count] > 0) {
+    DP_LOG_INFO(@"Fetched photos for %lu of %lu places in %.3f s.",
+                  (unsigned long)fetchCount, (unsigned long)[stalePlaces count],
+                  [NSDate timeIntervalSinceReferenceDate] - start);
+  }
+
+  return fetchCount;
+
+} // fetchPhotosForPlaces:maxResults:progress:
+
+
+
+//-------------------------- -o-
+// photoArrayForPlaces:maxResults:
+//
+// Refresh stale places, waiting for any that another caller is refreshing,
+// then merge photos of all places in places order.
+//
+// RETURN:  Photo array without duplicate FLICKR_PHOTO_IDs.
+//
+// ASSUME  Calling environment spawns thread before calling this method.
+//
+- (NSArray *) photoArrayForPlaces: (NSArray *)places
+                       maxResults: (NSUInteger)maxResults
+{
+  [self fetchPhotosForPlaces:places maxResults:maxResults progress:nil];
+
+
+  //
+  NSMutableArray  *photoArray  = [[NSMutableArray alloc] init];
+  NSMutableSet    *photoIDs    = [[NSMutableSet alloc] init];
+
+  for (NSDictionary *place in places)
+  {
+    for (NSDictionary *entry in [self photosForPlace:place])
+    {
+      NSString  *photoID = [entry objectForKey:FLICKR_PHOTO_ID];
+
+      if (photoID && ![photoIDs containsObject:photoID]) {
+        [photoIDs addObject:photoID];
+        [photoArray addObject:entry];
+      }
+    }
+  }
+
+  return photoArray;
+}
+
+
+
+//-------------------------- -o-
+- (void) removeAllPlaces
+{
+  dispatch_sync(self.indexQueue, ^{
+    self.places           = nil;
+    self.placesFetchDate  = nil;
+
+    [self.photosByPlaceID     removeAllObjects];
+    [self.fetchDateByPlaceID  removeAllObjects];
+  });
+}
+
+
+
+//-------------------------- -o-
+// isFreshDate:
+//
+// NB  indexQueue only.
+//
+- (BOOL) isFreshDate: (NSDate *)date
+{
+  return date && (-[date timeIntervalSinceNow] < self.maxAge);
+}
+
+
+@end // @implementation PlacePhotoIndex
+
@@ -0,0 +1,53 @@
+//
+// RecentsStore.h
+//
+// Most recently viewed photos, newest last, bounded by capacity.
+// Photos are held once by FLICKR_PHOTO_ID and ordered by ID;  changes
+// are appended to a log file that is replayed on launch and compacted
+// as it grows.
+//
+// Add and trim are hash lookups plus an array move;  listing k photos 
+// is O(k);  nothing is sorted.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FlickrFetcher.h"
+
+#import "Danaprajna.h"
+
+
+
+//------------------------------------------------------------ -o-
+#define RS_LOG_FILENAME_DEFAULT    @"recents.log"
+
+#define RS_LOG_COMPACT_SLACK       64
+    // Compact once the log holds this many records more than twice count.
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface RecentsStore : NSObject
+
+  @property  (readonly, strong, nonatomic)  NSURL       *logURL;
+  @property  (readonly, nonatomic)          NSUInteger   capacity;
+
+
+  //
+  - (id) initWithLogURL: (NSURL *)logURL
+               capacity: (NSUInteger)capacity;
+
+  - (NSUInteger) count;
+
+  - (BOOL) containsPhotoID: (NSString *)photoID;
+
+  - (void) addPhotoEntry: (NSDictionary *)photoEntry;
+
+  - (NSArray *) photoArrayMostRecent: (NSUInteger)maxCount;
+  - (NSArray *) photoArray;
+
+  - (void) removeAllPhotos;
+
+@end
+
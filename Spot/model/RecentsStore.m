@@ -0,0 +1,388 @@
+//
+// RecentsStore.m
+//
+// LOG FORMAT--
+//   Zero or more records, each a little-endian uint32 length followed by
+//   a binary property list:
+//
+//     [ RS_RECORD_ADD, photoID ]             Photo already in the store.
+//     [ RS_RECORD_ADD, photoID, photoEntry ] Photo new to the store.
+//
+//   Replaying the records in order against the same capacity rebuilds
+//   the store.  A torn record at the end is dropped.  removeAllPhotos
+//   truncates the log.
+//
+
+#import "RecentsStore.h"
+
+
+
+//------------------------------------------------------------ -o-
+#define RS_RECORD_ADD   @"+"
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface RecentsStore()
+
+  @property  (readwrite, strong, nonatomic)  NSURL       *logURL;
+  @property  (readwrite, nonatomic)          NSUInteger   capacity;
+
+  @property  (strong, nonatomic)  NSMutableOrderedSet  *photoIDs;       // Oldest first.
+  @property  (strong, nonatomic)  NSMutableDictionary  *entriesByID;
+
+  @property  (strong, nonatomic)  NSFileHandle  *logHandle;
+  @property  (nonatomic)          NSUInteger     logRecordCount;
+
+
+  //
+  - (BOOL) applyPhotoID: (NSString *)photoID
+                  entry: (NSDictionary *)photoEntry;
+
+  - (void) replayLog;
+  - (void) compactLog;
+
+  - (NSData *) recordForPhotoID: (NSString *)photoID
+                          entry: (NSDictionary *)photoEntry;
+
+  - (void) openLog;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation RecentsStore
+
+#pragma mark - Constructors.
+
+//-------------------------- -o-
+// initWithLogURL:capacity:
+//
+// NB  Reads and, if needed, compacts the log before returning.
+//
+- (id) initWithLogURL: (NSURL *)logURL
+             capacity: (NSUInteger)capacity
+{
+  if (!logURL || (capacity < 1)) {
+    DP_LOG_ERROR(@"logURL is undefined or capacity is zero.");
+    return nil;
+  }
+
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+  if (! [Zed createDirectoryForURL:[logURL URLByDeletingLastPathComponent] replace:NO]) {
+    return nil;
+  }
+
+
+  //
+  self.logURL       = logURL;
+  self.capacity     = capacity;
+  self.photoIDs     = [[NSMutableOrderedSet alloc] initWithCapacity:capacity + 1];
+  self.entriesByID  = [[NSMutableDictionary alloc] initWithCapacity:capacity + 1];
+
+  [self replayLog];
+
+  if (self.logRecordCount > ((2 * [self.photoIDs count]) + RS_LOG_COMPACT_SLACK)) {
+    [self compactLog];
+  }
+
+  [self openLog];
+
+  return self;
+
+} // initWithLogURL:capacity:
+
+
+//-------------------------- -o-
+- (void) dealloc
+{
+  [self.logHandle closeFile];
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//-------------------------- -o-
+- (NSUInteger) count
+{
+  @synchronized (self) {
+    return [self.photoIDs count];
+  }
+}
+
+
+//-------------------------- -o-
+- (BOOL) containsPhotoID: (NSString *)photoID
+{
+  @synchronized (self) {
+    return (nil != photoID) && [self.photoIDs containsObject:photoID];
+  }
+}
+
+
+
+//-------------------------- -o-
+// addPhotoEntry:
+//
+// Make photoEntry the most recent, then drop the oldest beyond capacity.
+//
+// NB  The entry is kept only while its photo is in the store;  viewing
+//       it again moves the ID and keeps the first entry.
+//
+- (void) addPhotoEntry: (NSDictionary *)photoEntry
+{
+  NSString  *photoID = [[photoEntry objectForKey:FLICKR_PHOTO_ID] description];
+
+  if (!photoID) {
+    DP_LOG_ERROR(@"photoEntry has no %@.", FLICKR_PHOTO_ID);
+    return;
+  }
+
+
+  //
+  @synchronized (self)
+  {
+    BOOL     isNew   = ! [self.photoIDs containsObject:photoID];
+    NSData  *record  = [self recordForPhotoID:photoID entry:(isNew ? photoEntry : nil)];
+
+    [self applyPhotoID:photoID entry:[photoEntry copy]];
+
+    if (!record)  { return; }
+
+    [self.logHandle writeData:record];
+    self.logRecordCount += 1;
+
+    if (self.logRecordCount > ((2 * [self.photoIDs count]) + RS_LOG_COMPACT_SLACK)) {
+      [self compactLog];
+      [self openLog];
+    }
+  }
+
+} // addPhotoEntry:
+
+
+
+//-------------------------- -o-
+// photoArrayMostRecent:
+//
+// RETURN:  Up to maxCount photo entries, newest first.
+//
+- (NSArray *) photoArrayMostRecent: (NSUInteger)maxCount
+{
+  @synchronized (self)
+  {
+    NSUInteger       count       = MIN(maxCount, [self.photoIDs count]);
+    NSUInteger       last        = [self.photoIDs count];
+    NSMutableArray  *photoArray  = [[NSMutableArray alloc] initWithCapacity:count];
+
+    for (NSUInteger i = 1; i <= count; i++) {
+      [photoArray addObject:[self.entriesByID objectForKey:[self.photoIDs objectAtIndex:(last - i)]]];
+    }
+
+    return photoArray;
+  }
+}
+
+
+//-------------------------- -o-
+- (NSArray *) photoArray
+{
+  return [self photoArrayMostRecent:NSUIntegerMax];
+}
+
+
+
+//-------------------------- -o-
+- (void) removeAllPhotos
+{
+  @synchronized (self)
+  {
+    [self.photoIDs removeAllObjects];
+    [self.entriesByID removeAllObjects];
+
+    [self.logHandle truncateFileAtOffset:0];
+    self.logRecordCount = 0;
+  }
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Private methods.
+
+//-------------------------- -o-
+// applyPhotoID:entry:
+//
+// RETURN:  NO if photoID is new to the store and has no entry.
+//
+- (BOOL) applyPhotoID: (NSString *)photoID
+                entry: (NSDictionary *)photoEntry
+{
+  NSUInteger  index = [self.photoIDs indexOfObject:photoID];
+
+  if (NSNotFound != index) {
+    [self.photoIDs removeObjectAtIndex:index];
+
+  } else if (photoEntry) {
+    [self.entriesByID setObject:photoEntry forKey:photoID];
+
+  } else {
+    return NO;
+  }
+
+  [self.photoIDs addObject:photoID];
+
+
+  //
+  while ([self.photoIDs count] > self.capacity)
+  {
+    [self.entriesByID removeObjectForKey:[self.photoIDs firstObject]];
+    [self.photoIDs removeObjectAtIndex:0];
+  }
+
+  return YES;
+
+} // applyPhotoID:entry:
+
+
+
+//-------------------------- -o-
+- (void) replayLog
+{
+  NSData               *log     = [NSData dataWithContentsOfURL:self.logURL options:NSDataReadingMappedIfSafe error:nil];
+  const unsigned char  *bytes   = [log bytes];
+  NSUInteger            length  = [log length];
+  NSUInteger            offset  = 0;
+
+  self.logRecordCount = 0;
+
+  while ((offset + sizeof(uint32_t)) <= length)
+  {
+    uint32_t  recordLength;
+
+    memcpy(&recordLength, bytes + offset, sizeof(uint32_t));
+    recordLength  = NSSwapLittleIntToHost(recordLength);
+    offset       += sizeof(uint32_t);
+
+    if ((offset + recordLength) > length)  { break; }
+
+
+    //
+    NSArray  *record = [NSPropertyListSerialization propertyListWithData: [log subdataWithRange:NSMakeRange(offset, recordLength)]
+                                                                 options: NSPropertyListImmutable
+                                                                  format: NULL
+                                                                   error: nil ];
+    offset              += recordLength;
+    self.logRecordCount += 1;
+
+    if (    ![record isKindOfClass:[NSArray class]]
+         || ([record count] < 2)
+         || ![[record objectAtIndex:0] isEqual:RS_RECORD_ADD] )
+    {
+      continue;
+    }
+
+    [self applyPhotoID: [record objectAtIndex:1]
+                 entry: ([record count] > 2) ? [record objectAtIndex:2] : nil ];
+  }
+
+
+  //
+  if (offset < length) {
+    DP_LOG_WARNING(@"Dropping torn record at end of recents log.  (%lu bytes)", (unsigned long)(length - offset));
+    self.logRecordCount = NSUIntegerMax;      // Force compaction.
+  }
+
+} // replayLog
+
+
+
+//-------------------------- -o-
+// compactLog
+//
+// Rewrite the log as one record per photo, oldest first.
+//
+// NB  Closes logHandle;  follow with openLog.
+//
+- (void) compactLog
+{
+  NSMutableData  *log = [[NSMutableData alloc] init];
+
+  for (NSString *photoID in self.photoIDs) {
+    NSData  *record = [self recordForPhotoID:photoID entry:[self.entriesByID objectForKey:photoID]];
+    if (record)  { [log appendData:record]; }
+  }
+
+  [self.logHandle closeFile];
+  self.logHandle = nil;
+
+  if (! [log writeToURL:self.logURL atomically:YES]) {
+    DP_LOG_ERROR(@"Could not write compacted recents log.  (%@)", self.logURL);
+  }
+
+  self.logRecordCount = [self.photoIDs count];
+}
+
+
+
+//-------------------------- -o-
+// recordForPhotoID:entry:
+//
+// RETURN:  Length-prefixed record  -OR-  nil if entry is not a property list.
+//
+- (NSData *) recordForPhotoID: (NSString *)photoID
+                        entry: (NSDictionary *)photoEntry
+{
+  NSArray  *record  = photoEntry ? @[ RS_RECORD_ADD, photoID, photoEntry ] : @[ RS_RECORD_ADD, photoID ];
+  NSError  *error   = nil;
+  NSData   *plist   = [NSPropertyListSerialization dataWithPropertyList: record
+                                                                 format: NSPropertyListBinaryFormat_v1_0
+                                                                options: 0
+                                                                  error: &error ];
+  if (!plist) {
+    DP_LOG_ERROR(@"Could not serialize recents record for %@.  (%@)", photoID, [error localizedDescription]);
+    return nil;
+  }
+
+
+  //
+  uint32_t        length  = NSSwapHostIntToLittle((uint32_t)[plist length]);
+  NSMutableData  *data    = [[NSMutableData alloc] initWithCapacity:sizeof(uint32_t) + [plist length]];
+
+  [data appendBytes:&length length:sizeof(uint32_t)];
+  [data appendData:plist];
+
+  return data;
+}
+
+
+
+//-------------------------- -o-
+- (void) openLog
+{
+  if (! [[NSFileManager defaultManager] fileExistsAtPath:[self.logURL path]]) {
+    [[NSData data] writeToURL:self.logURL atomically:YES];
+  }
+
+  self.logHandle = [NSFileHandle fileHandleForWritingToURL:self.logURL error:nil];
+  [self.logHandle seekToEndOfFile];
+
+  if (!self.logHandle) {
+    DP_LOG_ERROR(@"Could not open recents log;  changes will not persist.  (%@)", self.logURL);
+  }
+}
+
+
+@end // @implementation RecentsStore
+
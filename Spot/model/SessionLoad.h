@@ -0,0 +1,86 @@
+//
+// SessionLoad.h
+//
+// Simulated user sessions against PhotoFetch, its photo cache and the
+// photo loading path, many at once.  Each session picks a category and
+// shows its list, opens tags and photos within them, revisits recents,
+// and now and then clears recents, which also clears the cache.  Tags
+// and photos are chosen by Zipfian popularity:  a few are opened often,
+// most rarely.
+//
+// Choices are seeded.  A session makes the same choices in every run
+// with the same seed, given the same photo lists.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "Spot.h"
+#import "PhotoFetch.h"
+
+#import "Danaprajna.h"
+
+
+
+//------------------------------------------------------------ -o-
+typedef struct {
+  NSUInteger  sessions;               // Run at once.
+  NSUInteger  rounds;                 // Sessions run one after another by each runner.
+  NSUInteger  tagsPerSession;
+  NSUInteger  photosPerTag;
+  NSUInteger  recentsPerSession;      // Revisits.
+  double      zipfExponent;           // Popularity skew;  0 is uniform.
+  double      refreshProbability;     // Fetch a list again though one is already shown.
+  double      clearProbability;       // Clear recents at the end of a session.
+  uint32_t    seed;
+} SLConfig;
+
+#define SL_CONFIG_DEFAULT  \
+  ((SLConfig) { 8, 4, 3, 4, 2, 1.0, 0.1, 0.05, 193 })
+
+
+// Seconds.
+//
+typedef struct {
+  NSUInteger      count;
+  NSTimeInterval  mean;
+  NSTimeInterval  median;
+  NSTimeInterval  p90;
+  NSTimeInterval  p99;
+  NSTimeInterval  max;
+} SLLatency;
+
+
+typedef struct {
+  NSUInteger      sessions;           // Completed.
+  NSTimeInterval  elapsed;
+
+  SLLatency       timeToList;         // Category shown, or fetched when refreshed.
+  SLLatency       timeToImage;        // Photo data in hand, from cache or network.  Excludes decode.
+
+  uint64_t        photosOpened;
+  uint64_t        cacheHits;
+  double          cacheHitRatio;
+  uint64_t        bytesFetched;       // Photo bytes from the network.
+
+  uint64_t        listFailures;
+  uint64_t        photoFailures;
+  uint64_t        clears;
+
+  uint64_t        peakResidentBytes;  // Sampled every SL_MEMORY_SAMPLE_INTERVAL.
+} SLReport;
+
+
+#define SL_MEMORY_SAMPLE_INTERVAL  0.02
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface SessionLoad : NSObject
+
+  + (SLReport) run: (SLConfig)config;
+
+  + (NSString *) descriptionOfReport: (SLReport)report;
+
+@end
+
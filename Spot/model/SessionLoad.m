@@ -0,0 +1,467 @@
+//
+// SessionLoad.m
+//
+// Each runner is a thread of its own, not a GCD block, so every session
+// really is under way at once, blocked wherever a user would wait:  on
+// the list, then on each photo.  Photos are loaded and kept through the
+// same PhotoFetch methods ImageViewController uses.
+//
+// Sessions tally locally and merge into one SLTally when done.
+//
+
+#import "SessionLoad.h"
+
+#include <math.h>
+
+
+
+//------------------------------------------------------------ -o-
+#define SL_CATEGORY_COUNT  3
+
+static const PFCategory  slCategories[SL_CATEGORY_COUNT] =
+  { PFCategoryLatestGeoreferenced, PFCategoryStanford, PFCategoryTopPlaces };
+
+
+// xorshift32.  state is never zero.
+//
+static uint32_t slNext(uint32_t *state)
+{
+  uint32_t  x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+
+  return (*state = x);
+}
+
+
+static double slUniform(uint32_t *state)
+{
+  return slNext(state) / 4294967296.0;
+}
+
+
+// RETURN:  Rank in [0, count), drawn with probability proportional
+//            to 1 / (rank + 1)^exponent.
+//
+static NSUInteger slZipfIndex(uint32_t *state, NSUInteger count, double exponent)
+{
+  double  total = 0;
+
+  if (count <= 1)  { return 0; }
+
+  for (NSUInteger k = 0; k < count; k++) {
+    total += pow(k + 1, -exponent);
+  }
+
+  double  target = slUniform(state) * total;
+
+  for (NSUInteger k = 0; k < count; k++) {
+    target -= pow(k + 1, -exponent);
+    if (target < 0)  { return k; }
+  }
+
+  return count - 1;
+}
+
+
+// RETURN:  Summary of samples, seconds as NSNumber.  Nearest rank percentiles.
+//
+static SLLatency slLatency(NSArray *samples)
+{
+  SLLatency  latency = { 0, 0, 0, 0, 0, 0 };
+  NSArray   *sorted  = [samples sortedArrayUsingSelector:@selector(compare:)];
+  NSUInteger count   = [sorted count];
+
+  if (count <= 0)  { return latency; }
+
+  latency.count   = count;
+  latency.mean    = [[sorted valueForKeyPath:@"@sum.doubleValue"] doubleValue] / count;
+  latency.median  = [sorted[(count - 1) / 2] doubleValue];
+  latency.p90     = [sorted[(NSUInteger) ceil(0.90 * count) - 1] doubleValue];
+  latency.p99     = [sorted[(NSUInteger) ceil(0.99 * count) - 1] doubleValue];
+  latency.max     = [[sorted lastObject] doubleValue];
+
+  return latency;
+}
+
+
+
+
+//------------------------------------------------------------ -o-
+// Totals across sessions.  @synchronized (self).
+//
+@interface SLTally : NSObject
+
+  @property  (strong, nonatomic)  NSMutableArray  *listTimes;
+  @property  (strong, nonatomic)  NSMutableArray  *imageTimes;
+
+  @property  (nonatomic)  NSUInteger  sessions;
+  @property  (nonatomic)  uint64_t    photosOpened;
+  @property  (nonatomic)  uint64_t    cacheHits;
+  @property  (nonatomic)  uint64_t    bytesFetched;
+  @property  (nonatomic)  uint64_t    listFailures;
+  @property  (nonatomic)  uint64_t    photoFailures;
+  @property  (nonatomic)  uint64_t    clears;
+
+  - (void) addSession: (SLTally *)session;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface SLRunner : NSObject
+
+  @property  (nonatomic)          NSUInteger         index;
+  @property  (nonatomic)          SLConfig           config;
+  @property  (strong, nonatomic)  SLTally           *tally;
+  @property  (strong, nonatomic)  dispatch_group_t   group;
+
+  - (void) run;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface SessionLoad()
+
+  + (void) runSession: (NSUInteger)sessionIndex
+               config: (SLConfig)config
+                tally: (SLTally *)tally;
+
+  + (void) openPhoto: (NSDictionary *)photoEntry
+             tally: (SLTally *)tally;
+
+  + (NSArray *) tagsByPopularity: (PhotoTagIndex *)tagIndex;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation SessionLoad
+
+#pragma mark - Methods.
+
+//-------------------------- -o-
+// run:
+//
+// config.sessions runners, each running config.rounds sessions.
+// Waits for all of them, and for photos they keep to reach the cache.
+//
+// ASSUME  Not called on QRRoleNetwork or QRRoleIndex.
+//
++ (SLReport) run: (SLConfig)config
+{
+  SLReport        report;
+  SLTally        *tally  = [[SLTally alloc] init];
+  dispatch_group_t group = dispatch_group_create();
+  NSTimeInterval  start  = [NSDate timeIntervalSinceReferenceDate];
+
+  memset(&report, 0, sizeof(report));
+
+
+  // Peak memory, sampled on sampleQueue.
+  //
+  __block uint64_t    peakResidentBytes  = dp_resident_bytes();
+  dispatch_queue_t    sampleQueue        = dispatch_queue_create("SessionLoad memory", DISPATCH_QUEUE_SERIAL);
+  dispatch_source_t   sampler            = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, sampleQueue);
+
+  dispatch_source_set_timer(sampler, DISPATCH_TIME_NOW, (uint64_t)(SL_MEMORY_SAMPLE_INTERVAL * NSEC_PER_SEC), NSEC_PER_MSEC);
+  dispatch_source_set_event_handler(sampler, ^{
+    peakResidentBytes = MAX(peakResidentBytes, dp_resident_bytes());
+  });
+  dispatch_resume(sampler);
+
+
+  //
+  for (NSUInteger i = 0; i < config.sessions; i++)
+  {
+    SLRunner  *runner = [[SLRunner alloc] init];
+
+    runner.index   = i;
+    runner.config  = config;
+    runner.tally   = tally;
+    runner.group   = group;
+
+    dispatch_group_enter(group);
+    [NSThread detachNewThreadSelector:@selector(run) toTarget:runner withObject:nil];
+  }
+
+  dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+  [[PhotoFetch photoCache] waitForPendingOperations];
+
+
+  //
+  dispatch_source_cancel(sampler);
+  dispatch_sync(sampleQueue, ^{
+    peakResidentBytes = MAX(peakResidentBytes, dp_resident_bytes());
+  });
+
+  @synchronized (tally)
+  {
+    report.sessions           = tally.sessions;
+    report.elapsed            = [NSDate timeIntervalSinceReferenceDate] - start;
+    report.timeToList         = slLatency(tally.listTimes);
+    report.timeToImage        = slLatency(tally.imageTimes);
+    report.photosOpened       = tally.photosOpened;
+    report.cacheHits          = tally.cacheHits;
+    report.cacheHitRatio      = (tally.photosOpened > 0) ? (double) tally.cacheHits / tally.photosOpened : 0;
+    report.bytesFetched       = tally.bytesFetched;
+    report.listFailures       = tally.listFailures;
+    report.photoFailures      = tally.photoFailures;
+    report.clears             = tally.clears;
+    report.peakResidentBytes  = peakResidentBytes;
+  }
+
+  return report;
+}
+
+
+
+//-------------------------- -o-
++ (NSString *) descriptionOfReport: (SLReport)report
+{
+  NSMutableString  *description = [[NSMutableString alloc] init];
+
+  [description appendFormat:@"sessions %lu in %.3f s\n", (unsigned long)report.sessions, report.elapsed];
+
+  for (NSUInteger i = 0; i < 2; i++)
+  {
+    SLLatency  latency = (0 == i) ? report.timeToList : report.timeToImage;
+
+    [description appendFormat:@"%-14s n %-6lu mean %8.1f  median %8.1f  p90 %8.1f  p99 %8.1f  max %8.1f ms\n",
+                                (0 == i) ? "time to list" : "time to image", (unsigned long)latency.count,
+                                latency.mean * 1000, latency.median * 1000, latency.p90 * 1000, latency.p99 * 1000, latency.max * 1000];
+  }
+
+  [description appendFormat:@"photos %llu,  cache hits %llu (%.1f%%),  fetched %llu bytes\n",
+                              report.photosOpened, report.cacheHits, report.cacheHitRatio * 100, report.bytesFetched];
+  [description appendFormat:@"failed lists %llu,  failed photos %llu,  clears %llu\n",
+                              report.listFailures, report.photoFailures, report.clears];
+  [description appendFormat:@"peak resident %.1f MB", report.peakResidentBytes / (1024.0 * 1024.0)];
+
+  return description;
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Private methods.
+
+//-------------------------- -o-
+// runSession:config:tally:
+//
+// List, tags, photos, recents, and maybe clear.
+//
++ (void) runSession: (NSUInteger)sessionIndex
+             config: (SLConfig)config
+              tally: (SLTally *)tally
+{
+  SLTally   *session  = [[SLTally alloc] init];
+  uint32_t   state    = config.seed ^ ((uint32_t)(sessionIndex + 1) * 0x9e3779b9u);
+
+  if (0 == state)  { state = 1; }
+
+
+  // List.  Fetched when not yet shown, or refreshed.
+  //
+  PFCategory      category  = slCategories[slNext(&state) % SL_CATEGORY_COUNT];
+  PhotoSnapshot  *snapshot  = [[PhotoFetch snapshotStore] snapshotForCategory:category];
+  BOOL            refresh   = !snapshot || (slUniform(&state) < config.refreshProbability);
+  NSTimeInterval  start     = [NSDate timeIntervalSinceReferenceDate];
+
+  if (refresh) {
+    PhotoSnapshot  *fetched = [PhotoFetch fetchPhotos:category paging:PF_PAGING_DEFAULT progress:nil];
+
+    if (fetched)  { snapshot = fetched; }
+    else          { session.listFailures += 1; }
+
+  } else {
+    snapshot = [PhotoFetch showCategory:category];
+  }
+
+  if ([snapshot.photoArray count] > 0) {
+    [session.listTimes addObject:@([NSDate timeIntervalSinceReferenceDate] - start)];
+  }
+
+
+  // Tags, then photos in each.
+  //
+  NSArray  *tags = [self tagsByPopularity:snapshot.tagIndex];
+
+  for (NSUInteger t = 0; (t < config.tagsPerSession) && ([tags count] > 0); t++)
+  {
+    NSString  *tag     = tags[slZipfIndex(&state, [tags count], config.zipfExponent)];
+    NSArray   *photos  = [snapshot sortedPhotoArrayForTag:tag order:PFSortOrderUploadDate];
+
+    for (NSUInteger p = 0; (p < config.photosPerTag) && ([photos count] > 0); p++) {
+      [self openPhoto:photos[slZipfIndex(&state, [photos count], config.zipfExponent)] tally:session];
+    }
+  }
+
+
+  // Recents.
+  //
+  for (NSUInteger r = 0; r < config.recentsPerSession; r++)
+  {
+    NSArray  *recents = [PhotoFetch recentPhotos];
+
+    if ([recents count] <= 0)  { break; }
+
+    [self openPhoto:recents[slNext(&state) % [recents count]] tally:session];
+  }
+
+
+  //
+  if (slUniform(&state) < config.clearProbability) {
+    [PhotoFetch clearRecents];
+    session.clears += 1;
+  }
+
+  session.sessions = 1;
+  [tally addSession:session];
+}
+
+
+
+//-------------------------- -o-
+// openPhoto:tally:
+//
+// Load photoEntry as ImageViewController does, wait for it, then keep it.
+//
++ (void) openPhoto: (NSDictionary *)photoEntry
+             tally: (SLTally *)tally
+{
+  NSURL  *url = [FlickrFetcher urlForPhoto:photoEntry format:FlickrPhotoFormatLarge];
+
+  if (!url) {
+    tally.photoFailures += 1;
+    return;
+  }
+
+
+  //
+  __block NSData   *photoData  = nil;
+  __block BOOL      cached     = NO;
+  dispatch_semaphore_t  done   = dispatch_semaphore_create(0);
+  NSTimeInterval        start  = [NSDate timeIntervalSinceReferenceDate];
+
+  [PhotoFetch photoDataForEntry: photoEntry
+                            url: url
+                     parentSpan: 0
+                     completion: ^(NSData *data, NSURL *sourceURL, BOOL isCached, NSError *error)
+  {
+    photoData  = data;
+    cached     = isCached;
+    dispatch_semaphore_signal(done);
+  }];
+
+  dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+
+  if (!photoData) {
+    tally.photoFailures += 1;
+    return;
+  }
+
+
+  //
+  [tally.imageTimes addObject:@([NSDate timeIntervalSinceReferenceDate] - start)];
+
+  tally.photosOpened += 1;
+
+  if (cached)  { tally.cacheHits += 1; }
+  else         { tally.bytesFetched += [photoData length]; }
+
+  [PhotoFetch keepPhotoData:photoData forEntry:[photoEntry mutableCopy] addToRecents:YES];
+}
+
+
+
+//-------------------------- -o-
+// tagsByPopularity:
+//
+// RETURN:  Tags, most photos first, then by name.
+//
++ (NSArray *) tagsByPopularity: (PhotoTagIndex *)tagIndex
+{
+  NSDictionary  *tagCounts = tagIndex.tagCounts;
+
+  return [[tagCounts allKeys] sortedArrayUsingComparator:^NSComparisonResult(NSString *a, NSString *b) {
+    NSComparisonResult  byCount = [tagCounts[b] compare:tagCounts[a]];
+    return (NSOrderedSame != byCount) ? byCount : [a compare:b];
+  }];
+}
+
+
+@end // @implementation SessionLoad
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation SLTally
+
+//-------------------------- -o-
+- (id) init
+{
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+  self.listTimes   = [[NSMutableArray alloc] init];
+  self.imageTimes  = [[NSMutableArray alloc] init];
+
+  return self;
+}
+
+
+//-------------------------- -o-
+- (void) addSession: (SLTally *)session
+{
+  @synchronized (self)
+  {
+    [self.listTimes  addObjectsFromArray:session.listTimes];
+    [self.imageTimes addObjectsFromArray:session.imageTimes];
+
+    self.sessions       += session.sessions;
+    self.photosOpened   += session.photosOpened;
+    self.cacheHits      += session.cacheHits;
+    self.bytesFetched   += session.bytesFetched;
+    self.listFailures   += session.listFailures;
+    self.photoFailures  += session.photoFailures;
+    self.clears         += session.clears;
+  }
+}
+
+@end // @implementation SLTally
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation SLRunner
+
+//-------------------------- -o-
+- (void) run
+{
+  @autoreleasepool
+  {
+    for (NSUInteger round = 0; round < self.config.rounds; round++) {
+      [SessionLoad runSession:(self.index * self.config.rounds + round) config:self.config tally:self.tally];
+    }
+  }
+
+  dispatch_group_leave(self.group);
+}
+
+@end // @implementation SLRunner
+
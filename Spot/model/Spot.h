@@ -4,3 +4,13 @@
 
 #define PF_TABBAR_FADETIME      0.25
 
+
+
+//------------------------------------------------------------ -o-
+// enumerated values derived from FlickrFetcher method names
+//
+typedef enum { 
+  PFCategoryLatestGeoreferenced, 
+  PFCategoryStanford,
+  PFCategoryTopPlaces 
+} PFCategory;
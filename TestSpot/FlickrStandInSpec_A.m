@@ -0,0 +1,193 @@
+//
+// FlickrStandInSpec_A.m
+//
+// Replay through FlickrFetcher, fixture naming, and seeded fault injection.
+//
+//
+// CLASS DEPENDENCIES:  FlickrStandIn, FlickrFetcher
+//
+
+#import "Specta.h"
+
+#define EXP_SHORTHAND
+#import "Expecta.h"
+
+
+#import "FlickrStandIn.h"
+
+
+
+SpecBegin(FlickrStandIn_A)
+
+
+//------------------------------------------------------------------------------------- -o-
+#define  PLACECOUNT       3
+#define  REQUESTCOUNT     40
+#define  LATENCY          0.2
+#define  IMAGEBYTES       (100 * 1024)
+
+
+static NSURL *temporaryCorpusURL(void)
+{
+  NSURL  *dirURL     = [NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES];
+  NSURL  *corpusURL  = [dirURL URLByAppendingPathComponent:@"FlickrStandInSpec" isDirectory:YES];
+  NSURL  *restURL    = [corpusURL URLByAppendingPathComponent:@"rest" isDirectory:YES];
+
+  [[NSFileManager defaultManager] removeItemAtURL:corpusURL error:nil];
+  [[NSFileManager defaultManager] createDirectoryAtURL:restURL withIntermediateDirectories:YES attributes:nil error:nil];
+
+  NSMutableArray  *places = [[NSMutableArray alloc] init];
+
+  for (NSUInteger i = 0; i < PLACECOUNT; i++) {
+    [places addObject:@{ FLICKR_PLACE_ID : DP_STRWFMT(@"place%lu", (unsigned long)i), FLICKR_PLACE_NAME : DP_STRWFMT(@"Place %lu", (unsigned long)i) }];
+  }
+
+  NSData  *json = [NSJSONSerialization dataWithJSONObject:@{ @"places" : @{ @"place" : places }, @"stat" : @"ok" } options:0 error:nil];
+
+  [json writeToURL:[restURL URLByAppendingPathComponent:@"flickr.places.getTopPlacesList.json"] atomically:YES];
+
+  return corpusURL;
+}
+
+
+static NSString *failurePattern(void)
+{
+  NSMutableString  *pattern = [[NSMutableString alloc] init];
+
+  for (NSUInteger i = 0; i < REQUESTCOUNT; i++) {
+    [pattern appendString:([FlickrFetcher topPlaces] ? @"." : @"x")];
+  }
+
+  return pattern;
+}
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"FlickrStandIn",
+^{
+  __block FlickrStandIn  *standIn;
+
+
+  //-------------------------------------------------- -o-
+  beforeEach(^{
+    standIn = [[FlickrStandIn alloc] initWithCorpusURL:temporaryCorpusURL()];
+  });
+
+  afterEach(^{
+    [FlickrFetcher setBaseURL:nil];
+    [standIn stop];
+    standIn = nil;
+  });
+
+
+
+  //------------------------ -o-
+  it(@"names fixtures from most to least specific",
+  ^{
+    NSURL  *pageURL   = [NSURL URLWithString:@"http://127.0.0.1/services/rest/?method=flickr.photos.search&user_id=48247111@N07&page=2&per_page=250"];
+    NSURL  *photoURL  = [NSURL URLWithString:@"http://127.0.0.1/farm3/1234/5678_abcd_s.jpg"];
+
+    expect([FlickrStandIn fixtureNamesForURL:pageURL]).to.equal((@[ @"rest/flickr.photos.search_user_id-48247111@N07_page-2.json",
+                                                                     @"rest/flickr.photos.search_user_id-48247111@N07.json",
+                                                                     @"rest/flickr.photos.search.json" ]));
+    expect([FlickrStandIn fixtureNamesForURL:photoURL]).to.equal((@[ @"images/5678_abcd_s.jpg", FSI_IMAGE_DEFAULT ]));
+    expect([FlickrStandIn fixtureNamesForURL:[NSURL URLWithString:@"http://127.0.0.1/favicon.ico"]]).to.haveCountOf(0);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"names no fixture outside the corpus",
+  ^{
+    for (NSString *urlString in @[ @"http://127.0.0.1/services/rest/?method=..%2F..%2Fetc%2Fpasswd",
+                                   @"http://127.0.0.1/services/rest/?method=flickr..places",
+                                   @"http://127.0.0.1/services/rest/?method=flickr.places&place_id=a%2F..%2Fb",
+                                   @"http://127.0.0.1/services/rest/?method=flickr.places&page=1%2F2",
+                                   @"http://127.0.0.1/services/rest/?method=flickr.places&user_id=a%20b",
+                                   @"http://127.0.0.1/farm3/1234/.." ])
+    {
+      expect([FlickrStandIn fixtureNamesForURL:[NSURL URLWithString:urlString]]).to.haveCountOf(0);
+    }
+  });
+
+
+
+  //------------------------ -o-
+  it(@"replays REST fixtures and synthesizes photos for FlickrFetcher",
+  ^{
+    standIn.imageBytes = IMAGEBYTES;
+
+    expect([standIn start:0]).to.beTruthy();
+    [FlickrFetcher setBaseURL:standIn.baseURL];
+
+    NSArray  *places = [FlickrFetcher topPlaces];
+
+    expect(places).to.haveCountOf(PLACECOUNT);
+    expect([FlickrFetcher photosInPlace:places[0] maxResults:10]).to.beNil();
+
+    NSDictionary  *photo     = @{ @"farm" : @"3", @"server" : @"1234", @"id" : @"5678", @"secret" : @"abcd" };
+    NSURL         *photoURL  = [FlickrFetcher urlForPhoto:photo format:FlickrPhotoFormatSquare];
+
+    expect([photoURL host]).to.equal(@"127.0.0.1");
+    expect([[NSData dataWithContentsOfURL:photoURL] length]).to.equal(IMAGEBYTES);
+
+    FSIStats  stats = [standIn stats];
+
+    expect(stats.replayed).to.equal(1);
+    expect(stats.notFound).to.equal(1);
+    expect(stats.synthesized).to.equal(1);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"injects the same failures for the same seed",
+  ^{
+    standIn.errorRate  = 0.5;
+    standIn.seed       = 193;
+
+    expect([standIn start:0]).to.beTruthy();
+    [FlickrFetcher setBaseURL:standIn.baseURL];
+
+    NSString  *first = failurePattern();
+
+    FlickrStandIn  *again = [[FlickrStandIn alloc] initWithCorpusURL:standIn.corpusURL];
+
+    again.errorRate  = 0.5;
+    again.seed       = 193;
+
+    expect([again start:0]).to.beTruthy();
+    [FlickrFetcher setBaseURL:again.baseURL];
+
+    NSString  *second = failurePattern();
+    [again stop];
+
+    expect(second).to.equal(first);
+    expect(first).to.contain(@".");
+    expect(first).to.contain(@"x");
+    expect([standIn stats].injectedErrors).to.equal([[first componentsSeparatedByString:@"x"] count] - 1);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"delays every response by the injected latency",
+  ^{
+    standIn.latency = LATENCY;
+
+    expect([standIn start:0]).to.beTruthy();
+    [FlickrFetcher setBaseURL:standIn.baseURL];
+
+    NSTimeInterval  start = [NSDate timeIntervalSinceReferenceDate];
+
+    expect([FlickrFetcher topPlaces]).to.haveCountOf(PLACECOUNT);
+    expect([NSDate timeIntervalSinceReferenceDate] - start).to.beGreaterThanOrEqualTo(LATENCY);
+  });
+
+});
+
+
+SpecEnd
+
@@ -0,0 +1,109 @@
+//
+// LogSpec_A.m
+//
+// Measure the cost of DP_LOG macros on the calling thread.
+//
+//
+// CLASS DEPENDENCIES:  Log
+//
+
+#import "Specta.h"
+
+#define EXP_SHORTHAND
+#import "Expecta.h"
+
+
+#import "Danaprajna.h"
+
+
+
+SpecBegin(Log_A)
+
+
+//------------------------------------------------------------------------------------- -o-
+#define  CALLCOUNT_FILTERED    100000
+#define  CALLCOUNT_QUEUED      (DP_LOG_RING_CAPACITY / 2)
+#define  BATCHCOUNT_QUEUED     8
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"Log",
+^{
+  __block  DPLogLevel  savedThreshold;
+
+
+  //-------------------------------------------------- -o-
+  beforeEach(^{
+    savedThreshold = [Log levelThreshold];
+  });
+
+  afterEach(^{
+    [Log setLevelThreshold:savedThreshold];
+  });
+
+
+
+  //------------------------ -o-
+  it(@"benchmark per call cost:  below threshold, queued, synchronous NSLog",
+  ^{
+    NSTimeInterval  start, filteredElapsed, queuedElapsed = 0, syncElapsed = 0;
+    int64_t         droppedBefore = [Log droppedCount];
+
+
+    // Below runtime threshold:  no formatting, no queueing.
+    //
+    [Log setLevelThreshold:DP_LOG_LEVEL_ERROR];
+
+    start = [NSDate timeIntervalSinceReferenceDate];
+    for (NSUInteger i = 0; i < CALLCOUNT_FILTERED; i++) {
+      DP_LOG_INFO(@"filtered %lu of %d", (unsigned long)i, CALLCOUNT_FILTERED);
+    }
+    filteredElapsed = [NSDate timeIntervalSinceReferenceDate] - start;
+
+
+    // Queued for the drainer, in batches that fit the ring.
+    //
+    [Log setLevelThreshold:DP_LOG_LEVEL_DEBUG];
+
+    for (NSUInteger batch = 0; batch < BATCHCOUNT_QUEUED; batch++)
+    {
+      start = [NSDate timeIntervalSinceReferenceDate];
+      for (NSUInteger i = 0; i < CALLCOUNT_QUEUED; i++) {
+        DP_LOG_DEBUG(@"queued %lu of batch %lu", (unsigned long)i, (unsigned long)batch);
+      }
+      queuedElapsed += [NSDate timeIntervalSinceReferenceDate] - start;
+
+      expect([Log flush]).to.beTruthy();
+    }
+
+
+    // As every call was before:  format location and write on the caller.
+    //
+    for (NSUInteger i = 0; i < CALLCOUNT_QUEUED; i++)
+    {
+      start = [NSDate timeIntervalSinceReferenceDate];
+      NSLog(@"_LOG: %@_ %@ -- %@", @"DEBUG", DP_CODE_LOCATION, [NSString stringWithFormat:@"synchronous %lu", (unsigned long)i]);
+      syncElapsed += [NSDate timeIntervalSinceReferenceDate] - start;
+    }
+
+
+    //
+    double  filteredNs  = filteredElapsed * 1e9 / CALLCOUNT_FILTERED;
+    double  queuedNs    = queuedElapsed   * 1e9 / (CALLCOUNT_QUEUED * BATCHCOUNT_QUEUED);
+    double  syncNs      = syncElapsed     * 1e9 / CALLCOUNT_QUEUED;
+
+    DP_LOG_INFO(@"BENCHMARK  log call on caller thread:  below threshold %.1f ns,  queued %.1f ns,  synchronous NSLog %.1f ns",
+                  filteredNs, queuedNs, syncNs);
+
+    expect([Log droppedCount]).to.equal(droppedBefore);
+    expect(filteredNs).to.beLessThan(queuedNs);
+    expect(queuedNs).to.beLessThan(syncNs);
+  });
+
+}); // describe -- Log
+
+
+SpecEnd // Log_A
+
@@ -0,0 +1,112 @@
+//
+// NetworkActivitySpec_A.m
+//
+// Activity count under concurrent callers, and request accounting.
+//
+//
+// CLASS DEPENDENCIES:  NetworkActivity
+//
+
+#import "Specta.h"
+
+#define EXP_SHORTHAND
+#import "Expecta.h"
+
+
+#import "Danaprajna.h"
+
+
+
+SpecBegin(NetworkActivity_A)
+
+
+//------------------------------------------------------------------------------------- -o-
+#define  CALLCOUNT    10000
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"NetworkActivity",
+^{
+  //-------------------------------------------------- -o-
+  beforeEach(^{
+    [NetworkActivity resetStats];
+  });
+
+
+
+  //------------------------ -o-
+  it(@"keeps a balanced count across threads and never goes below zero",
+  ^{
+    NSInteger  before = [NetworkActivity activeCount];
+
+    dispatch_apply(CALLCOUNT, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+      [NetworkActivity activityBegin];
+      [NetworkActivity activityEnd];
+    });
+
+    expect([NetworkActivity activeCount]).to.equal(before);
+
+    if (0 == before) {
+      expect([NetworkActivity activityEnd]).to.equal(0);
+      expect([NetworkActivity activeCount]).to.equal(0);
+    }
+  });
+
+
+
+  //------------------------ -o-
+  it(@"totals requests and moves estimates toward recent ones",
+  ^{
+    uint64_t  started;
+
+    started = [NetworkActivity beginRequest];
+    usleep(10000);
+    [NetworkActivity endRequest:started bytes:1000 success:YES];
+
+    double  firstBandwidth = [NetworkActivity bandwidthEstimate];
+
+    started = [NetworkActivity beginRequest];
+    usleep(10000);
+    [NetworkActivity endRequest:started bytes:100000 success:YES];
+
+    started = [NetworkActivity beginRequest];
+    [NetworkActivity endRequest:started bytes:0 success:NO];
+
+
+    //
+    DPNetworkStats  stats = [NetworkActivity stats];
+
+    expect(stats.requests).to.equal(3);
+    expect(stats.failures).to.equal(1);
+    expect(stats.bytes).to.equal(101000);
+    expect(stats.duration).to.beGreaterThanOrEqualTo(0.02);
+
+    expect(firstBandwidth).to.beGreaterThan(0);
+    expect(stats.bandwidthEstimate).to.beGreaterThan(firstBandwidth);
+    expect(stats.bandwidthEstimate).to.beLessThan(stats.lastThroughput);
+    expect(stats.latencyEstimate).to.beGreaterThanOrEqualTo(0.01);
+  });
+
+
+
+
+  //------------------------ -o-
+  it(@"adds up bandwidth of requests in flight together",
+  ^{
+    uint64_t  first   = [NetworkActivity beginRequest];
+    uint64_t  second  = [NetworkActivity beginRequest];
+
+    usleep(10000);
+    [NetworkActivity endRequest:first bytes:1000 success:YES];
+    [NetworkActivity endRequest:second bytes:1000 success:YES];
+
+    expect([NetworkActivity lastThroughput]).to.beGreaterThan(0);
+    expect([NetworkActivity bandwidthEstimate]).to.beGreaterThan([NetworkActivity lastThroughput] * 1.5);
+  });
+
+}); // describe -- NetworkActivity
+
+
+SpecEnd // NetworkActivity_A
+
@@ -0,0 +1,678 @@
+//
+// PhotoIndexSpec_A.m
+//
+// Test and benchmark indexes built over fetched photo arrays.
+//
+//
+// CLASS DEPENDENCIES:  PhotoTagIndex, PhotoSetDiff, PhotoGeoIndex, PhotoTextIndex,
+//                      PhotoSortIndex, PhotoSnapshot
+//
+
+#import "Specta.h"
+
+#define EXP_SHORTHAND
+#import "Expecta.h"
+
+
+#import "PhotoTagIndex.h"
+#import "PhotoSetDiff.h"
+#import "PhotoGeoIndex.h"
+#import "PhotoTextIndex.h"
+#import "PhotoSortIndex.h"
+#import "PhotoSnapshot.h"
+
+
+
+SpecBegin(PhotoIndex_A)
+
+
+//------------------------------------------------------------------------------------- -o-
+#define  PHOTOCOUNT_BENCHMARK   10000
+#define  TAGCOUNT_VOCABULARY    500
+#define  TAGCOUNT_PER_PHOTO     8
+#define  RANDOM_SEED            193
+
+#define  GEOCOUNT_BENCHMARK     100000
+#define  GEOQUERY_COUNT         100
+#define  GEOQUERY_NEAREST       10
+
+#define  FRAME_SECONDS          (1.0 / 60)
+
+
+// Photo entries shaped like FlickrFetcher results, with deterministic content.
+//
+static NSArray *syntheticPhotoArray(NSUInteger photoCount)
+{
+  NSMutableArray  *photos = [[NSMutableArray alloc] initWithCapacity:photoCount];
+
+  srandom(RANDOM_SEED);
+
+  for (NSUInteger i = 0; i < photoCount; i++)
+  {
+    NSMutableArray  *tags = [[NSMutableArray alloc] init];
+
+    for (int t = 0; t < TAGCOUNT_PER_PHOTO; t++) {
+      [tags addObject:DP_STRWFMT(@"tag%ld", random() % TAGCOUNT_VOCABULARY)];
+    }
+
+    [photos addObject:
+      @{
+         FLICKR_PHOTO_ID    : DP_STRWFMT(@"%lu", (unsigned long)i),
+         FLICKR_PHOTO_TITLE : DP_STRWFMT(@"Photo %lu", (unsigned long)i),
+         FLICKR_TAGS        : [tags componentsJoinedByString:@" "],
+         @"description"     : @{ @"_content" : DP_STRWFMT(@"Seen near %@.", [tags componentsJoinedByString:@", "]) },
+       }];
+  }
+
+  return photos;
+}
+
+
+// Photo entries with coordinates spread uniformly over the globe.
+//
+static NSArray *syntheticGeoPhotoArray(NSUInteger photoCount)
+{
+  NSMutableArray  *photos = [[NSMutableArray alloc] initWithCapacity:photoCount];
+
+  srandom(RANDOM_SEED);
+
+  for (NSUInteger i = 0; i < photoCount; i++)
+  {
+    double  latitude   = asin((2.0 * random() / RAND_MAX) - 1.0) * 180.0 / M_PI;
+    double  longitude  = (360.0 * random() / RAND_MAX) - 180.0;
+
+    [photos addObject:
+      @{
+         FLICKR_PHOTO_ID   : DP_STRWFMT(@"%lu", (unsigned long)i),
+         FLICKR_LATITUDE   : DP_STRWFMT(@"%.6f", latitude),
+         FLICKR_LONGITUDE  : DP_STRWFMT(@"%.6f", longitude),
+       }];
+  }
+
+  return photos;
+}
+
+
+// Photo entries with tags, text, coordinates and upload dates.
+//
+static NSArray *syntheticSnapshotPhotoArray(NSUInteger photoCount)
+{
+  NSArray         *tagged  = syntheticPhotoArray(photoCount);
+  NSArray         *placed  = syntheticGeoPhotoArray(photoCount);
+  NSMutableArray  *photos  = [[NSMutableArray alloc] initWithCapacity:photoCount];
+
+  for (NSUInteger i = 0; i < photoCount; i++)
+  {
+    NSMutableDictionary  *entry = [tagged[i] mutableCopy];
+
+    [entry addEntriesFromDictionary:placed[i]];
+    entry[PF_PHOTO_DATEUPLOAD_KEY] = DP_STRWFMT(@"%lu", (unsigned long)(i % 97));
+
+    [photos addObject:entry];
+  }
+
+  return photos;
+}
+
+
+// Reference implementation: sort every photo by distance.
+//
+static NSArray *linearPhotoArrayNearest(NSArray *photos, double latitude, double longitude, NSUInteger count)
+{
+  NSArray  *sorted = [photos sortedArrayUsingComparator:^NSComparisonResult(NSDictionary *a, NSDictionary *b) 
+    {
+      double  distanceA = [PhotoGeoIndex distanceFromLatitude: latitude  longitude: longitude
+                                                   toLatitude: [a[FLICKR_LATITUDE] doubleValue]
+                                                    longitude: [a[FLICKR_LONGITUDE] doubleValue] ];
+      double  distanceB = [PhotoGeoIndex distanceFromLatitude: latitude  longitude: longitude
+                                                   toLatitude: [b[FLICKR_LATITUDE] doubleValue]
+                                                    longitude: [b[FLICKR_LONGITUDE] doubleValue] ];
+
+      return (distanceA < distanceB) ? NSOrderedAscending : ((distanceA > distanceB) ? NSOrderedDescending : NSOrderedSame);
+    }];
+
+  return [sorted subarrayWithRange:NSMakeRange(0, MIN(count, [sorted count]))];
+}
+
+
+// Reference implementation: linear scan, as PhotoFetch did before indexing.
+//
+static NSArray *linearPhotoArrayForTag(NSArray *photos, NSString *tag)
+{
+  NSMutableArray  *taggedPhotos = [[NSMutableArray alloc] init];
+
+  for (NSDictionary *entry in photos) {
+    if ([[entry[FLICKR_TAGS] componentsSeparatedByString:@" "] containsObject:tag]) {
+      [taggedPhotos addObject:entry];
+    }
+  }
+
+  return taggedPhotos;
+}
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"PhotoTagIndex",
+^{
+  __block  NSArray        *photos;
+  __block  PhotoTagIndex  *index;
+
+
+
+  //-------------------------------------------------- -o-
+  beforeAll(^{
+    photos = syntheticPhotoArray(PHOTOCOUNT_BENCHMARK);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"index small photo array; ignore exceptions and empty tags",
+  ^{
+    NSArray  *smallPhotos =
+      @[
+         @{ FLICKR_PHOTO_ID : @"1",  FLICKR_TAGS : @"cat dog portrait" },
+         @{ FLICKR_PHOTO_ID : @"2",  FLICKR_TAGS : @"dog dog" },
+         @{ FLICKR_PHOTO_ID : @"3",  FLICKR_TAGS : @"" },
+         @{ FLICKR_PHOTO_ID : @"4" },
+       ];
+
+    PhotoTagIndex  *smallIndex = [[PhotoTagIndex alloc] initWithPhotoArray:smallPhotos];
+
+    expect(smallIndex.tagCounts).to.equal((@{ @"cat" : @1, @"dog" : @2 }));
+    expect(smallIndex.sortedTags).to.equal((@[ @"cat", @"dog" ]));
+    expect([smallIndex photoIDsForTag:@"dog"]).to.equal((@[ @"1", @"2" ]));
+    expect([smallIndex photoArrayForTag:@"nonesuch"]).to.haveCountOf(0);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"benchmark build of index over 10k photos",
+  ^{
+    NSTimeInterval  start = [NSDate timeIntervalSinceReferenceDate];
+
+    index = [[PhotoTagIndex alloc] initWithPhotoArray:photos];
+
+    NSTimeInterval  elapsed = [NSDate timeIntervalSinceReferenceDate] - start;
+    DP_LOG_INFO(@"BENCHMARK  build PhotoTagIndex, %d photos:  %.3f ms", PHOTOCOUNT_BENCHMARK, elapsed * 1000);
+
+    expect(index).notTo.beNil();
+    expect([index.photosByID count]).to.equal(PHOTOCOUNT_BENCHMARK);
+    expect([index.sortedTags count]).to.equal(TAGCOUNT_VOCABULARY);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"benchmark per tag lookup against linear scan",
+  ^{
+    NSTimeInterval  start, indexedElapsed, linearElapsed;
+    NSArray        *indexed, *linear;
+
+    start           = [NSDate timeIntervalSinceReferenceDate];
+    indexed         = [index photoArrayForTag:@"tag7"];
+    indexedElapsed  = [NSDate timeIntervalSinceReferenceDate] - start;
+
+    start           = [NSDate timeIntervalSinceReferenceDate];
+    linear          = linearPhotoArrayForTag(photos, @"tag7");
+    linearElapsed   = [NSDate timeIntervalSinceReferenceDate] - start;
+
+    DP_LOG_INFO(@"BENCHMARK  tag lookup, %d photos:  indexed %.3f ms,  linear %.3f ms",
+                  PHOTOCOUNT_BENCHMARK, indexedElapsed * 1000, linearElapsed * 1000);
+
+    expect(indexed).to.equal(linear);
+    expect([index.tagCounts[@"tag7"] integerValue]).to.equal([linear count]);
+  });
+
+
+
+
+  //------------------------ -o-
+  it(@"update index from diff; match full rebuild",
+  ^{
+    NSMutableArray  *refreshed = [[photos subarrayWithRange:NSMakeRange(10, [photos count] - 10)] mutableCopy];
+
+    refreshed[0] = @{ FLICKR_PHOTO_ID : refreshed[0][FLICKR_PHOTO_ID],  FLICKR_TAGS : @"tag7 brandnewtag" };
+    [refreshed addObject:@{ FLICKR_PHOTO_ID : @"new1",  FLICKR_TAGS : @"tag7 tag8" }];
+
+    PhotoSetDiff  *diff = [PhotoSetDiff diffFromPhotosByID:index.photosByID toPhotoArray:refreshed];
+
+    expect(diff.addedIDs).to.haveCountOf(1);
+    expect(diff.removedIDs).to.haveCountOf(10);
+    expect(diff.changedIDs).to.haveCountOf(1);
+    expect([diff exceedsChangeRatio:0.5]).to.beFalsy();
+
+
+    //
+    NSTimeInterval  start = [NSDate timeIntervalSinceReferenceDate];
+
+    PhotoTagIndex  *updated = [[PhotoTagIndex alloc] initWithTagIndex:index applyingDiff:diff];
+
+    NSTimeInterval  elapsed = [NSDate timeIntervalSinceReferenceDate] - start;
+    DP_LOG_INFO(@"BENCHMARK  update PhotoTagIndex from diff of %lu:  %.3f ms", (unsigned long)[diff changeCount], elapsed * 1000);
+
+
+    PhotoTagIndex  *rebuilt = [[PhotoTagIndex alloc] initWithPhotoArray:refreshed];
+
+    expect(updated.tagCounts).to.equal(rebuilt.tagCounts);
+    expect(updated.sortedTags).to.equal(rebuilt.sortedTags);
+    expect([NSSet setWithArray:[updated photoIDsForTag:@"tag7"]]).to.equal([NSSet setWithArray:[rebuilt photoIDsForTag:@"tag7"]]);
+
+    expect([index.photosByID count]).to.equal(PHOTOCOUNT_BENCHMARK);
+  });
+
+}); // describe -- PhotoTagIndex
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"PhotoGeoIndex",
+^{
+  __block  NSArray        *photos;
+  __block  PhotoGeoIndex  *index;
+
+
+
+  //-------------------------------------------------- -o-
+  beforeAll(^{
+    photos = syntheticGeoPhotoArray(GEOCOUNT_BENCHMARK);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"query small photo array; wrap at longitude 180; skip entries without coordinates",
+  ^{
+    NSArray  *smallPhotos =
+      @[
+         @{ FLICKR_PHOTO_ID : @"sf",     FLICKR_LATITUDE : @"37.77",  FLICKR_LONGITUDE : @"-122.42" },
+         @{ FLICKR_PHOTO_ID : @"oak",    FLICKR_LATITUDE : @"37.80",  FLICKR_LONGITUDE : @"-122.27" },
+         @{ FLICKR_PHOTO_ID : @"tokyo",  FLICKR_LATITUDE : @"35.68",  FLICKR_LONGITUDE : @"139.69" },
+         @{ FLICKR_PHOTO_ID : @"fiji",   FLICKR_LATITUDE : @"-17.7",  FLICKR_LONGITUDE : @"179.9" },
+         @{ FLICKR_PHOTO_ID : @"samoa",  FLICKR_LATITUDE : @"-14.3",  FLICKR_LONGITUDE : @"-170.7" },
+         @{ FLICKR_PHOTO_ID : @"nowhere" },
+       ];
+
+    PhotoGeoIndex  *smallIndex = [[PhotoGeoIndex alloc] initWithPhotoArray:smallPhotos];
+
+    expect(smallIndex.count).to.equal(5);
+
+    expect([[smallIndex photoArrayNearestLatitude:37.7 longitude:-122.4 count:2] valueForKey:FLICKR_PHOTO_ID])
+      .to.equal((@[ @"sf", @"oak" ]));
+    expect([[smallIndex photoArrayNearestLatitude:-16 longitude:-178 count:2] valueForKey:FLICKR_PHOTO_ID])
+      .to.equal((@[ @"fiji", @"samoa" ]));
+
+    expect([NSSet setWithArray:[[smallIndex photoArrayInRegionSouth:-20 west:170 north:0 east:-160] valueForKey:FLICKR_PHOTO_ID]])
+      .to.equal([NSSet setWithArray:(@[ @"fiji", @"samoa" ])]);
+    expect([NSSet setWithArray:[[smallIndex photoArrayInRegionSouth:-20 west:170 north:0 east:190] valueForKey:FLICKR_PHOTO_ID]])
+      .to.equal([NSSet setWithArray:(@[ @"fiji", @"samoa" ])]);
+    expect([[smallIndex photoArrayInRegionSouth:-20 west:170 north:0 east:180] valueForKey:FLICKR_PHOTO_ID])
+      .to.equal((@[ @"fiji" ]));
+    expect([smallIndex photoArrayInRegionSouth:30 west:-130 north:40 east:-120]).to.haveCountOf(2);
+    expect([smallIndex photoArrayInRegionSouth:-90 west:-180 north:90 east:180]).to.haveCountOf(5);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"benchmark build of index over 100k points",
+  ^{
+    NSTimeInterval  start = [NSDate timeIntervalSinceReferenceDate];
+
+    index = [[PhotoGeoIndex alloc] initWithPhotoArray:photos];
+
+    NSTimeInterval  elapsed = [NSDate timeIntervalSinceReferenceDate] - start;
+    DP_LOG_INFO(@"BENCHMARK  build PhotoGeoIndex, %d points:  %.3f ms", GEOCOUNT_BENCHMARK, elapsed * 1000);
+
+    expect(index.count).to.equal(GEOCOUNT_BENCHMARK);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"benchmark nearest and region queries against linear scan",
+  ^{
+    NSTimeInterval  start, nearestElapsed = 0, regionElapsed = 0, linearElapsed = 0;
+
+    srandom(RANDOM_SEED + 1);
+
+    for (int q = 0; q < GEOQUERY_COUNT; q++)
+    {
+      double  latitude   = (170.0 * random() / RAND_MAX) - 85.0;
+      double  longitude  = (360.0 * random() / RAND_MAX) - 180.0;
+
+      start            = [NSDate timeIntervalSinceReferenceDate];
+      NSArray *nearest = [index photoArrayNearestLatitude:latitude longitude:longitude count:GEOQUERY_NEAREST];
+      nearestElapsed  += [NSDate timeIntervalSinceReferenceDate] - start;
+
+      start            = [NSDate timeIntervalSinceReferenceDate];
+      NSArray *region  = [index photoArrayInRegionSouth:latitude - 2 west:longitude - 2 north:latitude + 2 east:longitude + 2];
+      regionElapsed   += [NSDate timeIntervalSinceReferenceDate] - start;
+
+      expect(nearest).to.haveCountOf(GEOQUERY_NEAREST);
+      expect(region).notTo.beNil();
+
+      if (q < 5) {
+        start           = [NSDate timeIntervalSinceReferenceDate];
+        NSArray *linear = linearPhotoArrayNearest(photos, latitude, longitude, GEOQUERY_NEAREST);
+        linearElapsed  += [NSDate timeIntervalSinceReferenceDate] - start;
+
+        expect([nearest valueForKey:FLICKR_PHOTO_ID]).to.equal([linear valueForKey:FLICKR_PHOTO_ID]);
+      }
+    }
+
+    DP_LOG_INFO(@"BENCHMARK  geo query, %d points:  nearest %d %.3f ms,  region %.3f ms,  linear nearest %.3f ms  (per query)",
+                  GEOCOUNT_BENCHMARK, GEOQUERY_NEAREST, 
+                  nearestElapsed * 1000 / GEOQUERY_COUNT, regionElapsed * 1000 / GEOQUERY_COUNT, linearElapsed * 1000 / 5);
+
+    expect(nearestElapsed / GEOQUERY_COUNT).to.beLessThan(0.001);
+    expect(regionElapsed / GEOQUERY_COUNT).to.beLessThan(0.001);
+  });
+
+}); // describe -- PhotoGeoIndex
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"PhotoTextIndex",
+^{
+  __block  NSArray         *photos;
+  __block  PhotoTextIndex  *index;
+
+
+
+  //-------------------------------------------------- -o-
+  beforeAll(^{
+    photos = syntheticPhotoArray(PHOTOCOUNT_BENCHMARK);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"fold case and diacritics; match every word as prefix",
+  ^{
+    NSArray  *smallPhotos =
+      @[
+         @{ FLICKR_PHOTO_ID : @"1",  FLICKR_PHOTO_TITLE : @"Caf\u00e9 at Dawn" },
+         @{ FLICKR_PHOTO_ID : @"2",  FLICKR_PHOTO_TITLE : @"Cafeteria",  @"description" : @{ @"_content" : @"Lunch, DAWN-ish" } },
+         @{ FLICKR_PHOTO_ID : @"3",  FLICKR_PHOTO_TITLE : @"Sunset" },
+         @{ FLICKR_PHOTO_ID : @"4" },
+       ];
+
+    PhotoTextIndex  *smallIndex = [[PhotoTextIndex alloc] initWithPhotoArray:smallPhotos];
+
+    expect([PhotoTextIndex tokensForString:@"  Caf\u00c9,  dawn-ish!"]).to.equal((@[ @"cafe", @"dawn", @"ish" ]));
+
+    expect([smallIndex photoIDsMatchingQuery:@"cafe"]).to.equal([NSSet setWithArray:(@[ @"1", @"2" ])]);
+    expect([smallIndex photoIDsMatchingQuery:@"CAF\u00c9 lun"]).to.equal([NSSet setWithArray:(@[ @"2" ])]);
+    expect([smallIndex photoIDsMatchingQuery:@"dawn"]).to.equal([NSSet setWithArray:(@[ @"1", @"2" ])]);
+    expect([smallIndex photoIDsMatchingQuery:@"sunrise"]).to.haveCountOf(0);
+    expect([smallIndex photoArrayMatchingQuery:@"  "]).to.haveCountOf(4);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"benchmark build of index over 10k photos",
+  ^{
+    NSTimeInterval  start = [NSDate timeIntervalSinceReferenceDate];
+
+    index = [[PhotoTextIndex alloc] initWithPhotoArray:photos];
+
+    NSTimeInterval  elapsed = [NSDate timeIntervalSinceReferenceDate] - start;
+    DP_LOG_INFO(@"BENCHMARK  build PhotoTextIndex, %d photos:  %.3f ms", PHOTOCOUNT_BENCHMARK, elapsed * 1000);
+
+    expect(index).notTo.beNil();
+  });
+
+
+
+  //------------------------ -o-
+  it(@"answer each keystroke within a frame",
+  ^{
+    NSString        *typed    = @"photo tag123";
+    NSTimeInterval   slowest  = 0;
+
+    for (NSUInteger length = 1; length <= [typed length]; length++)
+    {
+      NSString        *query    = [typed substringToIndex:length];
+      NSTimeInterval   start    = [NSDate timeIntervalSinceReferenceDate];
+      NSSet           *matches  = [index photoIDsMatchingQuery:query];
+      NSTimeInterval   elapsed  = [NSDate timeIntervalSinceReferenceDate] - start;
+
+      slowest = MAX(slowest, elapsed);
+      DP_LOG_INFO(@"BENCHMARK  text query \"%@\", %d photos:  %lu matches,  %.3f ms",
+                    query, PHOTOCOUNT_BENCHMARK, (unsigned long)[matches count], elapsed * 1000);
+    }
+
+    NSArray  *linear = [photos filteredArrayUsingPredicate:
+                         [NSPredicate predicateWithFormat:@"description._content CONTAINS[cd] 'tag123,' OR description._content ENDSWITH[cd] 'tag123.'"]];
+
+    expect([index photoIDsMatchingQuery:typed]).to.equal([NSSet setWithArray:[linear valueForKey:FLICKR_PHOTO_ID]]);
+    expect(slowest).to.beLessThan(FRAME_SECONDS);
+  });
+
+}); // describe -- PhotoTextIndex
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"PhotoSortIndex",
+^{
+  __block  NSArray        *photos;
+  __block  PhotoSnapshot  *snapshot;
+
+
+
+  //-------------------------------------------------- -o-
+  beforeAll(^{
+    photos    = syntheticPhotoArray(PHOTOCOUNT_BENCHMARK);
+    snapshot  = [PhotoSnapshot snapshotWithPhotoArray: photos
+                                             category: PFCategoryStanford
+                                              version: 1
+                                             previous: nil ];
+  });
+
+
+
+  //------------------------ -o-
+  it(@"order by title, then description, ignoring case; newest first by upload date",
+  ^{
+    NSArray  *smallPhotos =
+      @[
+         @{ FLICKR_PHOTO_ID : @"1",  FLICKR_PHOTO_TITLE : @"beach",  @"description" : @{ @"_content" : @"Zebra" },  PF_PHOTO_DATEUPLOAD_KEY : @"100" },
+         @{ FLICKR_PHOTO_ID : @"2",  FLICKR_PHOTO_TITLE : @"Beach",  @"description" : @{ @"_content" : @"apple" },  PF_PHOTO_DATEUPLOAD_KEY : @"300" },
+         @{ FLICKR_PHOTO_ID : @"3",  FLICKR_PHOTO_TITLE : @"Aardvark" },
+         @{ FLICKR_PHOTO_ID : @"4",  FLICKR_PHOTO_TITLE : @"city",   PF_PHOTO_DATEUPLOAD_KEY : @"200" },
+       ];
+
+    PhotoSortIndex  *smallIndex  = [[PhotoSortIndex alloc] initWithPhotoArray:smallPhotos];
+    NSArray         *subset      = @[ smallPhotos[3], smallPhotos[0], smallPhotos[1] ];
+
+    expect([[smallIndex sortedPhotoArray:smallPhotos order:PFSortOrderTitle] valueForKey:FLICKR_PHOTO_ID])
+      .to.equal((@[ @"3", @"2", @"1", @"4" ]));
+    expect([[smallIndex sortedPhotoArray:subset order:PFSortOrderUploadDate] valueForKey:FLICKR_PHOTO_ID])
+      .to.equal((@[ @"2", @"4", @"1" ]));
+  });
+
+
+
+  //------------------------ -o-
+  it(@"benchmark sorted view of one tag:  sort descriptors, first view, cached view",
+  ^{
+    NSArray         *tagged = [snapshot.tagIndex photoArrayForTag:@"tag7"];
+    NSTimeInterval   start, descriptorElapsed, firstElapsed, cachedElapsed;
+
+    NSArray  *descriptors =
+      @[
+         [[NSSortDescriptor alloc] initWithKey:FLICKR_PHOTO_TITLE        ascending:YES  selector:@selector(caseInsensitiveCompare:)],
+         [[NSSortDescriptor alloc] initWithKey:FLICKR_PHOTO_DESCRIPTION  ascending:YES  selector:@selector(caseInsensitiveCompare:)],
+       ];
+
+    start              = [NSDate timeIntervalSinceReferenceDate];
+    NSArray *expected  = [tagged sortedArrayUsingDescriptors:descriptors];
+    descriptorElapsed  = [NSDate timeIntervalSinceReferenceDate] - start;
+
+    start              = [NSDate timeIntervalSinceReferenceDate];
+    NSArray *first     = [snapshot sortedPhotoArrayForTag:@"tag7" order:PFSortOrderTitle];
+    firstElapsed       = [NSDate timeIntervalSinceReferenceDate] - start;
+
+    start              = [NSDate timeIntervalSinceReferenceDate];
+    NSArray *cached    = [snapshot sortedPhotoArrayForTag:@"tag7" order:PFSortOrderTitle];
+    cachedElapsed      = [NSDate timeIntervalSinceReferenceDate] - start;
+
+    DP_LOG_INFO(@"BENCHMARK  sort %lu of %d photos:  descriptors %.3f ms,  first view %.3f ms,  cached view %.3f ms",
+                  (unsigned long)[tagged count], PHOTOCOUNT_BENCHMARK, 
+                  descriptorElapsed * 1000, firstElapsed * 1000, cachedElapsed * 1000);
+
+    expect(first).to.equal(expected);
+    expect(cached).to.beIdenticalTo(first);
+  });
+
+}); // describe -- PhotoSortIndex
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"PhotoSnapshot",
+^{
+  __block  NSArray        *photos;
+  __block  PhotoSnapshot  *previous;
+
+
+  // Indexes derived from previous must answer as a full rebuild does.
+  //
+  void (^expectSnapshotMatchesRebuild)(PhotoSnapshot *) = ^(PhotoSnapshot *snapshot)
+  {
+    PhotoSnapshot  *rebuilt = [PhotoSnapshot snapshotWithPhotoArray: snapshot.photoArray
+                                                           category: PFCategoryStanford
+                                                            version: 3
+                                                           previous: nil ];
+
+    expect(snapshot.geoIndex.count).to.equal(rebuilt.geoIndex.count);
+    expect([[snapshot.geoIndex photoArrayNearestLatitude:10 longitude:20 count:GEOQUERY_NEAREST] valueForKey:FLICKR_PHOTO_ID])
+      .to.equal([[rebuilt.geoIndex photoArrayNearestLatitude:10 longitude:20 count:GEOQUERY_NEAREST] valueForKey:FLICKR_PHOTO_ID]);
+    expect([NSSet setWithArray:[[snapshot.geoIndex photoArrayInRegionSouth:-30 west:-60 north:30 east:60] valueForKey:FLICKR_PHOTO_ID]])
+      .to.equal([NSSet setWithArray:[[rebuilt.geoIndex photoArrayInRegionSouth:-30 west:-60 north:30 east:60] valueForKey:FLICKR_PHOTO_ID]]);
+
+    expect(snapshot.textIndex.sortedTokens).to.equal(rebuilt.textIndex.sortedTokens);
+
+    for (NSString *query in @[ @"photo 1", @"tag7", @"brandnew", @"seen near tag12" ]) {
+      expect([snapshot.textIndex photoIDsMatchingQuery:query]).to.equal([rebuilt.textIndex photoIDsMatchingQuery:query]);
+    }
+
+    for (int order = 0; order < PFSortOrderCount; order++) {
+      expect([[snapshot sortedPhotoArrayForTag:@"tag7" order:order] valueForKey:FLICKR_PHOTO_ID])
+        .to.equal([[rebuilt sortedPhotoArrayForTag:@"tag7" order:order] valueForKey:FLICKR_PHOTO_ID]);
+      expect([[snapshot.sortIndex sortedPhotoArray:snapshot.photoArray order:order] valueForKey:FLICKR_PHOTO_ID])
+        .to.equal([[rebuilt.sortIndex sortedPhotoArray:rebuilt.photoArray order:order] valueForKey:FLICKR_PHOTO_ID]);
+    }
+  };
+
+
+  // Replace entry at position with one of new title, tags and place.
+  //
+  NSDictionary *(^changedEntry)(NSDictionary *) = ^NSDictionary *(NSDictionary *entry)
+  {
+    return @{
+             FLICKR_PHOTO_ID          : entry[FLICKR_PHOTO_ID],
+             FLICKR_PHOTO_TITLE       : @"Brandnew title",
+             FLICKR_TAGS              : @"tag7 brandnewtag",
+             FLICKR_LATITUDE          : @"10.5",
+             FLICKR_LONGITUDE         : @"20.5",
+             PF_PHOTO_DATEUPLOAD_KEY  : @"1000",
+           };
+  };
+
+
+
+  //-------------------------------------------------- -o-
+  beforeEach(^{
+    photos    = syntheticSnapshotPhotoArray(PHOTOCOUNT_BENCHMARK);
+    previous  = [PhotoSnapshot snapshotWithPhotoArray: photos
+                                             category: PFCategoryStanford
+                                              version: 1
+                                             previous: nil ];
+
+    for (int order = 0; order < PFSortOrderCount; order++) {
+      [previous sortedPhotoArrayForTag:@"tag7" order:order];
+    }
+  });
+
+
+
+  //------------------------ -o-
+  it(@"update indexes in place when photos are changed and appended; match full rebuild",
+  ^{
+    NSMutableArray  *refreshed = [photos mutableCopy];
+
+    refreshed[5] = changedEntry(refreshed[5]);
+    [refreshed addObject:changedEntry(@{ FLICKR_PHOTO_ID : @"new1" })];
+
+
+    //
+    NSTimeInterval  start = [NSDate timeIntervalSinceReferenceDate];
+
+    PhotoSnapshot  *snapshot = [PhotoSnapshot snapshotWithPhotoArray: refreshed
+                                                            category: PFCategoryStanford
+                                                             version: 2
+                                                            previous: previous ];
+
+    NSTimeInterval  elapsed = [NSDate timeIntervalSinceReferenceDate] - start;
+    DP_LOG_INFO(@"BENCHMARK  derive PhotoSnapshot, %d photos, 2 changes:  %.3f ms", PHOTOCOUNT_BENCHMARK, elapsed * 1000);
+
+    expect([snapshot.diff changeCount]).to.equal(2);
+    expect(snapshot.textIndex.sortedTokens).to.contain(@"brandnew");
+
+    expectSnapshotMatchesRebuild(snapshot);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"remap indexes when photos are removed ahead of survivors; match full rebuild",
+  ^{
+    NSMutableArray  *refreshed = [[photos subarrayWithRange:NSMakeRange(10, [photos count] - 10)] mutableCopy];
+
+    refreshed[0] = changedEntry(refreshed[0]);
+    [refreshed insertObject:changedEntry(@{ FLICKR_PHOTO_ID : @"new1" }) atIndex:100];
+
+    PhotoSnapshot  *snapshot = [PhotoSnapshot snapshotWithPhotoArray: refreshed
+                                                            category: PFCategoryStanford
+                                                             version: 2
+                                                            previous: previous ];
+
+    expect([snapshot.diff changeCount]).to.equal(12);
+
+    expectSnapshotMatchesRebuild(snapshot);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"share indexes and sorted views when nothing changed",
+  ^{
+    NSArray        *view      = [previous sortedPhotoArrayForTag:@"tag8" order:PFSortOrderTitle];
+    PhotoSnapshot  *snapshot  = [PhotoSnapshot snapshotWithPhotoArray: [photos copy]
+                                                             category: PFCategoryStanford
+                                                              version: 2
+                                                             previous: previous ];
+
+    expect(snapshot.geoIndex).to.beIdenticalTo(previous.geoIndex);
+    expect(snapshot.textIndex).to.beIdenticalTo(previous.textIndex);
+    expect(snapshot.sortIndex).to.beIdenticalTo(previous.sortIndex);
+    expect([snapshot sortedPhotoArrayForTag:@"tag8" order:PFSortOrderTitle]).to.beIdenticalTo(view);
+  });
+
+}); // describe -- PhotoSnapshot
+
+
+SpecEnd // PhotoIndex_A
+
@@ -0,0 +1,163 @@
+//
+// PhotoListSpec_A.m
+//
+// Measure photo list scrolling with rows precomputed by PhotoListRows.
+//
+//
+// CLASS DEPENDENCIES:  PhotoListTVC, PhotoListRows
+//
+
+#import "Specta.h"
+
+#define EXP_SHORTHAND
+#import "Expecta.h"
+
+
+#import "PhotoListTVC.h"
+#import "PhotoListRows.h"
+
+
+
+//------------------------------------------------------------------------------------- -o-
+// Storyboard prototype cell for PhotoListTVC is subtitle style.
+//
+@interface PhotoListSpecCell : UITableViewCell
+@end
+
+@implementation PhotoListSpecCell
+
+- (id) initWithStyle: (UITableViewCellStyle)style
+     reuseIdentifier: (NSString *)reuseIdentifier
+{
+  return [super initWithStyle:UITableViewCellStyleSubtitle reuseIdentifier:reuseIdentifier];
+}
+
+@end
+
+
+
+
+SpecBegin(PhotoList_A)
+
+
+//------------------------------------------------------------------------------------- -o-
+#define  ROWCOUNT_BENCHMARK    5000
+#define  ROWS_PER_FRAME        3
+#define  FRAME_SECONDS         (1.0 / 60)
+#define  ROWS_READY_TIMEOUT    10.0
+
+
+static NSArray *syntheticRowPhotoArray(NSUInteger photoCount)
+{
+  NSMutableArray  *photos = [[NSMutableArray alloc] initWithCapacity:photoCount];
+
+  for (NSUInteger i = 0; i < photoCount; i++)
+  {
+    [photos addObject:
+      @{
+         FLICKR_PHOTO_ID     : DP_STRWFMT(@"row%lu", (unsigned long)i),
+         FLICKR_PHOTO_TITLE  : DP_STRWFMT(@"Photo %lu", (unsigned long)i),
+         @"description"      : @{ @"_content" : DP_STRWFMT(@"Description of photo %lu.", (unsigned long)i) },
+       }];
+  }
+
+  return photos;
+}
+
+
+static int compareIntervals(const void *a, const void *b)
+{
+  double  da = *(const double *)a;
+  double  db = *(const double *)b;
+
+  return (da < db) ? -1 : ((da > db) ? 1 : 0);
+}
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"PhotoListTVC",
+^{
+  __block  PhotoListTVC  *tvc;
+  __block  NSArray       *photos;
+
+
+
+  //-------------------------------------------------- -o-
+  beforeAll(^{
+    photos = syntheticRowPhotoArray(ROWCOUNT_BENCHMARK);
+
+    tvc = [[PhotoListTVC alloc] initWithStyle:UITableViewStylePlain];
+    tvc.notRecentsList = YES;
+
+    tvc.view.frame = [[UIScreen mainScreen] bounds];
+    [tvc.tableView registerClass:[PhotoListSpecCell class] forCellReuseIdentifier:@"ImageTitle"];
+  });
+
+
+
+  //------------------------ -o-
+  it(@"build rows off the main thread",
+  ^{
+    tvc.photoArray = photos;
+    [tvc.tableView reloadData];
+
+    NSDate  *deadline = [NSDate dateWithTimeIntervalSinceNow:ROWS_READY_TIMEOUT];
+
+    while (    ([[tvc valueForKey:@"rows"] photoArray] != photos)
+            && ([deadline timeIntervalSinceNow] > 0) )
+    {
+      [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+
+    PhotoListRows  *rows = [tvc valueForKey:@"rows"];
+
+    expect(rows.photoArray).to.beIdenticalTo(photos);
+    expect([rows count]).to.equal(ROWCOUNT_BENCHMARK);
+    expect([[rows rowAtIndex:7] title]).to.equal(@"Photo 7");
+  });
+
+
+
+  //------------------------ -o-
+  it(@"benchmark frame times scrolling 5,000 rows",
+  ^{
+    UITableView  *tableView   = tvc.tableView;
+    CGFloat       step        = tableView.rowHeight * ROWS_PER_FRAME;
+    CGFloat       maxOffset   = tableView.contentSize.height - tableView.bounds.size.height;
+    NSUInteger    frameCount  = (NSUInteger)(maxOffset / step) + 1;
+    double       *frames      = malloc(frameCount * sizeof(double));
+    NSUInteger    slowFrames  = 0;
+
+    for (NSUInteger f = 0; f < frameCount; f++)
+    {
+      NSTimeInterval  start = [NSDate timeIntervalSinceReferenceDate];
+
+      tableView.contentOffset = CGPointMake(0, f * step);
+      [tableView layoutIfNeeded];
+
+      frames[f] = [NSDate timeIntervalSinceReferenceDate] - start;
+      if (frames[f] > FRAME_SECONDS)  { slowFrames += 1; }
+    }
+
+    qsort(frames, frameCount, sizeof(double), compareIntervals);
+
+    double  median  = frames[frameCount / 2];
+    double  p95     = frames[(frameCount * 95) / 100];
+    double  worst   = frames[frameCount - 1];
+
+    DP_LOG_INFO(@"BENCHMARK  scroll %d rows, %lu frames:  median %.3f ms,  p95 %.3f ms,  max %.3f ms,  over frame budget %lu",
+                  ROWCOUNT_BENCHMARK, (unsigned long)frameCount, median * 1000, p95 * 1000, worst * 1000, (unsigned long)slowFrames);
+
+    free(frames);
+
+    expect(frameCount).to.beGreaterThan(ROWCOUNT_BENCHMARK / ROWS_PER_FRAME / 2);
+    expect(p95).to.beLessThan(FRAME_SECONDS);
+  });
+
+}); // describe -- PhotoListTVC
+
+
+SpecEnd // PhotoList_A
+
@@ -0,0 +1,135 @@
+//
+// PlacePhotoIndexSpec_A.m
+//
+// Per place photo fetches shared by concurrent callers, over FlickrStandIn.
+//
+//
+// CLASS DEPENDENCIES:  PlacePhotoIndex, FlickrStandIn, FlickrFetcher
+//
+
+#import "Specta.h"
+
+#define EXP_SHORTHAND
+#import "Expecta.h"
+
+
+#import "PlacePhotoIndex.h"
+#import "FlickrStandIn.h"
+
+
+
+SpecBegin(PlacePhotoIndex_A)
+
+
+//------------------------------------------------------------------------------------- -o-
+#define  PLACECOUNT         4
+#define  PHOTOS_PER_PLACE   5
+#define  LATENCY            0.2
+#define  CALLERCOUNT        2
+
+
+// One photos.search fixture per place, each with its own photo IDs.
+//
+static NSURL *temporaryCorpusURL(void)
+{
+  NSURL  *dirURL     = [NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES];
+  NSURL  *corpusURL  = [dirURL URLByAppendingPathComponent:@"PlacePhotoIndexSpec" isDirectory:YES];
+  NSURL  *restURL    = [corpusURL URLByAppendingPathComponent:@"rest" isDirectory:YES];
+
+  [[NSFileManager defaultManager] removeItemAtURL:corpusURL error:nil];
+  [[NSFileManager defaultManager] createDirectoryAtURL:restURL withIntermediateDirectories:YES attributes:nil error:nil];
+
+  for (NSUInteger p = 0; p < PLACECOUNT; p++)
+  {
+    NSMutableArray  *photos = [[NSMutableArray alloc] init];
+
+    for (NSUInteger i = 0; i < PHOTOS_PER_PLACE; i++) {
+      [photos addObject:@{ FLICKR_PHOTO_ID : DP_STRWFMT(@"%lu-%lu", (unsigned long)p, (unsigned long)i), FLICKR_PHOTO_TITLE : @"Photo" }];
+    }
+
+    NSData  *json = [NSJSONSerialization dataWithJSONObject:@{ @"photos" : @{ @"photo" : photos }, @"stat" : @"ok" } options:0 error:nil];
+
+    [json writeToURL:[restURL URLByAppendingPathComponent:DP_STRWFMT(@"flickr.photos.search_place_id-place%lu.json", (unsigned long)p)]
+          atomically:YES];
+  }
+
+  return corpusURL;
+}
+
+
+static NSArray *placeArray(void)
+{
+  NSMutableArray  *places = [[NSMutableArray alloc] init];
+
+  for (NSUInteger p = 0; p < PLACECOUNT; p++) {
+    [places addObject:@{ FLICKR_PLACE_ID : DP_STRWFMT(@"place%lu", (unsigned long)p), FLICKR_PLACE_NAME : DP_STRWFMT(@"Place %lu", (unsigned long)p) }];
+  }
+
+  return places;
+}
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"PlacePhotoIndex",
+^{
+  __block FlickrStandIn  *standIn;
+
+
+  //-------------------------------------------------- -o-
+  beforeEach(^{
+    standIn = [[FlickrStandIn alloc] initWithCorpusURL:temporaryCorpusURL()];
+    standIn.latency = LATENCY;
+
+    expect([standIn start:0]).to.beTruthy();
+    [FlickrFetcher setBaseURL:standIn.baseURL];
+  });
+
+  afterEach(^{
+    [FlickrFetcher setBaseURL:nil];
+    [standIn stop];
+    [[NSFileManager defaultManager] removeItemAtURL:standIn.corpusURL error:nil];
+    standIn = nil;
+  });
+
+
+
+  //------------------------ -o-
+  it(@"gives every concurrent caller the photos of every place, fetching each place once",
+  ^{
+    PlacePhotoIndex  *index      = [[PlacePhotoIndex alloc] initWithMaxAge:60 inFlightMax:PLACECOUNT];
+    NSArray          *places     = placeArray();
+    NSMutableArray   *results    = [[NSMutableArray alloc] init];
+    dispatch_group_t  callers    = dispatch_group_create();
+
+    for (NSUInteger c = 0; c < CALLERCOUNT; c++)
+    {
+      dispatch_group_async(callers, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        NSArray  *photoArray = [index photoArrayForPlaces:places maxResults:PHOTOS_PER_PLACE];
+
+        @synchronized (results) {
+          [results addObject:photoArray ?: @[]];
+        }
+      });
+
+      usleep((useconds_t)(LATENCY * 1000000 / 4));      // Second caller starts while the first is in flight.
+    }
+
+    dispatch_group_wait(callers, DISPATCH_TIME_FOREVER);
+
+
+    //
+    expect(results).to.haveCountOf(CALLERCOUNT);
+
+    for (NSArray *photoArray in results) {
+      expect(photoArray).to.haveCountOf(PLACECOUNT * PHOTOS_PER_PLACE);
+    }
+
+    expect([standIn stats].replayed).to.equal(PLACECOUNT);
+  });
+
+});
+
+
+SpecEnd
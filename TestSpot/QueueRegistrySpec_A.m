@@ -0,0 +1,102 @@
+//
+// QueueRegistrySpec_A.m
+//
+// Concurrency limit, submission order and stats of QueueRegistry roles.
+//
+//
+// CLASS DEPENDENCIES:  QueueRegistry
+//
+
+#import "Specta.h"
+
+#define EXP_SHORTHAND
+#import "Expecta.h"
+
+
+#import "Danaprajna.h"
+#import "QueueRegistry.h"
+
+#import <libkern/OSAtomic.h>
+
+
+
+SpecBegin(QueueRegistry_A)
+
+
+//------------------------------------------------------------------------------------- -o-
+#define  BLOCKCOUNT    64
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"QueueRegistry",
+^{
+  //------------------------ -o-
+  it(@"never runs more blocks of a role at once than its limit",
+  ^{
+    dispatch_group_t         group       = dispatch_group_create();
+    NSUInteger               limit       = [QueueRegistry concurrencyForRole:QRRoleNetwork];
+    QRStats                  before      = [QueueRegistry statsForRole:QRRoleNetwork];
+    __block volatile int32_t running     = 0;
+    __block volatile int32_t runningMax  = 0;
+
+    for (NSUInteger i = 0; i < BLOCKCOUNT; i++)
+    {
+      [QueueRegistry async:QRRoleNetwork group:group block:
+      ^{
+        int32_t  now = OSAtomicIncrement32Barrier(&running);
+        int32_t  max;
+
+        do {
+          max = runningMax;
+        } while ((now > max) && !OSAtomicCompareAndSwap32Barrier(max, now, &runningMax));
+
+        usleep(2000);
+        OSAtomicDecrement32Barrier(&running);
+      }];
+    }
+
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+
+    //
+    QRStats  after = [QueueRegistry statsForRole:QRRoleNetwork];
+
+    DP_LOG_INFO(@"BENCHMARK  %d blocks, limit %lu:  %@", BLOCKCOUNT, (unsigned long)limit,
+                  [QueueRegistry statsDescription][[QueueRegistry nameForRole:QRRoleNetwork]]);
+
+    expect(runningMax).to.beLessThanOrEqualTo(limit);
+    expect(runningMax).to.beGreaterThan(1);
+    expect(after.completed - before.completed).to.equal(BLOCKCOUNT);
+    expect(after.runTotal).to.beGreaterThan(before.runTotal);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"runs a role with limit one in submission order",
+  ^{
+    dispatch_group_t   group  = dispatch_group_create();
+    NSMutableArray    *order  = [[NSMutableArray alloc] init];
+
+    expect([QueueRegistry concurrencyForRole:QRRoleIndex]).to.equal(1);
+
+    for (NSUInteger i = 0; i < BLOCKCOUNT; i++)
+    {
+      [QueueRegistry async:QRRoleIndex group:group block:^{
+        [order addObject:@(i)];
+      }];
+    }
+
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+    for (NSUInteger i = 0; i < BLOCKCOUNT; i++) {
+      expect(order[i]).to.equal(@(i));
+    }
+  });
+
+}); // describe -- QueueRegistry
+
+
+SpecEnd // QueueRegistry_A
+
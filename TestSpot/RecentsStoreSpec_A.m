@@ -0,0 +1,141 @@
+//
+// RecentsStoreSpec_A.m
+//
+// Test and benchmark the recents store and its log.
+//
+//
+// CLASS DEPENDENCIES:  RecentsStore
+//
+
+#import "Specta.h"
+
+#define EXP_SHORTHAND
+#import "Expecta.h"
+
+
+#import "RecentsStore.h"
+
+
+
+SpecBegin(RecentsStore_A)
+
+
+//------------------------------------------------------------------------------------- -o-
+#define  CAPACITY_SMALL        3
+#define  CAPACITY_BENCHMARK    5000
+#define  ADDCOUNT_BENCHMARK    20000
+
+
+static NSDictionary *syntheticPhotoEntry(NSUInteger i)
+{
+  return @{
+            FLICKR_PHOTO_ID     : DP_STRWFMT(@"%lu", (unsigned long)i),
+            FLICKR_PHOTO_TITLE  : DP_STRWFMT(@"Photo %lu", (unsigned long)i),
+          };
+}
+
+
+static NSURL *temporaryLogURL(NSString *name)
+{
+  NSURL  *dirURL = [NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES];
+  NSURL  *logURL = [[dirURL URLByAppendingPathComponent:@"RecentsStoreSpec" isDirectory:YES] URLByAppendingPathComponent:name];
+
+  [[NSFileManager defaultManager] removeItemAtURL:logURL error:nil];
+
+  return logURL;
+}
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"RecentsStore",
+^{
+
+  //------------------------ -o-
+  it(@"keep newest first within capacity; move a photo viewed again; replay from log",
+  ^{
+    NSURL         *logURL  = temporaryLogURL(@"small.log");
+    RecentsStore  *store   = [[RecentsStore alloc] initWithLogURL:logURL capacity:CAPACITY_SMALL];
+
+    for (NSUInteger i = 1; i <= 4; i++) {
+      [store addPhotoEntry:syntheticPhotoEntry(i)];
+    }
+    [store addPhotoEntry:syntheticPhotoEntry(2)];
+
+    expect([[store photoArray] valueForKey:FLICKR_PHOTO_ID]).to.equal((@[ @"2", @"4", @"3" ]));
+    expect([[store photoArrayMostRecent:1] valueForKey:FLICKR_PHOTO_ID]).to.equal((@[ @"2" ]));
+    expect([store containsPhotoID:@"1"]).to.beFalsy();
+
+    store = nil;
+    store = [[RecentsStore alloc] initWithLogURL:logURL capacity:CAPACITY_SMALL];
+
+    expect([[store photoArray] valueForKey:FLICKR_PHOTO_ID]).to.equal((@[ @"2", @"4", @"3" ]));
+    expect([[store photoArray][0] objectForKey:FLICKR_PHOTO_TITLE]).to.equal(@"Photo 2");
+
+    [store removeAllPhotos];
+    store = [[RecentsStore alloc] initWithLogURL:logURL capacity:CAPACITY_SMALL];
+
+    expect([store count]).to.equal(0);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"drop a torn record at the end of the log",
+  ^{
+    NSURL         *logURL  = temporaryLogURL(@"torn.log");
+    RecentsStore  *store   = [[RecentsStore alloc] initWithLogURL:logURL capacity:CAPACITY_SMALL];
+
+    [store addPhotoEntry:syntheticPhotoEntry(1)];
+    [store addPhotoEntry:syntheticPhotoEntry(2)];
+    store = nil;
+
+    NSFileHandle  *handle = [NSFileHandle fileHandleForWritingToURL:logURL error:nil];
+    [handle truncateFileAtOffset:[handle seekToEndOfFile] - 3];
+    [handle closeFile];
+
+    store = [[RecentsStore alloc] initWithLogURL:logURL capacity:CAPACITY_SMALL];
+
+    expect([[store photoArray] valueForKey:FLICKR_PHOTO_ID]).to.equal((@[ @"1" ]));
+  });
+
+
+
+  //------------------------ -o-
+  it(@"benchmark add and list with capacity 5,000",
+  ^{
+    NSURL           *logURL  = temporaryLogURL(@"benchmark.log");
+    RecentsStore    *store   = [[RecentsStore alloc] initWithLogURL:logURL capacity:CAPACITY_BENCHMARK];
+    NSTimeInterval   start, addElapsed, listElapsed, replayElapsed;
+
+    start       = [NSDate timeIntervalSinceReferenceDate];
+    for (NSUInteger i = 0; i < ADDCOUNT_BENCHMARK; i++) {
+      [store addPhotoEntry:syntheticPhotoEntry(i % (CAPACITY_BENCHMARK * 2))];
+    }
+    addElapsed  = [NSDate timeIntervalSinceReferenceDate] - start;
+
+    start        = [NSDate timeIntervalSinceReferenceDate];
+    NSArray *top = [store photoArrayMostRecent:10];
+    listElapsed  = [NSDate timeIntervalSinceReferenceDate] - start;
+
+    store = nil;
+
+    start          = [NSDate timeIntervalSinceReferenceDate];
+    store          = [[RecentsStore alloc] initWithLogURL:logURL capacity:CAPACITY_BENCHMARK];
+    replayElapsed  = [NSDate timeIntervalSinceReferenceDate] - start;
+
+    DP_LOG_INFO(@"BENCHMARK  recents capacity %d:  %d adds %.3f ms (%.1f us each),  list 10 %.3f ms,  replay %.3f ms",
+                  CAPACITY_BENCHMARK, ADDCOUNT_BENCHMARK, addElapsed * 1000, addElapsed * 1e6 / ADDCOUNT_BENCHMARK,
+                  listElapsed * 1000, replayElapsed * 1000);
+
+    expect([top count]).to.equal(10);
+    expect([store count]).to.equal(CAPACITY_BENCHMARK);
+    expect([[store photoArrayMostRecent:10] valueForKey:FLICKR_PHOTO_ID]).to.equal([top valueForKey:FLICKR_PHOTO_ID]);
+  });
+
+}); // describe -- RecentsStore
+
+
+SpecEnd // RecentsStore_A
+
@@ -0,0 +1,114 @@
+//
+// SessionLoadSpec_A.m
+//
+// Concurrent simulated sessions against a FlickrStandIn.
+//
+//
+// CLASS DEPENDENCIES:  SessionLoad, FlickrStandIn, PhotoFetch
+//
+
+#import "Specta.h"
+
+#define EXP_SHORTHAND
+#import "Expecta.h"
+
+
+#import "SessionLoad.h"
+#import "FlickrStandIn.h"
+
+
+
+SpecBegin(SessionLoad_A)
+
+
+//------------------------------------------------------------------------------------- -o-
+#define  PHOTOCOUNT     60
+#define  SESSIONCOUNT   4
+#define  ROUNDCOUNT     2
+
+
+// One search answers every category;  top places lists one place,
+//   whose search falls back to the same file.
+//
+static NSURL *temporaryCorpusURL(void)
+{
+  NSURL  *dirURL     = [NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES];
+  NSURL  *corpusURL  = [dirURL URLByAppendingPathComponent:@"SessionLoadSpec" isDirectory:YES];
+  NSURL  *restURL    = [corpusURL URLByAppendingPathComponent:@"rest" isDirectory:YES];
+
+  [[NSFileManager defaultManager] removeItemAtURL:corpusURL error:nil];
+  [[NSFileManager defaultManager] createDirectoryAtURL:restURL withIntermediateDirectories:YES attributes:nil error:nil];
+
+  NSMutableArray  *photos = [[NSMutableArray alloc] init];
+
+  for (NSUInteger i = 0; i < PHOTOCOUNT; i++) {
+    [photos addObject:@{ FLICKR_PHOTO_ID     : DP_STRWFMT(@"sessionload%lu", (unsigned long)i),
+                         FLICKR_PHOTO_TITLE  : DP_STRWFMT(@"Photo %lu", (unsigned long)i),
+                         FLICKR_TAGS         : DP_STRWFMT(@"tag%lu tag%lu common", (unsigned long)(i % 5), (unsigned long)(i % 7)),
+                         @"farm"             : @1,
+                         @"server"           : @"1000",
+                         @"secret"           : DP_STRWFMT(@"secret%lu", (unsigned long)i),
+                         @"dateupload"       : DP_STRWFMT(@"%lu", (unsigned long)(1390000000 + i)) }];
+  }
+
+  NSDictionary  *search  = @{ @"photos" : @{ @"page" : @1, @"pages" : @1, @"photo" : photos }, @"stat" : @"ok" };
+  NSDictionary  *places  = @{ @"places" : @{ @"place" : @[ @{ FLICKR_PLACE_ID : @"place0", FLICKR_PLACE_NAME : @"Place 0" } ] }, @"stat" : @"ok" };
+
+  [[NSJSONSerialization dataWithJSONObject:search options:0 error:nil]
+    writeToURL:[restURL URLByAppendingPathComponent:@"flickr.photos.search.json"] atomically:YES];
+  [[NSJSONSerialization dataWithJSONObject:places options:0 error:nil]
+    writeToURL:[restURL URLByAppendingPathComponent:@"flickr.places.getTopPlacesList.json"] atomically:YES];
+
+  return corpusURL;
+}
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"SessionLoad",
+^{
+  //------------------------ -o-
+  it(@"runs every session and accounts for every photo opened",
+  ^{
+    FlickrStandIn  *standIn = [[FlickrStandIn alloc] initWithCorpusURL:temporaryCorpusURL()];
+
+    expect([standIn start:0]).to.beTruthy();
+    [FlickrFetcher setBaseURL:standIn.baseURL];
+
+
+    //
+    SLConfig  config = SL_CONFIG_DEFAULT;
+
+    config.sessions          = SESSIONCOUNT;
+    config.rounds            = ROUNDCOUNT;
+    config.clearProbability  = 0;
+
+    SLReport  report = [SessionLoad run:config];
+
+    [FlickrFetcher setBaseURL:nil];
+    [standIn stop];
+
+    DP_LOG_INFO(@"BENCHMARK  SessionLoad\n%@", [SessionLoad descriptionOfReport:report]);
+
+
+    //
+    expect(report.sessions).to.equal(SESSIONCOUNT * ROUNDCOUNT);
+    expect(report.listFailures).to.equal(0);
+    expect(report.photoFailures).to.equal(0);
+    expect(report.clears).to.equal(0);
+
+    expect(report.timeToList.count).to.equal(SESSIONCOUNT * ROUNDCOUNT);
+    expect(report.timeToImage.count).to.equal(report.photosOpened);
+    expect(report.photosOpened).to.beGreaterThan(0);
+    expect(report.cacheHits).to.beLessThanOrEqualTo(report.photosOpened);
+    expect(report.timeToImage.median).to.beLessThanOrEqualTo(report.timeToImage.p90);
+    expect(report.timeToImage.p90).to.beLessThanOrEqualTo(report.timeToImage.max);
+    expect(report.peakResidentBytes).to.beGreaterThan(0);
+  });
+
+});
+
+
+SpecEnd
+
@@ -0,0 +1,128 @@
+//
+// TraceSpec_A.m
+//
+// Parent links, Chrome trace export, and the cost of spans when off.
+//
+//
+// CLASS DEPENDENCIES:  Trace
+//
+
+#import "Specta.h"
+
+#define EXP_SHORTHAND
+#import "Expecta.h"
+
+
+#import "Danaprajna.h"
+
+
+
+SpecBegin(Trace_A)
+
+
+//------------------------------------------------------------------------------------- -o-
+#define  CALLCOUNT_DISABLED    100000
+
+
+
+//------------------------------------------------------------------------------------- -o-
+// RETURN:  Exported events keyed by name.
+//
+static NSDictionary *
+eventsByName (void)
+{
+  NSDictionary         *trace   = [NSJSONSerialization JSONObjectWithData:[Trace chromeTraceJSON] options:0 error:nil];
+  NSMutableDictionary  *events  = [[NSMutableDictionary alloc] init];
+
+  for (NSDictionary *event in trace[@"traceEvents"]) {
+    events[event[@"name"]] = event;
+  }
+
+  return events;
+}
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"Trace",
+^{
+  __block  BOOL  savedEnabled;
+
+
+  //-------------------------------------------------- -o-
+  beforeEach(^{
+    savedEnabled = [Trace isEnabled];
+    [Trace clear];
+  });
+
+  afterEach(^{
+    [Trace setEnabled:savedEnabled];
+    [Trace clear];
+  });
+
+
+
+  //------------------------ -o-
+  it(@"links nested, child and async spans to their parents",
+  ^{
+    [Trace setEnabled:YES];
+
+    DPTraceSpan  outer  = DP_TRACE_BEGIN("outer");
+    DPTraceSpan  async  = DP_TRACE_BEGIN_ASYNC("async");
+    DPTraceSpan  inner  = DP_TRACE_BEGIN("inner");
+
+    DP_TRACE_END(inner);
+
+    dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+      DPTraceSpan  child = DP_TRACE_BEGIN_CHILD("child", async.spanID);
+      DP_TRACE_END(child);
+    });
+
+    DP_TRACE_END(async);
+    DP_TRACE_END(outer);
+
+    DPTraceSpan  after = DP_TRACE_BEGIN("after");
+    DP_TRACE_END(after);
+
+
+    //
+    NSDictionary  *events = eventsByName();
+
+    expect([Trace count]).to.equal(5);
+
+    expect(events[@"outer"][@"ph"]).to.equal(@"X");
+    expect(events[@"async"][@"args"][@"parent"]).to.equal(@(outer.spanID));
+    expect(events[@"inner"][@"args"][@"parent"]).to.equal(@(outer.spanID));
+    expect(events[@"child"][@"args"][@"parent"]).to.equal(@(async.spanID));
+    expect(events[@"after"][@"args"][@"parent"]).to.equal(@0);
+
+    expect([events[@"outer"][@"dur"] doubleValue]).to.beGreaterThanOrEqualTo([events[@"inner"][@"dur"] doubleValue]);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"records nothing when off",
+  ^{
+    [Trace setEnabled:NO];
+
+    NSTimeInterval  start = [NSDate timeIntervalSinceReferenceDate];
+
+    for (NSUInteger i = 0; i < CALLCOUNT_DISABLED; i++) {
+      DPTraceSpan  span = DP_TRACE_BEGIN("disabled");
+      DP_TRACE_END(span);
+    }
+
+    NSTimeInterval  elapsed = [NSDate timeIntervalSinceReferenceDate] - start;
+
+    DP_LOG_INFO(@"BENCHMARK  span begin and end with tracing off:  %.1f ns", elapsed * 1e9 / CALLCOUNT_DISABLED);
+
+    expect([Trace count]).to.equal(0);
+  });
+
+}); // describe -- Trace
+
+
+SpecEnd // Trace_A
+
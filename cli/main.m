@@ -0,0 +1,703 @@
+//
+// main.m
+// spotcli
+//
+// Run model layer workloads without UIKit:  index builds and queries over
+// synthetic photos, DataFileCache save/lookup/evict, and paginated Flickr
+// fetches through PhotoFetch, simulated user sessions through SessionLoad.
+// Serve a fixture corpus with FlickrStandIn.  Replay a file access trace
+// against simulated caches of several sizes.  Measure a first session
+// against a cold cache, and against one warmed from a snapshot.
+//
+//   spotcli [options] index [photos]
+//   spotcli [options] cache [files] [bytes]
+//   spotcli [options] replay [trace|-] [bytes,...]
+//   spotcli [options] warmstart [trace|- [trace|-]]
+//   spotcli [options] fetch [latest|stanford] [pages]
+//   spotcli [options] session [sessions] [rounds]
+//   spotcli [options] serve [port]
+//
+// -t trace.json   Record trace spans and write them as Chrome trace JSON.
+// -b url          Send Flickr requests to url.
+// -s corpus       Send Flickr requests to a FlickrStandIn serving corpus,
+//                   in this process.  serve uses it, or CLI_CORPUS_DEFAULT.
+// -r              Record requests missing from the corpus, from Flickr.
+// -l ms[:ms]      Stand-in latency, and jitter.
+// -w bytes        Stand-in bandwidth, bytes per second per connection.
+// -e rate         Stand-in error rate, 0 to 1.
+// -z bytes        Stand-in photo size.
+//
+
+#import "Danaprajna.h"
+#import "DataFileCache.h"
+#import "DataFileCacheSimulator.h"
+#import "QueueRegistry.h"
+
+#import "FlickrFetcher.h"
+#import "FlickrStandIn.h"
+#import "PhotoFetch.h"
+#import "PhotoGeoIndex.h"
+#import "PhotoSnapshot.h"
+#import "PhotoSortIndex.h"
+#import "PhotoTagIndex.h"
+#import "PhotoTextIndex.h"
+#import "SessionLoad.h"
+
+
+
+//------------------------------------------------------------ -o-
+#define CLI_PHOTOCOUNT_DEFAULT    10000
+#define CLI_TAGCOUNT_VOCABULARY   500
+#define CLI_TAGCOUNT_PER_PHOTO    8
+#define CLI_RANDOM_SEED           193
+#define CLI_QUERY_COUNT           100
+
+#define CLI_FILECOUNT_DEFAULT     500
+#define CLI_FILESIZE_DEFAULT      (64 * 1024)
+#define CLI_CACHE_FRACTION        0.5      // Cache holds this fraction of the files written.
+
+#define CLI_REPLAY_ACCESSES       1000000
+#define CLI_REPLAY_FILECOUNT      100000
+#define CLI_REPLAY_ZIPF_EXPONENT  0.9
+#define CLI_REPLAY_CACHESIZES     "16777216,67108864,268435456"
+
+#define CLI_WARMSTART_ACCESSES    10000
+#define CLI_WARMSTART_CACHESIZE   (64 * 1024 * 1024)
+
+#define CLI_PAGES_DEFAULT         PF_FETCH_PAGES_MAX
+
+#define CLI_CORPUS_DEFAULT        "TestSpot/fixtures/flickr"
+
+
+
+//------------------------------------------------------------ -o-
+static NSTimeInterval
+elapsedSince (NSTimeInterval start)
+{
+  return [NSDate timeIntervalSinceReferenceDate] - start;
+}
+
+
+static void
+report (NSString *label, NSTimeInterval seconds, NSUInteger count)
+{
+  printf("%-28s %10.3f ms", [label UTF8String], seconds * 1000);
+
+  if (count > 1) {
+    printf("   %10.1f us each", seconds * 1e6 / count);
+  }
+
+  printf("\n");
+}
+
+
+
+//------------------------------------------------------------ -o-
+// Photo entries shaped like FlickrFetcher results, with deterministic content.
+//
+static NSArray *
+syntheticPhotoArray (NSUInteger photoCount)
+{
+  NSMutableArray  *photos = [[NSMutableArray alloc] initWithCapacity:photoCount];
+
+  srandom(CLI_RANDOM_SEED);
+
+  for (NSUInteger i = 0; i < photoCount; i++)
+  {
+    NSMutableArray  *tags = [[NSMutableArray alloc] init];
+
+    for (int t = 0; t < CLI_TAGCOUNT_PER_PHOTO; t++) {
+      [tags addObject:DP_STRWFMT(@"tag%ld", random() % CLI_TAGCOUNT_VOCABULARY)];
+    }
+
+    double  latitude   = asin((2.0 * random() / RAND_MAX) - 1.0) * 180.0 / M_PI;
+    double  longitude  = (360.0 * random() / RAND_MAX) - 180.0;
+
+    [photos addObject:
+      @{
+         FLICKR_PHOTO_ID    : DP_STRWFMT(@"%lu", (unsigned long)i),
+         FLICKR_PHOTO_TITLE : DP_STRWFMT(@"Photo %lu", (unsigned long)i),
+         FLICKR_TAGS        : [tags componentsJoinedByString:@" "],
+         FLICKR_LATITUDE    : DP_STRWFMT(@"%.6f", latitude),
+         FLICKR_LONGITUDE   : DP_STRWFMT(@"%.6f", longitude),
+         @"description"     : @{ @"_content" : DP_STRWFMT(@"Seen near %@.", [tags componentsJoinedByString:@", "]) },
+       }];
+  }
+
+  return photos;
+}
+
+
+
+
+//------------------------------------------------------------ -o-
+// runIndex
+//
+// Build every index over photoCount photos, then query each.
+//
+static int
+runIndex (NSUInteger photoCount)
+{
+  NSTimeInterval  start;
+  NSArray        *photos = syntheticPhotoArray(photoCount);
+
+  printf("index:  %lu photos\n", (unsigned long)photoCount);
+
+
+  // Each index alone, then a snapshot, which builds all of them.
+  //
+  start = [NSDate timeIntervalSinceReferenceDate];
+  (void) [[PhotoTagIndex alloc] initWithPhotoArray:photos];
+  report(@"tag index build", elapsedSince(start), 1);
+
+  start = [NSDate timeIntervalSinceReferenceDate];
+  (void) [[PhotoSortIndex alloc] initWithPhotoArray:photos];
+  report(@"sort index build", elapsedSince(start), 1);
+
+  start = [NSDate timeIntervalSinceReferenceDate];
+  (void) [[PhotoTextIndex alloc] initWithPhotoArray:photos];
+  report(@"text index build", elapsedSince(start), 1);
+
+  start = [NSDate timeIntervalSinceReferenceDate];
+  (void) [[PhotoGeoIndex alloc] initWithPhotoArray:photos];
+  report(@"geo index build", elapsedSince(start), 1);
+
+  start = [NSDate timeIntervalSinceReferenceDate];
+  PhotoSnapshot  *snapshot = [PhotoSnapshot snapshotWithPhotoArray: photos
+                                                          category: PFCategoryLatestGeoreferenced
+                                                           version: 1
+                                                          previous: nil ];
+  report(@"snapshot build", elapsedSince(start), 1);
+
+
+  //
+  NSArray  *tags = [snapshot.tagIndex sortedTags];
+
+  if ([tags count] <= 0) {
+    fprintf(stderr, "index:  no tags indexed.\n");
+    return 1;
+  }
+
+  start = [NSDate timeIntervalSinceReferenceDate];
+  for (NSUInteger i = 0; i < CLI_QUERY_COUNT; i++) {
+    [snapshot sortedPhotoArrayForTag:tags[i % [tags count]] order:PFSortOrderUploadDate];
+  }
+  report(@"sorted photos for tag", elapsedSince(start), CLI_QUERY_COUNT);
+
+  start = [NSDate timeIntervalSinceReferenceDate];
+  for (NSUInteger i = 0; i < CLI_QUERY_COUNT; i++) {
+    [snapshot.textIndex photoArrayMatchingQuery:DP_STRWFMT(@"seen %@", tags[i % [tags count]])];
+  }
+  report(@"text query", elapsedSince(start), CLI_QUERY_COUNT);
+
+  start = [NSDate timeIntervalSinceReferenceDate];
+  for (NSUInteger i = 0; i < CLI_QUERY_COUNT; i++) {
+    [snapshot.geoIndex photoArrayNearestLatitude:(i % 180) - 90.0 longitude:(i * 7 % 360) - 180.0 count:10];
+  }
+  report(@"geo nearest 10", elapsedSince(start), CLI_QUERY_COUNT);
+
+  return 0;
+}
+
+
+
+
+//------------------------------------------------------------ -o-
+// runCache
+//
+// Save fileCount files of fileSize bytes into a cache that holds only
+// part of them, so later saves evict;  then look each one up.
+//
+static int
+runCache (NSUInteger fileCount, NSUInteger fileSize)
+{
+  NSTimeInterval   start;
+  NSURL           *cacheDirURL  = [NSURL fileURLWithPath:
+                                     [NSTemporaryDirectory() stringByAppendingPathComponent:
+                                       DP_STRWFMT(@"spotcli-cache-%d", getpid())]];
+  long long        cacheSize    = (long long)(fileCount * fileSize * CLI_CACHE_FRACTION);
+
+  printf("cache:  %lu files of %lu bytes, cache %lld bytes at %s\n",
+           (unsigned long)fileCount, (unsigned long)fileSize, cacheSize, [[cacheDirURL path] UTF8String]);
+
+  DataFileCache  *cache = [[DataFileCache alloc] initCacheDirectoryWithURL:cacheDirURL sizeInBytes:cacheSize];
+
+  if (!cache) {
+    fprintf(stderr, "cache:  could not create cache.\n");
+    return 1;
+  }
+
+
+  //
+  uint32_t        pattern   = 0x5a5a1234;
+  NSMutableData  *fileData  = [[NSMutableData alloc] initWithLength:fileSize];
+  NSUInteger      saved     = 0;
+  NSUInteger      found     = 0;
+
+  dp_memset_pattern4([fileData mutableBytes], &pattern, fileSize);
+
+  start = [NSDate timeIntervalSinceReferenceDate];
+  for (NSUInteger i = 0; i < fileCount; i++) {
+    if ([cache saveFile:DP_STRWFMT(@"file-%lu", (unsigned long)i) withData:fileData])  { saved += 1; }
+  }
+  report(@"save (with eviction)", elapsedSince(start), fileCount);
+
+  start = [NSDate timeIntervalSinceReferenceDate];
+  for (NSUInteger i = 0; i < fileCount; i++) {
+    if ([cache cachedFileURL:DP_STRWFMT(@"file-%lu", (unsigned long)i)])  { found += 1; }
+  }
+  report(@"lookup", elapsedSince(start), fileCount);
+
+  printf("saved %lu,  still cached %lu,  free bytes %ld\n",
+           (unsigned long)saved, (unsigned long)found, (long)[cache currentFreeBytes]);
+
+
+  //
+  start = [NSDate timeIntervalSinceReferenceDate];
+  [cache clearCache];
+  report(@"clear", elapsedSince(start), 1);
+
+  [Zed removeItemForURL:cacheDirURL];
+
+  return (saved == fileCount) ? 0 : 1;
+}
+
+
+
+
+//------------------------------------------------------------ -o-
+// replaySynthetic
+//
+// accesses, one per virtual second from startTime, over
+// CLI_REPLAY_FILECOUNT files chosen by Zipfian popularity.  Each file has
+// its own size, from 8 to 64 KB.
+//
+static BOOL
+replaySynthetic (DataFileCacheSimulator *simulator, NSUInteger accesses, unsigned seed, NSTimeInterval startTime)
+{
+  double  *cumulative  = malloc(CLI_REPLAY_FILECOUNT * sizeof(double));
+  double   total       = 0;
+
+  if (!cumulative)  { return NO; }
+
+  for (NSUInteger k = 0; k < CLI_REPLAY_FILECOUNT; k++) {
+    total         += pow(k + 1, -CLI_REPLAY_ZIPF_EXPONENT);
+    cumulative[k]  = total;
+  }
+
+  srandom(seed);
+
+  for (NSUInteger i = 0; i < accesses; i++)
+  {
+    double      target  = (random() / ((double)RAND_MAX + 1)) * total;
+    NSUInteger  low     = 0;
+    NSUInteger  high    = CLI_REPLAY_FILECOUNT - 1;
+
+    while (low < high)
+    {
+      NSUInteger  middle = (low + high) / 2;
+
+      if (cumulative[middle] > target) {
+        high = middle;
+      } else {
+        low = middle + 1;
+      }
+    }
+
+    @autoreleasepool {
+      [simulator accessFile: DP_STRWFMT(@"file-%lu", (unsigned long)low)
+                       size: 8192 + ((low * 2654435761u) % (56 * 1024))
+                     atTime: startTime + i ];
+    }
+  }
+
+  free(cumulative);
+
+  return YES;
+}
+
+
+
+//------------------------------------------------------------ -o-
+// runReplay
+//
+// Replay tracePath, or synthetic accesses, once for each cache size.
+//
+static int
+runReplay (const char *tracePath, const char *cacheSizes)
+{
+  BOOL   synthetic  = (!tracePath) || (0 == strcmp(tracePath, "-"));
+  int    rval       = 0;
+
+  if (synthetic) {
+    printf("replay:  %d synthetic accesses over %d files,  Zipf exponent %.2f\n",
+             CLI_REPLAY_ACCESSES, CLI_REPLAY_FILECOUNT, CLI_REPLAY_ZIPF_EXPONENT);
+  } else {
+    printf("replay:  %s\n", tracePath);
+  }
+
+
+  //
+  for (NSString *size in [@(cacheSizes) componentsSeparatedByString:@","])
+  {
+    long long                cacheSize  = [size longLongValue];
+    DataFileCacheSimulator  *simulator  = [[DataFileCacheSimulator alloc] initWithCacheSize:cacheSize];
+
+    if (!simulator) {
+      fprintf(stderr, "replay:  cannot simulate a cache of %lld bytes.\n", cacheSize);
+      return 1;
+    }
+
+    NSTimeInterval  start     = [NSDate timeIntervalSinceReferenceDate];
+    BOOL            replayed  = synthetic ? replaySynthetic(simulator, CLI_REPLAY_ACCESSES, CLI_RANDOM_SEED, 0)
+                                          : [simulator replayTraceAtURL:[NSURL fileURLWithPath:@(tracePath)]];
+
+    report(DP_STRWFMT(@"replay, %lld byte cache", cacheSize), elapsedSince(start), (NSUInteger)simulator.stats.accesses);
+    printf("%s\n", [[DataFileCacheSimulator descriptionOfStats:simulator.stats] UTF8String]);
+
+    if (!replayed)  { rval = 1; }
+  }
+
+  return rval;
+}
+
+
+
+//------------------------------------------------------------ -o-
+// runWarmStart
+//
+// Replay earlier accesses (historyPath, or CLI_REPLAY_ACCESSES synthetic)
+// and export a snapshot of the cache.  Then replay a first session 
+// (sessionPath, or CLI_WARMSTART_ACCESSES synthetic, later and with 
+// another seed) against a cold cache, and against one that imported 
+// the snapshot.
+//
+// NB  Session accesses should come after history, so that imported
+//       files are older than those of the session.
+//
+static int
+runWarmStart (const char *historyPath, const char *sessionPath)
+{
+  BOOL   syntheticHistory  = (!historyPath) || (0 == strcmp(historyPath, "-"));
+  BOOL   syntheticSession  = (!sessionPath) || (0 == strcmp(sessionPath, "-"));
+  NSURL *snapshotURL       = [NSURL fileURLWithPath:
+                               [NSTemporaryDirectory() stringByAppendingPathComponent:DP_STRWFMT(@"spotcli-%d.dfcsnapshot", getpid())]];
+  int    rval              = 0;
+
+  printf("warmstart:  history %s,  session %s,  %d byte cache\n",
+           syntheticHistory ? "synthetic" : historyPath, syntheticSession ? "synthetic" : sessionPath, CLI_WARMSTART_CACHESIZE);
+
+
+  //
+  DataFileCacheSimulator  *history  = [[DataFileCacheSimulator alloc] initWithCacheSize:CLI_WARMSTART_CACHESIZE];
+  NSTimeInterval           start    = [NSDate timeIntervalSinceReferenceDate];
+
+  BOOL  replayed = syntheticHistory ? replaySynthetic(history, CLI_REPLAY_ACCESSES, CLI_RANDOM_SEED, 0)
+                                    : [history replayTraceAtURL:[NSURL fileURLWithPath:@(historyPath)]];
+
+  report(@"warmstart, history", elapsedSince(start), (NSUInteger)history.stats.accesses);
+
+  start = [NSDate timeIntervalSinceReferenceDate];
+
+  if ((!replayed) || (! [history.cache exportSnapshotToURL:snapshotURL])) {
+    fprintf(stderr, "warmstart:  cannot replay history, or export its snapshot.\n");
+    return 1;
+  }
+
+  report(@"warmstart, export", elapsedSince(start), (NSUInteger)(CLI_WARMSTART_CACHESIZE - [history.cache currentFreeBytes]));
+
+
+  //
+  for (NSString *label in @[ @"cold", @"warm" ])
+  {
+    DataFileCacheSimulator  *session = [[DataFileCacheSimulator alloc] initWithCacheSize:CLI_WARMSTART_CACHESIZE];
+
+    if ([label isEqualToString:@"warm"])
+    {
+      start = [NSDate timeIntervalSinceReferenceDate];
+
+      NSInteger  imported = [session importSnapshotAtURL:snapshotURL atTime:history.now];
+
+      report(@"warmstart, import", elapsedSince(start), (NSUInteger)MAX(imported, 0));
+
+      if (imported < 0)  { rval = 1; }
+    }
+
+    start     = [NSDate timeIntervalSinceReferenceDate];
+    replayed  = syntheticSession ? replaySynthetic(session, CLI_WARMSTART_ACCESSES, CLI_RANDOM_SEED + 1, CLI_REPLAY_ACCESSES)
+                                 : [session replayTraceAtURL:[NSURL fileURLWithPath:@(sessionPath)]];
+
+    report(DP_STRWFMT(@"warmstart, %@ session", label), elapsedSince(start), (NSUInteger)session.stats.accesses);
+    printf("%s:  %s\n", [label UTF8String], [[DataFileCacheSimulator descriptionOfStats:session.stats] UTF8String]);
+
+    if (!replayed)  { rval = 1; }
+  }
+
+  [[NSFileManager defaultManager] removeItemAtURL:snapshotURL error:nil];
+
+  return rval;
+}
+
+
+
+
+//------------------------------------------------------------ -o-
+// runFetch
+//
+// Paginated fetch from Flickr, or from standIn when there is one.
+//
+static int
+runFetch (PFCategory category, NSUInteger pages, FlickrStandIn *standIn)
+{
+  PFPaging  paging = PF_PAGING_DEFAULT;
+
+  paging.pagesMax = pages;
+
+  printf("fetch:  up to %lu pages of %lu\n", (unsigned long)paging.pagesMax, (unsigned long)paging.perPage);
+
+  PhotoSnapshot  *snapshot = [PhotoFetch fetchPhotos:category paging:paging progress:nil];
+
+  if (!snapshot) {
+    fprintf(stderr, "fetch:  first page failed.\n");
+    return 1;
+  }
+
+
+  //
+  NSDictionary    *statistics  = [PhotoFetch lastFetchStatistics];
+  DPNetworkStats   network     = [NetworkActivity stats];
+
+  printf("photos %lu,  tags %lu\n", (unsigned long)[snapshot.photoArray count], (unsigned long)[snapshot.tagIndex.sortedTags count]);
+
+  report(@"first page", [statistics[PF_FETCHSTAT_FIRSTPAGE_SECONDS] doubleValue], 1);
+  report(@"total", [statistics[PF_FETCHSTAT_TOTAL_SECONDS] doubleValue], 1);
+
+  printf("requests %llu (%llu failed),  %llu bytes,  bandwidth %.1f KB/s,  latency %.3f s\n",
+           network.requests, network.failures, network.bytes,
+           network.bandwidthEstimate / 1024, network.latencyEstimate);
+
+  NSDictionary  *queueStats = [QueueRegistry statsDescription];
+
+  for (NSString *role in [[queueStats allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+    printf("queue %-8s %s\n", [role UTF8String], [queueStats[role] UTF8String]);
+  }
+
+  if (standIn) {
+    FSIStats  served = [standIn stats];
+
+    printf("stand-in:  requests %llu,  replayed %llu,  recorded %llu,  synthesized %llu,  not found %llu,  errors %llu\n",
+             served.requests, served.replayed, served.recorded, served.synthesized, served.notFound, served.injectedErrors);
+  }
+
+  return 0;
+}
+
+
+
+
+//------------------------------------------------------------ -o-
+// runSession
+//
+// Concurrent simulated sessions.  Best run against a stand-in (-s).
+//
+static int
+runSession (NSUInteger sessions, NSUInteger rounds)
+{
+  SLConfig  config = SL_CONFIG_DEFAULT;
+
+  config.sessions  = sessions;
+  config.rounds    = rounds;
+
+  printf("session:  %lu at once,  %lu rounds each\n", (unsigned long)config.sessions, (unsigned long)config.rounds);
+
+  SLReport  report = [SessionLoad run:config];
+
+  printf("%s\n", [[SessionLoad descriptionOfReport:report] UTF8String]);
+
+  return (report.sessions == sessions * rounds) ? 0 : 1;
+}
+
+
+
+
+//------------------------------------------------------------ -o-
+// runServe
+//
+// Serve until killed.  Point the app at it with
+//   "-SpotFlickrBaseURL http://127.0.0.1:<port>".
+//
+static int
+runServe (FlickrStandIn *standIn, uint16_t port)
+{
+  if (![standIn start:port]) {
+    fprintf(stderr, "serve:  cannot listen on port %u.\n", port);
+    return 1;
+  }
+
+  printf("serve:  %s at %s\n", [[standIn.corpusURL path] UTF8String], [[standIn.baseURL absoluteString] UTF8String]);
+  fflush(stdout);
+
+  dispatch_main();
+}
+
+
+
+
+//------------------------------------------------------------ -o-
+static void
+usage (const char *name)
+{
+  fprintf(stderr, "usage:  %s [options] index [photos]\n", name);
+  fprintf(stderr, "        %s [options] cache [files] [bytes]\n", name);
+  fprintf(stderr, "        %s [options] replay [trace|-] [bytes,...]\n", name);
+  fprintf(stderr, "        %s [options] warmstart [trace|- [trace|-]]\n", name);
+  fprintf(stderr, "        %s [options] fetch [latest|stanford] [pages]\n", name);
+  fprintf(stderr, "        %s [options] session [sessions] [rounds]\n", name);
+  fprintf(stderr, "        %s [options] serve [port]\n", name);
+  fprintf(stderr, "options:  -t trace.json  -b url  -s corpus  -r  -l ms[:ms]  -w bytes  -e rate  -z bytes\n");
+}
+
+
+
+//------------------------------------------------------------ -o-
+int
+main (int argc, const char *argv[])
+{
+  int  rval = 2;
+
+  @autoreleasepool
+  {
+    NSString       *tracePath   = nil;
+    NSString       *baseURL     = nil;
+    NSString       *corpusPath  = nil;
+    BOOL            record      = NO;
+    double          latency     = 0;
+    double          jitter      = 0;
+    unsigned long   bandwidth   = 0;
+    double          errorRate   = 0;
+    unsigned long   imageBytes  = 0;
+    int             arg         = 1;
+
+    while ((argc > arg) && ('-' == argv[arg][0]))
+    {
+      const char  *option  = argv[arg];
+      const char  *value   = (argc > arg + 1) ? argv[arg + 1] : NULL;
+
+      if (0 == strcmp(option, "-r")) {
+        record  = YES;
+        arg    += 1;
+        continue;
+      }
+
+      if (!value) {
+        usage(argv[0]);
+        return 2;
+      }
+
+      if      (0 == strcmp(option, "-t"))  { tracePath   = @(value); }
+      else if (0 == strcmp(option, "-b"))  { baseURL     = @(value); }
+      else if (0 == strcmp(option, "-s"))  { corpusPath  = @(value); }
+      else if (0 == strcmp(option, "-w"))  { bandwidth   = strtoul(value, NULL, 10); }
+      else if (0 == strcmp(option, "-e"))  { errorRate   = strtod(value, NULL); }
+      else if (0 == strcmp(option, "-z"))  { imageBytes  = strtoul(value, NULL, 10); }
+      else if (0 == strcmp(option, "-l")) {
+        char  *end = NULL;
+
+        latency = strtod(value, &end) / 1000;
+        if (end && (':' == *end))  { jitter = strtod(end + 1, NULL) / 1000; }
+
+      } else {
+        usage(argv[0]);
+        return 2;
+      }
+
+      arg += 2;
+    }
+
+    if (argc <= arg) {
+      usage(argv[0]);
+      return 2;
+    }
+
+    [Trace setEnabled:(nil != tracePath)];
+
+
+    //
+    const char  *workload  = argv[arg];
+    const char  *arg1      = (argc > arg + 1) ? argv[arg + 1] : NULL;
+    const char  *arg2      = (argc > arg + 2) ? argv[arg + 2] : NULL;
+
+    BOOL            serve    = (0 == strcmp(workload, "serve"));
+    FlickrStandIn  *standIn  = nil;
+
+    if (corpusPath || serve)
+    {
+      standIn = [[FlickrStandIn alloc] initWithCorpusURL:
+                  [NSURL fileURLWithPath:(corpusPath ? corpusPath : @CLI_CORPUS_DEFAULT) isDirectory:YES]];
+
+      standIn.latency         = latency;
+      standIn.latencyJitter   = jitter;
+      standIn.bytesPerSecond  = bandwidth;
+      standIn.errorRate       = errorRate;
+      standIn.imageBytes      = imageBytes;
+      standIn.seed            = CLI_RANDOM_SEED;
+      standIn.recordMissing   = record;
+    }
+
+    if (standIn && !serve) {
+      if (![standIn start:0]) {
+        fprintf(stderr, "stand-in:  cannot listen.\n");
+        return 1;
+      }
+
+      [FlickrFetcher setBaseURL:standIn.baseURL];
+
+    } else if (baseURL) {
+      [FlickrFetcher setBaseURL:[NSURL URLWithString:baseURL]];
+    }
+
+    if (0 == strcmp(workload, "index")) {
+      rval = runIndex(arg1 ? strtoul(arg1, NULL, 10) : CLI_PHOTOCOUNT_DEFAULT);
+
+    } else if (0 == strcmp(workload, "cache")) {
+      rval = runCache(arg1 ? strtoul(arg1, NULL, 10) : CLI_FILECOUNT_DEFAULT,
+                      arg2 ? strtoul(arg2, NULL, 10) : CLI_FILESIZE_DEFAULT);
+
+    } else if (0 == strcmp(workload, "replay")) {
+      rval = runReplay(arg1, arg2 ? arg2 : CLI_REPLAY_CACHESIZES);
+
+    } else if (0 == strcmp(workload, "warmstart")) {
+      rval = runWarmStart(arg1, arg2);
+
+    } else if (0 == strcmp(workload, "fetch")) {
+      PFCategory  category = (arg1 && (0 == strcmp(arg1, "stanford"))) ? PFCategoryStanford : PFCategoryLatestGeoreferenced;
+
+      rval = runFetch(category, arg2 ? strtoul(arg2, NULL, 10) : CLI_PAGES_DEFAULT, standIn);
+
+    } else if (0 == strcmp(workload, "session")) {
+      SLConfig  config = SL_CONFIG_DEFAULT;
+
+      rval = runSession(arg1 ? strtoul(arg1, NULL, 10) : config.sessions,
+                        arg2 ? strtoul(arg2, NULL, 10) : config.rounds);
+
+    } else if (serve) {
+      rval = runServe(standIn, (uint16_t) (arg1 ? strtoul(arg1, NULL, 10) : 0));
+
+    } else {
+      usage(argv[0]);
+    }
+
+
+    //
+    if (tracePath) {
+      [Trace writeChromeTraceToURL:[NSURL fileURLWithPath:tracePath]];
+      printf("trace:  %lu spans written to %s\n", (unsigned long)[Trace count], [tracePath UTF8String]);
+    }
+
+    [standIn stop];
+    [Log flush];
+  }
+
+  return rval;
+}
+
@@ -0,0 +1,59 @@
+//
+// ChangeFeed.h
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import <Foundation/Foundation.h>
+
+#import "Danaprajna.h"
+
+
+
+//------------------------------------------------------------ -o-
+#define CF_COALESCE_INTERVAL_DEFAULT   0.05     // Seconds.
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface ChangeFeedEvent : NSObject
+
+  @property  (readonly, strong, nonatomic)  NSString  *topic;
+  @property  (readonly, strong, nonatomic)  id         payload;      // NSNull if none was published.
+
+@end
+
+
+// events is in publication order.  An event equal to one published
+//   earlier in the same batch (same topic and payload) replaces it.
+//
+typedef void (^ChangeFeedBlock)(NSArray *events);
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface ChangeFeed : NSObject
+
+  @property  (readonly, nonatomic)  NSTimeInterval  coalesceInterval;
+
+
+  //
+  - (id) initWithCoalesceInterval: (NSTimeInterval)coalesceInterval;
+
+  - (void) publishTopic: (NSString *)topic
+                payload: (id)payload;
+
+  - (id) subscribeTopics: (NSArray *)topics
+                   queue: (dispatch_queue_t)queue
+                   block: (ChangeFeedBlock)block;
+
+  - (void) unsubscribe: (id)subscription;
+
+@end
+
@@ -0,0 +1,255 @@
+//
+// ChangeFeed.m
+//
+// Publish/subscribe by topic, with events coalesced per subscriber.
+//
+// The first event after a delivery starts a coalesceInterval window;
+// events published during the window are batched and delivered together,
+// on the subscriber queue, when it closes.
+//
+// All subscription state lives on feedQueue.
+//
+//
+// CLASS DEPENDENCIES:  none
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import "ChangeFeed.h"
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface ChangeFeedEvent()
+
+  @property  (readwrite, strong, nonatomic)  NSString  *topic;
+  @property  (readwrite, strong, nonatomic)  id         payload;
+
+@end
+
+
+
+//------------------------------------------------------------ -o--
+@implementation ChangeFeedEvent
+
+//----------------- -o-
+- (BOOL) isEqual: (id)object
+{
+  if (![object isKindOfClass:[ChangeFeedEvent class]])  { return NO; }
+
+  ChangeFeedEvent  *other = object;
+  return [self.topic isEqualToString:other.topic] && [self.payload isEqual:other.payload];
+}
+
+
+//----------------- -o-
+- (NSUInteger) hash
+{
+  return [self.topic hash] ^ [self.payload hash];
+}
+
+
+//----------------- -o-
+- (NSString *) description
+{
+  return DP_STRWFMT(@"%@: %@", self.topic, self.payload);
+}
+
+@end // @implementation ChangeFeedEvent
+
+
+
+
+//------------------------------------------------------------ -o-
+// One per subscribeTopics:queue:block:;  returned as its handle.
+//
+@interface ChangeFeedSubscription : NSObject
+
+  @property  (strong, nonatomic)  NSSet                *topics;
+  @property  (strong, nonatomic)  dispatch_queue_t      queue;
+  @property  (copy, nonatomic)    ChangeFeedBlock       block;
+
+  @property  (strong, nonatomic)  NSMutableOrderedSet  *pendingEvents;
+  @property  (nonatomic)          BOOL                  isFlushScheduled;
+  @property  (nonatomic)          BOOL                  isCancelled;
+
+@end
+
+@implementation ChangeFeedSubscription
+@end
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface ChangeFeed()
+
+  @property  (readwrite, nonatomic)  NSTimeInterval  coalesceInterval;
+
+  @property  (strong, nonatomic)  dispatch_queue_t   feedQueue;
+  @property  (strong, nonatomic)  NSMutableArray    *subscriptions;
+
+  - (void) flushSubscription: (ChangeFeedSubscription *)subscription;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation ChangeFeed
+
+#pragma mark - Constructors
+
+//----------------- -o-
+- (id) initWithCoalesceInterval: (NSTimeInterval)coalesceInterval
+{
+  if (coalesceInterval < 0) {
+    DP_LOG_ERROR(@"coalesceInterval is less than zero.  (%f)", coalesceInterval);
+    return nil;
+  }
+
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+
+  //
+  self.coalesceInterval  = coalesceInterval;
+  self.feedQueue         = dispatch_queue_create("ChangeFeed", DISPATCH_QUEUE_SERIAL);
+  self.subscriptions     = [[NSMutableArray alloc] init];
+
+  return self;
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//----------------- -o-
+// publishTopic:payload:
+//
+// NB  Any thread.  Never blocks on subscribers.
+//
+- (void) publishTopic: (NSString *)topic
+              payload: (id)payload
+{
+  if (!topic) {
+    DP_LOG_ERROR(@"topic is undefined.");
+    return;
+  }
+
+  ChangeFeedEvent  *event = [[ChangeFeedEvent alloc] init];
+
+  event.topic    = topic;
+  event.payload  = payload ? payload : [NSNull null];
+
+
+  //
+  dispatch_async(self.feedQueue,
+  ^{
+    for (ChangeFeedSubscription *subscription in self.subscriptions)
+    {
+      if (! [subscription.topics containsObject:topic])  { continue; }
+
+      [subscription.pendingEvents removeObject:event];
+      [subscription.pendingEvents addObject:event];
+
+      if (subscription.isFlushScheduled)  { continue; }
+
+      subscription.isFlushScheduled = YES;
+
+      dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.coalesceInterval * NSEC_PER_SEC)),
+                     self.feedQueue,
+                     ^{ [self flushSubscription:subscription]; });
+    }
+  });
+
+} // publishTopic:payload:
+
+
+
+//----------------- -o-
+// subscribeTopics:queue:block:
+//
+// RETURN:  Handle for unsubscribe:.
+//
+// NB  block runs on queue;  holding strong references to the subscriber
+//       from block creates a retain cycle until unsubscribe:.
+//
+- (id) subscribeTopics: (NSArray *)topics
+                 queue: (dispatch_queue_t)queue
+                 block: (ChangeFeedBlock)block
+{
+  if (([topics count] < 1) || !queue || !block) {
+    DP_LOG_ERROR(@"Undefined arguments: topics, queue and/or block.");
+    return nil;
+  }
+
+  ChangeFeedSubscription  *subscription = [[ChangeFeedSubscription alloc] init];
+
+  subscription.topics         = [NSSet setWithArray:topics];
+  subscription.queue          = queue;
+  subscription.block          = block;
+  subscription.pendingEvents  = [[NSMutableOrderedSet alloc] init];
+
+  dispatch_async(self.feedQueue, ^{
+    [self.subscriptions addObject:subscription];
+  });
+
+  return subscription;
+}
+
+
+
+//----------------- -o-
+// unsubscribe:
+//
+// NB  A batch already handed to the subscriber queue is dropped.
+//
+- (void) unsubscribe: (id)subscription
+{
+  if (![subscription isKindOfClass:[ChangeFeedSubscription class]])  { return; }
+
+  dispatch_sync(self.feedQueue, ^{
+    ((ChangeFeedSubscription *)subscription).isCancelled = YES;
+    [self.subscriptions removeObjectIdenticalTo:subscription];
+  });
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Private methods.
+
+//----------------- -o-
+// NB  feedQueue only.
+//
+- (void) flushSubscription: (ChangeFeedSubscription *)subscription
+{
+  NSArray  *events = [subscription.pendingEvents array];
+
+  subscription.pendingEvents     = [[NSMutableOrderedSet alloc] init];
+  subscription.isFlushScheduled  = NO;
+
+  if (subscription.isCancelled || ([events count] < 1))  { return; }
+
+  dispatch_async(subscription.queue, ^{
+    if (! subscription.isCancelled) {
+      subscription.block(events);
+    }
+  });
+}
+
+
+@end // @implementation ChangeFeed
+
@@ -8,18 +8,18 @@
 //     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
 //---------------------------------------------------------------------
 
-#import <UIKit/UIKit.h>
+#import <Foundation/Foundation.h>
 
 #import "Danaprajna.h"
+#import "ChangeFeed.h"
 
+#import "DataFileCacheStore.h"
+#import "DataFileCacheDiskStore.h"
+#import "DataFileCacheMemoryStore.h"
 
 
-//------------------------------------------------------------ -o-
-#define DFC_CACHEDIR_BASENAME_DEFAULT      @"DataFileCache"
-#define DFC_CACHEDIR_DATADIR_NAME          @"data"
-#define DFC_CACHEDIR_PROPERTYLIST_NAME     @"dataTimestamps.plist"
-
 
+//------------------------------------------------------------ -o-
 // SCHEMA for self.propertyList --
 //   NSDictionary of zero or more:
 //     NSString fileName --> NSNumber timestamp
@@ -27,24 +27,130 @@
 #define DFC_FILE_TIMESTAMP_KEY      @"DATAFILECACHE_TIMESTAMP"
 
 
+// SCHEMA for a snapshot --
+//   Binary property list, NSDictionary:
+//     DFC_SNAPSHOT_VERSION_KEY --> NSNumber DFC_SNAPSHOT_VERSION
+//     DFC_SNAPSHOT_ENTRIES_KEY --> NSArray, least recently used first, of NSDictionary:
+//       DFC_SNAPSHOT_FILENAME_KEY   --> NSString fileName
+//       DFC_SNAPSHOT_TIMESTAMP_KEY  --> NSNumber timestamp
+//       DFC_SNAPSHOT_SIZE_KEY       --> NSNumber size in bytes
+//       DFC_SNAPSHOT_DATA_KEY       --> NSData contents
+//
+#define DFC_SNAPSHOT_VERSION          1
+
+#define DFC_SNAPSHOT_VERSION_KEY      @"DATAFILECACHE_SNAPSHOT_VERSION"
+#define DFC_SNAPSHOT_ENTRIES_KEY      @"DATAFILECACHE_SNAPSHOT_ENTRIES"
+#define DFC_SNAPSHOT_FILENAME_KEY     @"DATAFILECACHE_SNAPSHOT_FILENAME"
+#define DFC_SNAPSHOT_TIMESTAMP_KEY    @"DATAFILECACHE_SNAPSHOT_TIMESTAMP"
+#define DFC_SNAPSHOT_SIZE_KEY         @"DATAFILECACHE_SNAPSHOT_SIZE"
+#define DFC_SNAPSHOT_DATA_KEY         @"DATAFILECACHE_SNAPSHOT_DATA"
+
+
+// Posted by the cache instance as entries are added, removed (deleted or
+//   evicted) or cleared all at once.  Posted after the change:  on the
+//   calling thread for synchronous methods, on completionQueue before
+//   the completion for asynchronous ones.
+//
+//   userInfo:  DFC_NOTIFICATION_FILENAME_KEY --> NSString fileName  
+//                (not for DFC_NOTIFICATION_CLEARED)
+//
+// With changeFeed set, the same names are also published there as topics,
+//   payload fileName (none for DFC_NOTIFICATION_CLEARED).  They are
+//   published from the cache's I/O queue, in the order of the changes.
+//
+#define DFC_NOTIFICATION_FILE_ADDED      @"DataFileCacheFileAdded"
+#define DFC_NOTIFICATION_FILE_REMOVED    @"DataFileCacheFileRemoved"
+#define DFC_NOTIFICATION_CLEARED         @"DataFileCacheCleared"
+
+#define DFC_NOTIFICATION_FILENAME_KEY    @"DataFileCacheFileName"
+
+
+// Completions of the asynchronous methods.  Called on completionQueue.
+//
+typedef void (^DFCCompletionBlock)(BOOL success);
+typedef void (^DFCLookupBlock)(NSURL *fileURL);                                 // nil if not cached.
+typedef void (^DFCLookupFilesBlock)(NSSet *cachedFileNames);
+typedef void (^DFCReadBlock)(NSData *fileData, NSURL *fileURL, NSError *error);  // fileURL nil if not cached.
+typedef void (^DFCImportBlock)(NSInteger filesImported);                         // -1 on failure.
 
 
+// Seconds, as timeIntervalSinceReferenceDate.  Called as changes run.
+//
+typedef NSTimeInterval (^DFCClockBlock)(void);
+
+
+
+
+// Every operation runs on the cache's own I/O queue.  Changes (save,
+//   delete, touch, make space, clear) run one at a time, each after every
+//   operation called before it;  lookups and reads run together between
+//   changes.  So operations on one file take effect in the order they
+//   are called, from any thread.
+//
+// The synchronous methods wait for their operation on the same queue.
+//   isFileCached: and currentFreeBytes answer at once from memory, as of
+//   the last change completed, and are safe on the main thread.
+//
+// Batches (saveFiles:, deleteFiles:, touchFiles:) change many files as
+//   one:  one space reservation and eviction pass, one write of the
+//   property list.  Each batch is all or nothing;  if it fails, the
+//   cache is left as it was.  Files of a batch share one timestamp.
+//
+// Eviction is least recently used first, in the order files were saved
+//   or touched.  Timestamps from clock are kept in the property list, to
+//   restore that order when the cache is opened again.  So, given the
+//   same operations, a cache in a DataFileCacheMemoryStore with a
+//   virtual clock makes the same evictions every time.
+//
+// Snapshots carry the cached files, with their timestamps and sizes, in
+//   recency order, in one archive:  to ship or restore a warm cache.
+//   Export runs as a read, between changes, so it sees one consistent
+//   cache.  Import checks the whole snapshot before it changes anything,
+//   then adds its files as one batch, merged into recency by timestamp.
+//   Files already cached are skipped.  Import never evicts:  it takes
+//   the most recent files that fit in free space.  Given snapshotURL,
+//   the constructors import only into a cache that opens empty.
+//
 @interface DataFileCache : NSObject
 //------------------------------------------------------------ -o-
 
-  @property  (readonly, strong, nonatomic)  NSURL  *cacheDirURL;
-  @property  (readonly, strong, nonatomic)  NSURL  *propertyListURL;
-  @property  (readonly, strong, nonatomic)  NSURL  *dataDirURL;
+  @property  (readonly, strong, nonatomic)  id<DataFileCacheStore>  store;
+
+  @property  (readonly, nonatomic)  NSURL  *cacheDirURL;
+  @property  (readonly, nonatomic)  NSURL  *propertyListURL;
+  @property  (readonly, nonatomic)  NSURL  *dataDirURL;
+      // nil unless store is a DataFileCacheDiskStore.
 
   @property  (nonatomic)  BOOL  verbose;
       // YES enables DP_LOG_INFO messages.
 
+  @property  (strong, nonatomic)  ChangeFeed  *changeFeed;
+      // Optional.  See DFC_NOTIFICATION_*.
+
+  @property  (strong, nonatomic)  dispatch_queue_t  completionQueue;
+      // Default is a serial queue of the cache's own:  completions run one
+      //   at a time, in the order their operations finished.
+
+  @property  (copy, nonatomic)  DFCClockBlock  clock;
+      // Timestamps for saves and touches.  Default is the wall clock.
+
 
 
   //
   - (id) initCacheDirectoryWithURL: (NSURL *)    cacheDirURL
                        sizeInBytes: (long long)  sizeInBytes;
 
+  - (id) initWithStore: (id<DataFileCacheStore>)  store
+           sizeInBytes: (long long)               sizeInBytes;
+
+  - (id) initCacheDirectoryWithURL: (NSURL *)    cacheDirURL
+                       sizeInBytes: (long long)  sizeInBytes
+                       snapshotURL: (NSURL *)    snapshotURL;
+
+  - (id) initWithStore: (id<DataFileCacheStore>)  store
+           sizeInBytes: (long long)               sizeInBytes
+           snapshotURL: (NSURL *)                 snapshotURL;
+
 
   - (BOOL) saveFile: (NSString *) fileName
            withData: (NSData *)   fileData;
@@ -61,5 +167,59 @@
 
   - (BOOL) clearCache;
 
+
+  // Batches.
+  //
+  - (BOOL) saveFiles: (NSDictionary *)filesByName;       // NSString fileName --> NSData
+  - (BOOL) deleteFiles: (NSArray *)fileNames;
+  - (BOOL) touchFiles: (NSArray *)fileNames;
+
+
+  // Snapshots.
+  //
+  - (BOOL)      exportSnapshotToURL: (NSURL *)snapshotURL;
+  - (NSInteger) importSnapshotAtURL: (NSURL *)snapshotURL;    // Files imported, or -1.
+
+
+  // Asynchronous.  completion may be nil where there is nothing to return.
+  //
+  - (void) saveFile: (NSString *)           fileName
+           withData: (NSData *)             fileData
+         completion: (DFCCompletionBlock)   completion;
+
+  - (void) lookupFile: (NSString *)      fileName
+           completion: (DFCLookupBlock)  completion;
+
+  - (void) lookupFiles: (NSArray *)             fileNames
+            completion: (DFCLookupFilesBlock)   completion;
+
+  - (void) readFile: (NSString *)     fileName
+         completion: (DFCReadBlock)   completion;
+
+  - (void) deleteFile: (NSString *)           fileName
+           completion: (DFCCompletionBlock)   completion;
+
+  - (void) makeBytesAvailable: (long long)            bytesRequested
+                   completion: (DFCCompletionBlock)   completion;
+
+  - (void) clearCacheWithCompletion: (DFCCompletionBlock)completion;
+
+  - (void) saveFiles: (NSDictionary *)       filesByName
+          completion: (DFCCompletionBlock)   completion;
+
+  - (void) deleteFiles: (NSArray *)             fileNames
+            completion: (DFCCompletionBlock)    completion;
+
+  - (void) touchFiles: (NSArray *)             fileNames
+           completion: (DFCCompletionBlock)    completion;
+
+  - (void) exportSnapshotToURL: (NSURL *)              snapshotURL
+                    completion: (DFCCompletionBlock)   completion;
+
+  - (void) importSnapshotAtURL: (NSURL *)          snapshotURL
+                    completion: (DFCImportBlock)   completion;
+
+  - (void) waitForPendingOperations;
+
 @end
 
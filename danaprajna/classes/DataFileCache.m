@@ -3,6 +3,13 @@
 //
 // Manage directory of files as LRU cache.
 //
+// All disk I/O runs on ioQueue, a concurrent queue:  lookups and reads as
+// ordinary blocks, changes as barriers.  The synchronous methods are thin
+// wrappers that wait for the same blocks the asynchronous methods submit.
+//
+// Files and property list live in a DataFileCacheStore;  recency lists
+// the cached files in the order they are to be evicted.
+//
 //
 //---------------------------------------------------------------------
 //     Copyright David Reeder 2014.  ios@mobilesound.org
@@ -19,13 +26,10 @@
 @interface DataFileCache() 
 
   //
-  @property  (readwrite, strong, nonatomic)  NSURL                *cacheDirURL;
+  @property  (readwrite, strong, nonatomic)  id<DataFileCacheStore>   store;
 
-  @property  (readwrite, strong, nonatomic)  NSURL                *propertyListURL;
-  @property  (strong, nonatomic)             NSMutableDictionary  *propertyList;
-
-  @property  (readwrite, strong, nonatomic)  NSURL                *dataDirURL;
-  @property  (strong, nonatomic)             NSMutableArray       *dataDirContents;
+  @property  (strong, nonatomic)             NSMutableDictionary     *propertyList;
+  @property  (strong, nonatomic)             NSMutableOrderedSet     *recency;       // Least recently used first.
 
 
   // NB  A signed value allows the case where sum of pre-existing file(s) 
@@ -35,15 +39,70 @@
                                      cacheSizeFreeBytes;
 
 
-  // Private system resources for this instance.
+  // Reads run together on ioQueue;  changes run alone, as barriers.
   //
-  @property  (strong, nonatomic)  NSFileManager     *fileManager;
+  @property  (strong, nonatomic)  dispatch_queue_t   ioQueue;
+
+  @property  (strong, nonatomic)  NSMutableArray    *pendingNotifications;    // ioQueue.
 
 
   // Private methods.
   //
+  - (void) change: (dispatch_block_t)block
+       completion: (dispatch_block_t)completion;
+
+  - (void) changeAndWait: (dispatch_block_t)block;
+
+  - (BOOL) ioSaveFile: (NSString *) fileName
+             withData: (NSData *)   fileData;
+
+  - (NSURL *) ioCachedFileURL: (NSString *)fileName;
+
+  - (BOOL) ioDeleteFile: (NSString *)fileName;
+  - (BOOL) ioRemoveFile: (NSString *)fileName;
+  - (BOOL) ioMakeBytesAvailable: (long long)bytesRequested;
+  - (BOOL) ioClearCache;
+
+  - (NSDictionary *) ioEvictionsForBytes: (long long)  bytesRequested
+                                 sparing: (NSSet *)    sparedFileNames;
+
+  - (BOOL) ioSaveFiles: (NSDictionary *)filesByName;
+  - (BOOL) ioDeleteFiles: (NSArray *)fileNames;
+  - (BOOL) ioTouchFiles: (NSArray *)fileNames;
+
+  - (BOOL) ioSetAside: (NSArray *)fileNames;
+  - (void) ioPutBack: (NSArray *)fileNames;
+  - (void) ioRemoveStoredFiles: (NSArray *)fileNames;
+
+  - (BOOL) ioCommitChange: (dispatch_block_t)change;
+
+  - (NSDictionary *) ioSnapshot;
+  - (NSInteger)      ioImportSnapshotEntries: (NSArray *)entries;
+
+  - (BOOL) writeSnapshot: (NSDictionary *)  snapshot
+                   toURL: (NSURL *)         snapshotURL;
+
+  - (NSArray *) entriesOfSnapshotAtURL: (NSURL *)snapshotURL;
+
+  - (NSNumber *) timestamp;
+
+  - (void) setTimestamp: (NSNumber *)timestamp
+                forFile: (NSString *)fileName;
+
+  - (void) forgetFile: (NSString *)fileName;
+
+  - (NSUInteger) recencyIndexForTimestamp: (NSNumber *)  timestamp
+                            importedNames: (NSSet *)     importedNames;
+  - (void) orderRecency;
+
   - (BOOL) sync;
 
+  - (void) postNotificationName: (NSString *)name
+                       fileName: (NSString *)fileName;
+
+  - (NSArray *) takePendingNotifications;
+  - (void)      postNotifications: (NSArray *)notifications;
+
 @end
 
 
@@ -61,13 +120,53 @@
 //   cacheDirURL  Valid URL  -OR-  nil to use system path + default basename.
 //   sizeInBytes  Size of cache.  
 //
+// Cache in a DataFileCacheDiskStore.  See DataFileCacheDiskStore open.
 //
-// DFC_CACHEDIR_BASENAME and DFC_CACHEDIR_DATADIR_NAME are removed if they exist and are not directories.
-// If one of data directory or property list does not exist, the other is removed.
-// Upon successful return, data directory and property list are consistent with one another.
-//
 - (id) initCacheDirectoryWithURL: (NSURL *)    cacheDirURL__
                      sizeInBytes: (long long)  sizeInBytes__
+{
+  return [self initCacheDirectoryWithURL:cacheDirURL__ sizeInBytes:sizeInBytes__ snapshotURL:nil];
+}
+
+
+
+//------------------------ -o-
+- (id) initWithStore: (id<DataFileCacheStore>)  store__
+         sizeInBytes: (long long)               sizeInBytes__
+{
+  return [self initWithStore:store__ sizeInBytes:sizeInBytes__ snapshotURL:nil];
+}
+
+
+
+//------------------------ -o-
+- (id) initCacheDirectoryWithURL: (NSURL *)    cacheDirURL__
+                     sizeInBytes: (long long)  sizeInBytes__
+                     snapshotURL: (NSURL *)    snapshotURL__
+{
+  DataFileCacheDiskStore  *diskStore = [[DataFileCacheDiskStore alloc] initWithCacheDirectoryURL:cacheDirURL__];
+
+  if (!diskStore)  { return nil; }
+
+  return [self initWithStore:diskStore sizeInBytes:sizeInBytes__ snapshotURL:snapshotURL__];
+}
+
+
+
+//------------------------ -o-
+// initWithStore:sizeInBytes:snapshotURL: 
+//
+// INPUTS--
+//   snapshotURL  Snapshot to import if the cache opens empty  -OR-  nil.
+//
+// Upon successful return, files and property list in store are consistent with one another.
+//
+// NB  A snapshot that cannot be imported is logged, and the cache opens 
+//       without it.
+//
+- (id) initWithStore: (id<DataFileCacheStore>)  store__
+         sizeInBytes: (long long)               sizeInBytes__
+         snapshotURL: (NSURL *)                 snapshotURL__
 {
   // Sanity check inputs.
   // Initialize properties.
@@ -78,193 +177,104 @@
     return nil;
   }
 
+  if (!store__) {
+    DP_LOG_ERROR(@"store is undefined.");
+    return nil;
+  }
+
   if (!(self = [super init])) {
     DP_LOG_ERROR(@"[super init] failed.");
     return nil;
   }
 
   //
-  self.cacheDirURL            = cacheDirURL__;
+  self.store                  = store__;
   self.cacheSizeMaximumBytes  = sizeInBytes__;
 
-  self.verbose = NO;
-
-
-
-  // Establish pathnames to cacheDir elements.
-  // Sanity check and instantiate data directory and property list.
-  // If one of data directory or property list is missing, delete the other.
-  //
-  if (!self.cacheDirURL) {                                      
-    NSArray *cacheDirOptions = [self.fileManager URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask];
-    if ([cacheDirOptions count] < 1) {
-      DP_LOG_ERROR(@"Could not acquire path to NSCachesDirectory."); 
-      return nil;
-    }
-
-    self.cacheDirURL = [cacheDirOptions[0] URLByAppendingPathComponent:DFC_CACHEDIR_BASENAME_DEFAULT isDirectory:YES];
-  }
-
+  self.verbose  = NO;
+  self.clock    = ^NSTimeInterval{ return [NSDate timeIntervalSinceReferenceDate]; };
 
-  if (! [Zed createDirectoryForURL:self.cacheDirURL replace:YES]) {
-    return nil;
-  }
+  self.ioQueue               = dispatch_queue_create("DataFileCache", DISPATCH_QUEUE_CONCURRENT);
+  self.completionQueue       = dispatch_queue_create("DataFileCache completions", DISPATCH_QUEUE_SERIAL);
+  self.pendingNotifications  = [[NSMutableArray alloc] init];
 
-  self.dataDirURL       = [self.cacheDirURL URLByAppendingPathComponent:DFC_CACHEDIR_DATADIR_NAME isDirectory:YES];
-  self.propertyListURL  = [self.cacheDirURL URLByAppendingPathComponent:DFC_CACHEDIR_PROPERTYLIST_NAME];
 
 
+  // Check consistency of property list versus stored files.
   //
-  BOOL  dataPathExists       = NO;
-  BOOL  dataPathIsDirectory  = NO;
+  NSDictionary  *dictOfFilesOnRecord  = [self.store open];
+  NSArray       *storedFileNames      = [self.store fileNames];
 
-  self.propertyList  = [[NSDictionary dictionaryWithContentsOfURL:self.propertyListURL] mutableCopy];
-  dataPathExists     = [self.fileManager fileExistsAtPath:[self.dataDirURL path] isDirectory:&dataPathIsDirectory];
+  if ((!dictOfFilesOnRecord) || (!storedFileNames))  { return nil; }
 
-  NSString  *dataPathErrorMsg = nil;
 
-
-  if (dataPathExists)
-  {
-    if (!dataPathIsDirectory) {                                 
-      dataPathErrorMsg = DP_STRWFMT(@"REMOVING file with same name as data directory.  (%@)", self.dataDirURL);
-    } else if (!self.propertyList) {                            
-      dataPathErrorMsg = DP_STRWFMT(@"REMOVING data directory because property list is missing.  (%@)", self.dataDirURL);
-    }
-
-  }
-
-  if (self.propertyList) 
-  {
-    if ((!dataPathExists) || dataPathErrorMsg) {                
-      dataPathErrorMsg = DP_STRWFMT(@"REMOVING property list because data directory is missing or corrupt.  (%@)", self.propertyListURL);
-    }
-  }
-
-
-  if (dataPathErrorMsg)                                         
-  {
-    DP_LOG_WARNING(@"%@", dataPathErrorMsg);
-
-    if (! ([Zed removeItemForURL:self.dataDirURL]
-             && [Zed removeItemForURL:self.propertyListURL]) )
-    {
-      return nil;
-    }
-
-    dataPathExists = NO;
-  }
+  NSMutableDictionary  *newDict             = [[NSMutableDictionary alloc] init];
+  NSMutableSet         *unlistedFileNames   = [NSMutableSet setWithArray:storedFileNames];
+  long long             sumOfDatafileSizes  = 0;
 
 
-
-  // (Re)create property list and data directory
-  //    -OR-
-  // Check consistency of property list versus data directory.
+  // After for-loop--
+  //   . newDict is a copy of dictOfFilesOnRecord, but only contains files 
+  //       that exist and have a timestamp;
+  //   . unlistedFileNames contains files that were not in dictOfFilesOnRecord;
+  //   . sumOfDatafileSizes is the total size (including resource forks) of all files 
+  //       listed in newDict.
   //
-  long long  sumOfDatafileSizes = 0;
-
-
-  if (!dataPathExists)  
+  for (id key in dictOfFilesOnRecord)         
   {
-    if (! [Zed createDirectoryForURL:self.dataDirURL replace:YES]) {
-      return nil;
-    }
-
-    self.propertyList = [[NSMutableDictionary alloc] init];
+    NSNumber  *timestamp = (NSNumber *)[dictOfFilesOnRecord objectForKey:key];
 
-    if (self.verbose) {
-      DP_LOG_INFO(@"CREATED property list and data directory for cache directory.  (%@)", self.cacheDirURL);
+    if (!timestamp) {                                         
+      DP_LOG_WARNING(@"Property list entry missing timestamp.  (%@)", key);
+      continue;
     }
 
+    if (![unlistedFileNames containsObject:key]) {         
+      DP_LOG_WARNING(@"Property list entry missing in data directory.  (%@)", key);
+      continue;
+    } 
 
-  } else {
-    NSDictionary         *dictOfFilesOnRecord  = self.propertyList;
-    NSMutableDictionary  *newDict              = [[NSMutableDictionary alloc] init];
-
-    NSMutableArray       *dataDirList          = [Zed directoryListForURL:self.dataDirURL];
-
-
-    if (!dataDirList)  { return nil; }
-    
+    [unlistedFileNames removeObject:key];
 
-    // After for-loop--
-    //   . newDict is a copy of dictOfFilesOnRecord, but only contains files 
-    //       that exist and have a timestamp;
-    //   . dataDirList contains files that were not in dictOfFilesOnRecord;
-    //   . sumOfDatafileSizes is the total size (including resource forks) of all files 
-    //       listed in newDict.
     //
-    for (id key in dictOfFilesOnRecord)         
+    NSInteger  dataDirEntryFileSize = [self.store sizeOfFile:key];
+
+    if (dataDirEntryFileSize < 0)                             
     {
-      NSNumber  *timestamp = (NSNumber *)[dictOfFilesOnRecord objectForKey:key];
+      DP_LOG_WARNING(@"File in data directory is corrupt or missing.  (%@)", key);
 
-      if (!timestamp) {                                         
-        DP_LOG_WARNING(@"Property list entry missing timestamp.  (%@)", key);
-        continue;
+      if (! [self.store removeFile:key]) {            
+        DP_LOG_ERROR(@"Could not remove errant data directory file.  (%@)", key);
+        return nil;  // XXX -- Option to let this slide?
       }
 
-      NSURL  *dataDirEntry = [self.dataDirURL URLByAppendingPathComponent:key];
-      if (![dataDirList containsObject:dataDirEntry]) {         
-        DP_LOG_WARNING(@"Property list entry missing in data directory.  (%@)", key);
-        continue;
-      } 
-
-      //
-      NSInteger  dataDirEntryFileSize = [Zed fileSizeForURL:dataDirEntry includeResourceFork:YES];
-
-      if (dataDirEntryFileSize < 0)                             
-      {
-        DP_LOG_WARNING(@"File in data directory is corrupt or missing.  (%@)", key);
-
-        if (! [Zed removeItemForURL:dataDirEntry]) {            
-          DP_LOG_ERROR(@"Could not remove errant data directory file.  (%@)", key);
-          return nil;  // XXX -- Option to let this slide?
-        }
-
-        [dataDirList removeObject:dataDirEntry];
-        continue;
+      continue;
+    }
 
-      } else {
-        sumOfDatafileSizes += dataDirEntryFileSize;
-      }
+    sumOfDatafileSizes += dataDirEntryFileSize;
+    [newDict setObject:timestamp forKey:key];
 
-      //
-      [dataDirList removeObject:dataDirEntry];
-      [newDict setObject:timestamp forKey:key];
+  } // endfor
 
-    } // endfor
 
+  //
+  self.propertyList = newDict;
 
-    //
-    self.propertyList = newDict;
+  if (! [self.store writePropertyList:self.propertyList]) 
+  {
+    DP_LOG_ERROR(@"Failed to write property list after synchronizing with data directory.");
+    return nil;
+  }
 
-    if (![self.propertyList writeToURL:self.propertyListURL atomically:YES]) 
-    {
-      DP_LOG_ERROR(@"Failed to write property list after synchronizing with data directory.  (%@)", self.propertyListURL); 
-      return nil;
+  for (NSString *fileName in unlistedFileNames)
+  {
+    if (! [self.store removeFile:fileName]) {
+      DP_LOG_ERROR(@"Failed to remove data file(s) that do not appear in property list.");
+      return nil;  // XXX -- Option to let this slide?
     }
+  }
 
-
-    //
-    if ([dataDirList count] > 0)                                
-    {
-      __block  BOOL  stopped = NO;
-
-      [dataDirList enumerateObjectsUsingBlock:^(id obj, NSUInteger index, BOOL *stop)
-        {
-          if (! [Zed removeItemForURL:obj]) {
-            stopped  = YES;
-            *stop    = YES;
-          }
-        }];
-
-      if (stopped) {                                            
-        DP_LOG_ERROR(@"Failed to remove data file(s) that do not appear in property list.");
-        return nil;  // XXX -- Option to let this slide?
-      }
-    } 
-
-  } // endifelse !dataPathExists 
+  [self orderRecency];
 
 
 
@@ -278,7 +288,7 @@
 
     self.cacheSizeFreeBytes = -difference;
 
-    if (! [self makeBytesAvailable:0]) {
+    if (! [self ioMakeBytesAvailable:0]) {
       DP_LOG_ERROR(@"Failed to free enough space for request cache size.");
       return nil;
     }
@@ -289,9 +299,8 @@
 
 
   //
-  unsigned long long  fileSystemFreeBytes = 
-                        [Zed fileSystemAttributeForURL: self.cacheDirURL
-                                         attributeName: NSFileSystemFreeSize ]; 
+  unsigned long long  fileSystemFreeBytes = [self.store availableBytes];
+
   if (DP_ULONGLONG_MAX == fileSystemFreeBytes)  { return nil; }
 
 
@@ -304,9 +313,23 @@
   }
 
 
+  // Warm a cache that starts cold.
+  //
+  if (snapshotURL__ && ([self.propertyList count] < 1))
+  {
+    NSArray  *entries = [self entriesOfSnapshotAtURL:snapshotURL__];
+
+    if ((!entries) || ([self ioImportSnapshotEntries:entries] < 0)) {
+      DP_LOG_WARNING(@"Opening cache without snapshot.  (%@)", snapshotURL__);
+    }
+  }
+
+
+  [self postNotifications:[self takePendingNotifications]];
+
   return self;
 
-} // initCacheDirectoryWithURL:dataFileSuffix:sizeInBytes: 
+} // initWithStore:sizeInBytes:snapshotURL: 
 
 
 
@@ -315,13 +338,29 @@
 #pragma mark - Getters/setters.
 
 //----------------- -o-
-- (NSFileManager *)  fileManager
+- (NSURL *) cacheDirURL
 {
-  if (!_fileManager) {
-    _fileManager = [[NSFileManager alloc] init];
-  }
+  if (! [self.store isKindOfClass:[DataFileCacheDiskStore class]])  { return nil; }
 
-  return _fileManager;
+  return [(DataFileCacheDiskStore *)self.store cacheDirURL];
+}
+
+
+//----------------- -o-
+- (NSURL *) propertyListURL
+{
+  if (! [self.store isKindOfClass:[DataFileCacheDiskStore class]])  { return nil; }
+
+  return [(DataFileCacheDiskStore *)self.store propertyListURL];
+}
+
+
+//----------------- -o-
+- (NSURL *) dataDirURL
+{
+  if (! [self.store isKindOfClass:[DataFileCacheDiskStore class]])  { return nil; }
+
+  return [(DataFileCacheDiskStore *)self.store dataDirURL];
 }
 
 
@@ -334,234 +373,1258 @@
 - (BOOL) saveFile: (NSString *) fileName
          withData: (NSData *)   fileData
 {
-  if ((!fileName) || (!fileData)) {                             
-    DP_LOG_ERROR(@"Undefined arguments: fileName and/or fileData.");
-    return NO;
-  }
+  __block  BOOL  rval = NO;
 
+  [self changeAndWait:^{ rval = [self ioSaveFile:fileName withData:fileData]; }];
 
-  //
-  if ([self isFileCached:fileName])  
-  {
-    [self.propertyList setObject:DP_DATE_NOW forKey:fileName];
-    if (! [self sync])  { return NO; };
+  return rval;
+}
 
-    if (self.verbose) {
-      DP_LOG_INFO(@"Refreshed timestamp on cached entry.  (%@)", fileName); 
-    }
 
-    return YES;
+
+//----------------- -o-
+// isFileCached:
+//
+// NB  From memory, without waiting on ioQueue.
+//
+- (BOOL) isFileCached:(NSString *)fileName
+{
+  @synchronized (self) {
+    return (nil != [self.propertyList objectForKey:fileName]);
   }
+}
 
 
-  //
-  if (! [self makeBytesAvailable:[fileData length]])
-  {
-    DP_LOG_ERROR(@"Failed to acquire space sufficient to cache data for \"%@\".", fileName);
-    return NO;
-  }
 
+//----------------- -o-
+- (NSURL *) cachedFileURL: (NSString *)fileName
+{
+  __block  NSURL  *fileURL = nil;
 
-  NSURL  *fileURL = DP_URL_PLUSFILE(self.dataDirURL, fileName);
+  dispatch_sync(self.ioQueue, ^{ fileURL = [self ioCachedFileURL:fileName]; });
 
-  if (! [fileData writeToURL:fileURL atomically:YES])
-  {
-    DP_LOG_ERROR(@"Failed to write cache data for \"%@\".", fileName);
-    return NO;
-  }
+  return fileURL;
+}
 
-  NSInteger fileSize = [Zed fileSizeForURL:fileURL includeResourceFork:YES];
-  if (fileSize < 0) {                                   
-    DP_LOG_ERROR(@"Failed to read size of cached file \"%@\".  DELETING from cache...", fileName);
 
-    if (! [self deleteFile:fileName]) {
-      DP_LOG_ERROR(@"Failed to remove improperly logged cached file \"%@\".", fileName);
-    }
 
-    return NO;
+//----------------- -o-
+// currentFreeBytes
+//
+// NB  From memory, without waiting on ioQueue.
+//
+- (NSInteger)  currentFreeBytes
+{
+  @synchronized (self) {
+    return (NSInteger) self.cacheSizeFreeBytes;
   }
+}
 
 
-  [self.propertyList setObject:DP_DATE_NOW forKey:fileName];
-  [self sync]; 
-  
-  self.cacheSizeFreeBytes -= fileSize;
 
+//----------------- -o-
+// deleteFile:
+//
+// RETURN:  YES if file is not cached; NO otherwise.
+//
+// NB  Deleting non-existent files returns YES.
+//
+- (BOOL) deleteFile:(NSString *)fileName
+{
+  __block  BOOL  rval = NO;
 
-  return YES;
+  [self changeAndWait:^{ rval = [self ioDeleteFile:fileName]; }];
 
-} // saveFile:withData: 
+  return rval;
+}
 
 
 
 //----------------- -o-
-- (BOOL) isFileCached:(NSString *)fileName
+- (BOOL) makeBytesAvailable:(long long) bytesRequested
 {
-  if (nil != [self.propertyList objectForKey:fileName]) {
-    return YES;
-  }
+  __block  BOOL  rval = NO;
 
-  return NO;
+  [self changeAndWait:^{ rval = [self ioMakeBytesAvailable:bytesRequested]; }];
+
+  return rval;
 }
 
 
 
 //----------------- -o-
-- (NSURL *) cachedFileURL: (NSString *)fileName
+- (BOOL) clearCache
 {
-  if (! [self isFileCached:fileName]) {
-    return nil;
-  } 
+  __block  BOOL  rval = NO;
+
+  [self changeAndWait:^{ rval = [self ioClearCache]; }];
 
-  return DP_URL_PLUSFILE(self.dataDirURL, fileName);
+  return rval;
 }
 
 
 
 //----------------- -o-
-- (NSInteger)  currentFreeBytes
+// saveFiles:
+//
+// Cache every file of filesByName, or none of them.  Files already cached
+//   are only touched, as with saveFile:withData:.
+//
+- (BOOL) saveFiles: (NSDictionary *)filesByName
 {
-  return self.cacheSizeFreeBytes;
+  __block  BOOL  rval = NO;
+
+  [self changeAndWait:^{ rval = [self ioSaveFiles:filesByName]; }];
+
+  return rval;
 }
 
 
 
 //----------------- -o-
-// deleteFile:
+// deleteFiles:
 //
-// RETURN:  YES if file is not cached; NO otherwise.
-//
-// NB  Deleting non-existent files returns YES.
+// NB  As with deleteFile:, files not cached are ignored.
 //
-- (BOOL) deleteFile:(NSString *)fileName
+- (BOOL) deleteFiles: (NSArray *)fileNames
 {
-  if (!fileName) {                                      
-    DP_LOG_ERROR(@"fileName is undefined.");
-    return NO;
-  }
+  __block  BOOL  rval = NO;
 
+  [self changeAndWait:^{ rval = [self ioDeleteFiles:fileNames]; }];
 
-  //
-  if (! [self isFileCached:fileName]) {
-    return YES;
-  }
+  return rval;
+}
 
 
-  //
-  NSURL      *fileURL   = DP_URL_PLUSFILE(self.dataDirURL, fileName);
-  NSInteger   fileSize  = [Zed fileSizeForURL:fileURL includeResourceFork:YES];
 
-  if (fileSize < 0)  { return NO; }                     
+//----------------- -o-
+// touchFiles:
+//
+// Make fileNames the most recently used, so the last to be evicted.
+//
+// RETURN:  NO if any of fileNames is not cached;  none are touched.
+//
+- (BOOL) touchFiles: (NSArray *)fileNames
+{
+  __block  BOOL  rval = NO;
 
-  if (! [Zed removeItemForURL:fileURL])  { return NO; }
+  [self changeAndWait:^{ rval = [self ioTouchFiles:fileNames]; }];
 
-  [self.propertyList removeObjectForKey:fileName];
-  if (! [self sync])  { return NO; }                    
+  return rval;
+}
 
-  self.cacheSizeFreeBytes += fileSize;
 
 
-  return YES;
+//----------------- -o-
+// exportSnapshotToURL:
+//
+// Write every cached file, with its timestamp, to snapshotURL.
+//
+// NB  Files are read between changes;  the snapshot is written after,
+//       atomically, while changes go on.
+//
+- (BOOL) exportSnapshotToURL: (NSURL *)snapshotURL
+{
+  __block  NSDictionary  *snapshot = nil;
+
+  dispatch_sync(self.ioQueue, ^{ snapshot = [self ioSnapshot]; });
+
+  return [self writeSnapshot:snapshot toURL:snapshotURL];
 }
 
 
 
 //----------------- -o-
-// makeBytesAvailable:
+// importSnapshotAtURL:
 //
-// Make list of file(s) to delete to free up space.
-// Determine if needed space, though less than cache size, is also available in the file system.
-// Delete file(s) and free space in cache. 
+// NB  The snapshot is read and checked before the change is queued.
 //
-// NB  File deletion postponed until all error checks are complete.
+// RETURN:  Number of files imported, zero if none fit or all are cached
+//            already  -OR-  -1 if the snapshot is invalid or cannot be 
+//            imported;  none are.
 //
-- (BOOL) makeBytesAvailable:(long long) bytesRequested
+- (NSInteger) importSnapshotAtURL: (NSURL *)snapshotURL
 {
-  if (bytesRequested < 0) {                             
-    DP_LOG_ERROR(@"bytesRequested is less than zero.  (%lld)", bytesRequested);
-    return NO;
-  }
+  NSArray  *entries = [self entriesOfSnapshotAtURL:snapshotURL];
 
+  if (!entries)  { return -1; }
 
-  //
-  if (bytesRequested > self.cacheSizeMaximumBytes)      
-  {
-    DP_LOG_ERROR(@"Size of free space request (%lld) is greater than cache size (%lld).",
-                     bytesRequested, self.cacheSizeMaximumBytes);
-    return NO;
-  }
+  __block  NSInteger  rval = -1;
 
-  if (bytesRequested <= self.cacheSizeFreeBytes) {      
-    return YES; 
-  }
+  [self changeAndWait:^{ rval = [self ioImportSnapshotEntries:entries]; }];
+
+  return rval;
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Asynchronous methods.
+
+//----------------- -o-
+- (void) saveFile: (NSString *)           fileName
+         withData: (NSData *)             fileData
+       completion: (DFCCompletionBlock)   completion
+{
+  __block  BOOL  rval = NO;
+
+  [self change: ^{ rval = [self ioSaveFile:fileName withData:fileData]; }
+    completion: ^{ if (completion)  { completion(rval); } } ];
+}
+
+
+
+//----------------- -o-
+- (void) lookupFile: (NSString *)      fileName
+         completion: (DFCLookupBlock)  completion
+{
+  if (!completion)  { return; }
+
+  dispatch_async(self.ioQueue, 
+  ^{
+    NSURL  *fileURL = [self ioCachedFileURL:fileName];
+
+    dispatch_async(self.completionQueue, ^{ completion(fileURL); });
+  });
+}
+
+
+
+//----------------- -o-
+// lookupFiles:completion:
+//
+// RETURN:  (In completion.)  Those of fileNames that are cached, all as of one moment.
+//
+- (void) lookupFiles: (NSArray *)             fileNames
+          completion: (DFCLookupFilesBlock)   completion
+{
+  if (!completion)  { return; }
+
+  NSArray  *names = [fileNames copy];
+
+  dispatch_async(self.ioQueue, 
+  ^{
+    NSMutableSet  *cachedFileNames = [[NSMutableSet alloc] initWithCapacity:[names count]];
+
+    for (NSString *fileName in names)
+    {
+      if (nil != [self.propertyList objectForKey:fileName]) {
+        [cachedFileNames addObject:fileName];
+      }
+    }
+
+    dispatch_async(self.completionQueue, ^{ completion(cachedFileNames); });
+  });
+}
+
+
+
+//----------------- -o-
+// readFile:completion:
+//
+// Contents of fileName, read before any change called later can remove it.
+//
+- (void) readFile: (NSString *)     fileName
+       completion: (DFCReadBlock)   completion
+{
+  if (!completion)  { return; }
+
+  dispatch_async(self.ioQueue, 
+  ^{
+    NSURL    *fileURL   = [self ioCachedFileURL:fileName];
+    NSData   *fileData  = nil;
+    NSError  *error     = nil;
+
+    if (fileURL)
+    {
+      DPTraceSpan  readSpan = DP_TRACE_BEGIN("cache.read");
+
+      fileData = [self.store readFile:fileName error:&error];
+
+      DP_TRACE_END(readSpan);
+    }
+
+    dispatch_async(self.completionQueue, ^{ completion(fileData, fileURL, error); });
+  });
+}
+
+
+
+//----------------- -o-
+- (void) deleteFile: (NSString *)           fileName
+         completion: (DFCCompletionBlock)   completion
+{
+  __block  BOOL  rval = NO;
+
+  [self change: ^{ rval = [self ioDeleteFile:fileName]; }
+    completion: ^{ if (completion)  { completion(rval); } } ];
+}
+
+
+
+//----------------- -o-
+- (void) makeBytesAvailable: (long long)            bytesRequested
+                 completion: (DFCCompletionBlock)   completion
+{
+  __block  BOOL  rval = NO;
+
+  [self change: ^{ rval = [self ioMakeBytesAvailable:bytesRequested]; }
+    completion: ^{ if (completion)  { completion(rval); } } ];
+}
+
+
+
+//----------------- -o-
+- (void) clearCacheWithCompletion: (DFCCompletionBlock)completion
+{
+  __block  BOOL  rval = NO;
+
+  [self change: ^{ rval = [self ioClearCache]; }
+    completion: ^{ if (completion)  { completion(rval); } } ];
+}
+
+
+
+//----------------- -o-
+- (void) saveFiles: (NSDictionary *)       filesByName
+        completion: (DFCCompletionBlock)   completion
+{
+  __block  BOOL  rval = NO;
+
+  NSDictionary  *files = [filesByName copy];
+
+  [self change: ^{ rval = [self ioSaveFiles:files]; }
+    completion: ^{ if (completion)  { completion(rval); } } ];
+}
+
+
+
+//----------------- -o-
+- (void) deleteFiles: (NSArray *)             fileNames
+          completion: (DFCCompletionBlock)    completion
+{
+  __block  BOOL  rval = NO;
+
+  NSArray  *names = [fileNames copy];
+
+  [self change: ^{ rval = [self ioDeleteFiles:names]; }
+    completion: ^{ if (completion)  { completion(rval); } } ];
+}
+
+
+
+//----------------- -o-
+- (void) touchFiles: (NSArray *)             fileNames
+         completion: (DFCCompletionBlock)    completion
+{
+  __block  BOOL  rval = NO;
+
+  NSArray  *names = [fileNames copy];
+
+  [self change: ^{ rval = [self ioTouchFiles:names]; }
+    completion: ^{ if (completion)  { completion(rval); } } ];
+}
+
+
+
+//----------------- -o-
+- (void) exportSnapshotToURL: (NSURL *)              snapshotURL
+                  completion: (DFCCompletionBlock)   completion
+{
+  NSURL  *url = [snapshotURL copy];
+
+  dispatch_async(self.ioQueue, 
+  ^{
+    NSDictionary  *snapshot = [self ioSnapshot];
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), 
+    ^{
+      BOOL  rval = [self writeSnapshot:snapshot toURL:url];
+
+      dispatch_async(self.completionQueue, ^{ if (completion)  { completion(rval); } });
+    });
+  });
+}
+
+
+
+//----------------- -o-
+// importSnapshotAtURL:completion:
+//
+// NB  Unlike importSnapshotAtURL:, reads and checks the snapshot as part
+//       of the change, so that it keeps its place among operations 
+//       called after.
+//
+- (void) importSnapshotAtURL: (NSURL *)          snapshotURL
+                  completion: (DFCImportBlock)   completion
+{
+  __block  NSInteger  rval = -1;
+
+  NSURL  *url = [snapshotURL copy];
+
+  [self change: ^{
+                  NSArray  *entries = [self entriesOfSnapshotAtURL:url];
+
+                  if (entries)  { rval = [self ioImportSnapshotEntries:entries]; }
+                }
+    completion: ^{ if (completion)  { completion(rval); } } ];
+}
+
+
+
+//----------------- -o-
+// waitForPendingOperations
+//
+// Return once every operation called before has run.  Their completions 
+//   may still be on the way.
+//
+- (void) waitForPendingOperations
+{
+  dispatch_barrier_sync(self.ioQueue, ^{ });
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Private methods.
+
+//----------------- -o-
+// change:completion:
+//
+// Run block alone on ioQueue.  Then, on completionQueue, post the 
+//   notifications it queued and run completion.
+//
+- (void) change: (dispatch_block_t)block
+     completion: (dispatch_block_t)completion
+{
+  dispatch_barrier_async(self.ioQueue, 
+  ^{
+    block();
+
+    NSArray  *notifications = [self takePendingNotifications];
+
+    dispatch_async(self.completionQueue, ^{
+      [self postNotifications:notifications];
+      completion();
+    });
+  });
+}
+
+
+
+//----------------- -o-
+// changeAndWait:
+//
+// Run block alone on ioQueue, wait for it, then post the notifications 
+//   it queued.
+//
+// ASSUME  Not called on ioQueue.
+//
+- (void) changeAndWait: (dispatch_block_t)block
+{
+  __block  NSArray  *notifications = nil;
+
+  dispatch_barrier_sync(self.ioQueue, ^{
+    block();
+    notifications = [self takePendingNotifications];
+  });
+
+  [self postNotifications:notifications];
+}
+
+
+
+//----------------- -o-
+// ioSaveFile:withData:
+//
+// NB  io* methods run alone on ioQueue, except ioCachedFileURL:, which 
+//       only reads.  They change propertyList, recency and cacheSizeFreeBytes
+//       under @synchronized (self), for isFileCached: and currentFreeBytes.
+//
+- (BOOL) ioSaveFile: (NSString *) fileName
+           withData: (NSData *)   fileData
+{
+  if ((!fileName) || (!fileData)) {                             
+    DP_LOG_ERROR(@"Undefined arguments: fileName and/or fileData.");
+    return NO;
+  }
+
+
+  //
+  if (nil != [self.propertyList objectForKey:fileName])
+  {
+    @synchronized (self) {
+      [self setTimestamp:[self timestamp] forFile:fileName];
+    }
+    if (! [self sync])  { return NO; };
+
+    if (self.verbose) {
+      DP_LOG_INFO(@"Refreshed timestamp on cached entry.  (%@)", fileName); 
+    }
+
+    return YES;
+  }
+
+
+  //
+  DPTraceSpan  evictSpan       = DP_TRACE_BEGIN("cache.evict");
+  BOOL         spaceAvailable  = [self ioMakeBytesAvailable:[fileData length]];
+
+  DP_TRACE_END(evictSpan);
+
+  if (! spaceAvailable)
+  {
+    DP_LOG_ERROR(@"Failed to acquire space sufficient to cache data for \"%@\".", fileName);
+    return NO;
+  }
+
+
+  DPTraceSpan   writeSpan  = DP_TRACE_BEGIN("cache.write");
+  BOOL          written    = [self.store writeFile:fileName data:fileData];
+
+  DP_TRACE_END(writeSpan);
+
+  if (! written)
+  {
+    DP_LOG_ERROR(@"Failed to write cache data for \"%@\".", fileName);
+    return NO;
+  }
+
+  NSInteger fileSize = [self.store sizeOfFile:fileName];
+  if (fileSize < 0) {                                   
+    DP_LOG_ERROR(@"Failed to read size of cached file \"%@\".  DELETING from cache...", fileName);
+
+    if (! [self ioDeleteFile:fileName]) {
+      DP_LOG_ERROR(@"Failed to remove improperly logged cached file \"%@\".", fileName);
+    }
+
+    return NO;
+  }
+
+
+  @synchronized (self) {
+    [self setTimestamp:[self timestamp] forFile:fileName];
+    self.cacheSizeFreeBytes -= fileSize;
+  }
+
+  [self sync]; 
+
+  [self postNotificationName:DFC_NOTIFICATION_FILE_ADDED fileName:fileName];
+
+
+  return YES;
+
+} // ioSaveFile:withData: 
+
+
+
+//----------------- -o-
+- (NSURL *) ioCachedFileURL: (NSString *)fileName
+{
+  DPTraceSpan  lookupSpan  = DP_TRACE_BEGIN("cache.lookup");
+  NSURL       *fileURL     = nil;
+
+  if (fileName && (nil != [self.propertyList objectForKey:fileName])) {
+    fileURL = [self.store URLForFile:fileName];
+  } 
+
+  DP_TRACE_END(lookupSpan);
+
+  return fileURL;
+}
+
+
+
+//----------------- -o-
+- (BOOL) ioDeleteFile:(NSString *)fileName
+{
+  if (!fileName) {                                      
+    DP_LOG_ERROR(@"fileName is undefined.");
+    return NO;
+  }
+
+
+  //
+  if (nil == [self.propertyList objectForKey:fileName]) {
+    return YES;
+  }
+
+  if (! [self ioRemoveFile:fileName])  { return NO; }
+
+  return [self sync];
+}
+
+
+
+//----------------- -o-
+// ioRemoveFile:
+//
+// Remove cached fileName from store and from memory, without writing 
+//   the property list.
+//
+- (BOOL) ioRemoveFile:(NSString *)fileName
+{
+  NSInteger  fileSize = [self.store sizeOfFile:fileName];
+
+  if (fileSize < 0)  { return NO; }                     
+
+  if (! [self.store removeFile:fileName])  { return NO; }
+
+  @synchronized (self) {
+    [self forgetFile:fileName];
+    self.cacheSizeFreeBytes += fileSize;
+  }
+
+  [self postNotificationName:DFC_NOTIFICATION_FILE_REMOVED fileName:fileName];
+
+
+  return YES;
+}
+
+
+
+//----------------- -o-
+// ioMakeBytesAvailable:
+//
+// Delete file(s) listed by ioEvictionsForBytes:sparing:, then write the
+//   property list once.
+//
+- (BOOL) ioMakeBytesAvailable:(long long) bytesRequested
+{
+  NSDictionary  *evictions = [self ioEvictionsForBytes:bytesRequested sparing:nil];
+
+  if (!evictions)  { return NO; }
+  if ([evictions count] < 1)  { return YES; }
+
+
+  //
+  for (NSString *fileName in evictions)
+  {
+    if (! [self ioRemoveFile:fileName]) {
+      [self sync];
+      return NO;
+    }
+  }
+
+  return [self sync];
+
+} // ioMakeBytesAvailable:
+
+
+
+//----------------- -o-
+// ioEvictionsForBytes:sparing:
+//
+// Make list of file(s) to delete to free up space, in recency order, 
+//   skipping sparedFileNames.
+// Determine if needed space, though less than cache size, is also available in the file system.
+//
+// RETURN:  NSString fileName --> NSNumber fileSize for each file to delete;
+//            empty if bytesRequested are already free
+//          -OR-  nil if bytesRequested cannot be freed.
+//
+- (NSDictionary *) ioEvictionsForBytes: (long long)  bytesRequested
+                               sparing: (NSSet *)    sparedFileNames
+{
+  if (bytesRequested < 0) {                             
+    DP_LOG_ERROR(@"bytesRequested is less than zero.  (%lld)", bytesRequested);
+    return nil;
+  }
+
+
+  //
+  if (bytesRequested > self.cacheSizeMaximumBytes)      
+  {
+    DP_LOG_ERROR(@"Size of free space request (%lld) is greater than cache size (%lld).",
+                     bytesRequested, self.cacheSizeMaximumBytes);
+    return nil;
+  }
+
+  if (bytesRequested <= self.cacheSizeFreeBytes) {      
+    return @{}; 
+  }
+
+
+  //
+  NSMutableDictionary  *filesScheduledForDeletion  = [[NSMutableDictionary alloc] init];
+
+  long long  wouldBeFreeBytes = self.cacheSizeFreeBytes;
+  NSInteger  fileSize;
+        
+  for (NSString *key in self.recency)
+  { 
+    if (bytesRequested <= wouldBeFreeBytes) {
+      break;
+    }
+
+    if ([sparedFileNames containsObject:key]) {
+      continue;
+    }
+
+    fileSize = [self.store sizeOfFile:key];
+    if (fileSize < 0)  { return nil; }
+
+    wouldBeFreeBytes += fileSize;
+    [filesScheduledForDeletion setObject:@(fileSize) forKey:key];
+  }
+
+  if (bytesRequested > wouldBeFreeBytes) {
+    DP_LOG_ERROR(@"Cannot free %lld bytes without deleting files that are to be kept.", bytesRequested);
+    return nil;
+  }
+
+
+  //
+  unsigned long long  fileSystemFreeBytes = [self.store availableBytes];
+  if (DP_ULONGLONG_MAX == fileSystemFreeBytes)  { return nil; }
+
+  if (wouldBeFreeBytes > fileSystemFreeBytes) {
+    DP_LOG_ERROR(@"Cache requires more bytes (%lld) than available in file system (%llu).",
+                     wouldBeFreeBytes, fileSystemFreeBytes);
+    return nil;
+  }
+
+
+  return filesScheduledForDeletion;
+
+} // ioEvictionsForBytes:sparing:
+
+
+
+//----------------- -o-
+- (BOOL) ioClearCache
+{
+  @synchronized (self) {
+    self.propertyList        = [[NSMutableDictionary alloc] init];
+    self.recency             = [[NSMutableOrderedSet alloc] init];
+    self.cacheSizeFreeBytes  = self.cacheSizeMaximumBytes;
+  }
+
+  if (! [self sync]) { 
+    return NO; 
+  }
+
+  if (! [self.store removeAllFiles])  { return NO; }
+
+  if (self.verbose) {
+    DP_LOG_INFO(@"CLEARED property list and data files for cache.  (%@)", self.store);
+  }
+
+  [self postNotificationName:DFC_NOTIFICATION_CLEARED fileName:nil];
+
+  return YES;
+}
+
+
+
+//----------------- -o-
+// ioSaveFiles:
+//
+// Reserve space for every new file at once, sparing files of the batch 
+//   that are already cached.  Write new files, set evicted files aside,
+//   then commit the property list.  Any failure undoes what came before.
+//
+- (BOOL) ioSaveFiles: (NSDictionary *)filesByName
+{
+  if ([filesByName count] < 1) {
+    DP_LOG_ERROR(@"filesByName is undefined or empty.");
+    return NO;
+  }
+
+
+  //
+  NSMutableArray  *refreshed       = [[NSMutableArray alloc] init];
+  NSMutableArray  *added           = [[NSMutableArray alloc] init];
+  long long        bytesRequested  = 0;
+
+  for (id fileName in filesByName)
+  {
+    id  fileData = [filesByName objectForKey:fileName];
+
+    if ((![fileName isKindOfClass:[NSString class]]) || (![fileData isKindOfClass:[NSData class]])) {
+      DP_LOG_ERROR(@"filesByName must map NSString to NSData.  (%@)", fileName);
+      return NO;
+    }
+
+    if (nil != [self.propertyList objectForKey:fileName]) {
+      [refreshed addObject:fileName];
+    } else {
+      [added addObject:fileName];
+      bytesRequested += [fileData length];
+    }
+  }
+
+
+  //
+  DPTraceSpan    evictSpan  = DP_TRACE_BEGIN("cache.evict");
+  NSDictionary  *evictions  = [self ioEvictionsForBytes:bytesRequested sparing:[NSSet setWithArray:refreshed]];
+
+  DP_TRACE_END(evictSpan);
+
+  if (!evictions)
+  {
+    DP_LOG_ERROR(@"Failed to acquire space sufficient to cache batch of %lu files.", (unsigned long)[filesByName count]);
+    return NO;
+  }
+
+  long long  evictedBytes = 0;
+
+  for (NSString *fileName in evictions) {
+    evictedBytes += [[evictions objectForKey:fileName] longLongValue];
+  }
+
+
+  //
+  NSMutableArray  *written     = [[NSMutableArray alloc] init];
+  long long        addedBytes  = 0;
+  BOOL             failed      = NO;
+  DPTraceSpan      writeSpan   = DP_TRACE_BEGIN("cache.write");
+
+  for (NSString *fileName in added)
+  {
+    if (! [self.store writeFile:fileName data:[filesByName objectForKey:fileName]]) {
+      DP_LOG_ERROR(@"Failed to write cache data for \"%@\".", fileName);
+      failed = YES;
+      break;
+    }
+
+    [written addObject:fileName];
+
+    NSInteger fileSize = [self.store sizeOfFile:fileName];
+    if (fileSize < 0) {                                   
+      DP_LOG_ERROR(@"Failed to read size of cached file \"%@\".", fileName);
+      failed = YES;
+      break;
+    }
+
+    addedBytes += fileSize;
+  }
+
+  DP_TRACE_END(writeSpan);
+
+  if (failed || (! [self ioSetAside:[evictions allKeys]]))
+  {
+    [self ioRemoveStoredFiles:written];
+    return NO;
+  }
+
+
+  //
+  NSNumber  *timestamp = [self timestamp];
+
+  BOOL  committed = [self ioCommitChange:^{
+                      for (NSString *fileName in evictions) {
+                        [self forgetFile:fileName];
+                      }
+
+                      for (NSString *fileName in filesByName) {
+                        [self setTimestamp:timestamp forFile:fileName];
+                      }
+
+                      self.cacheSizeFreeBytes += evictedBytes - addedBytes;
+                    }];
+
+  if (! committed)
+  {
+    [self ioPutBack:[evictions allKeys]];
+    [self ioRemoveStoredFiles:written];
+    return NO;
+  }
+
+  [self.store emptyTrash];
+
+
+  //
+  for (NSString *fileName in evictions) {
+    [self postNotificationName:DFC_NOTIFICATION_FILE_REMOVED fileName:fileName];
+  }
+
+  for (NSString *fileName in added) {
+    [self postNotificationName:DFC_NOTIFICATION_FILE_ADDED fileName:fileName];
+  }
+
+  if (self.verbose) {
+    DP_LOG_INFO(@"Saved batch:  %lu added, %lu refreshed, %lu evicted.", 
+                  (unsigned long)[added count], (unsigned long)[refreshed count], (unsigned long)[evictions count]);
+  }
+
+
+  return YES;
+
+} // ioSaveFiles:
+
+
+
+//----------------- -o-
+// ioDeleteFiles:
+//
+// Set every cached file of fileNames aside, then commit the property list.
+//
+- (BOOL) ioDeleteFiles: (NSArray *)fileNames
+{
+  if (!fileNames) {
+    DP_LOG_ERROR(@"fileNames is undefined.");
+    return NO;
+  }
+
+
+  //
+  NSMutableArray  *removed      = [[NSMutableArray alloc] init];
+  long long        freedBytes   = 0;
+
+  for (id fileName in [NSOrderedSet orderedSetWithArray:fileNames])
+  {
+    if (! [fileName isKindOfClass:[NSString class]]) {
+      DP_LOG_ERROR(@"fileNames must contain only NSString.  (%@)", fileName);
+      return NO;
+    }
+
+    if (nil == [self.propertyList objectForKey:fileName])  { continue; }
+
+    NSInteger  fileSize = [self.store sizeOfFile:fileName];
+
+    if (fileSize < 0)  { return NO; }
+
+    freedBytes += fileSize;
+    [removed addObject:fileName];
+  }
+
+  if ([removed count] < 1)  { return YES; }
+
+
+  //
+  if (! [self ioSetAside:removed])  { return NO; }
+
+  BOOL  committed = [self ioCommitChange:^{
+                      for (NSString *fileName in removed) {
+                        [self forgetFile:fileName];
+                      }
+
+                      self.cacheSizeFreeBytes += freedBytes;
+                    }];
+
+  if (! committed)
+  {
+    [self ioPutBack:removed];
+    return NO;
+  }
+
+  [self.store emptyTrash];
+
+
+  //
+  for (NSString *fileName in removed) {
+    [self postNotificationName:DFC_NOTIFICATION_FILE_REMOVED fileName:fileName];
+  }
+
+  return YES;
+
+} // ioDeleteFiles:
+
+
+
+//----------------- -o-
+- (BOOL) ioTouchFiles: (NSArray *)fileNames
+{
+  if (!fileNames) {
+    DP_LOG_ERROR(@"fileNames is undefined.");
+    return NO;
+  }
+
+  for (id fileName in fileNames)
+  {
+    if ((![fileName isKindOfClass:[NSString class]]) || (nil == [self.propertyList objectForKey:fileName])) {
+      DP_LOG_ERROR(@"Cannot touch file that is not cached.  (%@)", fileName);
+      return NO;
+    }
+  }
+
+  if ([fileNames count] < 1)  { return YES; }
 
 
   //
-  NSArray         *sortedKeys                 = [self.propertyList keysSortedByValueUsingComparator:DP_BLOCK_CMPNUM_LT];
-  NSMutableArray  *filesScheduledForDeletion  = [[NSMutableArray alloc] init];
+  NSNumber  *timestamp = [self timestamp];
 
-  long long  wouldBeFreeBytes = self.cacheSizeFreeBytes;
-  NSInteger  fileSize;
-        
-  for (NSString *key in sortedKeys)
-  { 
-    if (bytesRequested <= wouldBeFreeBytes) {
+  BOOL  committed = [self ioCommitChange:^{
+                      for (NSString *fileName in fileNames) {
+                        [self setTimestamp:timestamp forFile:fileName];
+                      }
+                    }];
+
+  if (committed && self.verbose) {
+    DP_LOG_INFO(@"Refreshed timestamps on %lu cached entries.", (unsigned long)[fileNames count]);
+  }
+
+  return committed;
+}
+
+
+
+//----------------- -o-
+// ioSnapshot
+//
+// RETURN:  Every cached file, least recently used first, as SCHEMA for 
+//            a snapshot  -OR-  nil if a file cannot be read.
+//
+// NB  Only reads.  Holds the contents of the whole cache in memory.
+//
+- (NSDictionary *) ioSnapshot
+{
+  NSMutableArray  *entries     = [[NSMutableArray alloc] initWithCapacity:[self.recency count]];
+  DPTraceSpan      readSpan    = DP_TRACE_BEGIN("cache.read");
+
+  for (NSString *fileName in self.recency)
+  {
+    NSError  *error     = nil;
+    NSData   *fileData  = [self.store readFile:fileName error:&error];
+
+    if (!fileData) {
+      DP_LOG_ERROR(@"Failed to read cached file \"%@\" for snapshot.  %@", fileName, [error localizedDescription]);
+      DP_TRACE_END(readSpan);
+      return nil;
+    }
+
+    [entries addObject:@{ DFC_SNAPSHOT_FILENAME_KEY   : fileName,
+                          DFC_SNAPSHOT_TIMESTAMP_KEY  : [self.propertyList objectForKey:fileName],
+                          DFC_SNAPSHOT_SIZE_KEY       : @([fileData length]),
+                          DFC_SNAPSHOT_DATA_KEY       : fileData }];
+  }
+
+  DP_TRACE_END(readSpan);
+
+  return @{ DFC_SNAPSHOT_VERSION_KEY  : @(DFC_SNAPSHOT_VERSION),
+            DFC_SNAPSHOT_ENTRIES_KEY  : entries };
+}
+
+
+
+//----------------- -o-
+// ioImportSnapshotEntries:
+//
+// Take entries not cached, most recent first, while they fit in free
+//   space of the cache and of the store.  Write their files, then commit
+//   their timestamps and place them in recency by timestamp.  Any failure
+//   undoes what came before.
+//
+// ASSUME  entries are from entriesOfSnapshotAtURL:.
+//
+// NB  Timestamps later than clock are taken as now.  Cached files keep
+//       their order;  an imported file goes after those with earlier
+//       timestamps, before cached files of the same timestamp.
+//
+// RETURN:  Number of files imported  -OR-  -1 on failure.
+//
+- (NSInteger) ioImportSnapshotEntries: (NSArray *)entries
+{
+  unsigned long long  fileSystemFreeBytes = [self.store availableBytes];
+
+  if (DP_ULONGLONG_MAX == fileSystemFreeBytes)  { return -1; }
+
+  long long  freeBytes = MIN(self.cacheSizeFreeBytes, (long long)MIN(fileSystemFreeBytes, (unsigned long long)LLONG_MAX));
+
+
+  //
+  NSMutableArray  *taken       = [[NSMutableArray alloc] init];
+  long long        takenBytes  = 0;
+
+  for (NSDictionary *entry in [entries reverseObjectEnumerator])
+  {
+    NSString   *fileName  = [entry objectForKey:DFC_SNAPSHOT_FILENAME_KEY];
+    long long   size      = [[entry objectForKey:DFC_SNAPSHOT_SIZE_KEY] longLongValue];
+
+    if (nil != [self.propertyList objectForKey:fileName])  { continue; }
+    if ((takenBytes + size) > freeBytes)                   { continue; }
+
+    takenBytes += size;
+    [taken addObject:entry];
+  }
+
+  if ([taken count] < 1)  { return 0; }
+
+
+  //
+  NSMutableArray  *written     = [[NSMutableArray alloc] init];
+  long long        addedBytes  = 0;
+  BOOL             failed      = NO;
+  DPTraceSpan      writeSpan   = DP_TRACE_BEGIN("cache.write");
+
+  for (NSDictionary *entry in taken)
+  {
+    NSString  *fileName = [entry objectForKey:DFC_SNAPSHOT_FILENAME_KEY];
+
+    if (! [self.store writeFile:fileName data:[entry objectForKey:DFC_SNAPSHOT_DATA_KEY]]) {
+      DP_LOG_ERROR(@"Failed to write cache data for \"%@\".", fileName);
+      failed = YES;
       break;
     }
 
-    fileSize = [Zed    fileSizeForURL: DP_URL_PLUSFILE(self.dataDirURL, key)
-                  includeResourceFork: YES ];
-    if (fileSize < 0)  { return NO; }
+    [written addObject:fileName];
 
-    wouldBeFreeBytes += fileSize;
-    [filesScheduledForDeletion addObject:key];
+    NSInteger fileSize = [self.store sizeOfFile:fileName];
+    if (fileSize < 0) {                                   
+      DP_LOG_ERROR(@"Failed to read size of cached file \"%@\".", fileName);
+      failed = YES;
+      break;
+    }
+
+    addedBytes += fileSize;
+  }
+
+  DP_TRACE_END(writeSpan);
+
+  if (failed)
+  {
+    [self ioRemoveStoredFiles:written];
+    return -1;
   }
 
 
   //
-  unsigned long long  fileSystemFreeBytes = [Zed fileSystemAttributeForURL: self.dataDirURL
-                                                             attributeName: NSFileSystemFreeSize ]; 
-  if (DP_ULONGLONG_MAX == fileSystemFreeBytes)  { return NO; }
+  NSTimeInterval  now = self.clock();
 
-  if (wouldBeFreeBytes > fileSystemFreeBytes) {
-    DP_LOG_ERROR(@"Cache requires more bytes (%lld) than available in file system (%llu).",
-                     wouldBeFreeBytes, fileSystemFreeBytes);
-    return NO;
+  NSMutableSet  *importedNames = [[NSMutableSet alloc] initWithCapacity:[taken count]];
+
+  BOOL  committed = [self ioCommitChange:^{
+                      for (NSDictionary *entry in [taken reverseObjectEnumerator])
+                      {
+                        NSString  *fileName   = [entry objectForKey:DFC_SNAPSHOT_FILENAME_KEY];
+                        NSNumber  *timestamp  = [entry objectForKey:DFC_SNAPSHOT_TIMESTAMP_KEY];
+
+                        if ([timestamp doubleValue] > now)  { timestamp = @(now); }
+
+                        [self.recency insertObject:fileName atIndex:[self recencyIndexForTimestamp:timestamp importedNames:importedNames]];
+                        [self.propertyList setObject:timestamp forKey:fileName];
+                        [importedNames addObject:fileName];
+                      }
+
+                      self.cacheSizeFreeBytes -= addedBytes;
+                    }];
+
+  if (! committed)
+  {
+    [self ioRemoveStoredFiles:written];
+    return -1;
   }
 
 
   //
-  for (NSString *fileName in filesScheduledForDeletion) {
-    if (! [self deleteFile:fileName]) {
+  for (NSString *fileName in [written reverseObjectEnumerator]) {
+    [self postNotificationName:DFC_NOTIFICATION_FILE_ADDED fileName:fileName];
+  }
+
+  if (self.verbose) {
+    DP_LOG_INFO(@"Imported %lu of %lu files from snapshot.", (unsigned long)[written count], (unsigned long)[entries count]);
+  }
+
+  return (NSInteger)[written count];
+
+} // ioImportSnapshotEntries:
+
+
+
+//----------------- -o-
+// ioSetAside:
+//
+// Set fileNames aside in store, all of them or none.
+//
+- (BOOL) ioSetAside: (NSArray *)fileNames
+{
+  NSMutableArray  *moved = [[NSMutableArray alloc] init];
+
+  for (NSString *fileName in fileNames)
+  {
+    if (! [self.store setAsideFile:fileName])
+    {
+      [self ioPutBack:moved];
       return NO;
     }
-  }
 
+    [moved addObject:fileName];
+  }
 
   return YES;
+}
+
+
 
-} // makeBytesAvailable:
+//----------------- -o-
+- (void) ioPutBack: (NSArray *)fileNames
+{
+  for (NSString *fileName in fileNames) {
+    [self.store putBackFile:fileName];
+  }
+}
 
 
 
 //----------------- -o-
-- (BOOL) clearCache
+- (void) ioRemoveStoredFiles: (NSArray *)fileNames
 {
-  self.propertyList = [[NSMutableDictionary alloc] init];
-  if (! [self sync]) { 
-    return NO; 
+  for (NSString *fileName in fileNames) {
+    [self.store removeFile:fileName];
   }
+}
 
-  self.cacheSizeFreeBytes = self.cacheSizeMaximumBytes;
 
-  if (! [Zed recreateDirectoryForURL:self.dataDirURL])
-  { 
-    DP_LOG_ERROR(@"Failed to delete and recreate data directory for cache.");
-    return NO; 
+
+//----------------- -o-
+// ioCommitChange:
+//
+// Apply change to propertyList, recency and cacheSizeFreeBytes, then 
+//   write the property list.  If it cannot be written, undo change.
+//
+- (BOOL) ioCommitChange: (dispatch_block_t)change
+{
+  NSDictionary  *previousList;
+  NSOrderedSet  *previousRecency;
+  long long      previousFreeBytes;
+
+  @synchronized (self) {
+    previousList       = [self.propertyList copy];
+    previousRecency    = [self.recency copy];
+    previousFreeBytes  = self.cacheSizeFreeBytes;
+
+    change();
+  }
+
+  if ([self sync])  { return YES; }
+
+  @synchronized (self) {
+    self.propertyList        = [previousList mutableCopy];
+    self.recency             = [previousRecency mutableCopy];
+    self.cacheSizeFreeBytes  = previousFreeBytes;
+  }
+
+  return NO;
+}
+
+
+
+//----------------- -o-
+- (BOOL) writeSnapshot: (NSDictionary *)  snapshot
+                 toURL: (NSURL *)         snapshotURL
+{
+  if ((!snapshot) || (!snapshotURL)) {
+    DP_LOG_ERROR(@"Undefined arguments: snapshot and/or snapshotURL.");
+    return NO;
+  }
+
+  NSError  *error         = nil;
+  NSData   *snapshotData  = [NSPropertyListSerialization dataWithPropertyList: snapshot
+                                                                       format: NSPropertyListBinaryFormat_v1_0
+                                                                      options: 0
+                                                                        error: &error ];
+
+  if ((!snapshotData) || (! [snapshotData writeToURL:snapshotURL options:NSDataWritingAtomic error:&error])) {
+    DP_LOG_ERROR(@"Failed to write snapshot.  (%@)  %@", snapshotURL, [error localizedDescription]);
+    return NO;
   }
 
   if (self.verbose) {
-    DP_LOG_INFO(@"REMOVED and RE-CREATED property list and data directory for cache directory.  (%@)", self.cacheDirURL);
+    DP_LOG_INFO(@"Wrote snapshot of %lu files, %lu bytes.  (%@)", 
+                  (unsigned long)[[snapshot objectForKey:DFC_SNAPSHOT_ENTRIES_KEY] count], (unsigned long)[snapshotData length], snapshotURL);
   }
 
   return YES;
@@ -570,17 +1633,227 @@
 
 
 //----------------- -o-
-- (BOOL) sync
+// entriesOfSnapshotAtURL:
+//
+// Every entry must name a file that is safe in any store, only once, 
+//   with a finite timestamp, and data of the size given.
+//
+// RETURN:  Entries of the snapshot, least recently used first  -OR-  
+//            nil if it cannot be read, is of another version, or any
+//            entry is malformed.
+//
+- (NSArray *) entriesOfSnapshotAtURL: (NSURL *)snapshotURL
 {
-  if (! [self.propertyList writeToURL:self.propertyListURL atomically:YES])
+  if (!snapshotURL) {
+    DP_LOG_ERROR(@"snapshotURL is undefined.");
+    return nil;
+  }
+
+  NSError  *error         = nil;
+  NSData   *snapshotData  = [[NSData alloc] initWithContentsOfURL:snapshotURL options:NSDataReadingMappedIfSafe error:&error];
+
+  if (!snapshotData) {
+    DP_LOG_ERROR(@"Failed to read snapshot.  (%@)  %@", snapshotURL, [error localizedDescription]);
+    return nil;
+  }
+
+  id  snapshot = [NSPropertyListSerialization propertyListWithData: snapshotData
+                                                           options: NSPropertyListImmutable
+                                                            format: NULL
+                                                             error: &error ];
+
+  if (! [snapshot isKindOfClass:[NSDictionary class]]) {
+    DP_LOG_ERROR(@"Snapshot is not a dictionary.  (%@)  %@", snapshotURL, [error localizedDescription]);
+    return nil;
+  }
+
+  if (! [[snapshot objectForKey:DFC_SNAPSHOT_VERSION_KEY] isEqual:@(DFC_SNAPSHOT_VERSION)]) {
+    DP_LOG_ERROR(@"Snapshot version is not %d.  (%@)", DFC_SNAPSHOT_VERSION, snapshotURL);
+    return nil;
+  }
+
+  NSArray  *entries = [snapshot objectForKey:DFC_SNAPSHOT_ENTRIES_KEY];
+
+  if (! [entries isKindOfClass:[NSArray class]]) {
+    DP_LOG_ERROR(@"Snapshot entries are missing.  (%@)", snapshotURL);
+    return nil;
+  }
+
+
+  //
+  NSMutableSet  *fileNames = [[NSMutableSet alloc] initWithCapacity:[entries count]];
+
+  for (id entry in entries)
   {
-    DP_LOG_ERROR(@"Failed to write property list for cache data.  (%@)", self.propertyListURL);
-    return NO;
+    id  fileName   = [entry isKindOfClass:[NSDictionary class]] ? [entry objectForKey:DFC_SNAPSHOT_FILENAME_KEY]  : nil;
+    id  timestamp  = [entry isKindOfClass:[NSDictionary class]] ? [entry objectForKey:DFC_SNAPSHOT_TIMESTAMP_KEY] : nil;
+    id  size       = [entry isKindOfClass:[NSDictionary class]] ? [entry objectForKey:DFC_SNAPSHOT_SIZE_KEY]      : nil;
+    id  fileData   = [entry isKindOfClass:[NSDictionary class]] ? [entry objectForKey:DFC_SNAPSHOT_DATA_KEY]      : nil;
+
+    BOOL  wellFormed =    [fileName isKindOfClass:[NSString class]]
+                       && ([fileName length] > 0)
+                       && (NSNotFound == [fileName rangeOfString:@"/"].location)
+                       && (! [fileName isEqualToString:@"."])
+                       && (! [fileName isEqualToString:@".."])
+                       && (! [fileNames containsObject:fileName])
+                       && [timestamp isKindOfClass:[NSNumber class]]
+                       && isfinite([timestamp doubleValue])
+                       && [size isKindOfClass:[NSNumber class]]
+                       && [fileData isKindOfClass:[NSData class]]
+                       && ([size longLongValue] == (long long)[fileData length]);
+
+    if (!wellFormed) {
+      DP_LOG_ERROR(@"Snapshot entry %lu is malformed.  (%@)", (unsigned long)[fileNames count], snapshotURL);
+      return nil;
+    }
+
+    [fileNames addObject:fileName];
   }
 
-  return YES;
+  return entries;
+
+} // entriesOfSnapshotAtURL:
+
+
+
+//----------------- -o-
+- (NSNumber *) timestamp
+{
+  return [NSNumber numberWithDouble:self.clock()];
 }
 
 
-@end // @implementation DataFileCache
 
+//----------------- -o-
+// setTimestamp:forFile:
+//
+// Record fileName as the most recently used.
+//
+// NB  setTimestamp:forFile: and forgetFile: keep recency in step with
+//     propertyList.  Change one only through them, or as 
+//     ioImportSnapshotEntries: does.
+//
+- (void) setTimestamp: (NSNumber *)timestamp
+              forFile: (NSString *)fileName
+{
+  [self.propertyList setObject:timestamp forKey:fileName];
+
+  [self.recency removeObject:fileName];
+  [self.recency addObject:fileName];
+}
+
+
+
+//----------------- -o-
+- (void) forgetFile: (NSString *)fileName
+{
+  [self.propertyList removeObjectForKey:fileName];
+  [self.recency removeObject:fileName];
+}
+
+
+
+//----------------- -o-
+// recencyIndexForTimestamp:importedNames:
+//
+// Index in recency for a file imported with timestamp:  after files with
+//   earlier timestamps, and after importedNames of the same timestamp,
+//   but before other files of the same timestamp.
+//
+// ASSUME  recency is in order of timestamp, as the clock runs forward.
+//
+- (NSUInteger) recencyIndexForTimestamp: (NSNumber *)  timestamp
+                          importedNames: (NSSet *)     importedNames
+{
+  NSUInteger  low   = 0;
+  NSUInteger  high  = [self.recency count];
+
+  while (low < high)
+  {
+    NSUInteger          middle    = (low + high) / 2;
+    NSString           *fileName  = [self.recency objectAtIndex:middle];
+    NSComparisonResult  order     = [[self.propertyList objectForKey:fileName] compare:timestamp];
+
+    if ((NSOrderedAscending == order) || ((NSOrderedSame == order) && [importedNames containsObject:fileName])) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  return low;
+}
+
+
+
+//----------------- -o-
+// orderRecency
+//
+// Order recency by timestamp, as when the cache was last written.  
+//   Equal timestamps are ordered by fileName.
+//
+- (void) orderRecency
+{
+  NSDictionary  *propertyList = self.propertyList;
+
+  NSArray  *sortedKeys = [[propertyList allKeys] sortedArrayUsingComparator:
+                           ^NSComparisonResult(NSString *key1, NSString *key2)
+                           {
+                             NSComparisonResult  order = [[propertyList objectForKey:key1] compare:[propertyList objectForKey:key2]];
+
+                             return (NSOrderedSame != order) ? order : [key1 compare:key2];
+                           }];
+
+  self.recency = [[NSMutableOrderedSet alloc] initWithArray:sortedKeys];
+}
+
+
+
+//----------------- -o-
+- (BOOL) sync
+{
+  return [self.store writePropertyList:self.propertyList];
+}
+
+
+
+//----------------- -o-
+// postNotificationName:fileName:
+//
+// Publish to changeFeed now;  queue the notification for postNotifications:.
+//
+- (void) postNotificationName: (NSString *)name
+                     fileName: (NSString *)fileName
+{
+  [self.pendingNotifications addObject:
+    [NSNotification notificationWithName: name
+                                  object: self
+                                userInfo: fileName ? @{ DFC_NOTIFICATION_FILENAME_KEY : fileName } : nil ]];
+
+  [self.changeFeed publishTopic:name payload:fileName];
+}
+
+
+
+//----------------- -o-
+- (NSArray *) takePendingNotifications
+{
+  NSArray  *notifications = self.pendingNotifications;
+
+  self.pendingNotifications = [[NSMutableArray alloc] init];
+
+  return notifications;
+}
+
+
+
+//----------------- -o-
+- (void) postNotifications: (NSArray *)notifications
+{
+  for (NSNotification *notification in notifications) {
+    [[NSNotificationCenter defaultCenter] postNotification:notification];
+  }
+}
+
+
+@end // @implementation DataFileCache
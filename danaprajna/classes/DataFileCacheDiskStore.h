@@ -0,0 +1,49 @@
+//
+// DataFileCacheDiskStore.h
+//
+// DataFileCacheStore in a cache directory:
+//
+//   <cacheDirURL>/data/                   One file per cached fileName.
+//   <cacheDirURL>/dataTimestamps.plist    Property list.
+//   <cacheDirURL>/trash/                  Files set aside by a batch.
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import <Foundation/Foundation.h>
+
+#import "Danaprajna.h"
+#import "DataFileCacheStore.h"
+
+
+
+//------------------------------------------------------------ -o-
+#define DFC_CACHEDIR_BASENAME_DEFAULT      @"DataFileCache"
+#define DFC_CACHEDIR_DATADIR_NAME          @"data"
+#define DFC_CACHEDIR_PROPERTYLIST_NAME     @"dataTimestamps.plist"
+#define DFC_CACHEDIR_TRASHDIR_NAME         @"trash"
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface DataFileCacheDiskStore : NSObject <DataFileCacheStore>
+
+  @property  (readonly, strong, nonatomic)  NSURL  *cacheDirURL;
+  @property  (readonly, strong, nonatomic)  NSURL  *propertyListURL;
+  @property  (readonly, strong, nonatomic)  NSURL  *dataDirURL;
+  @property  (readonly, strong, nonatomic)  NSURL  *trashDirURL;
+
+  @property  (nonatomic)  BOOL  verbose;
+      // YES enables DP_LOG_INFO messages.
+
+
+  //
+  - (id) initWithCacheDirectoryURL: (NSURL *)cacheDirURL;
+
+@end
+
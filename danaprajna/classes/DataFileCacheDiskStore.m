@@ -0,0 +1,343 @@
+//
+// DataFileCacheDiskStore.m
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import "DataFileCacheDiskStore.h"
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface DataFileCacheDiskStore()
+
+  @property  (readwrite, strong, nonatomic)  NSURL  *cacheDirURL;
+  @property  (readwrite, strong, nonatomic)  NSURL  *propertyListURL;
+  @property  (readwrite, strong, nonatomic)  NSURL  *dataDirURL;
+  @property  (readwrite, strong, nonatomic)  NSURL  *trashDirURL;
+
+  @property  (strong, nonatomic)  NSFileManager  *fileManager;
+
+
+  // Private methods.
+  //
+  - (BOOL) moveFile: (NSString *)fileName
+               from: (NSURL *)fromDirURL
+                 to: (NSURL *)toDirURL;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation DataFileCacheDiskStore
+
+#pragma mark - Constructors
+
+//------------------------ -o-
+// initWithCacheDirectoryURL:
+//
+// INPUTS--
+//   cacheDirURL  Valid URL  -OR-  nil to use system path + default basename.
+//
+- (id) initWithCacheDirectoryURL: (NSURL *)cacheDirURL__
+{
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+  //
+  self.cacheDirURL  = cacheDirURL__;
+  self.verbose      = NO;
+
+  if (!self.cacheDirURL) {
+    NSArray *cacheDirOptions = [self.fileManager URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask];
+    if ([cacheDirOptions count] < 1) {
+      DP_LOG_ERROR(@"Could not acquire path to NSCachesDirectory.");
+      return nil;
+    }
+
+    self.cacheDirURL = [cacheDirOptions[0] URLByAppendingPathComponent:DFC_CACHEDIR_BASENAME_DEFAULT isDirectory:YES];
+  }
+
+  self.dataDirURL       = [self.cacheDirURL URLByAppendingPathComponent:DFC_CACHEDIR_DATADIR_NAME isDirectory:YES];
+  self.propertyListURL  = [self.cacheDirURL URLByAppendingPathComponent:DFC_CACHEDIR_PROPERTYLIST_NAME];
+  self.trashDirURL      = [self.cacheDirURL URLByAppendingPathComponent:DFC_CACHEDIR_TRASHDIR_NAME isDirectory:YES];
+
+  return self;
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Getters/setters.
+
+//----------------- -o-
+- (NSFileManager *)  fileManager
+{
+  if (!_fileManager) {
+    _fileManager = [[NSFileManager alloc] init];
+  }
+
+  return _fileManager;
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - DataFileCacheStore.
+
+//----------------- -o-
+// open
+//
+// DFC_CACHEDIR_BASENAME and DFC_CACHEDIR_DATADIR_NAME are removed if they exist and are not directories.
+// If one of data directory or property list does not exist, the other is removed.
+//
+- (NSMutableDictionary *) open
+{
+  if (! [Zed createDirectoryForURL:self.cacheDirURL replace:YES]) {
+    return nil;
+  }
+
+
+  // Files left in trash by an interrupted batch are either out of the
+  //   property list already, or will be found missing from the data
+  //   directory.
+  //
+  if ([self.fileManager fileExistsAtPath:[self.trashDirURL path]]) {
+    if (! [Zed removeItemForURL:self.trashDirURL])  { return nil; }
+  }
+
+
+  //
+  BOOL  dataPathExists       = NO;
+  BOOL  dataPathIsDirectory  = NO;
+
+  NSMutableDictionary  *propertyList  = [[NSDictionary dictionaryWithContentsOfURL:self.propertyListURL] mutableCopy];
+  dataPathExists                      = [self.fileManager fileExistsAtPath:[self.dataDirURL path] isDirectory:&dataPathIsDirectory];
+
+  NSString  *dataPathErrorMsg = nil;
+
+
+  if (dataPathExists)
+  {
+    if (!dataPathIsDirectory) {
+      dataPathErrorMsg = DP_STRWFMT(@"REMOVING file with same name as data directory.  (%@)", self.dataDirURL);
+    } else if (!propertyList) {
+      dataPathErrorMsg = DP_STRWFMT(@"REMOVING data directory because property list is missing.  (%@)", self.dataDirURL);
+    }
+
+  }
+
+  if (propertyList)
+  {
+    if ((!dataPathExists) || dataPathErrorMsg) {
+      dataPathErrorMsg = DP_STRWFMT(@"REMOVING property list because data directory is missing or corrupt.  (%@)", self.propertyListURL);
+    }
+  }
+
+
+  if (dataPathErrorMsg)
+  {
+    DP_LOG_WARNING(@"%@", dataPathErrorMsg);
+
+    if (! ([Zed removeItemForURL:self.dataDirURL]
+             && [Zed removeItemForURL:self.propertyListURL]) )
+    {
+      return nil;
+    }
+
+    dataPathExists = NO;
+  }
+
+
+  //
+  if (!dataPathExists)
+  {
+    if (! [Zed createDirectoryForURL:self.dataDirURL replace:YES]) {
+      return nil;
+    }
+
+    propertyList = [[NSMutableDictionary alloc] init];
+
+    if (self.verbose) {
+      DP_LOG_INFO(@"CREATED property list and data directory for cache directory.  (%@)", self.cacheDirURL);
+    }
+  }
+
+  return propertyList;
+
+} // open
+
+
+
+//----------------- -o-
+- (BOOL) writePropertyList: (NSDictionary *)propertyList
+{
+  if (! [propertyList writeToURL:self.propertyListURL atomically:YES])
+  {
+    DP_LOG_ERROR(@"Failed to write property list for cache data.  (%@)", self.propertyListURL);
+    return NO;
+  }
+
+  return YES;
+}
+
+
+
+//----------------- -o-
+- (NSArray *) fileNames
+{
+  NSMutableArray  *dataDirList = [Zed directoryListForURL:self.dataDirURL];
+
+  if (!dataDirList)  { return nil; }
+
+  NSMutableArray  *fileNames = [[NSMutableArray alloc] initWithCapacity:[dataDirList count]];
+
+  for (NSURL *url in dataDirList) {
+    [fileNames addObject:[url lastPathComponent]];
+  }
+
+  return fileNames;
+}
+
+
+
+//----------------- -o-
+- (NSInteger) sizeOfFile: (NSString *)fileName
+{
+  return [Zed fileSizeForURL:DP_URL_PLUSFILE(self.dataDirURL, fileName) includeResourceFork:YES];
+}
+
+
+
+//----------------- -o-
+- (NSURL *) URLForFile: (NSString *)fileName
+{
+  return DP_URL_PLUSFILE(self.dataDirURL, fileName);
+}
+
+
+
+//----------------- -o-
+- (BOOL) writeFile: (NSString *)fileName
+              data: (NSData *)fileData
+{
+  return [fileData writeToURL:DP_URL_PLUSFILE(self.dataDirURL, fileName) atomically:YES];
+}
+
+
+
+//----------------- -o-
+- (NSData *) readFile: (NSString *)  fileName
+                error: (NSError **)  error
+{
+  return [[NSData alloc] initWithContentsOfURL:DP_URL_PLUSFILE(self.dataDirURL, fileName) options:0 error:error];
+}
+
+
+
+//----------------- -o-
+- (BOOL) removeFile: (NSString *)fileName
+{
+  return [Zed removeItemForURL:DP_URL_PLUSFILE(self.dataDirURL, fileName)];
+}
+
+
+
+//----------------- -o-
+- (BOOL) removeAllFiles
+{
+  if (! [Zed recreateDirectoryForURL:self.dataDirURL])
+  {
+    DP_LOG_ERROR(@"Failed to delete and recreate data directory for cache.");
+    return NO;
+  }
+
+  if (self.verbose) {
+    DP_LOG_INFO(@"REMOVED and RE-CREATED data directory for cache directory.  (%@)", self.cacheDirURL);
+  }
+
+  return YES;
+}
+
+
+
+//----------------- -o-
+- (BOOL) setAsideFile: (NSString *)fileName
+{
+  if (! [Zed createDirectoryForURL:self.trashDirURL replace:YES])  { return NO; }
+
+  return [self moveFile:fileName from:self.dataDirURL to:self.trashDirURL];
+}
+
+
+
+//----------------- -o-
+- (BOOL) putBackFile: (NSString *)fileName
+{
+  return [self moveFile:fileName from:self.trashDirURL to:self.dataDirURL];
+}
+
+
+
+//----------------- -o-
+// emptyTrash
+//
+// NB  A trash directory that cannot be removed now is removed when the
+//     store is next opened.
+//
+- (void) emptyTrash
+{
+  if ([self.fileManager fileExistsAtPath:[self.trashDirURL path]]) {
+    [Zed removeItemForURL:self.trashDirURL];
+  }
+}
+
+
+
+//----------------- -o-
+- (unsigned long long) availableBytes
+{
+  return [Zed fileSystemAttributeForURL:self.dataDirURL attributeName:NSFileSystemFreeSize];
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Private methods.
+
+//----------------- -o-
+- (BOOL) moveFile: (NSString *)fileName
+             from: (NSURL *)fromDirURL
+               to: (NSURL *)toDirURL
+{
+  NSError  *error = nil;
+
+  if (! [self.fileManager moveItemAtURL: DP_URL_PLUSFILE(fromDirURL, fileName)
+                                  toURL: DP_URL_PLUSFILE(toDirURL, fileName)
+                                  error: &error ])
+  {
+    if (error) {
+      DP_LOG_NSERROR(error);
+    }
+    DP_LOG_ERROR(@"Failed to move cached file \"%@\" to %@.", fileName, [toDirURL lastPathComponent]);
+    return NO;
+  }
+
+  return YES;
+}
+
+
+@end // @implementation DataFileCacheDiskStore
+
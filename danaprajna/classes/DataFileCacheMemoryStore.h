@@ -0,0 +1,50 @@
+//
+// DataFileCacheMemoryStore.h
+//
+// DataFileCacheStore in memory.  No disk I/O, and nothing left behind:
+// with a virtual clock (DataFileCache.clock), the same operations give
+// the same cache, every time.  Reopen by giving the same store to a new
+// DataFileCache.
+//
+// NB  writePropertyList: keeps a copy, as a disk store would:  changes
+//     the cache has not written are not seen when it is opened again.
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import <Foundation/Foundation.h>
+
+#import "Danaprajna.h"
+#import "DataFileCacheStore.h"
+
+
+
+//------------------------------------------------------------ -o-
+#define DFC_MEMORYSTORE_URL_SCHEME  @"x-datafilecache-memory"
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface DataFileCacheMemoryStore : NSObject <DataFileCacheStore>
+
+  @property  (nonatomic)  BOOL  keepsContents;
+      // Default YES.  NO keeps only sizes, and reads return zeros:
+      //   simulated caches far larger than memory.
+
+  @property  (nonatomic)  BOOL  keepsPropertyList;
+      // Default YES.  NO only counts writes of the property list, and the
+      //   cache opens empty:  replay of a single run, without the copy.
+
+  @property  (nonatomic)  unsigned long long  availableBytes;
+      // Reported as free in the file system.  Default is unlimited.
+
+  @property  (readonly, nonatomic)  unsigned long long  fileWrites,
+                                                        propertyListWrites;
+
+@end
+
@@ -0,0 +1,231 @@
+//
+// DataFileCacheMemoryStore.m
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import "DataFileCacheMemoryStore.h"
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface DataFileCacheMemoryStore()
+
+  @property  (readwrite, nonatomic)  unsigned long long  fileWrites,
+                                                         propertyListWrites;
+
+  // SCHEMA for files and trash --
+  //   NSString fileName --> NSData contents  -OR-  NSNumber size (!keepsContents)
+  //
+  @property  (strong, nonatomic)  NSMutableDictionary  *files;
+  @property  (strong, nonatomic)  NSMutableDictionary  *trash;
+
+  @property  (strong, nonatomic)  NSDictionary         *propertyList;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation DataFileCacheMemoryStore
+
+#pragma mark - Constructors
+
+//------------------------ -o-
+- (id) init
+{
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+  self.keepsContents      = YES;
+  self.keepsPropertyList  = YES;
+  self.availableBytes     = LLONG_MAX;
+
+  self.files  = [[NSMutableDictionary alloc] init];
+  self.trash  = [[NSMutableDictionary alloc] init];
+
+  return self;
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - DataFileCacheStore.
+
+//----------------- -o-
+- (NSMutableDictionary *) open
+{
+  [self.trash removeAllObjects];
+
+  if ((!self.propertyList) || (!self.keepsPropertyList)) {
+    return [[NSMutableDictionary alloc] init];
+  }
+
+  return [self.propertyList mutableCopy];
+}
+
+
+
+//----------------- -o-
+- (BOOL) writePropertyList: (NSDictionary *)propertyList
+{
+  if (self.keepsPropertyList) {
+    self.propertyList = [propertyList copy];
+  }
+
+  self.propertyListWrites += 1;
+
+  return YES;
+}
+
+
+
+//----------------- -o-
+- (NSArray *) fileNames
+{
+  return [self.files allKeys];
+}
+
+
+
+//----------------- -o-
+- (NSInteger) sizeOfFile: (NSString *)fileName
+{
+  id  contents = [self.files objectForKey:fileName];
+
+  if (!contents)  { return -1; }
+
+  return [contents isKindOfClass:[NSData class]] ? (NSInteger)[contents length] : [contents integerValue];
+}
+
+
+
+//----------------- -o-
+// URLForFile:
+//
+// NB  Names the file;  it cannot be read through the URL.
+//
+- (NSURL *) URLForFile: (NSString *)fileName
+{
+  NSURLComponents  *components = [[NSURLComponents alloc] init];
+
+  components.scheme  = DFC_MEMORYSTORE_URL_SCHEME;
+  components.host    = @"";
+  components.path    = [@"/" stringByAppendingString:fileName];
+
+  return components.URL;
+}
+
+
+
+//----------------- -o-
+- (BOOL) writeFile: (NSString *)fileName
+              data: (NSData *)fileData
+{
+  if (!fileData)  { return NO; }
+
+  [self.files setObject: self.keepsContents ? [fileData copy] : @([fileData length])
+                 forKey: fileName ];
+
+  self.fileWrites += 1;
+
+  return YES;
+}
+
+
+
+//----------------- -o-
+- (NSData *) readFile: (NSString *)  fileName
+                error: (NSError **)  error
+{
+  id  contents = [self.files objectForKey:fileName];
+
+  if (!contents)
+  {
+    if (error) {
+      *error = [NSError errorWithDomain: NSCocoaErrorDomain
+                                   code: NSFileReadNoSuchFileError
+                               userInfo: @{ NSFilePathErrorKey : fileName }];
+    }
+    return nil;
+  }
+
+  if ([contents isKindOfClass:[NSData class]])  { return contents; }
+
+  return [NSMutableData dataWithLength:[contents unsignedIntegerValue]];
+}
+
+
+
+//----------------- -o-
+- (BOOL) removeFile: (NSString *)fileName
+{
+  [self.files removeObjectForKey:fileName];
+  return YES;
+}
+
+
+
+//----------------- -o-
+- (BOOL) removeAllFiles
+{
+  [self.files removeAllObjects];
+  return YES;
+}
+
+
+
+//----------------- -o-
+- (BOOL) setAsideFile: (NSString *)fileName
+{
+  id  contents = [self.files objectForKey:fileName];
+
+  if (!contents) {
+    DP_LOG_ERROR(@"Failed to move cached file \"%@\" to trash.", fileName);
+    return NO;
+  }
+
+  [self.trash setObject:contents forKey:fileName];
+  [self.files removeObjectForKey:fileName];
+
+  return YES;
+}
+
+
+
+//----------------- -o-
+- (BOOL) putBackFile: (NSString *)fileName
+{
+  id  contents = [self.trash objectForKey:fileName];
+
+  if (!contents) {
+    DP_LOG_ERROR(@"Failed to move cached file \"%@\" to data.", fileName);
+    return NO;
+  }
+
+  [self.files setObject:contents forKey:fileName];
+  [self.trash removeObjectForKey:fileName];
+
+  return YES;
+}
+
+
+
+//----------------- -o-
+- (void) emptyTrash
+{
+  [self.trash removeAllObjects];
+}
+
+
+@end // @implementation DataFileCacheMemoryStore
+
@@ -0,0 +1,80 @@
+//
+// DataFileCacheSimulator.h
+//
+// Replay file accesses against a DataFileCache in a DataFileCacheMemoryStore,
+// on a virtual clock.  Each access is a hit, which touches the file, or a
+// miss, which saves it and may evict others.  No disk I/O and no waiting,
+// so millions of accesses replay in seconds, and the same accesses make
+// the same evictions every time.  Use it to choose a cache size offline.
+//
+//
+// TRACE FORMAT--
+//   One access per line:  <seconds> <fileName> <sizeInBytes>
+//   Fields are separated by spaces or tabs.  Blank lines and lines
+//   beginning with # are skipped.  seconds need not start at zero, and
+//   the clock never runs backward:  an earlier time counts as now.
+//
+//
+// CLASS DEPENDENCIES:  DataFileCache, DataFileCacheMemoryStore
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import <Foundation/Foundation.h>
+
+#import "Danaprajna.h"
+#import "DataFileCache.h"
+
+
+
+//------------------------------------------------------------ -o-
+#define DFC_SIMULATION_DIGEST_BASIS  14695981039346656037ULL     // FNV-1a, 64 bits.
+
+
+typedef struct {
+  unsigned long long  accesses;
+  unsigned long long  hits;
+  unsigned long long  misses;
+  unsigned long long  evictions;
+  unsigned long long  failures;           // Misses too large to cache.
+  unsigned long long  bytesAccessed;
+  unsigned long long  bytesHit;
+  uint64_t            evictionDigest;     // Of evicted fileNames, in order.
+} DFCSimulationStats;
+
+#define DFC_SIMULATION_STATS_DEFAULT  \
+  ((DFCSimulationStats) { 0, 0, 0, 0, 0, 0, 0, DFC_SIMULATION_DIGEST_BASIS })
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface DataFileCacheSimulator : NSObject
+
+  @property  (readonly, strong, nonatomic)  DataFileCache             *cache;
+  @property  (readonly, strong, nonatomic)  DataFileCacheMemoryStore  *store;
+
+  @property  (readonly, nonatomic)  NSTimeInterval       now;          // Virtual clock of cache.
+  @property  (readonly, nonatomic)  DFCSimulationStats   stats;
+
+
+  //
+  - (id) initWithCacheSize: (long long)sizeInBytes;
+
+  - (BOOL) accessFile: (NSString *)      fileName
+                 size: (NSUInteger)      sizeInBytes
+               atTime: (NSTimeInterval)  time;
+
+  - (BOOL) replayTraceAtURL: (NSURL *)traceURL;
+
+  - (NSInteger) importSnapshotAtURL: (NSURL *)         snapshotURL
+                             atTime: (NSTimeInterval)  time;
+
+  + (NSString *) descriptionOfStats: (DFCSimulationStats)stats;
+
+@end
+
@@ -0,0 +1,303 @@
+//
+// DataFileCacheSimulator.m
+//
+// The store keeps only sizes, and no property list;  saved data points
+// into one scratch buffer, grown to the largest miss.  Evictions are
+// counted from the cache's DFC_NOTIFICATION_FILE_REMOVED, posted on this
+// thread before each save returns.
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import "DataFileCacheSimulator.h"
+
+#include <ctype.h>
+#include <stdio.h>
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface DataFileCacheSimulator()
+
+  @property  (readwrite, strong, nonatomic)  DataFileCache             *cache;
+  @property  (readwrite, strong, nonatomic)  DataFileCacheMemoryStore  *store;
+
+  @property  (readwrite, nonatomic)  NSTimeInterval       now;
+  @property  (readwrite, nonatomic)  DFCSimulationStats   stats;
+
+  @property  (nonatomic)          long long       cacheSize;
+  @property  (strong, nonatomic)  NSMutableData  *scratch;
+  @property  (strong, nonatomic)  NSData         *emptyData;
+
+  @property  (strong, nonatomic)  id              evictionObserver;
+
+
+  // Private methods.
+  //
+  - (void) recordEviction: (NSString *)fileName;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation DataFileCacheSimulator
+
+#pragma mark - Constructors
+
+//------------------------ -o-
+- (id) initWithCacheSize: (long long)sizeInBytes
+{
+  if (!(self = [super init])) {
+    DP_LOG_ERROR(@"[super init] failed.");
+    return nil;
+  }
+
+  //
+  self.now        = 0;
+  self.stats      = DFC_SIMULATION_STATS_DEFAULT;
+  self.cacheSize  = sizeInBytes;
+  self.scratch    = [[NSMutableData alloc] init];
+  self.emptyData  = [NSData data];
+
+  self.store                    = [[DataFileCacheMemoryStore alloc] init];
+  self.store.keepsContents      = NO;
+  self.store.keepsPropertyList  = NO;
+
+  self.cache = [[DataFileCache alloc] initWithStore:self.store sizeInBytes:sizeInBytes];
+  if (!self.cache)  { return nil; }
+
+
+  //
+  __weak DataFileCacheSimulator  *weakSelf = self;
+
+  self.cache.clock = ^NSTimeInterval{ return weakSelf.now; };
+
+  self.evictionObserver =
+    [[NSNotificationCenter defaultCenter] addObserverForName: DFC_NOTIFICATION_FILE_REMOVED
+                                                      object: self.cache
+                                                       queue: nil
+                                                  usingBlock: ^(NSNotification *notification)
+                                                  {
+                                                    [weakSelf recordEviction:notification.userInfo[DFC_NOTIFICATION_FILENAME_KEY]];
+                                                  }];
+
+  return self;
+}
+
+
+
+//------------------------ -o-
+- (void) dealloc
+{
+  if (self.evictionObserver) {
+    [[NSNotificationCenter defaultCenter] removeObserver:self.evictionObserver];
+  }
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//----------------- -o-
+// accessFile:size:atTime:
+//
+// Touch fileName if it is cached, otherwise save sizeInBytes for it.
+//
+// RETURN:  YES on a hit.
+//
+- (BOOL) accessFile: (NSString *)      fileName
+               size: (NSUInteger)      sizeInBytes
+             atTime: (NSTimeInterval)  time
+{
+  if (!fileName) {
+    DP_LOG_ERROR(@"fileName is undefined.");
+    return NO;
+  }
+
+  if (time > self.now) {
+    self.now = time;
+  }
+
+  _stats.accesses       += 1;
+  _stats.bytesAccessed  += sizeInBytes;
+
+
+  //
+  if ([self.cache isFileCached:fileName])
+  {
+    _stats.hits      += 1;
+    _stats.bytesHit  += sizeInBytes;
+
+    [self.cache saveFile:fileName withData:self.emptyData];
+    return YES;
+  }
+
+  _stats.misses += 1;
+
+  if ((long long)sizeInBytes > self.cacheSize) {
+    _stats.failures += 1;
+    return NO;
+  }
+
+
+  //
+  if ([self.scratch length] < sizeInBytes) {
+    [self.scratch setLength:sizeInBytes];
+  }
+
+  NSData  *fileData = [NSData dataWithBytesNoCopy:[self.scratch mutableBytes] length:sizeInBytes freeWhenDone:NO];
+
+  if (! [self.cache saveFile:fileName withData:fileData]) {
+    _stats.failures += 1;
+  }
+
+  return NO;
+
+} // accessFile:size:atTime:
+
+
+
+//----------------- -o-
+// replayTraceAtURL:
+//
+// See TRACE FORMAT in DataFileCacheSimulator.h.
+//
+// RETURN:  NO if traceURL cannot be read, or at the first malformed line.
+//
+- (BOOL) replayTraceAtURL: (NSURL *)traceURL
+{
+  FILE  *trace = fopen([[traceURL path] fileSystemRepresentation], "r");
+
+  if (!trace) {
+    DP_LOG_ERROR(@"Cannot open trace.  (%@)", traceURL);
+    return NO;
+  }
+
+
+  //
+  char           *line        = NULL;
+  size_t          capacity    = 0;
+  unsigned long   lineNumber  = 0;
+  BOOL            rval        = YES;
+
+  while (getline(&line, &capacity, trace) >= 0)
+  {
+    char  *cursor  = line;
+    char  *end     = NULL;
+
+    lineNumber += 1;
+
+    while ((' ' == *cursor) || ('\t' == *cursor))  { cursor += 1; }
+
+    if (('\0' == *cursor) || ('\n' == *cursor) || ('\r' == *cursor) || ('#' == *cursor))  { continue; }
+
+
+    //
+    double  time = strtod(cursor, &end);
+
+    if (end == cursor)  { rval = NO; break; }
+
+    for (cursor = end; (' ' == *cursor) || ('\t' == *cursor); cursor++)  { }
+
+    char  *name = cursor;
+
+    while (('\0' != *cursor) && !isspace((unsigned char)*cursor))  { cursor += 1; }
+
+    size_t              nameLength  = (size_t)(cursor - name);
+    unsigned long long  size        = strtoull(cursor, &end, 10);
+
+    if ((nameLength < 1) || (end == cursor))  { rval = NO; break; }
+
+
+    //
+    @autoreleasepool
+    {
+      NSString  *fileName = [[NSString alloc] initWithBytes:name length:nameLength encoding:NSUTF8StringEncoding];
+
+      if (!fileName)  { rval = NO; break; }
+
+      [self accessFile:fileName size:(NSUInteger)size atTime:time];
+    }
+  }
+
+  free(line);
+  fclose(trace);
+
+  if (!rval) {
+    DP_LOG_ERROR(@"Malformed trace at line %lu.  (%@)", lineNumber, traceURL);
+  }
+
+  return rval;
+
+} // replayTraceAtURL:
+
+
+
+
+//----------------- -o-
+// importSnapshotAtURL:atTime:
+//
+// Warm the cache from a snapshot, as at time.  Snapshot timestamps later
+//   than time are taken as time;  see DataFileCache importSnapshotAtURL:.
+//
+// RETURN:  Number of files imported  -OR-  -1.
+//
+- (NSInteger) importSnapshotAtURL: (NSURL *)         snapshotURL
+                           atTime: (NSTimeInterval)  time
+{
+  if (time > self.now) {
+    self.now = time;
+  }
+
+  return [self.cache importSnapshotAtURL:snapshotURL];
+}
+
+
+
+//----------------- -o-
++ (NSString *) descriptionOfStats: (DFCSimulationStats)stats
+{
+  double  hitRatio      = (stats.accesses > 0)      ? (double)stats.hits / stats.accesses : 0;
+  double  byteHitRatio  = (stats.bytesAccessed > 0) ? (double)stats.bytesHit / stats.bytesAccessed : 0;
+
+  return DP_STRWFMT(@"accesses %llu,  hits %llu (%.2f%%),  byte hits %.2f%%,  evictions %llu,  failures %llu,  eviction digest %016llx",
+                      stats.accesses, stats.hits, hitRatio * 100, byteHitRatio * 100,
+                      stats.evictions, stats.failures, (unsigned long long)stats.evictionDigest);
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Private methods.
+
+//----------------- -o-
+// recordEviction:
+//
+// Fold fileName, and a NUL to end it, into evictionDigest.
+//
+- (void) recordEviction: (NSString *)fileName
+{
+  const unsigned char  *bytes   = (const unsigned char *)[fileName UTF8String];
+  uint64_t              digest  = _stats.evictionDigest;
+
+  for (; bytes && *bytes; bytes++) {
+    digest = (digest ^ *bytes) * 1099511628211ULL;
+  }
+
+  _stats.evictionDigest  = digest * 1099511628211ULL;
+  _stats.evictions      += 1;
+}
+
+
+@end // @implementation DataFileCacheSimulator
+
@@ -0,0 +1,67 @@
+//
+// DataFileCacheStore.h
+//
+// Where a DataFileCache keeps its files and its property list.
+// DataFileCacheDiskStore is a cache directory;  DataFileCacheMemoryStore
+// holds everything in memory, for simulation and tests.
+//
+// Files are named by fileName alone.  A store is only called from the
+// cache's I/O queue:  writes alone, reads possibly together.
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import <Foundation/Foundation.h>
+
+#import "Danaprajna.h"
+
+
+
+
+//------------------------------------------------------------ -o-
+@protocol DataFileCacheStore <NSObject>
+
+  // Prepare storage.
+  //
+  // RETURN:  Property list last written, empty if there is none
+  //          -OR-  nil on error.
+  //
+  - (NSMutableDictionary *) open;
+
+  - (BOOL) writePropertyList: (NSDictionary *)propertyList;
+
+
+  //
+  - (NSArray *)  fileNames;                                   // Every file stored, cached or not.  nil on error.
+
+  - (NSInteger)  sizeOfFile: (NSString *)fileName;            // -1 on error.
+
+  - (NSURL *)    URLForFile: (NSString *)fileName;
+
+  - (BOOL) writeFile: (NSString *)fileName
+                data: (NSData *)fileData;
+
+  - (NSData *) readFile: (NSString *)  fileName
+                  error: (NSError **)  error;
+
+  - (BOOL) removeFile: (NSString *)fileName;
+  - (BOOL) removeAllFiles;
+
+
+  // Files set aside stay out of fileNames until put back;  emptyTrash
+  //   removes them.
+  //
+  - (BOOL) setAsideFile: (NSString *)fileName;
+  - (BOOL) putBackFile: (NSString *)fileName;
+  - (void) emptyTrash;
+
+
+  //
+  - (unsigned long long) availableBytes;                      // DP_ULONGLONG_MAX on error.
+
+@end
+
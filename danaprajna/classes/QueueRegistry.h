@@ -0,0 +1,66 @@
+//
+// QueueRegistry.h
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import <Foundation/Foundation.h>
+
+#import "Danaprajna.h"
+
+
+
+//------------------------------------------------------------ -o-
+// Long-lived queues, one per role.
+//
+// NB  A block must never wait on work submitted to its own role:  with
+//       every slot taken by waiters, that work never starts.
+//
+typedef enum {
+  QRRoleFetch,          // Coordinates requests on QRRoleNetwork and waits for them.
+  QRRoleNetwork,        // One request per block.
+  QRRoleDisk,           // File reads and writes.
+  QRRoleDecode,         // Image decode.
+  QRRoleIndex,          // Index builds;  one at a time, in submission order.
+  QRRoleCount
+} QRRole;
+
+
+// Times are seconds.  wait is from submission to start.
+//
+typedef struct {
+  NSUInteger      depth;            // Submitted, not yet complete.
+  NSUInteger      running;
+  uint64_t        submitted;
+  uint64_t        completed;
+  NSTimeInterval  waitTotal;
+  NSTimeInterval  waitMax;
+  NSTimeInterval  runTotal;
+  NSTimeInterval  runMax;
+} QRStats;
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface QueueRegistry : NSObject
+
+  + (void) async: (QRRole)role
+           block: (dispatch_block_t)block;
+
+  + (void) async: (QRRole)role
+           group: (dispatch_group_t)group
+           block: (dispatch_block_t)block;
+
+  + (NSString *)  nameForRole:        (QRRole)role;
+  + (NSUInteger)  concurrencyForRole: (QRRole)role;
+
+  + (QRStats)       statsForRole: (QRRole)role;
+  + (NSDictionary *) statsDescription;
+
+@end
+
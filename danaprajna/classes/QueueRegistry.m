@@ -0,0 +1,276 @@
+//
+// QueueRegistry.m
+//
+// Long-lived queues by role, each with a dispatch priority and a limit
+// on blocks running at once.
+//
+// Each role has a serial feeder queue and a concurrent worker queue that
+// targets a global queue of the role priority.  The feeder takes a slot
+// from a counting semaphore before it passes each block, in submission
+// order, to the worker;  the worker returns the slot when the block ends.
+// Blocks waiting for a slot wait on the feeder, not on a thread of their
+// own, so a burst of submissions never adds threads beyond the limit.
+//
+//
+// CLASS DEPENDENCIES: Log
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import "QueueRegistry.h"
+
+
+
+//---------------------------------------------------- -o-
+// concurrency zero is one per active processor.
+//
+typedef struct {
+  const char  *name;
+  long         priority;
+  NSUInteger   concurrency;
+} QRRoleConfig;
+
+static const QRRoleConfig  roleConfig[QRRoleCount] =
+{
+  [QRRoleFetch]    = { "fetch",    DISPATCH_QUEUE_PRIORITY_DEFAULT,  2 },
+  [QRRoleNetwork]  = { "network",  DISPATCH_QUEUE_PRIORITY_DEFAULT,  4 },
+  [QRRoleDisk]     = { "disk",     DISPATCH_QUEUE_PRIORITY_DEFAULT,  2 },
+  [QRRoleDecode]   = { "decode",   DISPATCH_QUEUE_PRIORITY_HIGH,     0 },
+  [QRRoleIndex]    = { "index",    DISPATCH_QUEUE_PRIORITY_LOW,      1 },
+};
+
+
+// Times are mach_absolute_time() units.
+//
+typedef struct {
+  volatile int64_t  depth;
+  volatile int64_t  running;
+  volatile int64_t  submitted;
+  volatile int64_t  completed;
+  volatile int64_t  waitTotal;
+  volatile int64_t  waitMax;
+  volatile int64_t  runTotal;
+  volatile int64_t  runMax;
+} QRCounters;
+
+
+static dispatch_queue_t       feeders[QRRoleCount];
+static dispatch_queue_t       workers[QRRoleCount];
+static dispatch_semaphore_t   slots[QRRoleCount];
+static NSUInteger             concurrency[QRRoleCount];
+static QRCounters             counters[QRRoleCount];
+
+static mach_timebase_info_data_t  timebase;
+
+
+
+//------------------- -o-
+static void
+qrUpdateMax (volatile int64_t *max, int64_t value)
+{
+  int64_t  current;
+
+  do {
+    current = *max;
+    if (value <= current)  { return; }
+  } while (! OSAtomicCompareAndSwap64Barrier(current, value, max));
+}
+
+
+static NSTimeInterval
+qrSeconds (int64_t ticks)
+{
+  return (double) ticks * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+
+
+
+//---------------------------------------------------- -o--
+@implementation QueueRegistry
+
+#pragma mark - Class initialization.
+
+//------------------- -o-
++ (void) initialize
+{
+  if (self != [QueueRegistry class])  { return; }
+
+  mach_timebase_info(&timebase);
+
+  NSUInteger  processors = [[NSProcessInfo processInfo] activeProcessorCount];
+
+  for (QRRole role = 0; role < QRRoleCount; role++)
+  {
+    NSString  *label = DP_STRWFMT(@"QueueRegistry %s", roleConfig[role].name);
+
+    concurrency[role]  = roleConfig[role].concurrency ? roleConfig[role].concurrency : MAX(processors, 1);
+    slots[role]        = dispatch_semaphore_create(concurrency[role]);
+
+    feeders[role]  = dispatch_queue_create([[label stringByAppendingString:@" feeder"] UTF8String], DISPATCH_QUEUE_SERIAL);
+    workers[role]  = dispatch_queue_create([label UTF8String], DISPATCH_QUEUE_CONCURRENT);
+
+    dispatch_set_target_queue(workers[role], dispatch_get_global_queue(roleConfig[role].priority, 0));
+  }
+}
+
+
+
+
+//---------------------------------------------------- -o--
+#pragma mark - Methods.
+
+//------------------- -o-
++ (void) async: (QRRole)role
+         block: (dispatch_block_t)block
+{
+  [QueueRegistry async:role group:nil block:block];
+}
+
+
+
+//------------------- -o-
+// async:group:block:
+//
+// NB  Any thread.  Never blocks the caller.
+// NB  group, if given, is entered now and left when block completes.
+//
++ (void) async: (QRRole)role
+         group: (dispatch_group_t)group
+         block: (dispatch_block_t)block
+{
+  if ((NSUInteger)role >= QRRoleCount) {
+    DP_LOG_ERROR(@"Unknown role.  (%d)", (int)role);
+    return;
+  }
+
+  if (!block) {
+    DP_LOG_ERROR(@"block is undefined.");
+    return;
+  }
+
+
+  //
+  QRCounters            *roleCounters  = &counters[role];
+  dispatch_semaphore_t   slot          = slots[role];
+  dispatch_queue_t       worker        = workers[role];
+  uint64_t               submittedAt   = mach_absolute_time();
+
+  OSAtomicIncrement64Barrier(&roleCounters->depth);
+  OSAtomicIncrement64Barrier(&roleCounters->submitted);
+
+  if (group)  { dispatch_group_enter(group); }
+
+  dispatch_async(feeders[role],
+  ^{
+    dispatch_semaphore_wait(slot, DISPATCH_TIME_FOREVER);
+
+    dispatch_async(worker,
+    ^{
+      uint64_t  startedAt  = mach_absolute_time();
+      int64_t   waited     = (int64_t)(startedAt - submittedAt);
+
+      OSAtomicIncrement64Barrier(&roleCounters->running);
+      OSAtomicAdd64Barrier(waited, &roleCounters->waitTotal);
+      qrUpdateMax(&roleCounters->waitMax, waited);
+
+      block();
+
+      int64_t  ran = (int64_t)(mach_absolute_time() - startedAt);
+
+      OSAtomicAdd64Barrier(ran, &roleCounters->runTotal);
+      qrUpdateMax(&roleCounters->runMax, ran);
+      OSAtomicDecrement64Barrier(&roleCounters->running);
+      OSAtomicIncrement64Barrier(&roleCounters->completed);
+      OSAtomicDecrement64Barrier(&roleCounters->depth);
+
+      dispatch_semaphore_signal(slot);
+
+      if (group)  { dispatch_group_leave(group); }
+    });
+  });
+
+} // async:group:block:
+
+
+
+//------------------- -o-
++ (NSString *) nameForRole: (QRRole)role
+{
+  if ((NSUInteger)role >= QRRoleCount)  { return nil; }
+
+  return @(roleConfig[role].name);
+}
+
+
+//------------------- -o-
++ (NSUInteger) concurrencyForRole: (QRRole)role
+{
+  if ((NSUInteger)role >= QRRoleCount)  { return 0; }
+
+  return concurrency[role];
+}
+
+
+
+//------------------- -o-
+// statsForRole:
+//
+// NB  Counters are read one at a time;  under load they may not agree
+//       exactly with one another.
+//
++ (QRStats) statsForRole: (QRRole)role
+{
+  QRStats  stats = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+  if ((NSUInteger)role >= QRRoleCount)  { return stats; }
+
+
+  //
+  QRCounters  *roleCounters = &counters[role];
+
+  stats.depth      = (NSUInteger) MAX(roleCounters->depth, 0);
+  stats.running    = (NSUInteger) MAX(roleCounters->running, 0);
+  stats.submitted  = (uint64_t)   roleCounters->submitted;
+  stats.completed  = (uint64_t)   roleCounters->completed;
+  stats.waitTotal  = qrSeconds(roleCounters->waitTotal);
+  stats.waitMax    = qrSeconds(roleCounters->waitMax);
+  stats.runTotal   = qrSeconds(roleCounters->runTotal);
+  stats.runMax     = qrSeconds(roleCounters->runMax);
+
+  return stats;
+}
+
+
+
+//------------------- -o-
+// statsDescription
+//
+// RETURN:  Stats of every role, keyed by role name;  for logs.
+//
++ (NSDictionary *) statsDescription
+{
+  NSMutableDictionary  *description = [[NSMutableDictionary alloc] initWithCapacity:QRRoleCount];
+
+  for (QRRole role = 0; role < QRRoleCount; role++)
+  {
+    QRStats  stats = [QueueRegistry statsForRole:role];
+
+    description[[QueueRegistry nameForRole:role]] =
+      DP_STRWFMT(@"depth %lu  running %lu/%lu  completed %llu  wait avg %.3f max %.3f  run avg %.3f max %.3f",
+                   (unsigned long)stats.depth, (unsigned long)stats.running, (unsigned long)concurrency[role],
+                   stats.completed,
+                   stats.completed ? stats.waitTotal / stats.completed : 0, stats.waitMax,
+                   stats.completed ? stats.runTotal  / stats.completed : 0, stats.runMax);
+  }
+
+  return description;
+}
+
+
+@end // @implementation QueueRegistry
+
@@ -0,0 +1,42 @@
+//
+// TableRowUpdates.h
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import "Danaprajna.h"
+
+
+
+
+@interface TableRowUpdates : NSObject
+//------------------------------------------------------------ -o-
+
+  // NB  Deleted and reloaded index paths address rows before the update;
+  //     inserted index paths address rows after the update.
+  // NB  Index paths are (section, row), as UITableView expects.
+  //
+  @property  (readonly, strong, nonatomic)  NSArray  *deletedIndexPaths;
+  @property  (readonly, strong, nonatomic)  NSArray  *insertedIndexPaths;
+  @property  (readonly, strong, nonatomic)  NSArray  *reloadedIndexPaths;
+
+
+  //
+  + (TableRowUpdates *) updatesFromKeys: (NSArray *)oldKeys
+                                 toKeys: (NSArray *)newKeys
+                            changedKeys: (NSSet *)changedKeys
+                              inSection: (NSInteger)section;
+
+  - (BOOL) isEmpty;
+
+#if DP_UIKIT
+  - (void) applyToTableView: (UITableView *)tableView
+           withRowAnimation: (UITableViewRowAnimation)animation;
+#endif
+
+@end
+
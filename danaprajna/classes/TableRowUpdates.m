@@ -0,0 +1,226 @@
+//
+// TableRowUpdates.m
+//
+// Compute minimal row batch updates between two orderings of unique keys.
+//
+// Keys present in both orderings stay in place if they belong to the
+// longest increasing subsequence of their old row numbers, taken in new
+// order.  All other surviving keys are moved by delete and insert.
+// Keys that stay in place and appear in changedKeys are reloaded.
+//
+// Time efficiency: O(N log N)
+//
+// Only applyToTableView:withRowAnimation: needs UIKit;  it is compiled
+// under DP_UIKIT.
+//
+//
+// CLASS DEPENDENCIES: Log
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import "TableRowUpdates.h"
+
+
+
+
+//------------------------------------------------------------ -o-
+@interface TableRowUpdates()
+
+  @property  (readwrite, strong, nonatomic)  NSArray  *deletedIndexPaths;
+  @property  (readwrite, strong, nonatomic)  NSArray  *insertedIndexPaths;
+  @property  (readwrite, strong, nonatomic)  NSArray  *reloadedIndexPaths;
+
+@end
+
+
+
+
+//------------------------------------------------------------ -o-
+// truIndexPath()
+//
+// NB  Same as +[NSIndexPath indexPathForRow:inSection:], without UIKit.
+//
+static NSIndexPath *truIndexPath(NSUInteger row, NSInteger section)
+{
+  NSUInteger  indexes[2] = { (NSUInteger) section, row };
+
+  return [NSIndexPath indexPathWithIndexes:indexes length:2];
+}
+
+
+
+
+//------------------------------------------------------------ -o--
+@implementation TableRowUpdates
+
+#pragma mark - Constructors.
+
+//----------------- -o-
+// updatesFromKeys:toKeys:changedKeys:inSection:
+//
+// ASSUME  Keys are unique within each of oldKeys and newKeys.
+//
++ (TableRowUpdates *) updatesFromKeys: (NSArray *)oldKeys
+                               toKeys: (NSArray *)newKeys
+                          changedKeys: (NSSet *)changedKeys
+                            inSection: (NSInteger)section
+{
+  TableRowUpdates  *updates   = [[TableRowUpdates alloc] init];
+
+  NSMutableArray   *deleted   = [[NSMutableArray alloc] init];
+  NSMutableArray   *inserted  = [[NSMutableArray alloc] init];
+  NSMutableArray   *reloaded  = [[NSMutableArray alloc] init];
+
+
+  //
+  NSMutableDictionary  *oldRowForKey = [[NSMutableDictionary alloc] initWithCapacity:[oldKeys count]];
+
+  [oldKeys enumerateObjectsUsingBlock:^(id key, NSUInteger row, BOOL *stop) {
+    [oldRowForKey setObject:@(row) forKey:key];
+  }];
+
+
+  // Survivors, in new order:  old row and new row of each.
+  //
+  NSUInteger   newCount   = [newKeys count];
+  NSUInteger  *oldRows    = (NSUInteger *) malloc(sizeof(NSUInteger) * (newCount + 1));
+  NSUInteger  *newRows    = (NSUInteger *) malloc(sizeof(NSUInteger) * (newCount + 1));
+  NSUInteger   survivors  = 0;
+
+  if (!oldRows || !newRows) {
+    DP_LOG_ERROR(@"Could not malloc() row buffers.");
+    free(oldRows);  free(newRows);
+    return nil;
+  }
+
+  NSMutableSet  *survivingKeys = [[NSMutableSet alloc] initWithCapacity:newCount];
+
+  for (NSUInteger row = 0; row < newCount; row++)
+  {
+    NSNumber  *oldRow = [oldRowForKey objectForKey:newKeys[row]];
+
+    if (!oldRow) {
+      [inserted addObject:truIndexPath(row, section)];
+      continue;
+    }
+
+    oldRows[survivors]  = [oldRow unsignedIntegerValue];
+    newRows[survivors]  = row;
+    survivors          += 1;
+
+    [survivingKeys addObject:newKeys[row]];
+  }
+
+  [oldKeys enumerateObjectsUsingBlock:^(id key, NSUInteger row, BOOL *stop) {
+    if (! [survivingKeys containsObject:key]) {
+      [deleted addObject:truIndexPath(row, section)];
+    }
+  }];
+
+
+  // Longest increasing subsequence of oldRows (patience sorting).
+  //   tails[k]  index into oldRows of smallest tail of a subsequence of length k+1;
+  //   parent[i] index of predecessor of i in its subsequence.
+  //
+  NSUInteger  *tails   = (NSUInteger *) malloc(sizeof(NSUInteger) * (survivors + 1));
+  NSInteger   *parent  = (NSInteger *)  malloc(sizeof(NSInteger)  * (survivors + 1));
+  BOOL        *inPlace = (BOOL *)       calloc(survivors + 1, sizeof(BOOL));
+  NSUInteger   length  = 0;
+
+  if (!tails || !parent || !inPlace) {
+    DP_LOG_ERROR(@"Could not malloc() subsequence buffers.");
+    free(oldRows);  free(newRows);  free(tails);  free(parent);  free(inPlace);
+    return nil;
+  }
+
+  for (NSUInteger i = 0; i < survivors; i++)
+  {
+    NSUInteger  lo = 0, hi = length;
+
+    while (lo < hi) {
+      NSUInteger  mid = (lo + hi) / 2;
+      if (oldRows[tails[mid]] < oldRows[i])  { lo = mid + 1; } else { hi = mid; }
+    }
+
+    parent[i]  = (lo > 0) ? (NSInteger) tails[lo - 1] : -1;
+    tails[lo]  = i;
+
+    if (lo == length)  { length += 1; }
+  }
+
+  for (NSInteger i = (length > 0) ? (NSInteger) tails[length - 1] : -1; i >= 0; i = parent[i]) {
+    inPlace[i] = YES;
+  }
+
+
+  //
+  for (NSUInteger i = 0; i < survivors; i++)
+  {
+    NSIndexPath  *oldIndexPath = truIndexPath(oldRows[i], section);
+
+    if (!inPlace[i]) {
+      [deleted  addObject:oldIndexPath];
+      [inserted addObject:truIndexPath(newRows[i], section)];
+
+    } else if ([changedKeys containsObject:newKeys[newRows[i]]]) {
+      [reloaded addObject:oldIndexPath];
+    }
+  }
+
+  free(oldRows);  free(newRows);  free(tails);  free(parent);  free(inPlace);
+
+
+  //
+  updates.deletedIndexPaths   = deleted;
+  updates.insertedIndexPaths  = inserted;
+  updates.reloadedIndexPaths  = reloaded;
+
+  return updates;
+
+} // updatesFromKeys:toKeys:changedKeys:inSection:
+
+
+
+
+//------------------------------------------------------------ -o--
+#pragma mark - Methods.
+
+//----------------- -o-
+- (BOOL) isEmpty
+{
+  return    ([self.deletedIndexPaths count] <= 0)
+         && ([self.insertedIndexPaths count] <= 0)
+         && ([self.reloadedIndexPaths count] <= 0);
+}
+
+
+
+#if DP_UIKIT
+
+//----------------- -o-
+// applyToTableView:withRowAnimation:
+//
+// ASSUME  Data source already reflects newKeys when this is called.
+//
+- (void) applyToTableView: (UITableView *)tableView
+         withRowAnimation: (UITableViewRowAnimation)animation
+{
+  if ([self isEmpty])  { return; }
+
+  [tableView beginUpdates];
+  [tableView deleteRowsAtIndexPaths:self.deletedIndexPaths   withRowAnimation:animation];
+  [tableView insertRowsAtIndexPaths:self.insertedIndexPaths  withRowAnimation:animation];
+  [tableView reloadRowsAtIndexPaths:self.reloadedIndexPaths  withRowAnimation:animation];
+  [tableView endUpdates];
+}
+
+#endif
+
+
+@end // @implementation TableRowUpdates
+
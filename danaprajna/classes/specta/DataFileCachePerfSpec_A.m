@@ -0,0 +1,251 @@
+//
+// DataFileCachePerfSpec_A.m
+//
+// Measure DataFileCache operations at several cache sizes, against
+// baselines.  See SpectaPerf.h for baselines and tolerances.
+//
+//
+// CLASS DEPENDENCIES:  SpectaPerf, DataFileCache, DataFileCacheMemoryStore, TestSandbox
+//
+
+#import "Specta.h"
+
+#define EXP_SHORTHAND
+#import "Expecta.h"
+
+
+#import "SpectaPerf.h"
+#import "TestSandbox.h"
+
+#import "DataFileCache.h"
+#import "DataFileCacheMemoryStore.h"
+
+
+
+SpecBegin(DataFileCachePerf_A)
+
+
+//------------------------------------------------------------------------------------- -o-
+#define  FILESIZE         (16 * 1024)
+
+#define  CACHESIZES       (@[ @(FILESIZE * 16), @(FILESIZE * 128), @(FILESIZE * 1024) ])
+#define  ITERATIONS       16
+
+#define  OPENCOUNT        4096
+#define  BATCHCOUNT       64
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"DataFileCache performance",
+^{
+  DPPerfOptions  options = DP_PERF_OPTIONS_DEFAULT;
+
+  options.iterations = ITERATIONS;
+
+  __block  TestSandbox  *sandbox;
+
+
+  //-------------------------------------------------- -o-
+  beforeAll(^{
+    sandbox = [[TestSandbox alloc] initWithRootPath:@"~/testSandboxPerf/" testOnDevice:YES];
+  });
+
+  afterAll(^{
+    [sandbox removeSandbox];
+    sandbox = nil;
+  });
+
+
+  //------------------------ -o-
+  itMeasuresDataFileCache(DPPerfCacheSave,       CACHESIZES, FILESIZE, options);
+  itMeasuresDataFileCache(DPPerfCacheLookup,     CACHESIZES, FILESIZE, options);
+  itMeasuresDataFileCache(DPPerfCacheRead,       CACHESIZES, FILESIZE, options);
+  itMeasuresDataFileCache(DPPerfCacheDelete,     CACHESIZES, FILESIZE, options);
+  itMeasuresDataFileCache(DPPerfCacheMakeSpace,  CACHESIZES, FILESIZE, options);
+  itMeasuresDataFileCache(DPPerfCacheClear,      CACHESIZES, FILESIZE, options);
+  itMeasuresDataFileCache(DPPerfCacheTouch,      CACHESIZES, FILESIZE, options);
+
+  itMeasuresDataFileCache(DPPerfCacheSaveBatch,    CACHESIZES, FILESIZE, options);
+  itMeasuresDataFileCache(DPPerfCacheDeleteBatch,  CACHESIZES, FILESIZE, options);
+  itMeasuresDataFileCache(DPPerfCacheTouchBatch,   CACHESIZES, FILESIZE, options);
+
+
+
+  //------------------------ -o-
+  it(DP_STRWFMT(@"saves %d files as one batch, with one property list write", BATCHCOUNT),
+  ^{
+    NSURL  *cacheURL = DP_URL_PLUSDIR(sandbox.workspaceTmpURL, @"DataFileCachePerfBatch");
+
+    DataFileCache        *cache     = [[DataFileCache alloc] initCacheDirectoryWithURL:cacheURL sizeInBytes:FILESIZE * (BATCHCOUNT + 1)];
+    NSData               *fileData  = [NSMutableData dataWithLength:FILESIZE];
+    NSMutableDictionary  *files     = [[NSMutableDictionary alloc] init];
+
+    for (NSUInteger k = 0; k < BATCHCOUNT; k++) {
+      [files setObject:fileData forKey:DP_STRWFMT(@"file%lu", (unsigned long)k)];
+    }
+
+    DPPerfOptions  compared = DP_PERF_OPTIONS_DEFAULT;
+
+    compared.runs = 7;
+
+    DPPerfSummary  single  = [SpectaPerf measure: compared
+                                            setUp: ^{ [cache clearCache]; }
+                                            block: ^(NSUInteger iteration) {
+                                                     for (NSString *fileName in files) {
+                                                       [cache saveFile:fileName withData:fileData];
+                                                     }
+                                                   }];
+
+    DPPerfSummary  batch   = [SpectaPerf measure: compared
+                                            setUp: ^{ [cache clearCache]; }
+                                            block: ^(NSUInteger iteration) { [cache saveFiles:files]; }];
+
+    DP_LOG_INFO(@"BENCHMARK  DataFileCache save of %d files:  one at a time %.6fs, one batch %.6fs  (%.1fx)",
+                  BATCHCOUNT, single.median, batch.median, single.median / MAX(batch.median, 1e-9));
+
+    for (NSString *fileName in files) {
+      expect([cache isFileCached:fileName]).to.beTruthy();
+    }
+
+    expect([SpectaPerf compareSummary: batch
+                    withBaselineNamed: DP_STRWFMT(@"DataFileCachePerf_A saveFiles, %d files", BATCHCOUNT)
+                              options: compared]).to.beNil();
+
+    [Zed removeItemForURL:cacheURL];
+
+
+    // Store operations, not time:  one at a time writes the property list
+    //   once per file, the batch once in all.
+    //
+    DataFileCacheMemoryStore  *store        = [[DataFileCacheMemoryStore alloc] init];
+    DataFileCache             *counted      = [[DataFileCache alloc] initWithStore:store sizeInBytes:FILESIZE * (BATCHCOUNT + 1)];
+    unsigned long long         plistWrites  = store.propertyListWrites;
+    unsigned long long         fileWrites   = store.fileWrites;
+
+    for (NSString *fileName in files) {
+      [counted saveFile:fileName withData:fileData];
+    }
+
+    expect(store.fileWrites - fileWrites).to.equal(BATCHCOUNT);
+    expect(store.propertyListWrites - plistWrites).to.equal(BATCHCOUNT);
+
+    [counted clearCache];
+
+    plistWrites  = store.propertyListWrites;
+    fileWrites   = store.fileWrites;
+
+    expect([counted saveFiles:files]).to.beTruthy();
+
+    expect(store.fileWrites - fileWrites).to.equal(BATCHCOUNT);
+    expect(store.propertyListWrites - plistWrites).to.equal(1);
+  });
+
+
+
+  //------------------------ -o-
+  __block  NSURL               *openURL    = nil;
+  __block  unsigned long long   openBytes  = 0;
+
+  DPPerfOptions  openOptions = DP_PERF_OPTIONS_DEFAULT;
+
+  openOptions.runs = 7;
+
+  itMeasures(DP_STRWFMT(@"DataFileCache open, %d files", OPENCOUNT), openOptions,
+    ^{
+      if (openURL)  { return; }
+
+      SandboxAssetSpec  spec = SANDBOX_ASSETSPEC_DEFAULT;
+
+      spec.count        = OPENCOUNT;
+      spec.sizeInBytes  = FILESIZE;
+      spec.content      = SandboxContentSparse;
+
+      openURL    = DP_URL_PLUSFILE(sandbox.workspaceTmpURL, @"openCache");
+      openBytes  = [sandbox createDataFileCacheAtURL:openURL spec:spec];
+    },
+    ^(NSUInteger iteration) {
+      (void) [[DataFileCache alloc] initCacheDirectoryWithURL:openURL sizeInBytes:(long long)openBytes];
+    });
+
+
+
+  //------------------------ -o-
+  __block  NSMutableArray  *scratch;
+
+  itMeasures(@"summarizes a measured block", options,
+    ^{
+      scratch = [[NSMutableArray alloc] init];
+    },
+    ^(NSUInteger iteration) {
+      [scratch addObject:[NSString stringWithFormat:@"%lu", (unsigned long)iteration]];
+    });
+
+
+  it(@"counts allocations and orders its statistics",
+  ^{
+    DPPerfOptions  counted = DP_PERF_OPTIONS_DEFAULT;
+
+    counted.runs        = 9;
+    counted.iterations  = 10;
+
+    DPPerfSummary  summary = [SpectaPerf measure:counted setUp:nil block:^(NSUInteger iteration) {
+                                (void) [[NSObject alloc] init];
+                                (void) [[NSObject alloc] init];
+                              }];
+
+    expect(summary.runs).to.equal(9);
+    expect(summary.allocations).to.beGreaterThanOrEqualTo(2);
+    expect(summary.min).to.beLessThanOrEqualTo(summary.median);
+    expect(summary.median).to.beLessThanOrEqualTo(summary.p90);
+    expect(summary.p90).to.beLessThanOrEqualTo(summary.max);
+    expect(summary.mad).to.beGreaterThanOrEqualTo(0);
+  });
+
+
+  it(@"records a missing baseline, then fails regressions against it",
+  ^{
+    const char      *names[]    = { DP_PERF_BASELINE_DIR_ENV, DP_PERF_RECORD_ENV, DP_PERF_TOLERANCE_ENV };
+    NSUInteger       nameCount  = sizeof(names) / sizeof(names[0]);
+    NSMutableArray  *saved      = [[NSMutableArray alloc] init];          // Of NSString  -OR-  NSNull if unset.
+    NSString        *dirPath    = [NSTemporaryDirectory() stringByAppendingPathComponent:@"DataFileCachePerfSpec"];
+
+    for (NSUInteger k = 0; k < nameCount; k++) {
+      const char  *value = getenv(names[k]);
+
+      [saved addObject:value ? [NSString stringWithUTF8String:value] : [NSNull null]];
+      unsetenv(names[k]);
+    }
+
+    [[NSFileManager defaultManager] removeItemAtPath:dirPath error:nil];
+    setenv(DP_PERF_BASELINE_DIR_ENV, [dirPath fileSystemRepresentation], 1);
+
+    DPPerfOptions  defaults  = DP_PERF_OPTIONS_DEFAULT;
+    DPPerfSummary  summary   = { 15, 0.010, 0.001, 0.010, 0.009, 0.011, 0.012, 0.012, 4 };
+    DPPerfSummary  slower    = summary;
+    DPPerfSummary  fatter    = summary;
+
+    slower.median       = 0.020;
+    fatter.allocations  = 8;
+
+    expect([SpectaPerf compareSummary:summary withBaselineNamed:@"spec" options:defaults]).to.beNil();
+    expect([SpectaPerf compareSummary:summary withBaselineNamed:@"spec" options:defaults]).to.beNil();
+    expect([SpectaPerf compareSummary:slower withBaselineNamed:@"spec" options:defaults]).to.contain(@"median");
+    expect([SpectaPerf compareSummary:fatter withBaselineNamed:@"spec" options:defaults]).to.contain(@"allocations");
+
+    for (NSUInteger k = 0; k < nameCount; k++) {
+      if ([saved[k] isKindOfClass:[NSString class]]) {
+        setenv(names[k], [saved[k] UTF8String], 1);
+      } else {
+        unsetenv(names[k]);
+      }
+    }
+    [[NSFileManager defaultManager] removeItemAtPath:dirPath error:nil];
+  });
+
+});
+
+
+SpecEnd
+
@@ -0,0 +1,240 @@
+//
+// DataFileCacheSimulatorSpec_A.m
+//
+// DataFileCache in memory, on a virtual clock;  trace replay.
+//
+//
+// CLASS DEPENDENCIES:  DataFileCacheSimulator, DataFileCache, DataFileCacheMemoryStore
+//
+
+#import "Specta.h"
+
+#define EXP_SHORTHAND
+#import "Expecta.h"
+
+
+#import "DataFileCacheSimulator.h"
+
+
+
+SpecBegin(DataFileCacheSimulator_A)
+
+
+//------------------------------------------------------------------------------------- -o-
+#define  FILESIZE       1000
+
+#define  TRACELENGTH    20000
+#define  TRACEFILES     2000
+#define  TRACECACHE     (200 * 1024)
+
+
+// Skewed toward low numbered files, so some accesses hit.
+//
+static NSURL *temporaryTraceURL(NSString *name, NSUInteger length)
+{
+  NSURL            *traceURL  = [[NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES] URLByAppendingPathComponent:name];
+  NSMutableString  *trace     = [[NSMutableString alloc] initWithString:@"# seconds fileName sizeInBytes\n"];
+  uint32_t          state     = 193;
+
+  for (NSUInteger i = 0; i < length; i++)
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    uint32_t  file = (state % TRACEFILES) * (state % TRACEFILES) / TRACEFILES;
+
+    [trace appendFormat:@"%lu.5\tthumb-%u\t%u\n", (unsigned long)i, file, 512 + (file * 37) % 4096];
+  }
+
+  [trace writeToURL:traceURL atomically:YES encoding:NSUTF8StringEncoding error:nil];
+
+  return traceURL;
+}
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"DataFileCache in a memory store",
+^{
+  __block  DataFileCacheMemoryStore  *store;
+  __block  NSTimeInterval             now;
+  __block  NSData                    *fileData;
+
+  DFCClockBlock  clock = ^NSTimeInterval{ return now; };
+
+
+  //-------------------------------------------------- -o-
+  beforeEach(^{
+    store     = [[DataFileCacheMemoryStore alloc] init];
+    now       = 1000;
+    fileData  = [NSMutableData dataWithLength:FILESIZE];
+  });
+
+
+
+  //------------------------ -o-
+  it(@"evicts by the virtual clock, and keeps that order when opened again",
+  ^{
+    DataFileCache  *dfc = [[DataFileCache alloc] initWithStore:store sizeInBytes:3 * FILESIZE];
+
+    dfc.clock = clock;
+
+    for (NSString *fileName in @[ @"a", @"b", @"c" ]) {
+      expect([dfc saveFile:fileName withData:fileData]).to.beTruthy();
+      now += 1;
+    }
+
+    expect([dfc touchFiles:@[ @"a" ]]).to.beTruthy();
+    now += 1;
+
+    expect([dfc saveFile:@"d" withData:fileData]).to.beTruthy();
+    now += 1;
+
+    expect([dfc isFileCached:@"b"]).to.beFalsy();
+    expect([[dfc cachedFileURL:@"d"] scheme]).to.equal(DFC_MEMORYSTORE_URL_SCHEME);
+    expect(dfc.dataDirURL).to.beNil();
+
+
+    //
+    DataFileCache  *reopened = [[DataFileCache alloc] initWithStore:store sizeInBytes:3 * FILESIZE];
+
+    reopened.clock = clock;
+
+    expect([reopened currentFreeBytes]).to.equal(0);
+    expect([reopened saveFile:@"e" withData:fileData]).to.beTruthy();
+
+    expect([reopened isFileCached:@"c"]).to.beFalsy();
+    expect([reopened isFileCached:@"a"]).to.beTruthy();
+    expect([reopened isFileCached:@"d"]).to.beTruthy();
+    expect(store.fileWrites).to.equal(5);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"evicts in the order saved when every timestamp is the same",
+  ^{
+    DataFileCache  *dfc = [[DataFileCache alloc] initWithStore:store sizeInBytes:3 * FILESIZE];
+
+    dfc.clock = clock;
+
+    for (NSString *fileName in @[ @"z", @"y", @"x", @"w" ]) {
+      [dfc saveFile:fileName withData:fileData];
+    }
+
+    expect([dfc isFileCached:@"z"]).to.beFalsy();
+    expect([dfc isFileCached:@"y"]).to.beTruthy();
+    expect([dfc isFileCached:@"w"]).to.beTruthy();
+  });
+
+
+
+
+  //------------------------ -o-
+  it(@"imports a snapshot before cached files of the same timestamp, keeping their order",
+  ^{
+    NSURL          *snapshotURL  = [[NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES]
+                                     URLByAppendingPathComponent:@"DataFileCacheSimulatorSpec.dfcsnapshot"];
+    DataFileCache  *source       = [[DataFileCache alloc] initWithStore:[[DataFileCacheMemoryStore alloc] init] sizeInBytes:4 * FILESIZE];
+
+    source.clock = clock;
+
+    [source saveFile:@"s" withData:fileData];
+    expect([source exportSnapshotToURL:snapshotURL]).to.beTruthy();
+
+
+    //
+    DataFileCache  *dfc = [[DataFileCache alloc] initWithStore:store sizeInBytes:3 * FILESIZE];
+
+    dfc.clock = clock;
+
+    for (NSString *fileName in @[ @"z", @"a" ]) {
+      [dfc saveFile:fileName withData:fileData];
+    }
+
+    expect([dfc importSnapshotAtURL:snapshotURL]).to.equal(1);
+
+    [dfc saveFile:@"b" withData:fileData];
+    expect([dfc isFileCached:@"s"]).to.beFalsy();
+
+    [dfc saveFile:@"c" withData:fileData];
+    expect([dfc isFileCached:@"z"]).to.beFalsy();
+    expect([dfc isFileCached:@"a"]).to.beTruthy();
+
+    [[NSFileManager defaultManager] removeItemAtURL:snapshotURL error:nil];
+  });
+
+});
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"DataFileCacheSimulator",
+^{
+  //------------------------ -o-
+  it(@"replays a trace with the same evictions every time",
+  ^{
+    NSURL  *traceURL = temporaryTraceURL(@"DataFileCacheSimulatorSpec.trace", TRACELENGTH);
+
+    DataFileCacheSimulator  *first   = [[DataFileCacheSimulator alloc] initWithCacheSize:TRACECACHE];
+    DataFileCacheSimulator  *second  = [[DataFileCacheSimulator alloc] initWithCacheSize:TRACECACHE];
+
+    NSTimeInterval  start = [NSDate timeIntervalSinceReferenceDate];
+
+    expect([first replayTraceAtURL:traceURL]).to.beTruthy();
+
+    NSTimeInterval  elapsed = [NSDate timeIntervalSinceReferenceDate] - start;
+
+    expect([second replayTraceAtURL:traceURL]).to.beTruthy();
+
+    DP_LOG_INFO(@"BENCHMARK  DataFileCacheSimulator replay of %d accesses:  %.3f s\n%@",
+                  TRACELENGTH, elapsed, [DataFileCacheSimulator descriptionOfStats:first.stats]);
+
+
+    //
+    DFCSimulationStats  a = first.stats;
+    DFCSimulationStats  b = second.stats;
+
+    expect(a.accesses).to.equal(TRACELENGTH);
+    expect(a.hits + a.misses).to.equal(a.accesses);
+    expect(a.hits).to.beGreaterThan(0);
+    expect(a.evictions).to.beGreaterThan(0);
+    expect(a.failures).to.equal(0);
+
+    expect(b.hits).to.equal(a.hits);
+    expect(b.bytesHit).to.equal(a.bytesHit);
+    expect(b.evictions).to.equal(a.evictions);
+    expect(b.evictionDigest).to.equal(a.evictionDigest);
+
+    expect(first.now).to.equal(TRACELENGTH - 0.5);
+    expect([first.cache currentFreeBytes]).to.beLessThan(4096 + 512);
+
+    [[NSFileManager defaultManager] removeItemAtURL:traceURL error:nil];
+  });
+
+
+
+  //------------------------ -o-
+  it(@"stops at the first malformed line",
+  ^{
+    NSURL  *traceURL = [[NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES]
+                         URLByAppendingPathComponent:@"DataFileCacheSimulatorSpec.malformed"];
+
+    [@"1 a 10\n\n2 b\n3 c 10\n" writeToURL:traceURL atomically:YES encoding:NSUTF8StringEncoding error:nil];
+
+    DataFileCacheSimulator  *simulator = [[DataFileCacheSimulator alloc] initWithCacheSize:TRACECACHE];
+
+    expect([simulator replayTraceAtURL:traceURL]).to.beFalsy();
+    expect(simulator.stats.accesses).to.equal(1);
+
+    [[NSFileManager defaultManager] removeItemAtURL:traceURL error:nil];
+  });
+
+});
+
+
+SpecEnd
+
@@ -425,6 +425,331 @@ describe(@"DataFileCache",
 
   }); // context -- files in SMALL cache
 
+
+
+
+  //-------------------------------------------------- -o-
+  // Asynchronous operations--
+  //   . operations on one file take effect in the order called, without waiting between them
+  //   . completions run in the order their operations finished
+  //   . lookupFiles: answers for many files at once
+  //   . notifications are posted before completions run
+  //
+  context(@"#3 :: Asynchronous operations", 
+  ^{
+    __block  DataFileCache         *dfc;
+    __block  dispatch_semaphore_t   done;
+
+
+    //------------------------ -o-
+    beforeAll(^{ 
+      dfc   = [[DataFileCache alloc] initCacheDirectoryWithURL: DP_URL_PLUSDIR(sandbox.workspaceURL, @"cache-async")
+                                                  sizeInBytes: CACHESIZE_LARGE];
+      done  = dispatch_semaphore_create(0);
+    });
+
+
+
+    //------------------------ -o-
+    it(@"orders operations on one file as called", 
+    ^{
+      NSString          *smallName    = assetDict[SMALL][CACHENAME];
+      NSString          *mediumName   = assetDict[MEDIUM][CACHENAME];
+
+      __block  NSData   *readData     = nil;
+      __block  NSURL    *deletedURL   = [NSURL URLWithString:@"file:///"];
+      __block  NSSet    *cachedNames  = nil;
+
+      [dfc saveFile:smallName withData:smallData completion:nil];
+      [dfc readFile:smallName completion:^(NSData *fileData, NSURL *fileURL, NSError *error) { readData = fileData; }];
+
+      [dfc saveFile:mediumName withData:mediumData completion:nil];
+      [dfc deleteFile:mediumName completion:nil];
+      [dfc lookupFile:mediumName completion:^(NSURL *fileURL) {
+                                               deletedURL = fileURL;
+                                               dispatch_semaphore_signal(done);
+                                             }];
+
+      [dfc lookupFiles: @[ smallName, mediumName, assetThatDoesntExist ]
+            completion: ^(NSSet *cachedFileNames) {
+                          cachedNames = cachedFileNames;
+                          dispatch_semaphore_signal(done);
+                        }];
+
+      dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+      dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+
+      expect(readData).to.equal(smallData);
+      expect(deletedURL).to.beNil();
+      expect(cachedNames).to.equal([NSSet setWithObject:smallName]);
+      expect([dfc isFileCached:smallName]).to.beTruthy();
+      expect([dfc isFileCached:mediumName]).to.beFalsy();
+    });
+
+
+
+    //------------------------ -o-
+    it(@"posts notifications before completions", 
+    ^{
+      __block  NSUInteger  cleared   = 0;
+      __block  NSUInteger  observed  = 0;
+
+      id  observer = [[NSNotificationCenter defaultCenter] addObserverForName: DFC_NOTIFICATION_CLEARED
+                                                                       object: dfc
+                                                                        queue: nil
+                                                                   usingBlock: ^(NSNotification *note) { cleared += 1; }];
+
+      [dfc clearCacheWithCompletion:^(BOOL success) {
+        observed = success ? cleared : 0;
+        dispatch_semaphore_signal(done);
+      }];
+
+      dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+      [[NSNotificationCenter defaultCenter] removeObserver:observer];
+
+      expect(observed).to.equal(1);
+      expect([dfc currentFreeBytes]).to.equal(CACHESIZE_LARGE);
+      expect([Zed directoryListForURL:[dfc dataDirURL]]).to.haveCountOf(0);
+    });
+
+  }); // context -- asynchronous operations
+
+
+
+
+  //-------------------------------------------------- -o-
+  // Batches--
+  //   . a batch that cannot fit changes nothing
+  //   . files of the batch already cached are spared from eviction
+  //   . touching a file that is not cached fails the whole batch
+  //   . deleting a batch frees all of its space at once
+  //
+  context(@"#4 :: Batches", 
+  ^{
+    __block  DataFileCache  *dfc;
+
+    __block  NSString  *smallName,
+                       *mediumName,
+                       *largeName;
+
+
+    //------------------------ -o-
+    beforeAll(^{ 
+      dfc  = [[DataFileCache alloc] initCacheDirectoryWithURL: DP_URL_PLUSDIR(sandbox.workspaceURL, @"cache-batch")
+                                                 sizeInBytes: CACHESIZE_SMALL];
+
+      smallName   = assetDict[SMALL][CACHENAME];
+      mediumName  = assetDict[MEDIUM][CACHENAME];
+      largeName   = assetDict[LARGE][CACHENAME];
+    });
+
+
+
+    //------------------------ -o-
+    it(@"save all of a batch, or none of it", 
+    ^{
+      BOOL  rval = [dfc saveFiles:@{ smallName : smallData, mediumName : mediumData, largeName : largeData }];
+
+      expect(rval).to.beFalsy();
+      expect([dfc currentFreeBytes]).to.equal(CACHESIZE_SMALL);
+      expect([Zed directoryListForURL:[dfc dataDirURL]]).to.haveCountOf(0);
+
+      rval = [dfc saveFiles:@{ smallName : smallData, mediumName : mediumData }];
+
+      expect(rval).to.beTruthy();
+      expect([dfc isFileCached:smallName]).to.beTruthy();
+      expect([dfc isFileCached:mediumName]).to.beTruthy();
+      expect([dfc currentFreeBytes]).to.beLessThanOrEqualTo(CACHESIZE_SMALL - (FILESIZE_SMALL + FILESIZE_MEDIUM));
+    });
+
+
+
+    //------------------------ -o-
+    it(@"spare files of the batch from its own evictions", 
+    ^{
+      BOOL  rval = [dfc saveFiles:@{ smallName : smallData, largeName : largeData }];
+
+      expect(rval).to.beTruthy();
+      expect([dfc isFileCached:smallName]).to.beTruthy();
+      expect([dfc isFileCached:largeName]).to.beTruthy();
+      expect([dfc isFileCached:mediumName]).to.beFalsy();
+      expect([Zed directoryListForURL:[dfc dataDirURL]]).to.haveCountOf(2);
+    });
+
+
+
+    //------------------------ -o-
+    it(@"touch only files that are all cached", 
+    ^{
+      expect([dfc touchFiles:@[ smallName, mediumName ]]).to.beFalsy();
+      expect([dfc touchFiles:@[ largeName, smallName ]]).to.beTruthy();
+      expect([dfc touchFiles:@[]]).to.beTruthy();
+    });
+
+
+
+    //------------------------ -o-
+    it(@"delete a batch, ignoring files not cached", 
+    ^{
+      expect([dfc deleteFiles:@[ smallName, largeName, assetThatDoesntExist ]]).to.beTruthy();
+
+      expect([dfc isFileCached:smallName]).to.beFalsy();
+      expect([dfc isFileCached:largeName]).to.beFalsy();
+      expect([dfc currentFreeBytes]).to.equal(CACHESIZE_SMALL);
+      expect([Zed directoryListForURL:[dfc dataDirURL]]).to.haveCountOf(0);
+      expect([[NSFileManager defaultManager] fileExistsAtPath:[DP_URL_PLUSDIR([dfc cacheDirURL], DFC_CACHEDIR_TRASHDIR_NAME) path]]).to.beFalsy();
+    });
+
+  }); // context -- batches
+
+
+
+
+  //-------------------------------------------------- -o-
+  // Snapshots--
+  //   . export keeps recency order and sizes
+  //   . import at open time warms only a cache that opens empty
+  //   . live import fills free space, most recent first, and evicts nothing
+  //   . a malformed snapshot is rejected whole
+  //
+  context(@"#5 :: Snapshots", 
+  ^{
+    __block  NSURL           *snapshotURL;
+    __block  NSString        *smallName,
+                             *mediumName,
+                             *largeName;
+    __block  NSTimeInterval   now;
+
+    DFCClockBlock  clock = ^NSTimeInterval{ now += 1;  return now; };
+
+
+    //------------------------ -o-
+    beforeAll(^{ 
+      snapshotURL  = DP_URL_PLUSFILE(sandbox.workspaceURL, @"cache.dfcsnapshot");
+      now          = 1000;
+
+      smallName   = assetDict[SMALL][CACHENAME];
+      mediumName  = assetDict[MEDIUM][CACHENAME];
+      largeName   = assetDict[LARGE][CACHENAME];
+    });
+
+
+
+    //------------------------ -o-
+    it(@"export entries, sizes and recency order", 
+    ^{
+      DataFileCache  *dfc = [[DataFileCache alloc] initCacheDirectoryWithURL: DP_URL_PLUSDIR(sandbox.workspaceURL, @"cache-snapshot")
+                                                                 sizeInBytes: CACHESIZE_SMALL];
+      dfc.clock = clock;
+
+      expect([dfc saveFile:mediumName withData:mediumData]).to.beTruthy();
+      expect([dfc saveFile:smallName withData:smallData]).to.beTruthy();
+      expect([dfc touchFiles:@[ mediumName ]]).to.beTruthy();
+
+      expect([dfc exportSnapshotToURL:snapshotURL]).to.beTruthy();
+
+
+      //
+      NSDictionary  *snapshot  = [NSPropertyListSerialization propertyListWithData: [NSData dataWithContentsOfURL:snapshotURL]
+                                                                           options: NSPropertyListImmutable
+                                                                            format: NULL
+                                                                             error: nil ];
+      NSArray       *entries   = snapshot[DFC_SNAPSHOT_ENTRIES_KEY];
+
+      expect(snapshot[DFC_SNAPSHOT_VERSION_KEY]).to.equal(DFC_SNAPSHOT_VERSION);
+      expect(entries).to.haveCountOf(2);
+      expect(entries[0][DFC_SNAPSHOT_FILENAME_KEY]).to.equal(smallName);
+      expect(entries[1][DFC_SNAPSHOT_FILENAME_KEY]).to.equal(mediumName);
+      expect(entries[1][DFC_SNAPSHOT_SIZE_KEY]).to.equal(FILESIZE_MEDIUM);
+      expect(entries[1][DFC_SNAPSHOT_DATA_KEY]).to.equal(mediumData);
+    });
+
+
+
+    //------------------------ -o-
+    it(@"import at open time, only into an empty cache", 
+    ^{
+      NSURL          *warmURL  = DP_URL_PLUSDIR(sandbox.workspaceURL, @"cache-snapshot-warm");
+      DataFileCache  *dfc      = [[DataFileCache alloc] initCacheDirectoryWithURL: warmURL
+                                                                      sizeInBytes: CACHESIZE_SMALL
+                                                                      snapshotURL: snapshotURL];
+
+      expect([dfc isFileCached:smallName]).to.beTruthy();
+      expect([dfc isFileCached:mediumName]).to.beTruthy();
+      expect([NSData dataWithContentsOfURL:[dfc cachedFileURL:smallName]]).to.equal(smallData);
+      expect([dfc currentFreeBytes]).to.beLessThanOrEqualTo(CACHESIZE_SMALL - (FILESIZE_SMALL + FILESIZE_MEDIUM));
+
+      // Recency came with the snapshot:  small is evicted first.
+      //
+      expect([dfc saveFile:largeName withData:largeData]).to.beTruthy();
+      expect([dfc isFileCached:smallName]).to.beFalsy();
+      expect([dfc isFileCached:mediumName]).to.beTruthy();
+
+      dfc = [[DataFileCache alloc] initCacheDirectoryWithURL: warmURL
+                                                 sizeInBytes: CACHESIZE_SMALL
+                                                 snapshotURL: snapshotURL];
+
+      expect([dfc isFileCached:smallName]).to.beFalsy();
+      expect([dfc isFileCached:largeName]).to.beTruthy();
+    });
+
+
+
+    //------------------------ -o-
+    it(@"import live, into free space, without evicting", 
+    ^{
+      DataFileCache  *dfc = [[DataFileCache alloc] initCacheDirectoryWithURL: DP_URL_PLUSDIR(sandbox.workspaceURL, @"cache-snapshot-live")
+                                                                 sizeInBytes: CACHESIZE_SMALL];
+
+      expect([dfc saveFile:largeName withData:largeData]).to.beTruthy();
+
+      expect([dfc importSnapshotAtURL:snapshotURL]).to.equal(1);
+      expect([dfc isFileCached:largeName]).to.beTruthy();
+      expect([dfc isFileCached:mediumName]).to.beTruthy();
+      expect([dfc isFileCached:smallName]).to.beFalsy();
+
+      expect([dfc importSnapshotAtURL:snapshotURL]).to.equal(0);
+      expect([Zed directoryListForURL:[dfc dataDirURL]]).to.haveCountOf(2);
+    });
+
+
+
+    //------------------------ -o-
+    it(@"reject a malformed snapshot whole", 
+    ^{
+      DataFileCache  *dfc = [[DataFileCache alloc] initCacheDirectoryWithURL: DP_URL_PLUSDIR(sandbox.workspaceURL, @"cache-snapshot-bad")
+                                                                 sizeInBytes: CACHESIZE_LARGE];
+
+      NSURL  *badURL = DP_URL_PLUSFILE(sandbox.workspaceURL, @"bad.dfcsnapshot");
+
+      NSArray  *corruptions = @[ ^(NSMutableDictionary *snapshot) { snapshot[DFC_SNAPSHOT_ENTRIES_KEY][1][DFC_SNAPSHOT_SIZE_KEY] = @(FILESIZE_SMALL); },
+                                 ^(NSMutableDictionary *snapshot) { snapshot[DFC_SNAPSHOT_ENTRIES_KEY][1][DFC_SNAPSHOT_FILENAME_KEY] = @"../escaped.bin"; },
+                                 ^(NSMutableDictionary *snapshot) { snapshot[DFC_SNAPSHOT_ENTRIES_KEY][1][DFC_SNAPSHOT_FILENAME_KEY] = smallName; },
+                                 ^(NSMutableDictionary *snapshot) { snapshot[DFC_SNAPSHOT_VERSION_KEY] = @(DFC_SNAPSHOT_VERSION + 1); } ];
+
+      for (void (^corrupt)(NSMutableDictionary *) in corruptions)
+      {
+        NSMutableDictionary  *snapshot = [NSPropertyListSerialization propertyListWithData: [NSData dataWithContentsOfURL:snapshotURL]
+                                                                                   options: NSPropertyListMutableContainers
+                                                                                    format: NULL
+                                                                                     error: nil ];
+        corrupt(snapshot);
+
+        [[NSPropertyListSerialization dataWithPropertyList: snapshot
+                                                    format: NSPropertyListBinaryFormat_v1_0
+                                                   options: 0
+                                                     error: nil ] writeToURL:badURL atomically:YES];
+
+        expect([dfc importSnapshotAtURL:badURL]).to.equal(-1);
+        expect([dfc currentFreeBytes]).to.equal(CACHESIZE_LARGE);
+        expect([Zed directoryListForURL:[dfc dataDirURL]]).to.haveCountOf(0);
+      }
+
+      expect([dfc importSnapshotAtURL:snapshotURL]).to.equal(2);
+    });
+
+  }); // context -- snapshots
+
 }); // describe -- DataFileCache
 
 
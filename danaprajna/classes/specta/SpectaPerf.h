@@ -0,0 +1,147 @@
+//
+// SpectaPerf.h
+//
+// Measured examples for Specta.  itMeasures() defines an example that
+// runs a block through untimed warm-up runs, then timed runs, and
+// summarizes time per call:  median, median absolute deviation (MAD),
+// mean, percentiles.  Objective-C allocations per call are counted too.
+//
+// Each summary is compared with a baseline stored under the name of the
+// spec and example.  The example fails when the median exceeds the
+// baseline median by more than tolerance plus madAllowance baseline
+// MADs, or allocations exceed the baseline by more than
+// allocationTolerance.  A missing baseline is recorded and passes.
+//
+// itMeasuresDataFileCache() defines one measured example for each cache
+// size, against a DataFileCache filled to capacity before timing.
+//
+//
+// ENVIRONMENT--
+//   DP_PERF_BASELINE_DIR  Directory of baselines.  Default is
+//                           Documents/SpectaPerfBaselines.  Point it at
+//                           the source tree to keep baselines with the specs.
+//   DP_PERF_RECORD        Non-empty:  record every baseline anew, never fail.
+//   DP_PERF_TOLERANCE     Overrides tolerance for every example.
+//
+// Baselines are per machine (hw.machine):  <dir>/<machine>/<spec>.<example>.plist
+//
+// NB  Allocations are counted at +[NSObject allocWithZone:], only while
+//     measuring.  CoreFoundation and malloc() allocations are not counted.
+//
+//
+// CLASS DEPENDENCIES:  DataFileCache
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#define DP_VERSION_SPECTAPERF  0.1
+
+
+#import "Danaprajna.h"
+
+
+
+//--------------------------------------------------------------- -o-
+#define DP_PERF_BASELINE_DIR_ENV   "DP_PERF_BASELINE_DIR"
+#define DP_PERF_RECORD_ENV         "DP_PERF_RECORD"
+#define DP_PERF_TOLERANCE_ENV      "DP_PERF_TOLERANCE"
+
+#define DP_PERF_BASELINE_DIR_DEFAULT  @"SpectaPerfBaselines"
+
+
+typedef struct {
+  NSUInteger  warmups;                // Untimed runs first.
+  NSUInteger  runs;                   // Timed.
+  NSUInteger  iterations;             // Calls per run.  Each run is one sample, divided by iterations.
+  double      tolerance;              // Fraction of baseline median.
+  double      madAllowance;           // Baseline MADs allowed on top of tolerance.
+  double      allocationTolerance;    // Fraction of baseline allocations.
+} DPPerfOptions;
+
+#define DP_PERF_OPTIONS_DEFAULT  \
+  ((DPPerfOptions) { 2, 15, 1, 0.25, 3.0, 0.10 })
+
+
+// Seconds and allocations are per call.
+//
+typedef struct {
+  NSUInteger      runs;
+  NSTimeInterval  median;
+  NSTimeInterval  mad;
+  NSTimeInterval  mean;
+  NSTimeInterval  min;
+  NSTimeInterval  p90;
+  NSTimeInterval  p99;
+  NSTimeInterval  max;
+  double          allocations;        // Median across runs.
+} DPPerfSummary;
+
+
+typedef void (^DPPerfSetUpBlock)(void);                     // Before every run, untimed.
+typedef void (^DPPerfBlock)(NSUInteger iteration);          // iteration counts on across runs.
+
+
+typedef enum {
+  DPPerfCacheSave,          // New file into a full cache;  evicts.
+  DPPerfCacheLookup,        // cachedFileURL: of a cached file.
+  DPPerfCacheRead,          // cachedFileURL:, then its contents.
+  DPPerfCacheDelete,        // deleteFile: of a cached file.
+  DPPerfCacheMakeSpace,     // makeBytesAvailable: one file more each call.
+  DPPerfCacheClear,         // clearCache.
+  DPPerfCacheTouch,         // saveFile: of a cached file;  refreshes its timestamp.
+
+  DPPerfCacheSaveBatch,     // As above, one batch of iterations files per run.
+  DPPerfCacheDeleteBatch,   //   Times are still per file, to compare with
+  DPPerfCacheTouchBatch,    //   the single file operations.
+} DPPerfCacheOperation;
+
+
+
+
+//--------------------------------------------------------------- -o-
+@interface SpectaPerf : NSObject
+
+  + (DPPerfSummary) measure: (DPPerfOptions)     options
+                      setUp: (DPPerfSetUpBlock)  setUp
+                      block: (DPPerfBlock)       block;
+
+  + (NSString *) compareSummary: (DPPerfSummary)  summary
+              withBaselineNamed: (NSString *)     name
+                        options: (DPPerfOptions)  options;
+
+  + (NSURL *) baselineDirectoryURL;
+
+  + (NSString *) descriptionOfSummary: (DPPerfSummary)summary;
+
+  + (NSString *) nameOfCacheOperation: (DPPerfCacheOperation)operation;
+
+@end
+
+
+
+//--------------------------------------------------------------- -o-
+void  DPPerfItMeasures (const char        *fileName,
+                        NSUInteger         lineNumber,
+                        NSString          *name,
+                        DPPerfOptions      options,
+                        DPPerfSetUpBlock   setUp,
+                        DPPerfBlock        block);
+
+void  DPPerfItMeasuresDataFileCache (const char            *fileName,
+                                     NSUInteger             lineNumber,
+                                     DPPerfCacheOperation   operation,
+                                     NSArray               *cacheSizes,
+                                     NSUInteger             fileSize,
+                                     DPPerfOptions          options);
+
+
+// itMeasures(name, options, setUp, block)
+// itMeasuresDataFileCache(operation, cacheSizes, fileSize, options)
+//
+#define itMeasures(...)               DPPerfItMeasures(__FILE__, __LINE__, __VA_ARGS__)
+#define itMeasuresDataFileCache(...)  DPPerfItMeasuresDataFileCache(__FILE__, __LINE__, __VA_ARGS__)
+
@@ -0,0 +1,653 @@
+//
+// SpectaPerf.m
+//
+// Runs are timed with mach_absolute_time() around the calls alone;
+// setUp and bookkeeping fall outside.  Summaries use nearest rank
+// percentiles, as SessionLoad does.
+//
+// The allocation counter is switched on only while a run is timed, but
+// counts allocations from every thread while it is on.
+//
+//
+// CLASS DEPENDENCIES:  DataFileCache, Zed
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import "SpectaPerf.h"
+
+#import "Specta.h"
+#import "SpectaUtility.h"
+#import "ExpectaSupport.h"
+
+#import "DataFileCache.h"
+
+#import <objc/runtime.h>
+#include <sys/utsname.h>
+#include <math.h>
+
+
+
+//--------------------------------------------------------------- -o-
+// SCHEMA for baseline property lists --
+//   NSDictionary of NSNumber, keyed by:
+//
+#define DP_PERF_BASELINE_MEDIAN_KEY       @"median"
+#define DP_PERF_BASELINE_MAD_KEY          @"mad"
+#define DP_PERF_BASELINE_P90_KEY          @"p90"
+#define DP_PERF_BASELINE_RUNS_KEY         @"runs"
+#define DP_PERF_BASELINE_ALLOCATIONS_KEY  @"allocations"
+
+
+#define DP_PERF_CACHE_ROOT  @"SpectaPerf"
+
+
+static volatile int64_t   allocationCount  = 0;
+static volatile int32_t   counting         = 0;
+
+static mach_timebase_info_data_t  timebase;
+
+
+
+
+//--------------------------------------------------------------- -o-
+// RETURN:  Value at nearest rank p of count sorted values.
+//
+static double dpPerfPercentile(const double *sorted, NSUInteger count, double p)
+{
+  NSUInteger  rank = (NSUInteger) ceil(p * count);
+
+  return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+
+static int dpPerfCompareDoubles(const void *a, const void *b)
+{
+  double  x = *(const double *)a,
+          y = *(const double *)b;
+
+  return (x > y) - (x < y);
+}
+
+
+static double dpPerfMedian(double *values, NSUInteger count)
+{
+  qsort(values, count, sizeof(double), dpPerfCompareDoubles);
+  return values[(count - 1) / 2];
+}
+
+
+// RETURN:  name with every run of characters other than letters and
+//            digits replaced by one underscore.  Safe as a file name.
+//
+static NSString *dpPerfFileName(NSString *name)
+{
+  NSCharacterSet  *unsafe      = [[NSCharacterSet alphanumericCharacterSet] invertedSet];
+  NSArray         *components  = [name componentsSeparatedByCharactersInSet:unsafe];
+
+  return [[components filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"length > 0"]]
+            componentsJoinedByString:@"_"];
+}
+
+
+
+
+//--------------------------------------------------------------- -o-
+@interface NSObject (SpectaPerf)
+
+  + (id) spectaPerfAllocWithZone: (NSZone *)zone;
+
+@end
+
+
+@implementation NSObject (SpectaPerf)
+
+// NB  After the exchange in +[SpectaPerf initialize], this name holds
+//     the original +allocWithZone:.
+//
++ (id) spectaPerfAllocWithZone: (NSZone *)zone
+{
+  if (counting)  { OSAtomicIncrement64Barrier(&allocationCount); }
+
+  return [self spectaPerfAllocWithZone:zone];
+}
+
+@end
+
+
+
+
+//--------------------------------------------------------------- -o-
+@interface SpectaPerf()
+
+  + (NSURL *) baselineURLForName: (NSString *)name;
+
+  + (void) runExample: (NSString *)         name
+             fileName: (const char *)       fileName
+           lineNumber: (NSUInteger)         lineNumber
+              options: (DPPerfOptions)      options
+                setUp: (DPPerfSetUpBlock)   setUp
+                block: (DPPerfBlock)        block;
+
+@end
+
+
+
+
+//--------------------------------------------------------------- -o--
+@implementation SpectaPerf
+
+#pragma mark - Class initialization.
+
+//------------------- -o-
++ (void) initialize
+{
+  if (self != [SpectaPerf class])  { return; }
+
+  mach_timebase_info(&timebase);
+
+  method_exchangeImplementations(class_getClassMethod([NSObject class], @selector(allocWithZone:)),
+                                 class_getClassMethod([NSObject class], @selector(spectaPerfAllocWithZone:)));
+}
+
+
+
+
+//--------------------------------------------------------------- -o--
+#pragma mark - Methods.
+
+//------------------- -o-
+// measure:setUp:block:
+//
+// setUp (optional) runs before every run, warm-up or timed.
+// block runs options.iterations times per run.
+//
++ (DPPerfSummary) measure: (DPPerfOptions)     options
+                    setUp: (DPPerfSetUpBlock)  setUp
+                    block: (DPPerfBlock)       block
+{
+  DPPerfSummary  summary;
+  NSUInteger     iterations  = MAX(options.iterations, 1);
+  NSUInteger     runs        = MAX(options.runs, 1);
+  NSUInteger     iteration   = 0;
+
+  memset(&summary, 0, sizeof(summary));
+
+  if (!block) {
+    DP_LOG_ERROR(@"block is nil.");
+    return summary;
+  }
+
+
+  //
+  for (NSUInteger w = 0; w < options.warmups; w++)
+  {
+    @autoreleasepool {
+      if (setUp)  { setUp(); }
+
+      for (NSUInteger i = 0; i < iterations; i++) {
+        block(iteration++);
+      }
+    }
+  }
+
+
+  //
+  double  *samples      = (double *) calloc(runs, sizeof(double));
+  double  *allocations  = (double *) calloc(runs, sizeof(double));
+  double  *deviations   = (double *) calloc(runs, sizeof(double));
+
+  if (!(samples && allocations && deviations)) {
+    DP_LOG_ERROR(@"Could not calloc() samples.");
+    free(samples);  free(allocations);  free(deviations);
+    return summary;
+  }
+
+  for (NSUInteger r = 0; r < runs; r++)
+  {
+    @autoreleasepool {
+      if (setUp)  { setUp(); }
+
+      OSAtomicIncrement32Barrier(&counting);
+
+      int64_t   allocationStart  = allocationCount;
+      uint64_t  start            = mach_absolute_time();
+
+      for (NSUInteger i = 0; i < iterations; i++) {
+        block(iteration++);
+      }
+
+      uint64_t  end             = mach_absolute_time();
+      int64_t   allocationEnd   = allocationCount;
+
+      OSAtomicDecrement32Barrier(&counting);
+
+      samples[r]      = (double)(end - start) * timebase.numer / timebase.denom / NSEC_PER_SEC / iterations;
+      allocations[r]  = (double)(allocationEnd - allocationStart) / iterations;
+    }
+  }
+
+
+  //
+  double  sum = 0;
+
+  qsort(samples, runs, sizeof(double), dpPerfCompareDoubles);
+
+  for (NSUInteger r = 0; r < runs; r++)  { sum += samples[r]; }
+
+  summary.runs    = runs;
+  summary.median  = samples[(runs - 1) / 2];
+  summary.mean    = sum / runs;
+  summary.min     = samples[0];
+  summary.p90     = dpPerfPercentile(samples, runs, 0.90);
+  summary.p99     = dpPerfPercentile(samples, runs, 0.99);
+  summary.max     = samples[runs - 1];
+
+  for (NSUInteger r = 0; r < runs; r++)  { deviations[r] = fabs(samples[r] - summary.median); }
+
+  summary.mad          = dpPerfMedian(deviations, runs);
+  summary.allocations  = dpPerfMedian(allocations, runs);
+
+  free(samples);  free(allocations);  free(deviations);
+
+  return summary;
+
+} // measure:setUp:block:
+
+
+
+//------------------- -o-
+// compareSummary:withBaselineNamed:options:
+//
+// Record the baseline when it is missing or DP_PERF_RECORD is set.
+//
+// RETURN:  nil if summary is within tolerance of the baseline, or the
+//            baseline was recorded;  otherwise a description of each regression.
+//
++ (NSString *) compareSummary: (DPPerfSummary)  summary
+            withBaselineNamed: (NSString *)     name
+                      options: (DPPerfOptions)  options
+{
+  NSURL         *baselineURL  = [self baselineURLForName:name];
+  const char    *record       = getenv(DP_PERF_RECORD_ENV);
+  const char    *tolerance    = getenv(DP_PERF_TOLERANCE_ENV);
+  NSDictionary  *baseline     = nil;
+
+  if (!baselineURL)  { return DP_STRWFMT(@"No baseline directory for \"%@\".", name); }
+
+  if (!(record && *record)) {
+    baseline = [NSDictionary dictionaryWithContentsOfURL:baselineURL];
+  }
+
+
+  //
+  if (!baseline)
+  {
+    NSDictionary  *recorded = @{ DP_PERF_BASELINE_MEDIAN_KEY       : @(summary.median),
+                                 DP_PERF_BASELINE_MAD_KEY          : @(summary.mad),
+                                 DP_PERF_BASELINE_P90_KEY          : @(summary.p90),
+                                 DP_PERF_BASELINE_RUNS_KEY         : @(summary.runs),
+                                 DP_PERF_BASELINE_ALLOCATIONS_KEY  : @(summary.allocations) };
+
+    if (! [recorded writeToURL:baselineURL atomically:YES]) {
+      return DP_STRWFMT(@"Failed to record baseline.  (%@)", baselineURL);
+    }
+
+    DP_LOG_INFO(@"BASELINE recorded.  (%@)", [baselineURL path]);
+    return nil;
+  }
+
+
+  //
+  NSMutableArray  *regressions      = [[NSMutableArray alloc] init];
+
+  double  baselineMedian            = [baseline[DP_PERF_BASELINE_MEDIAN_KEY] doubleValue];
+  double  baselineMAD               = [baseline[DP_PERF_BASELINE_MAD_KEY] doubleValue];
+  double  baselineAllocations       = [baseline[DP_PERF_BASELINE_ALLOCATIONS_KEY] doubleValue];
+
+  if (tolerance && *tolerance)  { options.tolerance = atof(tolerance); }
+
+  double  medianLimit       = baselineMedian * (1 + options.tolerance) + options.madAllowance * baselineMAD;
+  double  allocationLimit   = ceil(baselineAllocations * (1 + options.allocationTolerance));
+
+  if (summary.median > medianLimit) {
+    [regressions addObject:DP_STRWFMT(@"median %.3f ms exceeds baseline %.3f ms (MAD %.3f ms) by more than %.0f%% + %.1f MAD",
+                                        summary.median * 1000, baselineMedian * 1000, baselineMAD * 1000,
+                                        options.tolerance * 100, options.madAllowance)];
+  }
+
+  if (summary.allocations > allocationLimit) {
+    [regressions addObject:DP_STRWFMT(@"allocations %.1f exceed baseline %.1f by more than %.0f%%",
+                                        summary.allocations, baselineAllocations, options.allocationTolerance * 100)];
+  }
+
+  return ([regressions count] > 0) ? [regressions componentsJoinedByString:@";  "] : nil;
+
+} // compareSummary:withBaselineNamed:options:
+
+
+
+//------------------- -o-
+// RETURN:  DP_PERF_BASELINE_DIR or Documents/DP_PERF_BASELINE_DIR_DEFAULT,
+//            plus hw.machine.  Created if missing.  nil on error.
+//
++ (NSURL *) baselineDirectoryURL
+{
+  const char      *dirPath  = getenv(DP_PERF_BASELINE_DIR_ENV);
+  NSURL           *dirURL   = nil;
+  struct utsname   host;
+
+  if (dirPath && *dirPath)
+  {
+    dirURL = [NSURL fileURLWithPath:[[NSString stringWithUTF8String:dirPath] stringByExpandingTildeInPath] isDirectory:YES];
+
+  } else {
+    NSArray  *documents = [[NSFileManager defaultManager] URLsForDirectory:NSDocumentDirectory inDomains:NSUserDomainMask];
+
+    if ([documents count] < 1) {
+      DP_LOG_ERROR(@"Could not acquire path to NSDocumentDirectory.");
+      return nil;
+    }
+
+    dirURL = [documents[0] URLByAppendingPathComponent:DP_PERF_BASELINE_DIR_DEFAULT isDirectory:YES];
+  }
+
+  if (0 != uname(&host)) {
+    DP_LOG_ERROR(@"uname() failed.");
+    return nil;
+  }
+
+  dirURL = [dirURL URLByAppendingPathComponent:dpPerfFileName([NSString stringWithUTF8String:host.machine]) isDirectory:YES];
+
+  if (! [Zed createDirectoryForURL:dirURL replace:NO])  { return nil; }
+
+  return dirURL;
+}
+
+
+
+//------------------- -o-
++ (NSString *) descriptionOfSummary: (DPPerfSummary)summary
+{
+  return DP_STRWFMT(@"runs %-4lu median %9.4f  MAD %9.4f  mean %9.4f  min %9.4f  p90 %9.4f  p99 %9.4f  max %9.4f ms,  allocations %.1f",
+                      (unsigned long)summary.runs, summary.median * 1000, summary.mad * 1000, summary.mean * 1000,
+                      summary.min * 1000, summary.p90 * 1000, summary.p99 * 1000, summary.max * 1000, summary.allocations);
+}
+
+
+
+//------------------- -o-
++ (NSString *) nameOfCacheOperation: (DPPerfCacheOperation)operation
+{
+  switch (operation)
+  {
+    case DPPerfCacheSave:       return @"save";
+    case DPPerfCacheLookup:     return @"lookup";
+    case DPPerfCacheRead:       return @"read";
+    case DPPerfCacheDelete:     return @"delete";
+    case DPPerfCacheMakeSpace:  return @"make space";
+    case DPPerfCacheClear:      return @"clear";
+    case DPPerfCacheTouch:      return @"touch";
+
+    case DPPerfCacheSaveBatch:    return @"batch save";
+    case DPPerfCacheDeleteBatch:  return @"batch delete";
+    case DPPerfCacheTouchBatch:   return @"batch touch";
+  }
+
+  return @"unknown";
+}
+
+
+
+
+//--------------------------------------------------------------- -o--
+#pragma mark - Private methods.
+
+//------------------- -o-
++ (NSURL *) baselineURLForName: (NSString *)name
+{
+  NSURL  *dirURL = [self baselineDirectoryURL];
+
+  return [dirURL URLByAppendingPathComponent:[dpPerfFileName(name) stringByAppendingPathExtension:@"plist"]];
+}
+
+
+
+//------------------- -o-
+// runExample:fileName:lineNumber:options:setUp:block:
+//
+// Measure, log and compare against the baseline named for the spec
+//   class and example.  Regressions fail the current example.
+//
+// ASSUME  Called from within a running example.
+//
++ (void) runExample: (NSString *)         name
+           fileName: (const char *)       fileName
+         lineNumber: (NSUInteger)         lineNumber
+            options: (DPPerfOptions)      options
+              setUp: (DPPerfSetUpBlock)   setUp
+              block: (DPPerfBlock)        block
+{
+  id             testCase    = SPTCurrentTestCase;
+  DPPerfSummary  summary     = [self measure:options setUp:setUp block:block];
+  NSString      *regression  = nil;
+
+  DP_LOG_INFO(@"BENCHMARK  %@\n%@", name, [self descriptionOfSummary:summary]);
+
+  regression = [self compareSummary: summary
+                  withBaselineNamed: DP_STRWFMT(@"%@ %@", NSStringFromClass([testCase class]), name)
+                            options: options ];
+  if (regression) {
+    EXPFail(testCase, (int)lineNumber, fileName, DP_STRWFMT(@"%@:  %@", name, regression));
+  }
+}
+
+
+@end // @implementation SpectaPerf
+
+
+
+
+//--------------------------------------------------------------- -o-
+void  DPPerfItMeasures (const char        *fileName,
+                        NSUInteger         lineNumber,
+                        NSString          *name,
+                        DPPerfOptions      options,
+                        DPPerfSetUpBlock   setUp,
+                        DPPerfBlock        block)
+{
+  it(name, ^{
+    [SpectaPerf runExample:name fileName:fileName lineNumber:lineNumber options:options setUp:setUp block:block];
+  });
+}
+
+
+
+//------------------- -o-
+// DPPerfItMeasuresDataFileCache()
+//
+// Each example builds its cache from scratch in a temporary directory,
+//   filled with cacheSize / fileSize files, and removes it when done.
+//   Operations that empty the cache refill it in setUp, untimed.
+//
+// Batch operations send one batch of iterations files, at the first
+//   iteration of each run.
+//
+// NB  iterations is at most the number of files per cache, and 1 for DPPerfCacheClear.
+//
+void  DPPerfItMeasuresDataFileCache (const char            *fileName,
+                                     NSUInteger             lineNumber,
+                                     DPPerfCacheOperation   operation,
+                                     NSArray               *cacheSizes,
+                                     NSUInteger             fileSize,
+                                     DPPerfOptions          options)
+{
+  for (NSNumber *cacheSize in cacheSizes)
+  {
+    NSUInteger  capacity  = (NSUInteger) ([cacheSize longLongValue] / MAX(fileSize, 1));
+    NSString   *name      = DP_STRWFMT(@"DataFileCache %@, %lld byte cache of %lu byte files",
+                                         [SpectaPerf nameOfCacheOperation:operation], [cacheSize longLongValue], (unsigned long)fileSize);
+
+    DPPerfOptions  cacheOptions = options;
+
+    cacheOptions.iterations = MIN(MAX(options.iterations, 1), MAX(capacity, 1));
+    if (DPPerfCacheClear == operation)  { cacheOptions.iterations = 1; }
+
+    NSUInteger  batchSize = cacheOptions.iterations;
+
+
+    //
+    it(name, ^{
+      id      testCase  = SPTCurrentTestCase;
+      NSURL  *cacheURL  = [[NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES]
+                            URLByAppendingPathComponent:DP_PERF_CACHE_ROOT isDirectory:YES];
+
+      cacheURL = [cacheURL URLByAppendingPathComponent:dpPerfFileName(name) isDirectory:YES];
+
+      if ((capacity < 1) || ![Zed removeItemForURL:cacheURL]) {
+        EXPFail(testCase, (int)lineNumber, fileName, DP_STRWFMT(@"%@:  no room for one file, or no fresh cache directory.", name));
+        return;
+      }
+
+
+      //
+      DataFileCache  *cache     = [[DataFileCache alloc] initCacheDirectoryWithURL:cacheURL sizeInBytes:[cacheSize longLongValue]];
+      NSMutableData  *fileData  = [NSMutableData dataWithLength:fileSize];
+      uint32_t        pattern   = 0x5f0ca7e5;
+
+      dp_memset_pattern4([fileData mutableBytes], &pattern, fileSize);
+
+      __block  BOOL        filled  = (nil != cache);
+      __block  NSUInteger  calls   = 0;
+
+      DPPerfSetUpBlock  fill = ^{
+        calls = 0;
+
+        for (NSUInteger k = 0; filled && (k < capacity); k++)
+        {
+          NSString  *key = DP_STRWFMT(@"file%lu", (unsigned long)k);
+
+          if (! [cache isFileCached:key]) {
+            filled = [cache saveFile:key withData:fileData];
+          }
+        }
+      };
+
+      fill();
+
+      if (!filled) {
+        EXPFail(testCase, (int)lineNumber, fileName, DP_STRWFMT(@"%@:  could not create and fill the cache.", name));
+        [Zed removeItemForURL:cacheURL];
+        return;
+      }
+
+
+      //
+      DPPerfBlock  block = nil;
+
+      switch (operation)
+      {
+        case DPPerfCacheSave:
+          block = ^(NSUInteger iteration) {
+            [cache saveFile:DP_STRWFMT(@"new%lu", (unsigned long)iteration) withData:fileData];
+          };
+          break;
+
+        case DPPerfCacheLookup:
+          block = ^(NSUInteger iteration) {
+            [cache cachedFileURL:DP_STRWFMT(@"file%lu", (unsigned long)(iteration % capacity))];
+          };
+          break;
+
+        case DPPerfCacheRead:
+          block = ^(NSUInteger iteration) {
+            NSURL  *fileURL = [cache cachedFileURL:DP_STRWFMT(@"file%lu", (unsigned long)(iteration % capacity))];
+
+            if (fileURL)  { (void) [NSData dataWithContentsOfURL:fileURL]; }
+          };
+          break;
+
+        case DPPerfCacheDelete:
+          block = ^(NSUInteger iteration) {
+            [cache deleteFile:DP_STRWFMT(@"file%lu", (unsigned long)(iteration % capacity))];
+          };
+          break;
+
+        case DPPerfCacheMakeSpace:
+          block = ^(NSUInteger iteration) {
+            [cache makeBytesAvailable:(long long)(++calls) * fileSize];
+          };
+          break;
+
+        case DPPerfCacheClear:
+          block = ^(NSUInteger iteration) {
+            [cache clearCache];
+          };
+          break;
+
+        case DPPerfCacheTouch:
+          block = ^(NSUInteger iteration) {
+            [cache saveFile:DP_STRWFMT(@"file%lu", (unsigned long)(iteration % capacity)) withData:fileData];
+          };
+          break;
+
+        case DPPerfCacheSaveBatch:
+          block = ^(NSUInteger iteration) {
+            if (0 != (iteration % batchSize))  { return; }
+
+            NSMutableDictionary  *files = [[NSMutableDictionary alloc] initWithCapacity:batchSize];
+
+            for (NSUInteger k = iteration; k < iteration + batchSize; k++) {
+              [files setObject:fileData forKey:DP_STRWFMT(@"new%lu", (unsigned long)k)];
+            }
+
+            [cache saveFiles:files];
+          };
+          break;
+
+        case DPPerfCacheDeleteBatch:
+        case DPPerfCacheTouchBatch:
+          block = ^(NSUInteger iteration) {
+            if (0 != (iteration % batchSize))  { return; }
+
+            NSMutableArray  *names = [[NSMutableArray alloc] initWithCapacity:batchSize];
+
+            for (NSUInteger k = iteration; k < iteration + batchSize; k++) {
+              [names addObject:DP_STRWFMT(@"file%lu", (unsigned long)(k % capacity))];
+            }
+
+            if (DPPerfCacheDeleteBatch == operation) {
+              [cache deleteFiles:names];
+            } else {
+              [cache touchFiles:names];
+            }
+          };
+          break;
+      }
+
+
+      //
+      BOOL  refills = (DPPerfCacheDelete == operation) || (DPPerfCacheDeleteBatch == operation)
+                        || (DPPerfCacheMakeSpace == operation) || (DPPerfCacheClear == operation);
+
+      [SpectaPerf runExample: name
+                    fileName: fileName
+                  lineNumber: lineNumber
+                     options: cacheOptions
+                       setUp: refills ? fill : nil
+                       block: block ];
+
+      if (!filled) {
+        EXPFail(testCase, (int)lineNumber, fileName, DP_STRWFMT(@"%@:  could not refill the cache.", name));
+      }
+
+      [Zed removeItemForURL:cacheURL];
+    });
+
+  } // endfor cacheSize
+}
+
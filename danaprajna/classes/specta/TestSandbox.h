@@ -26,6 +26,41 @@
 
 
 
+// Bulk assets.  File i of a spec gets the same size and content in every
+//   run with the same seed, whatever order the files are written in.
+//
+typedef enum {
+  SandboxSizeFixed,         // sizeInBytes.
+  SandboxSizeUniform,       // Between minBytes and maxBytes.
+  SandboxSizeLogNormal,     // Median sizeInBytes, shape sigma, clamped to minBytes and maxBytes (0 is no limit).
+} SandboxSizeDistribution;
+
+typedef enum {
+  SandboxContentPattern,        // A seeded four byte pattern per file, repeated.
+  SandboxContentRandom,         // Seeded pseudo-random bytes.
+  SandboxContentSparse,         // Zeros, as a hole where the file system allows.
+  SandboxContentPreallocated,   // Zeros, with blocks reserved up front.
+} SandboxContent;
+
+typedef struct {
+  NSUInteger               count;
+  SandboxSizeDistribution  distribution;
+  unsigned long long       sizeInBytes;
+  unsigned long long       minBytes;
+  unsigned long long       maxBytes;
+  double                   sigma;
+  SandboxContent           content;
+  uint32_t                 seed;
+  NSUInteger               concurrency;     // Files written at once.  0 is one per active processor.
+} SandboxAssetSpec;
+
+#define SANDBOX_ASSETSPEC_DEFAULT  \
+  ((SandboxAssetSpec) { 1000, SandboxSizeFixed, 64 * 1024, 0, 0, 1.0, SandboxContentPattern, 193, 0 })
+
+#define SANDBOX_ASSET_PREFIX_DEFAULT  @"asset"
+
+
+
 //--------------------------------------------------------------- -o-
 @interface  TestSandbox : NSObject
 
@@ -52,5 +87,18 @@
   - (BOOL)  createFileAsset: (NSString *) fileName
                      ofSize: (NSUInteger) sizeInBytes
                 withPattern: (NSString *) hexPattern;
+
+  - (unsigned long long)  createFileAssetsInDirectory: (NSURL *)            directoryURL
+                                           namePrefix: (NSString *)         namePrefix
+                                                 spec: (SandboxAssetSpec)   spec;
+
+  - (unsigned long long)  createDataFileCacheAtURL: (NSURL *)            cacheDirURL
+                                              spec: (SandboxAssetSpec)   spec;
+
+  + (NSString *)  assetNameWithPrefix: (NSString *)  namePrefix
+                                index: (NSUInteger)  index;
+
+  + (unsigned long long)  assetSizeForSpec: (SandboxAssetSpec)  spec
+                                     index: (NSUInteger)        index;
 @end
 
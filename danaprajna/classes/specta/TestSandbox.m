@@ -12,7 +12,12 @@
 // NB  Separate from, but reliant upon, Danaprajna (DP_) suite.
 //  
 //
-// CLASS DEPENDENCIES: Log, Zed
+// Bulk assets are written by several workers at once, each with its own
+// buffer, straight through open() and write().  Every size and byte of
+// file i comes from a generator seeded by spec.seed and i alone.
+//
+//
+// CLASS DEPENDENCIES: Log, Zed, DataFileCache
 //
 //
 //---------------------------------------------------------------------
@@ -24,6 +29,136 @@
 
 #import "TestSandbox.h"
 
+#import "DataFileCache.h"
+
+#include <math.h>
+
+
+
+//-------------------------------------------------------------- -o-
+#define SANDBOX_WRITE_BUFFER_BYTES    (1024 * 1024)
+#define SANDBOX_CACHE_TIMESTAMP_STEP  0.001     // Seconds between index timestamps of consecutive assets.
+
+
+// splitmix64.
+//
+static uint64_t sandboxMix(uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ull;
+  x  = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x  = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+
+  return x ^ (x >> 31);
+}
+
+
+static uint64_t sandboxFileState(uint32_t seed, NSUInteger index)
+{
+  return sandboxMix(sandboxMix(seed) ^ (uint64_t) index);
+}
+
+
+// RETURN:  In (0, 1].
+//
+static double sandboxUnit(uint64_t x)
+{
+  return ((x >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+
+// RETURN:  NO with errno set on failure.
+//
+static BOOL sandboxWriteAll(int fd, const uint8_t *bytes, size_t length)
+{
+  while (length > 0)
+  {
+    ssize_t  written = write(fd, bytes, length);
+
+    if (written < 0) {
+      if (EINTR == errno)  { continue; }
+      return NO;
+    }
+
+    bytes   += written;
+    length  -= (size_t) written;
+  }
+
+  return YES;
+}
+
+
+// buffer is SANDBOX_WRITE_BUFFER_BYTES.
+//
+// RETURN:  NO with errno set on failure.
+//
+static BOOL sandboxWriteFile(const char          *path,
+                             unsigned long long   size,
+                             SandboxContent       content,
+                             uint64_t             state,
+                             uint8_t             *buffer)
+{
+  int  fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  if (fd < 0)  { return NO; }
+
+
+  //
+  BOOL                ok         = YES;
+  unsigned long long  remaining  = size;
+  uint32_t            pattern    = (uint32_t) sandboxMix(state);
+  uint64_t            x          = sandboxMix(state) | 1;
+
+  switch (content)
+  {
+    case SandboxContentSparse:
+      ok = (0 == ftruncate(fd, (off_t) size));
+      break;
+
+    case SandboxContentPreallocated:
+      ok = (0 == size) || (0 == dp_preallocate(fd, (off_t) size)) || (0 == ftruncate(fd, (off_t) size));
+      break;
+
+    case SandboxContentPattern:
+      dp_memset_pattern4(buffer, &pattern, (size_t) MIN(size, (unsigned long long) SANDBOX_WRITE_BUFFER_BYTES));
+
+      while (ok && (remaining > 0))
+      {
+        size_t  chunk = (size_t) MIN(remaining, (unsigned long long) SANDBOX_WRITE_BUFFER_BYTES);
+
+        ok          = sandboxWriteAll(fd, buffer, chunk);
+        remaining  -= chunk;
+      }
+      break;
+
+    case SandboxContentRandom:
+      while (ok && (remaining > 0))
+      {
+        size_t  chunk = (size_t) MIN(remaining, (unsigned long long) SANDBOX_WRITE_BUFFER_BYTES);
+
+        for (size_t k = 0; k < chunk; k += sizeof(uint64_t))       // xorshift64
+        {
+          x ^= x << 13;
+          x ^= x >> 7;
+          x ^= x << 17;
+          memcpy(buffer + k, &x, MIN(sizeof(uint64_t), chunk - k));
+        }
+
+        ok          = sandboxWriteAll(fd, buffer, chunk);
+        remaining  -= chunk;
+      }
+      break;
+  }
+
+
+  //
+  int  savedErrno = errno;
+
+  if ((0 != close(fd)) && ok)  { return NO; }
+
+  errno = savedErrno;
+  return ok;
+}
+
 
 
 
@@ -189,31 +324,22 @@
 
 
   //
+  unsigned int  bytePattern;
+
   if (!fourByteHexPattern) 
   {
-    const char  *hexChar = [@"abcdef0123456789" cStringUsingEncoding:NSASCIIStringEncoding];
-    NSString    *randomPattern = @"";
+    bytePattern = (dp_random_uniform(0x10000) << 16) | dp_random_uniform(0x10000);
 
-    sranddev();
+  } else {
+    NSScanner  *scanner = [NSScanner scannerWithString:fourByteHexPattern];
 
-    for (int i = 8; i > 0; i--) {
-      randomPattern = [randomPattern stringByAppendingString:
-                        [NSString stringWithFormat:@"%c", hexChar[rand() % 16] ]];
+    rval = [scanner scanHexInt:&bytePattern];
+    if (!rval) {
+      DP_LOG_ERROR(@"fourByteHexPattern (\"%@\") is not a hexadecimal number.", fourByteHexPattern);
+      return NO;
     }
-
-    fourByteHexPattern = randomPattern;
   }
 
-
-  //
-  NSScanner     *scanner = [NSScanner scannerWithString:fourByteHexPattern];
-  unsigned int   bytePattern;
-
-  rval = [scanner scanHexInt:&bytePattern];
-  if (!rval) {
-    DP_LOG_ERROR(@"fourByteHexPattern (\"%@\") is not a hexadecimal number.", fourByteHexPattern);
-    return NO;
-  }
   bytePattern = (unsigned int) htonl((__uint32_t)bytePattern);
 
   char  *newData = (char *) malloc(sizeInBytes);
@@ -222,7 +348,7 @@
     return NO;
   }
 
-  memset_pattern4((void *)newData, (const void *)&bytePattern, sizeInBytes);
+  dp_memset_pattern4((void *)newData, (const void *)&bytePattern, sizeInBytes);
 
 
   //
@@ -248,5 +374,187 @@
 } // createFileAsset:ofSize:withPattern: 
 
 
+
+//------------------------------- -o-
+// createFileAssetsInDirectory:namePrefix:spec:
+//
+// Create spec.count files named by assetNameWithPrefix:index:,
+//   spec.concurrency at a time.
+//
+// INPUTS--
+//   directoryURL  Created if missing  -OR-  nil for self.assetURL.
+//   namePrefix    nil for SANDBOX_ASSET_PREFIX_DEFAULT.
+//
+// RETURN:  Sum of file sizes  -OR-  DP_ULONGLONG_MAX on error.
+//
+// NB  Existing files of the same names are replaced.
+//
+- (unsigned long long)  createFileAssetsInDirectory: (NSURL *)            directoryURL
+                                         namePrefix: (NSString *)         namePrefix
+                                               spec: (SandboxAssetSpec)   spec
+{
+  if (!directoryURL)  { directoryURL = self.assetURL; }
+  if (!namePrefix)    { namePrefix = SANDBOX_ASSET_PREFIX_DEFAULT; }
+
+  if (! [Zed createDirectoryForURL:directoryURL replace:NO])  { return DP_ULONGLONG_MAX; }
+
+
+  //
+  NSString    *directoryPath  = [directoryURL path];
+  NSUInteger   workers        = (spec.concurrency > 0) ? spec.concurrency : [[NSProcessInfo processInfo] activeProcessorCount];
+
+  workers = MIN(MAX(workers, 1), MAX(spec.count, 1));
+
+  __block  volatile int32_t  failures  = 0;
+  __block  volatile int64_t  total     = 0;
+
+  dispatch_apply(workers, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t worker)
+    {
+      uint8_t  *buffer = (uint8_t *) malloc(SANDBOX_WRITE_BUFFER_BYTES);
+
+      if (!buffer) {
+        OSAtomicIncrement32Barrier(&failures);
+        DP_LOG_ERROR(@"Could not malloc() buffer.");
+        return;
+      }
+
+      for (NSUInteger i = worker; (i < spec.count) && (0 == failures); i += workers)
+      {
+        @autoreleasepool {
+          NSString            *path  = [directoryPath stringByAppendingPathComponent:
+                                                        [TestSandbox assetNameWithPrefix:namePrefix index:i]];
+          unsigned long long   size  = [TestSandbox assetSizeForSpec:spec index:i];
+
+          if (sandboxWriteFile([path fileSystemRepresentation], size, spec.content, sandboxFileState(spec.seed, i), buffer))
+          {
+            OSAtomicAdd64Barrier((int64_t) size, &total);
+
+          } else if (1 == OSAtomicIncrement32Barrier(&failures)) {
+            DP_LOG_ERROR(@"Failed to write asset.  (%@:  %s)", path, strerror(errno));
+          }
+        }
+      }
+
+      free(buffer);
+    });
+
+  if (failures > 0)  { return DP_ULONGLONG_MAX; }
+
+  if (self.verbose) {
+    DP_LOG_INFO(@"CREATED %lu assets, %lld bytes.  (%@)", (unsigned long)spec.count, total, [directoryURL lastPathComponent]);
+  }
+
+  return (unsigned long long) total;
+
+} // createFileAssetsInDirectory:namePrefix:spec:
+
+
+
+//------------------------------- -o-
+// createDataFileCacheAtURL:spec:
+//
+// Build a cache directory DataFileCache will open as is:  spec.count
+//   assets in its data directory and an index of all of them.  Asset 0
+//   has the oldest timestamp, so eviction takes assets in index order.
+//
+// RETURN:  Sum of file sizes  -OR-  DP_ULONGLONG_MAX on error.
+//
+// NB  cacheDirURL is removed and recreated.  Open it with a cache size
+//     of at least the sum returned, or the cache evicts on open.
+//
+- (unsigned long long)  createDataFileCacheAtURL: (NSURL *)            cacheDirURL
+                                            spec: (SandboxAssetSpec)   spec
+{
+  if (!cacheDirURL) {
+    DP_LOG_ERROR(@"cacheDirURL is undefined.");
+    return DP_ULONGLONG_MAX;
+  }
+
+  if (! [Zed recreateDirectoryForURL:cacheDirURL])  { return DP_ULONGLONG_MAX; }
+
+
+  //
+  NSURL               *dataDirURL  = [cacheDirURL URLByAppendingPathComponent:DFC_CACHEDIR_DATADIR_NAME isDirectory:YES];
+  unsigned long long   total       = [self createFileAssetsInDirectory: dataDirURL
+                                                            namePrefix: SANDBOX_ASSET_PREFIX_DEFAULT
+                                                                  spec: spec ];
+
+  if (DP_ULONGLONG_MAX == total)  { return DP_ULONGLONG_MAX; }
+
+
+  //
+  NSMutableDictionary  *propertyList  = [[NSMutableDictionary alloc] initWithCapacity:spec.count];
+  NSTimeInterval        now           = [NSDate timeIntervalSinceReferenceDate];
+
+  for (NSUInteger i = 0; i < spec.count; i++) {
+    propertyList[[TestSandbox assetNameWithPrefix:SANDBOX_ASSET_PREFIX_DEFAULT index:i]] =
+      @(now - (spec.count - i) * SANDBOX_CACHE_TIMESTAMP_STEP);
+  }
+
+  NSURL  *propertyListURL = [cacheDirURL URLByAppendingPathComponent:DFC_CACHEDIR_PROPERTYLIST_NAME];
+
+  if (! [propertyList writeToURL:propertyListURL atomically:YES]) {
+    DP_LOG_ERROR(@"Failed to write property list for cache directory.  (%@)", propertyListURL);
+    return DP_ULONGLONG_MAX;
+  }
+
+
+  return total;
+
+} // createDataFileCacheAtURL:spec:
+
+
+
+//------------------------------- -o-
++ (NSString *)  assetNameWithPrefix: (NSString *)  namePrefix
+                              index: (NSUInteger)  index
+{
+  return DP_STRWFMT(@"%@%08lu", namePrefix, (unsigned long)index);
+}
+
+
+
+//------------------------------- -o-
+// assetSizeForSpec:index:
+//
+// Log-normal sizes are drawn by Box-Muller from two uniforms of file index's generator.
+//
++ (unsigned long long)  assetSizeForSpec: (SandboxAssetSpec)  spec
+                                   index: (NSUInteger)        index
+{
+  uint64_t            state  = sandboxFileState(spec.seed, index);
+  unsigned long long  size   = spec.sizeInBytes;
+
+  switch (spec.distribution)
+  {
+    case SandboxSizeFixed:
+      break;
+
+    case SandboxSizeUniform:
+      {
+        unsigned long long  high = MAX(spec.maxBytes, spec.minBytes);
+
+        size = spec.minBytes + (state % (high - spec.minBytes + 1));
+      }
+      break;
+
+    case SandboxSizeLogNormal:
+      {
+        double  u1  = sandboxUnit(sandboxMix(state));
+        double  u2  = sandboxUnit(sandboxMix(state ^ 0x5bd1e995));
+        double  z   = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+
+        size = (unsigned long long) llround(spec.sizeInBytes * exp(spec.sigma * z));
+
+        if (size < spec.minBytes)                          { size = spec.minBytes; }
+        if ((spec.maxBytes > 0) && (size > spec.maxBytes))  { size = spec.maxBytes; }
+      }
+      break;
+  }
+
+  return size;
+}
+
+
 @end // @implementation  TestSandbox
 
@@ -0,0 +1,143 @@
+//
+// TestSandboxSpec_A.m
+//
+// Bulk assets and pre-populated DataFileCache directories.
+//
+//
+// CLASS DEPENDENCIES:  TestSandbox, DataFileCache, Zed
+//
+
+#import "Specta.h"
+
+#define EXP_SHORTHAND
+#import "Expecta.h"
+
+
+#import "TestSandbox.h"
+
+#import "DataFileCache.h"
+
+
+
+SpecBegin(TestSandbox_A)
+
+
+//------------------------------------------------------------------------------------- -o-
+#define  ASSETCOUNT   200
+#define  MEDIANSIZE   (8 * 1024)
+
+
+
+
+//------------------------------------------------------------------------------------- -o-
+describe(@"TestSandbox bulk assets",
+^{
+  __block  TestSandbox       *sandbox;
+  __block  SandboxAssetSpec   spec;
+
+
+  //-------------------------------------------------- -o-
+  beforeEach(^{
+    sandbox = [[TestSandbox alloc] initWithRootPath:@"~/testSandbox/" testOnDevice:YES];
+    [sandbox recreateWorkspace];
+
+    spec               = SANDBOX_ASSETSPEC_DEFAULT;
+    spec.count         = ASSETCOUNT;
+    spec.distribution  = SandboxSizeLogNormal;
+    spec.sizeInBytes   = MEDIANSIZE;
+    spec.minBytes      = 1024;
+    spec.maxBytes      = 64 * 1024;
+    spec.content       = SandboxContentRandom;
+  });
+
+
+
+  //------------------------ -o-
+  it(@"writes the same sizes and bytes for the same seed, in parallel",
+  ^{
+    NSURL  *firstURL   = DP_URL_PLUSFILE(sandbox.workspaceURL, @"first");
+    NSURL  *secondURL  = DP_URL_PLUSFILE(sandbox.workspaceURL, @"second");
+
+    spec.concurrency = 1;
+    unsigned long long  first = [sandbox createFileAssetsInDirectory:firstURL namePrefix:nil spec:spec];
+
+    spec.concurrency = 8;
+    unsigned long long  second = [sandbox createFileAssetsInDirectory:secondURL namePrefix:nil spec:spec];
+
+    expect(first).notTo.equal(DP_ULONGLONG_MAX);
+    expect(second).to.equal(first);
+    expect([[Zed directoryListForURL:secondURL] count]).to.equal(ASSETCOUNT);
+
+    unsigned long long  sum = 0;
+
+    for (NSUInteger i = 0; i < ASSETCOUNT; i++)
+    {
+      NSString            *name  = [TestSandbox assetNameWithPrefix:SANDBOX_ASSET_PREFIX_DEFAULT index:i];
+      unsigned long long   size  = [TestSandbox assetSizeForSpec:spec index:i];
+
+      expect(size).to.beGreaterThanOrEqualTo(spec.minBytes);
+      expect(size).to.beLessThanOrEqualTo(spec.maxBytes);
+      expect([Zed fileSizeForURL:DP_URL_PLUSFILE(secondURL, name) includeResourceFork:NO]).to.equal(size);
+
+      sum += size;
+    }
+
+    expect(sum).to.equal(first);
+
+    NSString  *name = [TestSandbox assetNameWithPrefix:SANDBOX_ASSET_PREFIX_DEFAULT index:ASSETCOUNT - 1];
+
+    expect([NSData dataWithContentsOfURL:DP_URL_PLUSFILE(secondURL, name)])
+      .to.equal([NSData dataWithContentsOfURL:DP_URL_PLUSFILE(firstURL, name)]);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"writes sparse and preallocated files of full length",
+  ^{
+    NSURL  *sparseURL  = DP_URL_PLUSFILE(sandbox.workspaceURL, @"sparse");
+    NSURL  *zeroURL    = DP_URL_PLUSFILE(sandbox.workspaceURL, @"preallocated");
+
+    spec.distribution  = SandboxSizeFixed;
+    spec.count         = 4;
+
+    spec.content = SandboxContentSparse;
+    expect([sandbox createFileAssetsInDirectory:sparseURL namePrefix:@"sparse" spec:spec]).to.equal(4 * MEDIANSIZE);
+
+    spec.content = SandboxContentPreallocated;
+    expect([sandbox createFileAssetsInDirectory:zeroURL namePrefix:@"zero" spec:spec]).to.equal(4 * MEDIANSIZE);
+
+    NSData  *data = [NSData dataWithContentsOfURL:DP_URL_PLUSFILE(sparseURL, [TestSandbox assetNameWithPrefix:@"sparse" index:3])];
+
+    expect(data).to.equal([NSMutableData dataWithLength:MEDIANSIZE]);
+  });
+
+
+
+  //------------------------ -o-
+  it(@"builds a DataFileCache directory that opens with every asset cached, oldest first",
+  ^{
+    NSURL               *cacheURL  = DP_URL_PLUSFILE(sandbox.workspaceURL, @"cache");
+    unsigned long long   total     = [sandbox createDataFileCacheAtURL:cacheURL spec:spec];
+
+    expect(total).notTo.equal(DP_ULONGLONG_MAX);
+
+    DataFileCache  *cache = [[DataFileCache alloc] initCacheDirectoryWithURL:cacheURL sizeInBytes:(long long)total];
+
+    expect(cache).notTo.beNil();
+    expect([cache currentFreeBytes]).to.equal(0);
+
+    for (NSUInteger i = 0; i < ASSETCOUNT; i++) {
+      expect([cache isFileCached:[TestSandbox assetNameWithPrefix:SANDBOX_ASSET_PREFIX_DEFAULT index:i]]).to.beTruthy();
+    }
+
+    expect([cache makeBytesAvailable:1]).to.beTruthy();
+    expect([cache isFileCached:[TestSandbox assetNameWithPrefix:SANDBOX_ASSET_PREFIX_DEFAULT index:0]]).to.beFalsy();
+    expect([cache isFileCached:[TestSandbox assetNameWithPrefix:SANDBOX_ASSET_PREFIX_DEFAULT index:1]]).to.beTruthy();
+  });
+
+});
+
+
+SpecEnd
+
@@ -0,0 +1,218 @@
+//
+// DPPlatform.h
+//
+// Platform shims.  On Apple platforms, the system headers.  Elsewhere
+// (GNUstep with clang and libdispatch), stand-ins for the few Darwin
+// interfaces Danaprajna uses:  OSAtomic, OSSpinLock, mach_absolute_time,
+// CFBridging, arc4random, sranddev and memset_pattern4.
+//
+// dp_resident_bytes() is the resident size of this process:  task_info()
+// on Apple platforms, /proc/self/statm elsewhere.
+//
+// dp_preallocate() reserves blocks for a file and sets its length:
+// F_PREALLOCATE on Apple platforms, posix_fallocate() elsewhere.
+//
+// UIKit is only available where TARGET_OS_IPHONE is true;  code that
+// needs it is compiled under DP_UIKIT.
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#define DP_VERSION_PLATFORM  0.1
+
+
+#import <Foundation/Foundation.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+
+//---------------------------------------------------- -o-
+#if defined(__APPLE__)
+
+#  import <TargetConditionals.h>
+#  import <libkern/OSAtomic.h>
+#  import <mach/mach.h>
+#  import <mach/mach_time.h>
+
+#  define DP_UIKIT  TARGET_OS_IPHONE
+
+
+   static inline uint32_t  dp_random_uniform (uint32_t upperBound)  { return arc4random_uniform(upperBound); }
+
+   static inline void  dp_sranddev (void)  { sranddev(); }
+
+   static inline void  dp_memset_pattern4 (void *b, const void *pattern4, size_t len)
+                         { memset_pattern4(b, pattern4, len); }
+
+   static inline uint32_t  dp_thread_id (void)  { return (uint32_t) pthread_mach_thread_np(pthread_self()); }
+
+   static inline uint64_t  dp_resident_bytes (void)
+   {
+     struct mach_task_basic_info  info;
+     mach_msg_type_number_t       count = MACH_TASK_BASIC_INFO_COUNT;
+
+     if (KERN_SUCCESS != task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count))  { return 0; }
+
+     return info.resident_size;
+   }
+
+   // RETURN:  0 on success, -1 with errno set otherwise.
+   //
+   static inline int  dp_preallocate (int fd, off_t length)
+   {
+     fstore_t  store = { F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0, length, 0 };
+
+     if (-1 == fcntl(fd, F_PREALLOCATE, &store))
+     {
+       store.fst_flags = F_ALLOCATEALL;
+       if (-1 == fcntl(fd, F_PREALLOCATE, &store))  { return -1; }
+     }
+
+     return ftruncate(fd, length);
+   }
+
+
+
+//---------------------------------------------------- -o-
+#else
+
+#  include <dispatch/dispatch.h>
+#  include <time.h>
+#  include <sched.h>
+#  include <errno.h>
+#  include <sys/syscall.h>
+
+#  define DP_UIKIT  0
+
+
+   // OSAtomic, with the GCC builtins.  Every operation is a full barrier.
+   //
+   static inline int32_t  OSAtomicIncrement32Barrier (volatile int32_t *value)  { return __sync_add_and_fetch(value, 1); }
+   static inline int32_t  OSAtomicDecrement32Barrier (volatile int32_t *value)  { return __sync_sub_and_fetch(value, 1); }
+   static inline int64_t  OSAtomicIncrement64Barrier (volatile int64_t *value)  { return __sync_add_and_fetch(value, 1); }
+   static inline int64_t  OSAtomicDecrement64Barrier (volatile int64_t *value)  { return __sync_sub_and_fetch(value, 1); }
+
+   static inline int64_t  OSAtomicAdd64Barrier (int64_t amount, volatile int64_t *value)
+                            { return __sync_add_and_fetch(value, amount); }
+
+   static inline bool  OSAtomicCompareAndSwap32Barrier (int32_t oldValue, int32_t newValue, volatile int32_t *value)
+                         { return __sync_bool_compare_and_swap(value, oldValue, newValue); }
+
+   static inline bool  OSAtomicCompareAndSwap64Barrier (int64_t oldValue, int64_t newValue, volatile int64_t *value)
+                         { return __sync_bool_compare_and_swap(value, oldValue, newValue); }
+
+   static inline void  OSMemoryBarrier (void)  { __sync_synchronize(); }
+
+
+   // OSSpinLock.
+   //
+   typedef volatile int32_t  OSSpinLock;
+
+#  define OS_SPINLOCK_INIT  0
+
+   static inline void  OSSpinLockLock (OSSpinLock *lock)
+   {
+     while (__sync_lock_test_and_set(lock, 1)) {
+       while (*lock)  { sched_yield(); }
+     }
+   }
+
+   static inline void  OSSpinLockUnlock (OSSpinLock *lock)  { __sync_lock_release(lock); }
+
+
+   // mach_absolute_time(), in nanoseconds.
+   //
+   typedef struct {
+     uint32_t  numer;
+     uint32_t  denom;
+   } mach_timebase_info_data_t;
+
+   static inline int  mach_timebase_info (mach_timebase_info_data_t *info)
+   {
+     info->numer = 1;
+     info->denom = 1;
+     return 0;
+   }
+
+   static inline uint64_t  mach_absolute_time (void)
+   {
+     struct timespec  now;
+
+     clock_gettime(CLOCK_MONOTONIC, &now);
+     return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+   }
+
+
+   // CFBridging, under ARC.
+   //
+   static inline const void *  CFBridgingRetain (id object)           { return (__bridge_retained const void *) object; }
+   static inline id            CFBridgingRelease (const void *object)  { return (__bridge_transfer id) object; }
+
+
+   //
+   static inline void  dp_sranddev (void)
+   {
+     struct timespec  now;
+
+     clock_gettime(CLOCK_REALTIME, &now);
+
+     unsigned int  seed = (unsigned int) (now.tv_sec ^ now.tv_nsec ^ getpid());
+
+     srand(seed);
+     srandom(seed);
+   }
+
+   static inline uint32_t  dp_random_uniform (uint32_t upperBound)
+   {
+     static pthread_once_t  seeded = PTHREAD_ONCE_INIT;
+
+     pthread_once(&seeded, dp_sranddev);
+     return upperBound ? (uint32_t) (random() % upperBound) : 0;
+   }
+
+   static inline void  dp_memset_pattern4 (void *b, const void *pattern4, size_t len)
+   {
+     uint8_t  *bytes = (uint8_t *) b;
+
+     for (size_t i = 0; i < len; i++) {
+       bytes[i] = ((const uint8_t *) pattern4)[i % 4];
+     }
+   }
+
+   static inline uint32_t  dp_thread_id (void)  { return (uint32_t) syscall(SYS_gettid); }
+
+   static inline uint64_t  dp_resident_bytes (void)
+   {
+     unsigned long   size      = 0;
+     unsigned long   resident  = 0;
+     FILE           *statm     = fopen("/proc/self/statm", "r");
+
+     if (!statm)  { return 0; }
+
+     if (2 != fscanf(statm, "%lu %lu", &size, &resident))  { resident = 0; }
+     fclose(statm);
+
+     return (uint64_t) resident * (uint64_t) sysconf(_SC_PAGESIZE);
+   }
+
+   static inline int  dp_preallocate (int fd, off_t length)
+   {
+     int  error = posix_fallocate(fd, 0, length);
+
+     if (error)  { errno = error;  return -1; }
+     return 0;
+   }
+
+#endif
+
@@ -11,13 +11,22 @@
 #define DP_VERSION  0.6 	
 
 
-#import <UIKit/UIKit.h>
+#import "DPPlatform.h"
+
+#if DP_UIKIT
+#  import <UIKit/UIKit.h>
+#endif
 
 
 #import "Dump.h"
 #import "Log.h"
+#import "Trace.h"
+#import "NetworkActivity.h"
 
 #import "Zed.h"
 #import "ZedUD.h"
-#import "ZedCG.h"
+
+#if DP_UIKIT
+#  import "ZedCG.h"
+#endif
 
@@ -55,9 +55,11 @@
 
 #define DP_DUMPNV(obj)   @(obj)                            // NSNumber
 #define DP_DUMPRV(obj)   [NSValue valueWithRange:   obj]   // NSRange
-#define DP_DUMPPV(obj)   [NSValue valueWithCGPoint: obj]   // CGPoint
-#define DP_DUMPZV(obj)   [NSValue valueWithCGSize:  obj]   // CGSize
-#define DP_DUMPCV(obj)   [NSValue valueWithCGRect:  obj]   // CGRect
+#if DP_UIKIT
+#  define DP_DUMPPV(obj)   [NSValue valueWithCGPoint: obj]   // CGPoint
+#  define DP_DUMPZV(obj)   [NSValue valueWithCGSize:  obj]   // CGSize
+#  define DP_DUMPCV(obj)   [NSValue valueWithCGRect:  obj]   // CGRect
+#endif
 
 
 #define DP_DUMPN(obj)   [Dump  msg:[Dump o:@[DP_DUMPNV(obj)] l:@ #obj]  location:DP_CODE_LOCATION]
@@ -9,7 +9,7 @@
 //     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
 //---------------------------------------------------------------------
 
-#define DP_VERSION_LOG  0.5
+#define DP_VERSION_LOG  0.6
 
 
 #import "Danaprajna.h"
@@ -17,41 +17,121 @@
 
 
 //---------------------------------------------------- -o-
-#define DP_LOG_ENABLED        YES 
+#define DP_LOG_ENABLED        YES
 #define DP_LOG_LOGTYPE_FATAL  @"FATAL"
 
 
-#define DP_LOG_DEBUG(...)  \
-  [Log msg:[NSString stringWithFormat:__VA_ARGS__]  location:DP_CODE_LOCATION  logType:@"DEBUG"]
+// Levels, lowest first.
+//
+#define DP_LOG_LEVEL_DEBUG     0
+#define DP_LOG_LEVEL_INFO      1
+#define DP_LOG_LEVEL_WARNING   2
+#define DP_LOG_LEVEL_ERROR     3
+#define DP_LOG_LEVEL_FATAL     4
+
+typedef NSInteger DPLogLevel;
+
+
+// Messages below DP_LOG_LEVEL_COMPILED are removed by the preprocessor;
+//   their arguments are never evaluated.  Override in the build settings.
+//
+// Messages below [Log levelThreshold] are dropped at the call site, before
+//   the message is formatted.
+//
+#ifndef DP_LOG_LEVEL_COMPILED
+#  define DP_LOG_LEVEL_COMPILED   DP_LOG_LEVEL_DEBUG
+#endif
 
-#define DP_LOG_INFO(...)  \
-  [Log msg:[NSString stringWithFormat:__VA_ARGS__]  location:DP_CODE_LOCATION  logType:@"INFO"]
+extern volatile DPLogLevel  dpLogLevelThreshold;
 
-#define DP_LOG_WARNING(...)  \
-  [Log msg:[NSString stringWithFormat:__VA_ARGS__]  location:DP_CODE_LOCATION  logType:@"WARNING"]
 
-#define DP_LOG_ERROR(...)  \
-  [Log msg:[NSString stringWithFormat:__VA_ARGS__]  location:DP_CODE_LOCATION  logType:@"ERROR"]
+// Slots in the ring between callers and the drainer thread.  Power of two.
+//   Messages that find the ring full are counted and dropped.
+//
+#define DP_LOG_RING_CAPACITY   1024
+
+#define DP_LOG_FLUSH_TIMEOUT   1.0     // Seconds.
 
+
+
+//
+#define DP_LOG_AT(level, logType, ...)                                         \
+  do {                                                                         \
+    if ((level) >= dpLogLevelThreshold) {                                      \
+      [Log  enqueue: [NSString stringWithFormat:__VA_ARGS__]                   \
+              level: (level)                                                   \
+            logType: (logType)                                                 \
+              class: [self class]                                              \
+           selector: _cmd ];                                                   \
+    }                                                                          \
+  } while (0)
+
+#define DP_LOG_DISABLED(...)  do { } while (0)
+
+
+#if DP_LOG_LEVEL_COMPILED <= DP_LOG_LEVEL_DEBUG
+#  define DP_LOG_DEBUG(...)    DP_LOG_AT(DP_LOG_LEVEL_DEBUG, @"DEBUG", __VA_ARGS__)
+#else
+#  define DP_LOG_DEBUG(...)    DP_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if DP_LOG_LEVEL_COMPILED <= DP_LOG_LEVEL_INFO
+#  define DP_LOG_INFO(...)     DP_LOG_AT(DP_LOG_LEVEL_INFO, @"INFO", __VA_ARGS__)
+#else
+#  define DP_LOG_INFO(...)     DP_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if DP_LOG_LEVEL_COMPILED <= DP_LOG_LEVEL_WARNING
+#  define DP_LOG_WARNING(...)  DP_LOG_AT(DP_LOG_LEVEL_WARNING, @"WARNING", __VA_ARGS__)
+#else
+#  define DP_LOG_WARNING(...)  DP_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if DP_LOG_LEVEL_COMPILED <= DP_LOG_LEVEL_ERROR
+#  define DP_LOG_ERROR(...)    DP_LOG_AT(DP_LOG_LEVEL_ERROR, @"ERROR", __VA_ARGS__)
+#else
+#  define DP_LOG_ERROR(...)    DP_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+
+// NB  FATAL is never filtered and is not queued:  pending messages are
+//       flushed, then it is output and raised on the calling thread.
+//
 #define DP_LOG_FATAL(...)  \
   [Log msg:[NSString stringWithFormat:__VA_ARGS__]  location:DP_CODE_LOCATION  logType:DP_LOG_LOGTYPE_FATAL]
 
 
-#define DP_LOG_NSERROR(err)  \
-  [Log nserror:(NSError *)err  location:DP_CODE_LOCATION  logType:@"NSERROR"]
+#define DP_LOG_NSERROR(err)                                                    \
+  do {                                                                         \
+    if (DP_LOG_LEVEL_ERROR >= dpLogLevelThreshold) {                           \
+      [Log nserror:(NSError *)err  location:DP_CODE_LOCATION  logType:@"NSERROR"]; \
+    }                                                                          \
+  } while (0)
 
 
 
 //---------------------------------------------------- -o-
 @interface Log : NSObject
 
+  + (DPLogLevel) levelThreshold;
+  + (void)       setLevelThreshold: (DPLogLevel)level;
+
+  + (void)  enqueue: (NSString *)   msg
+              level: (DPLogLevel)   level
+            logType: (NSString *)   logType
+              class: (Class)        cls
+           selector: (SEL)          selector;
+
   + (void)      msg: (NSString *) msg
-           location: (NSString *) location  
+           location: (NSString *) location
             logType: (NSString *) logType;
 
   + (void)   nserror: (NSError *)  error
             location: (NSString *) location
              logType: (NSString *) logType;
 
+  + (BOOL)      flush;
+  + (int64_t)   droppedCount;
+
 @end // @interface Log : NSObject
 
@@ -1,6 +1,16 @@
 //
 // Log.m
 //
+// Callers format only the message, then place it in a bounded lock-free
+// ring (one slot per message, sequence-numbered per slot so any number
+// of threads may enqueue and dequeue).  A drainer thread builds the code
+// location and writes each message with NSLog, off the caller thread.
+//
+// FATAL is synchronous:  the ring is flushed first, so it is the last
+// message written.  flush waits on drainedCondition, which the drainer
+// broadcasts each time it empties the ring.
+//
+//
 // CLASS DEPENDENCIES: Zed, Dump
 //
 //
@@ -15,41 +25,165 @@
 
 
 //---------------------------------------------------- -o-
+volatile DPLogLevel  dpLogLevelThreshold = DP_LOG_LEVEL_DEBUG;
+
+
+// NB  Object pointers are unretained;  message and location are held by
+//       CFBridgingRetain() from enqueue until drained.  logType is
+//       always a string literal.
+//
+typedef struct {
+  volatile int64_t                  sequence;
+
+  DPLogLevel                        level;
+  __unsafe_unretained NSString     *logType;
+  __unsafe_unretained Class         cls;
+  SEL                               selector;
+  const void                       *location;      // NSString, when cls is Nil.
+  const void                       *message;       // NSString
+} DPLogSlot;
+
+
+static DPLogSlot          ring[DP_LOG_RING_CAPACITY];
+static volatile int64_t   enqueuePosition  = 0;
+static volatile int64_t   dequeuePosition  = 0;
+static volatile int64_t   droppedMessages  = 0;
+static volatile int64_t   writtenMessages  = 0;      // Drainer only.
+
+static dispatch_semaphore_t  drainSignal = NULL;
+static NSCondition          *drainedCondition = nil;
+
+
+
+
+//---------------------------------------------------- -o-
+@interface Log()
+
+  + (BOOL)      enqueue: (NSString *)   msg
+                  level: (DPLogLevel)   level
+                logType: (NSString *)   logType
+                  class: (Class)        cls
+               selector: (SEL)          selector
+               location: (NSString *)   location;
+
+  + (BOOL) dequeueSlot: (DPLogSlot *)slot;
+
+  + (void) drainLoop;
+  + (void) drain;
+
+  + (void) output: (NSString *) msg
+         location: (NSString *) location
+          logType: (NSString *) logType;
+
+@end
+
+
+
+
+//---------------------------------------------------- -o--
 @implementation Log
 
+#pragma mark - Class initialization.
+
+//------------------- -o-
++ (void) initialize
+{
+  if (self != [Log class])  { return; }
+
+  for (int64_t i = 0; i < DP_LOG_RING_CAPACITY; i++) {
+    ring[i].sequence = i;
+  }
+
+  drainSignal       = dispatch_semaphore_create(0);
+  drainedCondition  = [[NSCondition alloc] init];
+
+
+  //
+  NSThread  *drainer = [[NSThread alloc] initWithTarget:self selector:@selector(drainLoop) object:nil];
+
+  drainer.name = @"Log drainer";
+  [drainer start];
+}
+
+
+
+
+//---------------------------------------------------- -o--
+#pragma mark - Methods.
+
+//------------------- -o-
++ (DPLogLevel) levelThreshold
+{
+  return dpLogLevelThreshold;
+}
+
++ (void) setLevelThreshold: (DPLogLevel)level
+{
+  dpLogLevelThreshold = level;
+  OSMemoryBarrier();
+}
+
+
 
 //------------------- -o-
+// enqueue:level:logType:class:selector:
+//
+// NB  Never blocks;  a full ring drops msg and counts it.
+//
++ (void)  enqueue: (NSString *)   msg
+            level: (DPLogLevel)   level
+          logType: (NSString *)   logType
+            class: (Class)        cls
+         selector: (SEL)          selector
+{
+  [Log enqueue:msg level:level logType:logType class:cls selector:selector location:nil];
+}
+
+
+
+//------------------- -o-
+// msg:location:logType:
+//
+// Queue msg with a location already built  -OR-  for FATAL, flush and
+// output on the calling thread, then raise.
+//
 + (void)      msg: (NSString *) msg
          location: (NSString *) location
           logType: (NSString *) logType
 {
-  if (DP_LOG_ENABLED) {
-    NSLog(@"_LOG: %@_ %@ -- %@", logType, location, msg);
+  if (! [logType isEqualToString:DP_LOG_LOGTYPE_FATAL]) {
+    [Log enqueue:msg level:DP_LOG_LEVEL_ERROR logType:logType class:Nil selector:NULL location:location];
+    return;
   }
 
-  
-  if ([logType isEqualToString:DP_LOG_LOGTYPE_FATAL]) 
-  {
-    BOOL  useAlertOverExceptionOnFatalError = NO;
 
-    UIAlertView  *anAlert = [[UIAlertView alloc] initWithTitle: DP_LOG_LOGTYPE_FATAL
-                                                       message: msg
-                                                      delegate: nil
-                                             cancelButtonTitle: nil
-                                             otherButtonTitles: nil ];
+  //
+  BOOL  useAlertOverExceptionOnFatalError = NO;
 
-    NSException  *exception = [[NSException alloc] initWithName: DP_LOG_LOGTYPE_FATAL
-                                                         reason: msg
-                                                       userInfo: nil ];
+  [Log flush];
+  [Log output:msg location:location logType:logType];
 
-    if (useAlertOverExceptionOnFatalError) 
-    {
-      dispatch_async(dispatch_get_main_queue(), ^{ [anAlert show]; });
-    } else {
-      [exception raise];
-    }
+  NSException  *exception = [[NSException alloc] initWithName: DP_LOG_LOGTYPE_FATAL
+                                                       reason: msg
+                                                     userInfo: nil ];
+
+#if DP_UIKIT
+  UIAlertView  *anAlert = [[UIAlertView alloc] initWithTitle: DP_LOG_LOGTYPE_FATAL
+                                                     message: msg
+                                                    delegate: nil
+                                           cancelButtonTitle: nil
+                                           otherButtonTitles: nil ];
+
+  if (useAlertOverExceptionOnFatalError) 
+  {
+    dispatch_async(dispatch_get_main_queue(), ^{ [anAlert show]; });
+    return;
   }
-} 
+#endif
+
+  [exception raise];
+
+} // msg:location:logType:
 
 
 
@@ -77,5 +211,229 @@
 } // nserror:location:logType:
 
 
+
+//------------------- -o-
+// flush
+//
+// Wait until every message queued before the call is written.
+//
+// RETURN:  NO if DP_LOG_FLUSH_TIMEOUT passed first.
+//
++ (BOOL) flush
+{
+  int64_t  target    = enqueuePosition;
+  NSDate  *deadline  = [NSDate dateWithTimeIntervalSinceNow:DP_LOG_FLUSH_TIMEOUT];
+
+  if ([[NSThread currentThread].name isEqualToString:@"Log drainer"]) {
+    return YES;
+  }
+
+  BOOL  isFlushed = YES;
+
+  dispatch_semaphore_signal(drainSignal);
+
+  [drainedCondition lock];
+
+  while (writtenMessages < target)
+  {
+    if (! [drainedCondition waitUntilDate:deadline]) {
+      isFlushed = (writtenMessages >= target);
+      break;
+    }
+  }
+
+  [drainedCondition unlock];
+
+  return isFlushed;
+}
+
+
+
+//------------------- -o-
++ (int64_t) droppedCount
+{
+  return droppedMessages;
+}
+
+
+
+
+//---------------------------------------------------- -o--
+#pragma mark - Private methods.
+
+//------------------- -o-
+// enqueue:level:logType:class:selector:location:
+//
+// Claim the slot at enqueuePosition, fill it, then publish it by
+// advancing its sequence.
+//
++ (BOOL)      enqueue: (NSString *)   msg
+                level: (DPLogLevel)   level
+              logType: (NSString *)   logType
+                class: (Class)        cls
+             selector: (SEL)          selector
+             location: (NSString *)   location
+{
+  if (!DP_LOG_ENABLED)  { return NO; }
+
+  DPLogSlot  *slot;
+  int64_t     position = enqueuePosition;
+
+  for (;;)
+  {
+    slot = &ring[position & (DP_LOG_RING_CAPACITY - 1)];
+
+    int64_t  difference = slot->sequence - position;
+
+    if (0 == difference) {
+      if (OSAtomicCompareAndSwap64Barrier(position, position + 1, &enqueuePosition))  { break; }
+      position = enqueuePosition;
+
+    } else if (difference < 0) {
+      OSAtomicIncrement64Barrier(&droppedMessages);
+      return NO;
+
+    } else {
+      position = enqueuePosition;
+    }
+  }
+
+
+  //
+  slot->level     = level;
+  slot->logType   = logType;
+  slot->cls       = cls;
+  slot->selector  = selector;
+  slot->location  = location ? CFBridgingRetain(location) : NULL;
+  slot->message   = msg ? CFBridgingRetain(msg) : NULL;
+
+  OSMemoryBarrier();
+  slot->sequence = position + 1;
+
+  dispatch_semaphore_signal(drainSignal);
+
+  return YES;
+
+} // enqueue:level:logType:class:selector:location:
+
+
+
+//------------------- -o-
+// dequeueSlot:
+//
+// RETURN:  YES and a copy of the oldest published slot  -OR-  NO if none.
+//
+// NB  Caller releases slotCopy->message and slotCopy->location.
+//
++ (BOOL) dequeueSlot: (DPLogSlot *)slotCopy
+{
+  DPLogSlot  *slot;
+  int64_t     position = dequeuePosition;
+
+  for (;;)
+  {
+    slot = &ring[position & (DP_LOG_RING_CAPACITY - 1)];
+
+    int64_t  difference = slot->sequence - (position + 1);
+
+    if (0 == difference) {
+      if (OSAtomicCompareAndSwap64Barrier(position, position + 1, &dequeuePosition))  { break; }
+      position = dequeuePosition;
+
+    } else if (difference < 0) {
+      return NO;
+
+    } else {
+      position = dequeuePosition;
+    }
+  }
+
+
+  //
+  slotCopy->level     = slot->level;
+  slotCopy->logType   = slot->logType;
+  slotCopy->cls       = slot->cls;
+  slotCopy->selector  = slot->selector;
+  slotCopy->location  = slot->location;
+  slotCopy->message   = slot->message;
+
+  OSMemoryBarrier();
+  slot->sequence = position + DP_LOG_RING_CAPACITY;
+
+  return YES;
+
+} // dequeueSlot:
+
+
+
+//------------------- -o-
++ (void) drainLoop
+{
+  for (;;)
+  {
+    dispatch_semaphore_wait(drainSignal, DISPATCH_TIME_FOREVER);
+
+    @autoreleasepool {
+      [Log drain];
+    }
+  }
+}
+
+
+
+//------------------- -o-
+// drain
+//
+// Write every published message and wake flush, then report any
+// dropped since last time.
+//
++ (void) drain
+{
+  static int64_t  droppedReported = 0;
+  DPLogSlot       slot;
+
+  while ([Log dequeueSlot:&slot])
+  {
+    NSString  *msg       = slot.message  ? CFBridgingRelease(slot.message)  : nil;
+    NSString  *location  = slot.location ? CFBridgingRelease(slot.location) : nil;
+
+    if (slot.cls) {
+      location = [NSString stringWithFormat:@"%@ :: %@", slot.cls, NSStringFromSelector(slot.selector)];
+    }
+
+    [Log output:msg location:location logType:slot.logType];
+    OSAtomicIncrement64Barrier(&writtenMessages);
+  }
+
+  [drainedCondition lock];
+  [drainedCondition broadcast];
+  [drainedCondition unlock];
+
+
+  //
+  int64_t  dropped = droppedMessages;
+
+  if (dropped != droppedReported) {
+    [Log  output: [NSString stringWithFormat:@"Ring full;  %lld messages dropped.", dropped - droppedReported]
+        location: @"Log :: drain"
+         logType: @"WARNING" ];
+    droppedReported = dropped;
+  }
+
+} // drain
+
+
+
+//------------------- -o-
++ (void) output: (NSString *) msg
+       location: (NSString *) location
+        logType: (NSString *) logType
+{
+  if (DP_LOG_ENABLED) {
+    NSLog(@"_LOG: %@_ %@ -- %@", logType, location, msg);
+  }
+}
+
+
 @end // @implementation Log
 
@@ -0,0 +1,69 @@
+//
+// NetworkActivity.h
+//
+// Network activity indicator and request accounting.
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#define DP_VERSION_NETWORKACTIVITY  0.1
+
+
+#import "Danaprajna.h"
+
+
+
+//---------------------------------------------------- -o-
+// Weight of the newest request in the rolling latency estimate;  the
+//   weight of older requests decays by (1 - weight) with each new one.
+//
+#define DP_NETWORK_EWMA_WEIGHT   0.2
+
+// Bandwidth is bytes completed by the requests of the last window
+//   seconds, at most the last samples of them, over the wall-clock time
+//   they spanned.  Concurrent requests add up.
+//
+#define DP_NETWORK_BANDWIDTH_WINDOW    10.0
+#define DP_NETWORK_BANDWIDTH_SAMPLES   64
+
+
+// Bytes are response bytes.  Throughput and bandwidth are bytes per
+//   second;  durations are seconds.  Failed requests count toward
+//   requests and failures only.
+//
+typedef struct {
+  uint64_t        requests;
+  uint64_t        failures;
+  uint64_t        bytes;
+  NSTimeInterval  duration;              // Sum over successful requests.
+  NSTimeInterval  lastDuration;
+  double          lastThroughput;        // Of the last successful request alone.
+  double          bandwidthEstimate;     // Per DP_NETWORK_BANDWIDTH_WINDOW, when the last request ended.
+  NSTimeInterval  latencyEstimate;       // Rolling duration per request.
+} DPNetworkStats;
+
+
+
+//---------------------------------------------------- -o-
+@interface NetworkActivity : NSObject
+
+  + (NSInteger) activityBegin;
+  + (NSInteger) activityEnd;
+  + (NSInteger) activeCount;
+
+  + (uint64_t) beginRequest;
+  + (void)     endRequest: (uint64_t)  started
+                    bytes: (long long) bytes
+                  success: (BOOL)      success;
+
+  + (double)          bandwidthEstimate;
+  + (double)          lastThroughput;
+  + (NSTimeInterval)  latencyEstimate;
+  + (DPNetworkStats)  stats;
+  + (void)            resetStats;
+
+@end // @interface NetworkActivity : NSObject
+
@@ -0,0 +1,301 @@
+//
+// NetworkActivity.m
+//
+// Count network activity from any thread and show the status bar
+// indicator while any is outstanding.  The count is atomic;  the
+// indicator is only touched on the main queue, and always set from the
+// count as it is when the main queue gets to it, so updates that cross
+// on the way cannot leave it wrong.
+//
+// Requests timed with beginRequest and endRequest:bytes:success: also
+// update byte, duration and throughput totals, a rolling (EWMA) estimate
+// of latency, and a bandwidth estimate over a window of wall-clock time.
+// Bandwidth divides bytes by elapsed time rather than by the sum of
+// request durations, so requests in flight together are not each
+// charged the whole of their shared time.
+//
+//
+// CLASS DEPENDENCIES: Log
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import "NetworkActivity.h"
+
+
+
+//---------------------------------------------------- -o-
+static volatile int32_t   activeCount  = 0;
+
+static DPNetworkStats     stats;
+static OSSpinLock         statsLock    = OS_SPINLOCK_INIT;
+
+static mach_timebase_info_data_t  timebase;
+
+
+// Ring of recent successful requests, for bandwidthEstimate.  statsLock.
+//
+typedef struct {
+  uint64_t   started;
+  uint64_t   ended;
+  uint64_t   bytes;
+} DPNetworkSample;
+
+static DPNetworkSample    samples[DP_NETWORK_BANDWIDTH_SAMPLES];
+static NSUInteger         sampleNext   = 0;
+static NSUInteger         sampleCount  = 0;
+
+
+
+
+//---------------------------------------------------- -o-
+@interface NetworkActivity()
+
+  + (void) updateIndicator;
+
+  + (double) bandwidthAfterSample: (DPNetworkSample)sample;
+
+@end
+
+
+
+
+//---------------------------------------------------- -o--
+@implementation NetworkActivity
+
+#pragma mark - Class initialization.
+
+//------------------- -o-
++ (void) initialize
+{
+  if (self != [NetworkActivity class])  { return; }
+
+  mach_timebase_info(&timebase);
+  memset(&stats, 0, sizeof(stats));
+}
+
+
+
+
+//---------------------------------------------------- -o--
+#pragma mark - Methods.
+
+//------------------- -o-
+// activityBegin
+//
+// RETURN:  Count of activity outstanding, including this one.
+//
++ (NSInteger) activityBegin
+{
+  int32_t  count = OSAtomicIncrement32Barrier(&activeCount);
+
+  if (1 == count)  { [NetworkActivity updateIndicator]; }
+
+  return count;
+}
+
+
+
+//------------------- -o-
+// activityEnd
+//
+// RETURN:  Count of activity still outstanding.
+//
+// NB  Unbalanced calls are logged;  the count never goes below zero.
+//
++ (NSInteger) activityEnd
+{
+  int32_t  count;
+
+  do {
+    count = activeCount;
+
+    if (count <= 0) {
+      DP_LOG_WARNING(@"activityEnd without activityBegin.");
+      return 0;
+    }
+  } while (! OSAtomicCompareAndSwap32Barrier(count, count - 1, &activeCount));
+
+  if (1 == count)  { [NetworkActivity updateIndicator]; }
+
+  return count - 1;
+}
+
+
+
+//------------------- -o-
++ (NSInteger) activeCount
+{
+  return activeCount;
+}
+
+
+
+//------------------- -o-
+// beginRequest
+//
+// RETURN:  Start time;  pass to endRequest:bytes:success:.
+//
++ (uint64_t) beginRequest
+{
+  [NetworkActivity activityBegin];
+  return mach_absolute_time();
+}
+
+
+
+//------------------- -o-
++ (void) endRequest: (uint64_t)  started
+              bytes: (long long) bytes
+            success: (BOOL)      success
+{
+  uint64_t        ended     = mach_absolute_time();
+  NSTimeInterval  duration  = (double)(ended - started) * timebase.numer / timebase.denom / NSEC_PER_SEC;
+
+  [NetworkActivity activityEnd];
+
+
+  //
+  OSSpinLockLock(&statsLock);
+
+  stats.requests += 1;
+
+  if (!success || (bytes < 0))
+  {
+    stats.failures += 1;
+
+  } else {
+    double  throughput  = (duration > 0) ? bytes / duration : 0;
+    BOOL    isFirst     = (stats.requests - stats.failures) == 1;
+
+    stats.bytes           += (uint64_t) bytes;
+    stats.duration        += duration;
+    stats.lastDuration     = duration;
+    stats.lastThroughput   = throughput;
+
+    stats.bandwidthEstimate  = [NetworkActivity bandwidthAfterSample:(DPNetworkSample){ started, ended, (uint64_t) bytes }];
+    stats.latencyEstimate    = isFirst ? duration
+                                       : stats.latencyEstimate + DP_NETWORK_EWMA_WEIGHT * (duration - stats.latencyEstimate);
+  }
+
+  OSSpinLockUnlock(&statsLock);
+}
+
+
+
+//------------------- -o-
++ (double) bandwidthEstimate
+{
+  return [NetworkActivity stats].bandwidthEstimate;
+}
+
+
+//------------------- -o-
++ (double) lastThroughput
+{
+  return [NetworkActivity stats].lastThroughput;
+}
+
+
+//------------------- -o-
++ (NSTimeInterval) latencyEstimate
+{
+  return [NetworkActivity stats].latencyEstimate;
+}
+
+
+//------------------- -o-
++ (DPNetworkStats) stats
+{
+  OSSpinLockLock(&statsLock);
+  DPNetworkStats  snapshot = stats;
+  OSSpinLockUnlock(&statsLock);
+
+  return snapshot;
+}
+
+
+//------------------- -o-
++ (void) resetStats
+{
+  OSSpinLockLock(&statsLock);
+  memset(&stats, 0, sizeof(stats));
+  sampleNext   = 0;
+  sampleCount  = 0;
+  OSSpinLockUnlock(&statsLock);
+}
+
+
+
+
+//---------------------------------------------------- -o--
+#pragma mark - Private methods.
+
+//------------------- -o-
+// NB  No indicator without UIKit.
+//
++ (void) updateIndicator
+{
+#if DP_UIKIT
+  dispatch_async(dispatch_get_main_queue(), ^{
+    [UIApplication sharedApplication].networkActivityIndicatorVisible = (activeCount > 0);
+  });
+#endif
+}
+
+
+
+//------------------- -o-
+// bandwidthAfterSample:
+//
+// Add sample to the ring, drop samples that ended before the window,
+// then divide bytes of those left by the time from the earliest start
+// among them, or from the start of the window, to the end of sample.
+//
+// RETURN:  Bytes per second.
+//
+// NB  statsLock held.
+// NB  Samples are added in about the order they ended;  the scan stops
+//       at the first one found outside the window.
+//
++ (double) bandwidthAfterSample: (DPNetworkSample)sample
+{
+  uint64_t  window = (uint64_t)(DP_NETWORK_BANDWIDTH_WINDOW * NSEC_PER_SEC * timebase.denom / timebase.numer);
+
+  samples[sampleNext]  = sample;
+  sampleNext           = (sampleNext + 1) % DP_NETWORK_BANDWIDTH_SAMPLES;
+  sampleCount          = MIN(sampleCount + 1, DP_NETWORK_BANDWIDTH_SAMPLES);
+
+
+  //
+  uint64_t  windowStart  = (sample.ended > window) ? sample.ended - window : 0;
+  uint64_t  earliest     = sample.started;
+  uint64_t  bytes        = 0;
+
+  for (NSUInteger i = 0; i < sampleCount; i++)
+  {
+    DPNetworkSample  *recent = &samples[(sampleNext + DP_NETWORK_BANDWIDTH_SAMPLES - 1 - i) % DP_NETWORK_BANDWIDTH_SAMPLES];
+
+    if (recent->ended < windowStart) {
+      sampleCount = i;
+      break;
+    }
+
+    bytes     += recent->bytes;
+    earliest   = MIN(earliest, recent->started);
+  }
+
+  NSTimeInterval  elapsed =
+    (double)(sample.ended - MAX(earliest, windowStart)) * timebase.numer / timebase.denom / NSEC_PER_SEC;
+
+  return (elapsed > 0) ? bytes / elapsed : 0;
+
+} // bandwidthAfterSample:
+
+
+@end // @implementation NetworkActivity
+
@@ -0,0 +1,94 @@
+//
+// Trace.h
+//
+// Span macros.
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#define DP_VERSION_TRACE  0.1
+
+
+#import "Danaprajna.h"
+
+
+
+//---------------------------------------------------- -o-
+// Completed spans kept in memory;  the oldest are overwritten.
+//
+#define DP_TRACE_BUFFER_CAPACITY   8192
+
+#define DP_TRACE_CATEGORY          "danaprajna"
+
+
+// NB  Spans are values.  spanID is zero when tracing was off at begin,
+//       and such spans are ignored by DP_TRACE_END.
+//
+typedef struct {
+  uint64_t     spanID;
+  uint64_t     parentID;
+  uint64_t     enclosingID;      // Span current on this thread before begin.
+  uint64_t     start;            // mach_absolute_time()
+  const char  *name;             // String literal.
+} DPTraceSpan;
+
+
+extern volatile BOOL  dpTraceEnabled;
+
+
+// DP_TRACE_BEGIN(name)               Parent is the span current on this thread.
+// DP_TRACE_BEGIN_CHILD(name, parent) Parent is a spanID from another thread.
+// DP_TRACE_BEGIN_ASYNC(name)         As DP_TRACE_BEGIN, but never becomes 
+//                                      current;  for spans that end later, 
+//                                      or on another thread.
+// DP_TRACE_BEGIN_ASYNC_CHILD(name, parent)
+// DP_TRACE_END(span)
+//
+// name must be a C string literal.
+//
+#define DP_TRACE_SPAN_NONE  ((DPTraceSpan) { 0, 0, 0, 0, NULL })
+
+#define DP_TRACE_BEGIN(name)  \
+  (dpTraceEnabled ? [Trace beginSpan:(name) parentID:0 makeCurrent:YES] : DP_TRACE_SPAN_NONE)
+
+#define DP_TRACE_BEGIN_CHILD(name, parent)  \
+  (dpTraceEnabled ? [Trace beginSpan:(name) parentID:(parent) makeCurrent:YES] : DP_TRACE_SPAN_NONE)
+
+#define DP_TRACE_BEGIN_ASYNC(name)  \
+  (dpTraceEnabled ? [Trace beginSpan:(name) parentID:0 makeCurrent:NO] : DP_TRACE_SPAN_NONE)
+
+#define DP_TRACE_BEGIN_ASYNC_CHILD(name, parent)  \
+  (dpTraceEnabled ? [Trace beginSpan:(name) parentID:(parent) makeCurrent:NO] : DP_TRACE_SPAN_NONE)
+
+#define DP_TRACE_END(span)                     \
+  do {                                         \
+    if ((span).spanID) {                       \
+      [Trace endSpan:(span)];                  \
+    }                                          \
+  } while (0)
+
+
+
+//---------------------------------------------------- -o-
+@interface Trace : NSObject
+
+  + (BOOL) isEnabled;
+  + (void) setEnabled: (BOOL)enabled;
+
+  + (DPTraceSpan) beginSpan: (const char *)name
+                   parentID: (uint64_t)parentID
+                makeCurrent: (BOOL)makeCurrent;
+
+  + (void) endSpan: (DPTraceSpan)span;
+
+  + (NSUInteger) count;
+  + (void)       clear;
+
+  + (NSData *) chromeTraceJSON;
+  + (BOOL)     writeChromeTraceToURL: (NSURL *)url;
+
+@end // @interface Trace : NSObject
+
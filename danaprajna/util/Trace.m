@@ -0,0 +1,244 @@
+//
+// Trace.m
+//
+// Begin and end spans, each with an ID and a parent link, then export the
+// completed spans as Chrome trace-event JSON (chrome://tracing).
+//
+// A span is begun as a value on the caller's stack;  nothing is stored
+// until it ends.  The span current on each thread is kept so nested
+// spans find their parent without being told.
+//
+// With tracing off, DP_TRACE_BEGIN and DP_TRACE_END cost one load and
+// one branch each.
+//
+//
+// CLASS DEPENDENCIES: Log
+//
+//
+//---------------------------------------------------------------------
+//     Copyright David Reeder 2014.  ios@mobilesound.org
+//     Distributed under the Boost Software License, Version 1.0.
+//     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
+//---------------------------------------------------------------------
+
+#import "Trace.h"
+
+#import <pthread.h>
+
+
+
+//---------------------------------------------------- -o-
+volatile BOOL  dpTraceEnabled = NO;
+
+
+typedef struct {
+  const char  *name;
+  uint64_t     spanID;
+  uint64_t     parentID;
+  uint64_t     start;
+  uint64_t     end;
+  uint32_t     thread;
+} DPTraceEvent;
+
+
+static DPTraceEvent       events[DP_TRACE_BUFFER_CAPACITY];
+static NSUInteger         eventsNext   = 0;
+static NSUInteger         eventsCount  = 0;
+static OSSpinLock         eventsLock   = OS_SPINLOCK_INIT;
+
+static volatile int64_t   lastSpanID   = 0;
+
+static pthread_key_t               currentSpanKey;
+static mach_timebase_info_data_t   timebase;
+
+
+
+
+//---------------------------------------------------- -o--
+@implementation Trace
+
+#pragma mark - Class initialization.
+
+//------------------- -o-
++ (void) initialize
+{
+  if (self != [Trace class])  { return; }
+
+  pthread_key_create(&currentSpanKey, NULL);
+  mach_timebase_info(&timebase);
+}
+
+
+
+
+//---------------------------------------------------- -o--
+#pragma mark - Methods.
+
+//------------------- -o-
++ (BOOL) isEnabled
+{
+  return dpTraceEnabled;
+}
+
++ (void) setEnabled: (BOOL)enabled
+{
+  [Trace class];        // Run +initialize before any span begins.
+
+  dpTraceEnabled = enabled;
+  OSMemoryBarrier();
+}
+
+
+
+//------------------- -o-
+// beginSpan:parentID:makeCurrent:
+//
+// NB  parentID zero adopts the span current on this thread, if any.
+//
++ (DPTraceSpan) beginSpan: (const char *)name
+                 parentID: (uint64_t)parentID
+              makeCurrent: (BOOL)makeCurrent
+{
+  DPTraceSpan  span;
+  uint64_t     enclosingID = (uint64_t)(uintptr_t) pthread_getspecific(currentSpanKey);
+
+  span.spanID       = (uint64_t) OSAtomicIncrement64Barrier(&lastSpanID);
+  span.parentID     = parentID ? parentID : enclosingID;
+  span.enclosingID  = enclosingID;
+  span.name         = name;
+  span.start        = mach_absolute_time();
+
+  if (makeCurrent) {
+    pthread_setspecific(currentSpanKey, (const void *)(uintptr_t) span.spanID);
+  }
+
+  return span;
+}
+
+
+
+//------------------- -o-
+// endSpan:
+//
+// Record span, then restore the span that enclosed it on this thread.
+//
++ (void) endSpan: (DPTraceSpan)span
+{
+  DPTraceEvent  event;
+
+  event.end       = mach_absolute_time();
+  event.name      = span.name;
+  event.spanID    = span.spanID;
+  event.parentID  = span.parentID;
+  event.start     = span.start;
+  event.thread    = dp_thread_id();
+
+  if ((uint64_t)(uintptr_t) pthread_getspecific(currentSpanKey) == span.spanID) {
+    pthread_setspecific(currentSpanKey, (const void *)(uintptr_t) span.enclosingID);
+  }
+
+
+  //
+  OSSpinLockLock(&eventsLock);
+
+  events[eventsNext] = event;
+  eventsNext         = (eventsNext + 1) % DP_TRACE_BUFFER_CAPACITY;
+  eventsCount        = MIN(eventsCount + 1, DP_TRACE_BUFFER_CAPACITY);
+
+  OSSpinLockUnlock(&eventsLock);
+}
+
+
+
+//------------------- -o-
++ (NSUInteger) count
+{
+  OSSpinLockLock(&eventsLock);
+  NSUInteger  count = eventsCount;
+  OSSpinLockUnlock(&eventsLock);
+
+  return count;
+}
+
+
+//------------------- -o-
++ (void) clear
+{
+  OSSpinLockLock(&eventsLock);
+  eventsNext   = 0;
+  eventsCount  = 0;
+  OSSpinLockUnlock(&eventsLock);
+}
+
+
+
+//------------------- -o-
+// chromeTraceJSON
+//
+// RETURN:  { "traceEvents" : [ ... ] }, one complete ("X") event per span,
+//            oldest first.  Times are microseconds.  args hold id and parent.
+//
++ (NSData *) chromeTraceJSON
+{
+  NSUInteger     count;
+  DPTraceEvent  *ordered = malloc(sizeof(DPTraceEvent) * DP_TRACE_BUFFER_CAPACITY);
+
+  if (!ordered) {
+    DP_LOG_ERROR(@"Could not malloc() event copy.");
+    return nil;
+  }
+
+  OSSpinLockLock(&eventsLock);
+
+  count = eventsCount;
+  for (NSUInteger i = 0; i < count; i++) {
+    ordered[i] = events[(eventsNext + DP_TRACE_BUFFER_CAPACITY - count + i) % DP_TRACE_BUFFER_CAPACITY];
+  }
+
+  OSSpinLockUnlock(&eventsLock);
+
+
+  //
+  NSMutableArray  *traceEvents  = [[NSMutableArray alloc] initWithCapacity:count];
+  int              pid          = getpid();
+  double           toMicros     = (double) timebase.numer / timebase.denom / 1000.0;
+
+  for (NSUInteger i = 0; i < count; i++)
+  {
+    [traceEvents addObject:
+      @{
+         @"name"  : @(ordered[i].name),
+         @"cat"   : @DP_TRACE_CATEGORY,
+         @"ph"    : @"X",
+         @"ts"    : @(ordered[i].start * toMicros),
+         @"dur"   : @((ordered[i].end - ordered[i].start) * toMicros),
+         @"pid"   : @(pid),
+         @"tid"   : @(ordered[i].thread),
+         @"args"  : @{ @"id" : @(ordered[i].spanID), @"parent" : @(ordered[i].parentID) },
+       }];
+  }
+
+  free(ordered);
+
+  return [NSJSONSerialization dataWithJSONObject:@{ @"traceEvents" : traceEvents } options:0 error:nil];
+
+} // chromeTraceJSON
+
+
+
+//------------------- -o-
++ (BOOL) writeChromeTraceToURL: (NSURL *)url
+{
+  NSData  *json = [Trace chromeTraceJSON];
+
+  if (![json writeToURL:url atomically:YES]) {
+    DP_LOG_ERROR(@"Could not write trace.  (%@)", url);
+    return NO;
+  }
+
+  return YES;
+}
+
+
+@end // @implementation Trace
+
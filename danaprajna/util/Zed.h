@@ -26,10 +26,12 @@
   // Miscellaneous methods.
   //
 
+#if DP_UIKIT
   + (UIColor *) colorWith255Red: (NSUInteger) red
                           green: (NSUInteger) green
                            blue: (NSUInteger) blue
                           alpha: (float)      alpha;
+#endif
 
   + (NSString *) dateFormatFullShort: (NSDate *)date;
 
@@ -147,8 +149,11 @@ typedef NSComparisonResult (^dp_block_cmpindex0_t) (NSArray *arr1, NSArray *arr2
 //
 #define DP_STRWFMT(...)  [NSString stringWithFormat:__VA_ARGS__]
 
+// NB  UTF-8, sized in bytes with its terminator.  Buffer is autoreleased;
+//       copy it to keep it.
+//
 #define DP_NS2CSTRING(s)  \
-    ((char *) [[NSData dataWithBytes:[s cStringUsingEncoding:NSASCIIStringEncoding]  length:[s length] + 1]  bytes])
+    ((char *) [[NSData dataWithBytes:[s UTF8String]  length:[s lengthOfBytesUsingEncoding:NSUTF8StringEncoding] + 1]  bytes])
 
 
 #define DP_URL_PLUSFILE(url, fileComponent)  \
@@ -185,6 +190,9 @@ typedef NSComparisonResult (^dp_block_cmpindex0_t) (NSArray *arr1, NSArray *arr2
 
 // Create serial queue.
 //
+// NB  A new queue each call;  for queues kept for the life of their 
+//       owner.  Work submitted per item belongs on QueueRegistry.
+//
 #define DP_ASYNC_QUEUE(...)                                        \
     dispatch_queue_create(                                         \
       DP_NS2CSTRING( DP_CODE_LOCATION_WITH_MESSAGE(__VA_ARGS__) ), \
@@ -22,7 +22,7 @@
 //   recreateDirectoryForURL:
 //   
 //
-// CLASS DEPENDENCIES: Log
+// CLASS DEPENDENCIES: Log, NetworkActivity
 //
 //
 //---------------------------------------------------------------------
@@ -42,6 +42,7 @@
 
 
 //------------------- -o-
+#if DP_UIKIT
 + (UIColor *) colorWith255Red: (NSUInteger)red
                         green: (NSUInteger)green
                          blue: (NSUInteger)blue
@@ -52,6 +53,7 @@
                           blue: blue / 255.0
                          alpha: alpha ];
 }
+#endif
 
 
 
@@ -121,9 +123,17 @@
 
 
 //------------------- -o-
+// isIPad
+//
+// NB  NO without UIKit.
+//
 + (BOOL) isIPad
 {
+#if DP_UIKIT
   return ([[UIDevice currentDevice] userInterfaceIdiom] == UIUserInterfaceIdiomPad);
+#else
+  return NO;
+#endif
 }
 
 
@@ -135,25 +145,11 @@
 // Post spinner in status bar for network activity. 
 // Keep reference count so early arrivals do not mask continuing network activity. 
 //
+// NB  Any thread.  See NetworkActivity.
+//
 + (NSInteger) networkIndicatorEnable: (BOOL)enable
 {
-  UIApplication     *app          = [UIApplication sharedApplication];
-  static NSInteger   enableCount  = 0;
-
-  if (enable) {
-    app.networkActivityIndicatorVisible = YES;
-    enableCount += 1;
-
-  } else {
-    enableCount -= 1;
-
-    if (enableCount <= 0) {
-      app.networkActivityIndicatorVisible = NO;
-      enableCount = 0;
-    }
-  }
-
-  return enableCount;
+  return enable ? [NetworkActivity activityBegin] : [NetworkActivity activityEnd];
 }
 
 
@@ -200,7 +196,7 @@
   for (int i = 0; i < arraySize; i++) 
   {
     [inputMutableArray exchangeObjectAtIndex: i
-                           withObjectAtIndex: arc4random() % arraySize
+                           withObjectAtIndex: dp_random_uniform((uint32_t)arraySize)
     ];
   }
 
@@ -8,7 +8,7 @@
 //     (See LICENSE_1_0.txt or http://www.boost.org/LICENSE_1_0.txt)
 //---------------------------------------------------------------------
 
-#define DP_VERSION_ZEDUD  0.1
+#define DP_VERSION_ZEDUD  0.2
 
 
 #import "Danaprajna.h"
@@ -25,6 +25,12 @@
 #define DP_MAKE_UDKEY(k)        [NSString stringWithFormat:@"__%@", k]
 
 
+// Seconds between the first unsaved write and writing all changed roots
+//   back to NSUserDefaults.  See synchronize.
+//
+#define DP_ZEDUD_PERSIST_DELAY  1.0
+
+
 
 //---------------------------------------------------- -o-
 @interface ZedUD : NSObject
@@ -77,6 +83,9 @@
   + (void)             root: (NSString *) rootKey
          removeObjectForKey: (NSString *) objectKey;
 
+  //
+  + (void) synchronize;
+
 
 @end // ZedUD
 
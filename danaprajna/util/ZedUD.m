@@ -3,6 +3,15 @@
 //
 // Shortcuts and wrappers for NSUserDefaults.
 //
+// Each root dictionary is read from NSUserDefaults once, then kept in 
+// memory.  Reads and writes of one key touch only the memory copy;  
+// changed roots are written back together, on a private queue, 
+// DP_ZEDUD_PERSIST_DELAY seconds after the first unsaved write.  
+// synchronize writes them back immediately.
+//
+// Values are copied as they are stored, so later changes by the caller 
+// are not seen.
+//
 //
 // CLASS METHODS--
 //   udGetRootDictionary:
@@ -21,6 +30,7 @@
 //   root:setObject:forKey:
 //   udRemoveRootDictionary:
 //   root:removeObjectForKey:
+//   synchronize
 //   
 //
 // CLASS DEPENDENCIES: Log
@@ -36,13 +46,58 @@
 
 
 
+//---------------------------------------------------- -o-
+// Memory copy of each root:  NSMutableDictionary  -OR-  NSNull if removed 
+//   or absent from NSUserDefaults.  Guarded by @synchronized (memoryRoots).
+//
+static NSMutableDictionary  *memoryRoots         = nil;
+static NSMutableSet         *unsavedRootKeys     = nil;
+static BOOL                  isPersistScheduled  = NO;
+
+
+
+//---------------------------------------------------- -o-
+@interface ZedUD()
+
+  + (NSMutableDictionary *) memoryRoot: (NSString *)rootKey
+                                create: (BOOL)create;
+
+  + (void) markUnsaved: (NSString *)rootKey;
+
+  + (dispatch_queue_t) persistQueue;
+  + (void) persist;
+
+@end
+
+
+
+
 //---------------------------------------------------- -o--
 @implementation ZedUD
 
+#pragma mark - Class initialization.
+
+//------------------- -o-
++ (void) initialize
+{
+  if (self != [ZedUD class])  { return; }
+
+  memoryRoots      = [[NSMutableDictionary alloc] init];
+  unsavedRootKeys  = [[NSMutableSet alloc] init];
+}
+
+
+
+
+//---------------------------------------------------- -o--
 #pragma mark - Shortcuts and wrappers for NSUserDefaults.
 
 
 //------------------- -o-
+// udGetRootDictionary:
+//
+// RETURN:  Copy of whole root  -OR-  nil if there is none.
+//
 + (NSMutableDictionary *) udGetRootDictionary: (NSString *)rootKey
 {
   if (!rootKey) {
@@ -50,7 +105,9 @@
     return nil;
   }
 
-  return [[DP_USERDEFAULTS dictionaryForKey:DP_MAKE_UDKEY(rootKey)] mutableCopy ];
+  @synchronized (memoryRoots) {
+    return [[ZedUD memoryRoot:rootKey create:NO] mutableCopy];
+  }
 }
 
 
@@ -63,7 +120,9 @@
     return nil;
   }
 
-  return [[ZedUD udGetRootDictionary:rootKey] objectForKey:objectKey];
+  @synchronized (memoryRoots) {
+    return [[ZedUD memoryRoot:rootKey create:NO] objectForKey:objectKey];
+  }
 }
 
 + (NSMutableArray *)    root: (NSString *) rootKey 
@@ -144,8 +203,10 @@
     return;
   }
 
-  [DP_USERDEFAULTS setObject:dictContent forKey:DP_MAKE_UDKEY(rootKey)];
-  DP_USERDEFAULTS_SYNC();
+  @synchronized (memoryRoots) {
+    [memoryRoots setObject:[[NSMutableDictionary alloc] initWithDictionary:dictContent copyItems:YES] forKey:rootKey];
+    [ZedUD markUnsaved:rootKey];
+  }
 }
 
 
@@ -161,15 +222,15 @@
     return;
   }
 
+  if ([objectContent conformsToProtocol:@protocol(NSCopying)]) {
+    objectContent = [(id<NSCopying>)objectContent copyWithZone:nil];
+  }
 
-  NSMutableDictionary *dict = [ZedUD udGetRootDictionary:rootKey];
 
-  if (!dict) {
-    dict = [[NSMutableDictionary alloc] init];
+  @synchronized (memoryRoots) {
+    [[ZedUD memoryRoot:rootKey create:YES] setObject:objectContent forKey:objectKey];
+    [ZedUD markUnsaved:rootKey];
   }
-
-  [dict setObject:objectContent forKey:objectKey];
-  [ZedUD root:rootKey setRootDictionary:dict];
 }
 
 
@@ -182,7 +243,10 @@
     return;
   }
 
-  [DP_USERDEFAULTS removeObjectForKey:DP_MAKE_UDKEY(rootKey)];
+  @synchronized (memoryRoots) {
+    [memoryRoots setObject:[NSNull null] forKey:rootKey];
+    [ZedUD markUnsaved:rootKey];
+  }
 
   if (DP_ZEDUD_DEBUG_ENABLED) {
     DP_LOG_INFO(@"DELETED user defaults.  (rootKey=%@)", rootKey);
@@ -198,13 +262,139 @@
     return;
   }
 
+  @synchronized (memoryRoots) {
+    NSMutableDictionary  *dict = [ZedUD memoryRoot:rootKey create:NO];
+
+    if ([dict objectForKey:objectKey]) {
+      [dict removeObjectForKey:objectKey];
+      [ZedUD markUnsaved:rootKey];
+    }
+  }
+}
+
+
+
+//------------------- -o-
+// synchronize
+//
+// Write back every changed root, then synchronize NSUserDefaults.
+//
+// NB  Blocks until done.  Call before the app may be suspended.
+//
++ (void) synchronize
+{
+  dispatch_sync([ZedUD persistQueue], ^{
+    [ZedUD persist];
+  });
+
+  DP_USERDEFAULTS_SYNC();
+}
+
+
+
+
+//---------------------------------------------------- -o--
+#pragma mark - Private methods.
+
+//------------------- -o-
+// memoryRoot:create:
+//
+// RETURN:  Memory copy of rootKey, read from NSUserDefaults on first use  
+//            -OR-  nil if there is no root and create is NO.
+//
+// NB  Call within @synchronized (memoryRoots).
+//
++ (NSMutableDictionary *) memoryRoot: (NSString *)rootKey
+                              create: (BOOL)create
+{
+  id  root = [memoryRoots objectForKey:rootKey];
+
+  if (!root) 
+  {
+    NSDictionary  *stored = [DP_USERDEFAULTS dictionaryForKey:DP_MAKE_UDKEY(rootKey)];
 
-  NSMutableDictionary *dict = [ZedUD udGetRootDictionary:rootKey];
+    root = stored ? [stored mutableCopy] : [NSNull null];
+    [memoryRoots setObject:root forKey:rootKey];
+  }
 
-  if (dict) {
-    [dict removeObjectForKey:objectKey];
+  if ((root == [NSNull null]) && create) {
+    root = [[NSMutableDictionary alloc] init];
+    [memoryRoots setObject:root forKey:rootKey];
   }
+
+  return (root == [NSNull null]) ? nil : root;
 }
 
+
+
+//------------------- -o-
+// markUnsaved:
+//
+// NB  Call within @synchronized (memoryRoots).
+//
++ (void) markUnsaved: (NSString *)rootKey
+{
+  [unsavedRootKeys addObject:rootKey];
+
+  if (isPersistScheduled)  { return; }
+
+  isPersistScheduled = YES;
+
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(DP_ZEDUD_PERSIST_DELAY * NSEC_PER_SEC)),
+                 [ZedUD persistQueue],
+                 ^{ [ZedUD persist]; });
+}
+
+
+
+//------------------- -o-
++ (dispatch_queue_t) persistQueue
+{
+  static dispatch_queue_t  queue = nil;
+  static dispatch_once_t   onceToken;
+
+  dispatch_once(&onceToken, ^{
+    queue = dispatch_queue_create("ZedUD persist", DISPATCH_QUEUE_SERIAL);
+  });
+
+  return queue;
+}
+
+
+
+//------------------- -o-
+// persist
+//
+// NB  persistQueue only.  Each changed root is copied once per batch, 
+//       not once per write.
+//
++ (void) persist
+{
+  NSMutableDictionary  *batch = [[NSMutableDictionary alloc] init];
+
+  @synchronized (memoryRoots) 
+  {
+    for (NSString *rootKey in unsavedRootKeys) {
+      id  root = [memoryRoots objectForKey:rootKey];
+      [batch setObject:((root == [NSNull null]) ? root : [root copy]) forKey:rootKey];
+    }
+
+    [unsavedRootKeys removeAllObjects];
+    isPersistScheduled = NO;
+  }
+
+
+  //
+  [batch enumerateKeysAndObjectsUsingBlock:^(NSString *rootKey, id root, BOOL *stop) {
+    if (root == [NSNull null]) {
+      [DP_USERDEFAULTS removeObjectForKey:DP_MAKE_UDKEY(rootKey)];
+    } else {
+      [DP_USERDEFAULTS setObject:root forKey:DP_MAKE_UDKEY(rootKey)];
+    }
+  }];
+
+} // persist
+
+
 @end // ZedUD
 